@@ -0,0 +1,198 @@
+#include "isobus/hardware_integration/available_can_drivers.hpp"
+#include "isobus/hardware_integration/can_hardware_interface.hpp"
+#include "isobus/isobus/can_general_parameter_group_numbers.hpp"
+#include "isobus/isobus/can_identifier.hpp"
+#include "isobus/isobus/can_internal_control_function.hpp"
+#include "isobus/isobus/can_network_manager.hpp"
+#include "isobus/utility/system_timing.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! It is discouraged to use global variables, but it is done here for simplicity.
+static std::atomic<std::uint32_t> totalFrames(0);
+static std::atomic<std::uint32_t> addressClaimFrames(0);
+static std::atomic<std::uint32_t> requestForClaimFrames(0);
+static std::atomic<std::uint32_t> lastClaimTimestamp_ms(0);
+static std::atomic<std::uint64_t> rxProcessingTime_us(0);
+static std::atomic<std::uint64_t> updateProcessingTime_us(0);
+static std::atomic<std::uint64_t> stackCPUTime_us(0);
+
+// The CPU time of the calling thread. The stack runs on the CAN threads, so the process CPU time would mostly measure waiting.
+std::uint64_t get_thread_cpu_time_us()
+{
+	std::uint64_t retVal = 0;
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+	timespec threadTime;
+
+	if (0 == clock_gettime(CLOCK_THREAD_CPUTIME_ID, &threadTime))
+	{
+		retVal = (static_cast<std::uint64_t>(threadTime.tv_sec) * 1000000) + (static_cast<std::uint64_t>(threadTime.tv_nsec) / 1000);
+	}
+#endif
+	return retVal;
+}
+
+void signal_handler(int)
+{
+	CANHardwareInterface::stop();
+	_exit(EXIT_FAILURE);
+}
+
+void update_CAN_network()
+{
+	std::uint64_t startTime_us = isobus::SystemTiming::get_timestamp_us();
+	std::uint64_t startCPUTime_us = get_thread_cpu_time_us();
+	isobus::CANNetworkManager::CANNetwork.update();
+	updateProcessingTime_us += isobus::SystemTiming::get_time_elapsed_us(startTime_us);
+	stackCPUTime_us += get_thread_cpu_time_us() - startCPUTime_us;
+}
+
+void raw_can_glue(isobus::HardwareInterfaceCANFrame &rawFrame, void *parentPointer)
+{
+	const std::uint32_t parameterGroupNumber = isobus::CANIdentifier(rawFrame.identifier).get_parameter_group_number();
+	std::uint64_t startTime_us = isobus::SystemTiming::get_timestamp_us();
+	std::uint64_t startCPUTime_us = get_thread_cpu_time_us();
+
+	isobus::CANNetworkManager::CANNetwork.can_lib_process_rx_message(rawFrame, parentPointer);
+	rxProcessingTime_us += isobus::SystemTiming::get_time_elapsed_us(startTime_us);
+	stackCPUTime_us += get_thread_cpu_time_us() - startCPUTime_us;
+
+	totalFrames++;
+	if (static_cast<std::uint32_t>(isobus::CANLibParameterGroupNumber::AddressClaim) == parameterGroupNumber)
+	{
+		addressClaimFrames++;
+		lastClaimTimestamp_ms = isobus::SystemTiming::get_timestamp_ms();
+	}
+	else if ((static_cast<std::uint32_t>(isobus::CANLibParameterGroupNumber::ParameterGroupNumberRequest) == parameterGroupNumber) &&
+	         (3 == rawFrame.dataLength) &&
+	         (0x00 == rawFrame.data[0]) &&
+	         (0xEE == rawFrame.data[1]) &&
+	         (0x00 == rawFrame.data[2]))
+	{
+		requestForClaimFrames++;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::signal(SIGINT, signal_handler);
+
+	const std::uint32_t numberOfNodes = (argc > 1) ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 200;
+	const std::uint32_t arbitraryAddressCapablePercent = (argc > 2) ? static_cast<std::uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 100;
+	const bool randomNAMEs = (argc > 3) && (std::string("random") == argv[3]);
+	const std::uint32_t seed = (argc > 4) ? static_cast<std::uint32_t>(std::strtoul(argv[4], nullptr, 10)) : 1;
+	const std::uint8_t preferredAddress = 0x80;
+	const std::uint32_t quietPeriod_ms = 1000;
+	const std::uint32_t maximumRunTime_ms = 60000;
+
+#if defined(ISOBUS_VIRTUALCAN_AVAILABLE)
+	// Receive our own frames, so that every control function hears every other one's claims
+	std::shared_ptr<CANHardwarePlugin> canDriver = std::make_shared<VirtualCANPlugin>("address_claim_storm", true);
+#else
+	std::shared_ptr<CANHardwarePlugin> canDriver = nullptr;
+#endif
+	if (nullptr == canDriver)
+	{
+		std::cout << "This benchmark needs the VirtualCAN driver. Please build the library with -DCAN_DRIVER=VirtualCAN." << std::endl;
+		return -1;
+	}
+
+	CANHardwareInterface::set_number_of_can_channels(1);
+	CANHardwareInterface::assign_can_channel_frame_handler(0, canDriver);
+
+	if ((!CANHardwareInterface::start()) || (!canDriver->get_is_valid()))
+	{
+		std::cout << "Failed to start hardware interface. The CAN driver might be invalid." << std::endl;
+		return -2;
+	}
+
+	CANHardwareInterface::add_can_lib_update_callback(update_CAN_network, nullptr);
+	CANHardwareInterface::add_raw_can_message_rx_callback(raw_can_glue, nullptr);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(250));
+
+	std::mt19937 generator(seed);
+	std::uniform_int_distribution<std::uint32_t> percentDistribution(0, 99);
+	std::vector<std::unique_ptr<isobus::InternalControlFunction>> nodes;
+
+	std::cout << "Starting " << numberOfNodes << " control functions, " << arbitraryAddressCapablePercent << "% arbitrary address capable, "
+	          << (randomNAMEs ? "random" : "sequential") << " NAMEs, seed " << seed << std::endl;
+
+	const std::uint32_t startTimestamp_ms = isobus::SystemTiming::get_timestamp_ms();
+	lastClaimTimestamp_ms = startTimestamp_ms;
+
+	for (std::uint32_t i = 0; i < numberOfNodes; i++)
+	{
+		isobus::NAME nodeNAME(0);
+
+		if (randomNAMEs)
+		{
+			nodeNAME.set_identity_number(generator() & 0x1FFFFF);
+			nodeNAME.set_manufacturer_code(generator() & 0x7FF);
+			nodeNAME.set_ecu_instance(generator() & 0x07);
+			nodeNAME.set_function_instance(generator() & 0x1F);
+			nodeNAME.set_function_code(generator() & 0x7F);
+			nodeNAME.set_device_class(generator() & 0x7F);
+			nodeNAME.set_device_class_instance(generator() & 0x0F);
+			nodeNAME.set_industry_group(2);
+		}
+		else
+		{
+			nodeNAME.set_identity_number(i);
+			nodeNAME.set_manufacturer_code(64);
+			nodeNAME.set_function_code(static_cast<std::uint8_t>(isobus::NAME::Function::IOController));
+			nodeNAME.set_industry_group(2);
+		}
+		nodeNAME.set_arbitrary_address_capable(percentDistribution(generator) < arbitraryAddressCapablePercent);
+		nodes.emplace_back(new isobus::InternalControlFunction(nodeNAME, preferredAddress, 0));
+	}
+
+	while ((!isobus::SystemTiming::time_expired_ms(lastClaimTimestamp_ms, quietPeriod_ms)) &&
+	       (!isobus::SystemTiming::time_expired_ms(startTimestamp_ms, maximumRunTime_ms)))
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	const std::uint32_t frames = totalFrames;
+	std::set<std::uint8_t> claimedAddresses;
+	std::uint32_t nodesWithAddress = 0;
+
+	for (auto &node : nodes)
+	{
+		if (node->get_address_valid())
+		{
+			nodesWithAddress++;
+			claimedAddresses.insert(node->get_address());
+		}
+	}
+
+	std::cout << "Convergence time:            " << (lastClaimTimestamp_ms - startTimestamp_ms) << " ms" << std::endl;
+	std::cout << "Frames exchanged:            " << frames << std::endl;
+	std::cout << "  Address claims:            " << addressClaimFrames << std::endl;
+	std::cout << "  Requests for claim:        " << requestForClaimFrames << std::endl;
+	if (0 != frames)
+	{
+		std::cout << "Rx processing per frame:     " << (static_cast<double>(rxProcessingTime_us) / frames) << " us wall time" << std::endl;
+		std::cout << "Stack update per frame:      " << (static_cast<double>(updateProcessingTime_us) / frames) << " us wall time" << std::endl;
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+		std::cout << "Stack CPU time per frame:    " << (static_cast<double>(stackCPUTime_us) / frames) << " us" << std::endl;
+#endif
+	}
+	std::cout << "Control functions claimed:   " << nodesWithAddress << " of " << numberOfNodes << std::endl;
+	std::cout << "Duplicate addresses:         " << (nodesWithAddress - claimedAddresses.size()) << std::endl;
+
+	CANHardwareInterface::stop();
+	nodes.clear();
+	return ((nodesWithAddress == claimedAddresses.size()) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
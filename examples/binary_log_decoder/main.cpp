@@ -0,0 +1,33 @@
+#include "isobus/isobus/can_stack_async_logger.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+int main(int argc, char **argv)
+{
+	int retVal = EXIT_FAILURE;
+
+	if (2 != argc)
+	{
+		std::cerr << "Usage: " << argv[0] << " <binary log file>" << std::endl;
+	}
+	else
+	{
+		std::ifstream binaryLog(argv[1], std::ios::binary);
+
+		if (!binaryLog)
+		{
+			std::cerr << "Unable to open " << argv[1] << std::endl;
+		}
+		else if (isobus::CANStackAsyncLogger::decode(binaryLog, std::cout))
+		{
+			retVal = EXIT_SUCCESS;
+		}
+		else
+		{
+			std::cerr << "The log is not a CAN stack binary log, or it is cut short" << std::endl;
+		}
+	}
+	return retVal;
+}
@@ -42,6 +42,14 @@ namespace isobus
 		/// @returns true if a NAME matches this filter class's components
 		bool check_name_matches_filter(const NAME &nameToCompare) const;
 
+		/// @brief Returns the bits of a raw 64 bit NAME that this filter constrains, and the value they must have
+		/// @details A NAME matches this filter when `(rawNAME & mask) == value`. This lets filters be
+		/// combined and evaluated without decoding each NAME component.
+		/// @param[out] mask The bits of the raw NAME occupied by this filter's parameter
+		/// @param[out] value The filter's value, shifted into its position in the raw NAME
+		/// @returns true if the filter can match a NAME, false if the parameter is unknown or the value doesn't fit in it
+		bool get_raw_name_mask_and_value(std::uint64_t &mask, std::uint64_t &value) const;
+
 	private:
 		NAME::NAMEParameters parameter; ///< The NAME component to filter against
 		std::uint32_t value; ///< The value of the data associated with the filter component
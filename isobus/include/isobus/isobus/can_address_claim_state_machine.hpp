@@ -37,6 +37,7 @@ namespace isobus
 			SendPreferredAddressClaim, ///< State machine is claiming the prefferred address
 			ContendForPreferredAddress, ///< State machine is contending the prefferred address
 			SendArbitraryAddressClaim, ///< State machine is claiming an address
+			WaitForReclaimDelay, ///< A global request for address claim was received, wait for our random delay before answering
 			SendReclaimAddressOnRequest, ///< An ECU requested address claim, inform the bus of our current address
 			UnableToClaim, ///< State machine could not claim an address
 			AddressClaimingComplete ///< Address claiming is complete and we have an address
@@ -67,6 +68,13 @@ namespace isobus
 		/// @returns The address claimed by the state machine or 0xFE if no address has been claimed
 		std::uint8_t get_claimed_address() const;
 
+		/// @brief Returns the random delay a control function waits before claiming, and before answering a global request for address claim
+		/// @details ISO 11783-5 asks for a delay of 0 to 153 ms in steps of 0.6 ms. It is drawn from a generator
+		/// seeded with the NAME, so ECUs with the same firmware don't pick the same delay, and each ECU always picks the same one.
+		/// @param[in] isoNAME The NAME of the control function
+		/// @returns The delay in microseconds
+		static std::uint32_t get_random_claim_delay_us(const NAME &isoNAME);
+
 		/// @brief Updates the state machine, should be called periodically
 		void update();
 
@@ -88,10 +96,10 @@ namespace isobus
 
 		NAME m_isoname; ///< The ISO NAME to claim as
 		State m_currentState; ///< The address claim state machine state
-		std::uint32_t m_timestamp_ms; ///< A generic timestamp in milliseconds used to find timeouts
+		std::uint64_t m_timestamp_us; ///< A generic timestamp in microseconds used to find timeouts
+		std::uint32_t m_randomClaimDelay_us; ///< The random delay as required by the ISO11783 standard, derived from our NAME
 		std::uint8_t m_portIndex; ///< The CAN channel index to claim on
 		std::uint8_t m_preferredAddress; ///< The address we'd prefer to claim as (we may not get it)
-		std::uint8_t m_randomClaimDelay_ms; ///< The random delay as required by the ISO11783 standard
 		std::uint8_t m_claimedAddress; ///< The actual address we ended up claiming
 		bool m_enabled; ///<  Enable/disable state for this state machine
 	};
@@ -27,6 +27,16 @@ namespace isobus
 		CannotRespond = 3 ///< Signals to the requestor that we are unable to accept the request for some reason
 	};
 
+	/// @brief The address changes and lifetime events that the network manager reports for control functions on the bus
+	enum class ControlFunctionEvent : std::uint8_t
+	{
+		AddressClaimed = 0, ///< A control function without a valid address claimed one
+		AddressChanged = 1, ///< A control function moved from one valid address to another
+		AddressLost = 2, ///< A control function lost its address to another claimant
+		PartnerBound = 3, ///< A partnered control function was matched to a control function on the bus
+		Deleted = 4 ///< A partnered or internal control function is being deleted, so every pointer to it must be dropped
+	};
+
 	/// @brief A callback for control functions to get CAN messages
 	typedef void (*CANLibCallback)(CANMessage *message, void *parentPointer);
 	/// @brief A callback to get chunks of data for transfer by a protocol
@@ -42,6 +52,11 @@ namespace isobus
 	                                         ControlFunction *destinationControlFunction,
 	                                         bool successful,
 	                                         void *parentPointer);
+	/// @brief A callback for when a control function's address or partner binding changes, or when it is deleted
+	typedef void (*ControlFunctionEventCallback)(ControlFunction *controlFunction,
+	                                             ControlFunctionEvent event,
+	                                             std::uint8_t previousAddress,
+	                                             void *parentPointer);
 	/// @brief A callback for handling a PGN request
 	typedef bool (*PGNRequestCallback)(std::uint32_t parameterGroupNumber,
 	                                   ControlFunction *requestingControlFunction,
@@ -53,6 +68,10 @@ namespace isobus
 	                                                    ControlFunction *requestingControlFunction,
 	                                                    std::uint32_t repetitionRate,
 	                                                    void *parentPointer);
+	/// @brief A callback that sends one message of a periodically published PGN
+	typedef bool (*PeriodicPGNCallback)(std::uint32_t parameterGroupNumber,
+	                                    ControlFunction *destinationControlFunction,
+	                                    void *parentPointer);
 
 	//================================================================================================
 	/// @class ParameterGroupNumberCallbackData
@@ -19,12 +19,15 @@
 #include "isobus/isobus/can_frame.hpp"
 #include "isobus/isobus/can_identifier.hpp"
 #include "isobus/isobus/can_internal_control_function.hpp"
+#include "isobus/isobus/can_managed_message.hpp"
 #include "isobus/isobus/can_message.hpp"
 #include "isobus/isobus/can_transport_protocol.hpp"
 
 #include <array>
+#include <atomic>
 #include <list>
 #include <mutex>
+#include <vector>
 
 /// @brief This namespace encompases all of the ISO11783 stack's functionality to reduce global namespace pollution
 namespace isobus
@@ -85,6 +88,55 @@ namespace isobus
 		/// @param[in] parent A generic context variable that helps identify what object the callback was destined for
 		void remove_any_control_function_parameter_group_number_callback(std::uint32_t parameterGroupNumber, CANLibCallback callback, void *parent);
 
+		/// @brief Registers a callback for changes to any control function's address or partner binding
+		/// @details The network manager processes each address claim once, in `update`, and reports the
+		/// resulting changes through these callbacks. This removes the need to poll `get_address_valid`.
+		/// Callbacks are called from the thread that calls `update`, except for ControlFunctionEvent::Deleted,
+		/// which is called from the thread deleting the control function before its memory is freed.
+		/// Callbacks may add or remove event callbacks, which takes effect from the next event.
+		/// @param[in] callback The callback to call when a control function event occurs
+		/// @param[in] parent A generic context variable that helps identify what object the callback is destined for. Can be nullptr if you don't want to use it.
+		void add_control_function_event_callback(ControlFunctionEventCallback callback, void *parent);
+
+		/// @brief Removes a callback added with add_control_function_event_callback
+		/// @details An event that another thread is already reporting may still call the callback once.
+		/// @param[in] callback The callback that will be removed
+		/// @param[in] parent A generic context variable that helps identify what object the callback was destined for
+		void remove_control_function_event_callback(ControlFunctionEventCallback callback, void *parent);
+
+		/// @brief Suspends periodic broadcasts on a CAN channel, for example because a DM13 asked for a quiet bus
+		/// @details This doesn't block send_can_message. Every periodic sender in the stack checks
+		/// get_is_broadcast_allowed before sending, and application senders should do the same.
+		/// Calling this again while suspended restarts the duration, which is how a DM13 hold signal works.
+		/// @param[in] canPort The CAN channel to suspend broadcasts on
+		/// @param[in] duration_ms How long to suspend broadcasts for, or 0 to suspend them until resume_broadcasts is called
+		void suspend_broadcasts(std::uint8_t canPort, std::uint32_t duration_ms);
+
+		/// @brief Resumes periodic broadcasts on a CAN channel
+		/// @param[in] canPort The CAN channel to resume broadcasts on
+		void resume_broadcasts(std::uint8_t canPort);
+
+		/// @brief Returns if periodic broadcasts are suspended on a CAN channel
+		/// @param[in] canPort The CAN channel to check
+		/// @returns true if broadcasts are suspended and the suspension hasn't expired
+		bool get_are_broadcasts_suspended(std::uint8_t canPort);
+
+		/// @brief Returns if a periodic sender may send a PGN on a CAN channel
+		/// @details Only broadcasts are gated. Replies directed at a requester, like a requested
+		/// repetition rate, are not broadcasts and should be sent regardless.
+		/// @param[in] canPort The CAN channel to send on
+		/// @param[in] parameterGroupNumber The PGN to send
+		/// @returns true if broadcasts aren't suspended on the channel, or the PGN is exempt from suspensions
+		bool get_is_broadcast_allowed(std::uint8_t canPort, std::uint32_t parameterGroupNumber);
+
+		/// @brief Lets a PGN keep being sent while broadcasts are suspended
+		/// @param[in] parameterGroupNumber The PGN to exempt
+		void add_broadcast_suspension_exemption(std::uint32_t parameterGroupNumber);
+
+		/// @brief Removes an exemption added with add_broadcast_suspension_exemption
+		/// @param[in] parameterGroupNumber The PGN that should no longer be exempt
+		void remove_broadcast_suspension_exemption(std::uint32_t parameterGroupNumber);
+
 		/// @brief Returns an internal control function if the passed-in control function is an internal type
 		/// @returns An internal control function casted from the passed in control function
 		InternalControlFunction *get_internal_control_function(ControlFunction *controlFunction);
@@ -108,12 +160,14 @@ namespace isobus
 		/// @brief This is the main function used by the stack to receive CAN messages and add them to a queue.
 		/// @details This function is called by the stack itself when you call can_lib_process_rx_message.
 		/// @param[in] message The message to be received
-		void receive_can_message(CANMessage &message);
+		void receive_can_message(CANLibManagedMessage &message);
 
 		/// @brief The main update function for the network manager. Updates all protocols.
 		void update();
 
 		/// @brief Process the CAN Rx queue
+		/// @details This may be called from any thread. Resolving the frame's addresses to control
+		/// functions reads the address table without taking a lock.
 		/// @param[in] rxFrame Frame to process
 		/// @param[in] parentClass A generic context variable
 		static void can_lib_process_rx_message(HardwareInterfaceCANFrame &rxFrame, void *parentClass);
@@ -122,6 +176,10 @@ namespace isobus
 		/// @param[in] partner Pointer to the partner being deleted
 		void on_partner_deleted(PartneredControlFunction *partner, CANLibBadge<PartneredControlFunction>);
 
+		/// @brief Informs the network manager that an internal control function was deleted so that it can be purged from the address/cf tables
+		/// @param[in] internalControlFunction Pointer to the internal control function being deleted
+		void on_internal_control_function_deleted(InternalControlFunction *internalControlFunction, CANLibBadge<InternalControlFunction>);
+
 	protected:
 		// Using protected region to allow protocols use of special functions from the network manager
 		friend class AddressClaimStateMachine; ///< Allows the network manager to work closely with the address claiming process
@@ -174,18 +232,48 @@ namespace isobus
 		/// @brief Constructor for the network manager. Sets default values for members
 		CANNetworkManager();
 
-		/// @brief Updates the internal address table based on a received CAN message
-		/// @param[in] message A message being received by the stack
-		void update_address_table(CANMessage &message);
-
-		/// @brief Updates the internal address table based on a received address claim
-		/// @param[in] CANPort The CAN channel index of the CAN message being processed
-		/// @param[in] claimedAddress The address claimed
-		void update_address_table(std::uint8_t CANPort, std::uint8_t claimedAddress);
-
-		/// @brief Creates new control function classes based on the frames coming in from the bus
-		/// @param[in] rxFrame Raw frames coming in from the bus
-		void update_control_functions(HardwareInterfaceCANFrame &rxFrame);
+		/// @brief Stores a control function event callback and its context
+		struct ControlFunctionEventCallbackData
+		{
+			ControlFunctionEventCallback callback; ///< The function to call when a control function event occurs
+			void *parent; ///< A generic context variable that is passed back to the callback
+		};
+
+		/// @brief Ends a broadcast suspension on a CAN channel if its duration has run out
+		/// @details broadcastGateMutex must be locked by the caller.
+		/// @param[in] canPort The CAN channel to check, which must be less than CAN_PORT_MAXIMUM
+		/// @returns true if broadcasts are still suspended on the channel
+		bool update_broadcast_suspension(std::uint8_t canPort);
+
+		/// @brief Processes a received address claim, updating the control function lists and the address table
+		/// @details This is the only place an external control function's address changes. The claim's
+		/// source control function is set on the message so that claim callbacks see the claimant.
+		/// @param[in] message The address claim message being received
+		void process_rx_address_claim(CANLibManagedMessage &message);
+
+		/// @brief Updates the address table after an internal control function's address claim state machine changed its address
+		/// @param[in] internalControlFunction The internal control function that changed address
+		void process_internal_control_function_address_change(InternalControlFunction *internalControlFunction);
+
+		/// @brief Removes a control function from the address table because another control function took its address
+		/// @param[in] controlFunction The control function that lost its address
+		void evict_control_function_from_address_table(ControlFunction *controlFunction);
+
+		/// @brief Removes every reference the stack holds to a control function that is being deleted
+		/// @details Event callbacks are told first, so they can drop their pointers to it.
+		/// The control function is then unpublished from the address table, and the reader epoch is
+		/// advanced so this waits only for Rx threads of the previous epoch, which may have read the old
+		/// table entry, to finish queuing their messages. Rx threads that start later can't delay it.
+		/// Finally the control function is replaced in messages that are still waiting in the Rx queue.
+		/// @param[in] controlFunction The control function being deleted
+		/// @param[in] replacement A control function to use in its place in queued messages, or nullptr
+		void purge_control_function(ControlFunction *controlFunction, ControlFunction *replacement);
+
+		/// @brief Calls all control function event callbacks
+		/// @param[in] controlFunction The control function the event is about
+		/// @param[in] event The type of event that occurred
+		/// @param[in] previousAddress The address of the control function before the event
+		void notify_control_function_event(ControlFunction *controlFunction, ControlFunctionEvent event, std::uint8_t previousAddress);
 
 		/// @brief Checks if new partners have been created and matches them to existing control functions
 		void update_new_partners();
@@ -216,7 +304,7 @@ namespace isobus
 		/// @brief Gets a message from the Rx Queue.
 		/// @note This will only ever get an 8 byte message. Long messages are handled elsewhere.
 		/// @returns The can message that was at the front of the buffer
-		CANMessage get_next_can_message_from_rx_queue();
+		CANLibManagedMessage get_next_can_message_from_rx_queue();
 
 		/// @brief Returns the number of messages in the rx queue that need to be processed
 		/// @returns The number of messages in the rx queue that need to be processed
@@ -262,16 +350,26 @@ namespace isobus
 		ExtendedTransportProtocolManager extendedTransportProtocol; ///< Static instance of the protocol manager
 		TransportProtocolManager transportProtocol; ///< Static instance of the transport protocol manager
 
-		std::array<std::array<ControlFunction *, 256>, CAN_PORT_MAXIMUM> controlFunctionTable; ///< Table to maintain address to NAME mappings
+		std::array<std::array<std::atomic<ControlFunction *>, 256>, CAN_PORT_MAXIMUM> controlFunctionTable; ///< Table to maintain address to NAME mappings. Written by the update thread, read lock-free by Rx threads.
 		std::vector<ControlFunction *> activeControlFunctions; ///< A list of active control function used to track connected devices
 		std::vector<ControlFunction *> inactiveControlFunctions; ///< A list of inactive control functions, used to track disconnected devices
 		std::list<ParameterGroupNumberCallbackData> protocolPGNCallbacks; ///< A list of PGN callback registered by CAN protocols
-		std::list<CANMessage> receiveMessageList; ///< A queue of Rx messages to process
+		std::list<CANLibManagedMessage> receiveMessageList; ///< A queue of Rx messages to process
 		std::vector<ParameterGroupNumberCallbackData> globalParameterGroupNumberCallbacks; ///< A list of all global PGN callbacks
 		std::vector<ParameterGroupNumberCallbackData> anyControlFunctionParameterGroupNumberCallbacks; ///< A list of all global PGN callbacks
+		std::vector<ControlFunctionEventCallbackData> controlFunctionEventCallbacks; ///< A list of all control function event callbacks
+		std::vector<std::uint32_t> broadcastSuspensionExemptions; ///< The PGNs that may be sent while broadcasts are suspended, sorted
+		std::array<std::uint32_t, CAN_PORT_MAXIMUM> broadcastSuspensionTimestamps_ms; ///< When broadcasts were last suspended on each channel
+		std::array<std::uint32_t, CAN_PORT_MAXIMUM> broadcastSuspensionDurations_ms; ///< How long broadcasts are suspended for on each channel, 0 meaning until resumed
+		std::array<bool, CAN_PORT_MAXIMUM> broadcastsSuspended; ///< If broadcasts are suspended on each channel
 		std::mutex receiveMessageMutex; ///< A mutex for receive messages thread safety
 		std::mutex protocolPGNCallbacksMutex; ///< A mutex for PGN callback thread safety
 		std::mutex anyControlFunctionCallbacksMutex; ///< Mutex to protect the "any CF" callbacks
+		std::mutex controlFunctionEventCallbacksMutex; ///< Mutex to protect the control function event callbacks
+		std::mutex broadcastGateMutex; ///< Mutex to protect the broadcast suspensions and their exemptions
+		std::mutex addressTablePurgeMutex; ///< Serializes purges, so each one waits on the epoch it retired
+		std::array<std::atomic<std::uint32_t>, 2> addressTableReaderCounts; ///< The number of Rx threads resolving addresses with controlFunctionTable, per reader epoch
+		std::atomic<std::uint32_t> addressTableEpoch; ///< Its lowest bit selects the reader count that new Rx threads use
 		std::uint32_t updateTimestamp_ms; ///< Keeps track of the last time the CAN stack was update in milliseconds
 		bool initialized; ///< True if the network manager has been initialized by the update function
 	};
@@ -17,7 +17,10 @@
 #include "isobus/isobus/can_network_manager.hpp"
 #include "isobus/isobus/can_protocol.hpp"
 
+#include <array>
 #include <memory>
+#include <random>
+#include <unordered_map>
 
 namespace isobus
 {
@@ -94,6 +97,70 @@ namespace isobus
 		/// @returns true if the callback was registered, false if the callback is nullptr or is already registered for the same PGN
 		bool remove_request_for_repetition_rate_callback(std::uint32_t pgn, PGNRequestForRepetitionRateCallback callback, void *parentPointer);
 
+		/// @brief Publishes a PGN periodically from this protocol's update
+		/// @details The callback is called once per period to send the PGN. Requests for repetition rate
+		/// for the PGN are then handled automatically: each requester gets the PGN at the rate it asked for,
+		/// and a requested rate of 0xFFFF returns it to the default. All published PGNs share one schedule,
+		/// and each transmission is planned from the previous one's due time so the rate doesn't drift.
+		/// Broadcasts of the default rate are skipped while CANNetworkManager::get_is_broadcast_allowed forbids the PGN, for example
+		/// after a DM13. Transmissions to a requester are directed at it, so they continue.
+		/// A failed send waits for the next period. Rates requested by a control function are dropped after
+		/// MAXIMUM_CONSECUTIVE_PERIODIC_FAILURES failed sends in a row, or when the requester loses its address or is deleted.
+		/// The callback must not register or remove periodic PGNs.
+		/// @param[in] pgn The PGN to publish
+		/// @param[in] defaultRate_ms The rate to broadcast the PGN at, or 0 to only send it to requesters
+		/// @param[in] callback The callback that sends the PGN to the control function it is passed, or to global for nullptr
+		/// @param[in] parentPointer Generic context variable, usually the `this` pointer of the class registering the callback
+		/// @returns true if the PGN was registered, false if the callback is nullptr or the PGN is already published
+		bool register_periodic_pgn(std::uint32_t pgn, std::uint16_t defaultRate_ms, PeriodicPGNCallback callback, void *parentPointer);
+
+		/// @brief Stops publishing a PGN, including to any control functions that requested a repetition rate
+		/// @param[in] pgn The PGN to stop publishing
+		/// @returns true if the PGN was published
+		bool remove_periodic_pgn(std::uint32_t pgn);
+
+		/// @brief Timing statistics for one periodically published PGN and destination
+		struct PeriodicPGNStatistics
+		{
+			std::uint32_t numberOfTransmissions; ///< The number of times the callback sent the PGN
+			std::uint32_t numberOfFailedTransmissions; ///< The number of times the callback could not send the PGN
+			std::uint32_t maximumJitter_ms; ///< The largest delay between a transmission's due time and when it was sent
+			std::uint64_t totalJitter_ms; ///< The sum of all transmission delays, for computing the average
+		};
+
+		/// @brief Returns the timing statistics of a published PGN
+		/// @param[in] pgn The published PGN
+		/// @param[in] destination The control function that requested a repetition rate, or nullptr for the default broadcast
+		/// @param[out] statistics The statistics, if they were found
+		/// @returns true if the PGN is published to the destination
+		bool get_periodic_pgn_statistics(std::uint32_t pgn, const ControlFunction *destination, PeriodicPGNStatistics &statistics);
+
+		/// @brief Returns the number of PGN and destination pairs that are published periodically
+		/// @returns The number of entries in the periodic schedule
+		std::size_t get_number_periodic_pgn_schedules();
+
+		/// @brief Spreads the responses to global PGN requests over a window instead of answering right away
+		/// @details When several internal control functions answer the same global request, their responses
+		/// would otherwise all be sent in the same update. With a window, each global request is answered
+		/// after a delay of up to `window_ms`, from the protocol's update, and due responses are sent
+		/// highest priority first, at most MAXIMUM_GLOBAL_RESPONSES_PER_UPDATE per update.
+		/// Destination specific requests are always answered right away.
+		/// @param[in] window_ms The longest delay before answering a global request, or 0 to answer right away.
+		/// Limited to MAXIMUM_GLOBAL_RESPONSE_WINDOW_MS, the J1939-21 response time.
+		/// @param[in] useNAMEOffset If true, every response is delayed by the same offset derived from our NAME, so
+		/// control functions on one gateway always answer in the same order. If false, each response gets a pseudo-random delay.
+		void set_global_response_spreading(std::uint16_t window_ms, bool useNAMEOffset);
+
+		/// @brief Sets the priority of the deferred responses to global requests for a PGN
+		/// @details When several deferred responses are due, the one with the highest priority (lowest value) is sent first
+		/// @param[in] pgn The requested PGN
+		/// @param[in] priority The priority, from 0 (highest) to 7 (lowest). The default is 6.
+		void set_global_response_priority(std::uint32_t pgn, CANIdentifier::CANPriority priority);
+
+		/// @brief Returns the number of responses to global requests that are waiting to be sent
+		/// @returns The number of deferred responses
+		std::size_t get_number_pending_global_responses();
+
 		/// @brief Returns the number of PGN request callbacks that have been registered with this protocol instance
 		/// @returns The number of PGN request callbacks that have been registered with this protocol instance
 		std::size_t get_number_registered_pgn_request_callbacks() const;
@@ -106,6 +173,13 @@ namespace isobus
 		void update(CANLibBadge<CANNetworkManager>) override;
 
 		static constexpr std::uint8_t PGN_REQUEST_LENGTH = 3; ///< The CAN data length of a PGN request
+		static constexpr std::uint16_t DEFAULT_REPETITION_RATE = 0xFFFF; ///< A requested repetition rate that returns the requester to the default rate
+		static constexpr std::uint16_t MINIMUM_REPETITION_RATE_MS = 10; ///< Requested repetition rates are limited to this to protect the bus
+		static constexpr std::uint8_t MAXIMUM_CONSECUTIVE_PERIODIC_FAILURES = 5; ///< A requested rate is dropped after this many sends in a row fail
+		static constexpr std::uint32_t REQUEST_DEDUPLICATION_WINDOW_MS = 100; ///< Identical global PGN requests within this time get only one response
+		static constexpr std::size_t MAXIMUM_PENDING_GLOBAL_RESPONSES = 32; ///< The most deferred responses to global requests, beyond which requests are answered right away
+		static constexpr std::uint16_t MAXIMUM_GLOBAL_RESPONSE_WINDOW_MS = 200; ///< The longest global response spreading window, since J1939-21 requires a response within 200 ms
+		static constexpr std::uint8_t MAXIMUM_GLOBAL_RESPONSES_PER_UPDATE = 2; ///< The most deferred responses sent in one update, to bound the transmit queue
 
 	private:
 		/// @brief A storage class for holding PGN callbacks and their associated PGN
@@ -150,6 +224,99 @@ namespace isobus
 			void *parent; ///< Pointer to the class that registered the callback, or `nullptr`
 		};
 
+		/// @brief A global PGN request that was recently answered
+		struct RecentRequest
+		{
+			std::uint32_t pgn; ///< The requested PGN
+			std::uint32_t timestamp_ms; ///< When the request was received
+			bool valid; ///< If this entry holds a request
+		};
+
+		/// @brief A response to a global PGN request that is waiting for its due time
+		struct PendingGlobalResponse
+		{
+			ControlFunction *requester; ///< The control function that sent the request, the entry is dropped when it is deleted
+			std::uint32_t pgn; ///< The requested PGN
+			std::uint32_t dueTimestamp_ms; ///< When the response should be sent
+			std::uint8_t priority; ///< The priority of the response, lower values are sent first
+		};
+
+		/// @brief A PGN that is published periodically, and the callback that sends it
+		struct PeriodicPGN
+		{
+			PeriodicPGNCallback callbackFunction; ///< The callback that sends the PGN
+			void *parent; ///< Pointer to the class that registered the callback, or `nullptr`
+			std::uint32_t pgn; ///< The published PGN
+			std::uint16_t defaultRate_ms; ///< The rate to broadcast the PGN at, or 0 if it is only sent to requesters
+		};
+
+		/// @brief One PGN and destination in the periodic schedule
+		struct PeriodicPGNSchedule
+		{
+			PeriodicPGNStatistics statistics; ///< The timing statistics of the transmissions
+			ControlFunction *destination; ///< The control function that requested the rate, or nullptr for the default broadcast
+			std::uint32_t pgn; ///< The published PGN
+			std::uint32_t nextTransmission_ms; ///< When the PGN is next due
+			std::uint16_t rate_ms; ///< The period of the transmissions
+			std::uint8_t consecutiveFailures; ///< The number of sends in a row that failed
+		};
+
+		/// @brief Calls the PGN request callbacks registered for one PGN until one handles the request
+		/// @param[in] callbackPGN The PGN the callbacks were registered for, which may be the any PGN wildcard
+		/// @param[in] requestedPGN The PGN that was requested
+		/// @param[in] requester The control function that sent the request
+		/// @param[out] shouldAck Set by the callback to tell if the request should be acknowledged
+		/// @param[out] ackType Set by the callback to the type of acknowledgement to send
+		/// @returns true if a callback handled the request
+		bool call_pgn_request_callbacks(std::uint32_t callbackPGN, std::uint32_t requestedPGN, ControlFunction *requester, bool &shouldAck, AcknowledgementType &ackType);
+
+		/// @brief Calls the repetition rate callbacks registered for one PGN until one handles the request
+		/// @param[in] callbackPGN The PGN the callbacks were registered for, which may be the any PGN wildcard
+		/// @param[in] requestedPGN The PGN that a repetition rate was requested for
+		/// @param[in] requester The control function that sent the request
+		/// @param[in] requestedRate_ms The requested repetition rate
+		/// @returns true if a callback handled the request
+		bool call_repetition_rate_callbacks(std::uint32_t callbackPGN, std::uint32_t requestedPGN, ControlFunction *requester, std::uint16_t requestedRate_ms);
+
+		/// @brief Checks if an identical global PGN request was answered within the deduplication window, and remembers this one if not
+		/// @details Destination specific requests are never duplicates, so a requester that retries still gets its ACK or NACK
+		/// @param[in] pgn The requested PGN
+		/// @param[in] message The request message
+		/// @returns true if the request should not be answered again
+		bool get_is_duplicate_request(std::uint32_t pgn, const CANMessage *message);
+
+		/// @brief Defers the response to a global PGN request if spreading is enabled
+		/// @param[in] pgn The requested PGN
+		/// @param[in] requester The control function that sent the request
+		/// @returns true if the response was deferred, false if the request should be answered right away
+		bool defer_global_response(std::uint32_t pgn, ControlFunction *requester);
+
+		/// @brief Sends the deferred responses to global requests that are due, highest priority first
+		void update_global_responses();
+
+		/// @brief Orders the periodic schedule so that the entry due first is at the front of the heap
+		/// @param[in] first The first entry to compare
+		/// @param[in] second The second entry to compare
+		/// @returns true if the first entry is due after the second one
+		static bool is_due_later(const PeriodicPGNSchedule &first, const PeriodicPGNSchedule &second);
+
+		/// @brief Adds, changes or removes the schedule for a requester of a published PGN
+		/// @param[in] pgn The requested PGN
+		/// @param[in] requester The control function that requested a repetition rate
+		/// @param[in] requestedRate_ms The requested repetition rate
+		/// @returns true if the PGN is published and the request was handled
+		bool process_repetition_rate_request(std::uint32_t pgn, ControlFunction *requester, std::uint16_t requestedRate_ms);
+
+		/// @brief Sends every published PGN that is due, and plans its next transmission
+		void update_periodic_pgns();
+
+		/// @brief Drops the schedules and deferred responses of control functions that are being deleted
+		/// @param[in] controlFunction The control function the event is about
+		/// @param[in] event The type of event that occurred
+		/// @param[in] previousAddress The address of the control function before the event
+		/// @param[in] parent Provides the context to the actual PGN request protocol object
+		static void process_control_function_event(ControlFunction *controlFunction, ControlFunctionEvent event, std::uint8_t previousAddress, void *parent);
+
 		/// @brief Constructor for the PGN request protocol
 		/// @param[in] internalControlFunction The internal control function assigned to the protocol instance
 		ParameterGroupNumberRequestProtocol(std::shared_ptr<InternalControlFunction> internalControlFunction);
@@ -197,9 +364,20 @@ namespace isobus
 		static std::list<ParameterGroupNumberRequestProtocol *> pgnRequestProtocolList; ///< List of all PGN request protocol instances (one per ICF)
 
 		std::shared_ptr<InternalControlFunction> myControlFunction; ///< The internal control function that this protocol will send from
-		std::vector<PGNRequestCallbackInfo> pgnRequestCallbacks; ///< A list of all registered PGN callbacks and the PGN associated with each callback
-		std::vector<PGNRequestForRepetitionRateCallbackInfo> repetitionRateCallbacks; ///< A list of all registered request for repetition rate callbacks and the PGN associated with the callback
+		std::unordered_map<std::uint32_t, std::vector<PGNRequestCallbackInfo>> pgnRequestCallbacks; ///< The registered PGN request callbacks, indexed by the PGN they were registered for
+		std::unordered_map<std::uint32_t, std::vector<PGNRequestForRepetitionRateCallbackInfo>> repetitionRateCallbacks; ///< The registered request for repetition rate callbacks, indexed by the PGN they were registered for
+		std::array<RecentRequest, 16> recentRequests; ///< The most recently answered global PGN requests, used to drop duplicates
+		std::size_t nextRecentRequest; ///< The entry in recentRequests to overwrite next
+		std::vector<PendingGlobalResponse> pendingGlobalResponses; ///< The deferred responses to global requests, with capacity reserved up front
+		std::unordered_map<std::uint32_t, std::uint8_t> globalResponsePriorities; ///< The priorities of deferred responses, for PGNs that don't use the default
+		std::minstd_rand responseDelayGenerator; ///< Generates the delays of deferred responses, seeded from our NAME
+		std::uint32_t nameResponseOffset_ms; ///< The delay derived from our NAME, used when useNAMEOffset is set
+		std::uint16_t globalResponseWindow_ms; ///< The longest delay before answering a global request, or 0 to answer right away
+		bool useNAMEResponseOffset; ///< If every deferred response uses the NAME derived delay
 		std::mutex pgnRequestMutex; ///< A mutex to protect the callback lists
+		std::vector<PeriodicPGN> periodicPGNs; ///< The PGNs that are published periodically
+		std::vector<PeriodicPGNSchedule> periodicSchedule; ///< A min-heap of every PGN and destination being published, ordered by due time
+		std::mutex periodicPGNMutex; ///< A mutex to protect the periodic PGNs and their schedule
 	};
 }
 
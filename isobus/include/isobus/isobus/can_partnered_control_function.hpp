@@ -83,6 +83,8 @@ namespace isobus
 		bool get_name_filter_parameter(std::uint32_t index, NAME::NAMEParameters &parameter, std::uint32_t &filterValue) const;
 
 		/// @brief Checks to see if a NAME matches this CF's NAME filters
+		/// @details Filters on different NAME parameters must all match. When several filters share the
+		/// same parameter, the NAME matches if that parameter equals any one of their values.
 		/// @param[in] NAMEToCheck The NAME to check against this control function's filters
 		/// @returns true if this control function matches the NAME that was passed in, false otherwise
 		bool check_matches_name(NAME NAMEToCheck) const;
@@ -104,10 +106,28 @@ namespace isobus
 		/// @returns The PGN callback data associated with the index that was passed in
 		ParameterGroupNumberCallbackData get_parameter_group_number_callback(std::uint32_t index) const;
 
+		/// @brief Converts the NAME filters into masks and values over the raw 64 bit NAME
+		/// @details Parameters with a single filter are merged into one mask/value pair so that
+		/// check_matches_name is usually just a single AND and compare. Parameters with
+		/// several filters are kept as a small set of allowed values. A filter on an unknown
+		/// parameter can't be satisfied, so it makes the partner match no NAME at all.
+		void compile_name_filters();
+
+		/// @brief Stores a NAME parameter that has more than one acceptable value
+		struct NAMEFilterValueSet
+		{
+			std::uint64_t mask; ///< The bits of the raw NAME occupied by the parameter
+			std::vector<std::uint64_t> values; ///< The acceptable values of those bits
+		};
+
 		static std::vector<PartneredControlFunction *> partneredControlFunctionList; ///< A list of all created partnered control functions
 		static bool anyPartnerNeedsInitializing; ///< A way for the network manager to know if it needs to parse the partner list to match partners with existing CFs
 		const std::vector<NAMEFilter> NAMEFilterList; ///< A list of NAME parameters that describe this control function's identity
+		std::vector<NAMEFilterValueSet> compiledNAMEFilterValueSets; ///< NAME parameters that may match any of several values
 		std::vector<ParameterGroupNumberCallbackData> parameterGroupNumberCallbacks; ///< A list of all parameter group number callbacks associated with this control function
+		std::uint64_t compiledNAMEFilterMask; ///< The raw NAME bits constrained by single-valued filters
+		std::uint64_t compiledNAMEFilterValue; ///< The value the bits in compiledNAMEFilterMask must have
+		bool compiledNAMEFilterCanMatch; ///< False if the filters are empty or contradictory, so no NAME can match
 		bool initialized; ///< A way to track if the network manager has processed this CF against existing CFs
 	};
 
@@ -0,0 +1,161 @@
+//================================================================================================
+/// @file can_stack_async_logger.hpp
+///
+/// @brief Defines an asynchronous backend for the CAN stack logger. Log statements are stored as
+/// compact binary records and formatted on a background thread.
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#ifndef CAN_STACK_ASYNC_LOGGER_HPP
+#define CAN_STACK_ASYNC_LOGGER_HPP
+
+#include "isobus/isobus/can_stack_logger.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdarg>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace isobus
+{
+	//================================================================================================
+	/// @class CANStackAsyncLogger
+	///
+	/// @brief Moves formatting and the log sink off the threads that log, usually the CAN thread
+	/// @details While the backend is running, each CAN_STACK_LOG_ statement stores a binary record
+	/// (timestamp, level, format and up to MAXIMUM_ARGUMENTS arguments) in a ring that belongs to the
+	/// logging thread. Writing a record doesn't lock or allocate, so a slow sink can't stall frame
+	/// processing. A background thread drains the rings in timestamp order, formats each record, and
+	/// passes it to the CANStackLogger sink. It can also write the records to a binary stream, which
+	/// decode turns back into text offline, so nothing is formatted on the device at all.
+	///
+	/// If a ring is full the record is dropped and counted. String arguments are stored in a single
+	/// argument, so they are truncated to 8 characters, which fits the VT version labels the stack logs.
+	/// Text logged with the std::string functions of CANStackLogger is still logged synchronously.
+	//================================================================================================
+	class CANStackAsyncLogger
+	{
+	public:
+		static constexpr std::uint8_t MAXIMUM_ARGUMENTS = 4; ///< The most arguments a record stores, later ones are rendered as "?"
+		static constexpr std::uint32_t RECORDS_PER_THREAD = 256; ///< The size of each thread's ring, must be a power of 2
+		static constexpr std::uint32_t DEFAULT_DRAIN_PERIOD_MS = 20; ///< How often the background thread drains the rings by default
+
+		/// @brief One log statement, as stored in the rings
+		struct Record
+		{
+			std::uint64_t timestamp_us; ///< When the statement was logged
+			const char *format; ///< The printf style format, which must be a string literal
+			std::array<std::uint64_t, MAXIMUM_ARGUMENTS> arguments; ///< The raw arguments, in the order of the format's conversions
+			CANStackLogger::LoggingLevel level; ///< The log level of the statement
+			std::uint8_t numberOfArguments; ///< The number of valid arguments
+		};
+
+		/// @brief Starts the background thread. Log statements are asynchronous from then on.
+		/// @param[in] drainPeriod_ms How often the background thread drains the rings
+		/// @returns true if the thread was started, false if it was already running
+		static bool start(std::uint32_t drainPeriod_ms = DEFAULT_DRAIN_PERIOD_MS);
+
+		/// @brief Stops the background thread after it drains the records that are left
+		/// @details Waits for threads that are still writing a record, so their records are drained too
+		/// @returns true if the thread was stopped, false if it wasn't running
+		static bool stop();
+
+		/// @brief Returns if the background thread is running
+		/// @returns true if log statements are currently asynchronous
+		static bool get_is_running();
+
+		/// @brief Sets a stream the background thread writes every record to, in the format decode reads
+		/// @details The stream is written from the background thread, and must stay valid until it is replaced
+		/// @param[in] output The stream to write to, or nullptr to stop writing records
+		static void set_binary_output(std::ostream *output);
+
+		/// @brief Returns the number of records dropped because a ring was full
+		/// @returns The number of dropped records since the program started
+		static std::uint32_t get_number_dropped_records();
+
+		/// @brief Stores a log statement in the calling thread's ring. Used by CANStackLogger.
+		/// @param[in] level The log level of the statement
+		/// @param[in] format The printf style format, which must be a string literal
+		/// @param[in] arguments The arguments for the format
+		/// @returns true if the statement was handled (stored or dropped), false if the backend isn't running
+		static bool log(CANStackLogger::LoggingLevel level, const char *format, va_list arguments);
+
+		/// @brief Renders a record as text
+		/// @param[in] format The format of the record. Passed separately so decoded records can be rendered too.
+		/// @param[in] record The record to render
+		/// @param[out] buffer The buffer to render into, always null terminated
+		/// @param[in] bufferSize The size of the buffer
+		static void format_record(const char *format, const Record &record, char *buffer, std::size_t bufferSize);
+
+		/// @brief Renders binary records written by the background thread as text, one line per record
+		/// @param[in] input The binary records
+		/// @param[out] output The text, with the timestamp in microseconds and the level before each message
+		/// @returns true if the whole input was decoded, false if it isn't binary log data or is cut short
+		static bool decode(std::istream &input, std::ostream &output);
+
+	private:
+		/// @brief A single producer, single consumer ring of records owned by one logging thread
+		struct ThreadRing
+		{
+			std::array<Record, RECORDS_PER_THREAD> records; ///< The records
+			std::atomic<std::uint32_t> writeIndex; ///< The number of records written, only changed by the logging thread
+			std::atomic<std::uint32_t> readIndex; ///< The number of records drained, only changed by the background thread
+			std::atomic<bool> inUse; ///< If a thread owns the ring. Rings of threads that exited are reused.
+		};
+
+		/// @brief Releases the calling thread's ring when the thread exits
+		struct ThreadRingOwner
+		{
+			/// @brief Marks the ring as free for the next new thread
+			~ThreadRingOwner();
+
+			ThreadRing *ring; ///< The ring the thread owns, or nullptr if it never logged
+		};
+
+		/// @brief The tags of the entries in the binary output
+		enum class BinaryTag : std::uint8_t
+		{
+			Format = 'F', ///< Defines the text of a message ID
+			Record = 'R' ///< A record that refers to a message ID
+		};
+
+		/// @brief Returns the calling thread's ring, assigning one the first time a thread logs
+		/// @returns The calling thread's ring
+		static ThreadRing *get_thread_ring();
+
+		/// @brief The background thread executes this function
+		static void drain_thread_function();
+
+		/// @brief Moves every record out of the rings and sends them to the sink and binary output
+		static void drain();
+
+		/// @brief Writes a record to the binary output, defining its message ID first if needed
+		/// @param[in] record The record to write
+		static void write_binary_record(const Record &record);
+
+		static constexpr std::uint8_t BINARY_VERSION = 1; ///< The version written in the binary output header
+
+		static std::vector<std::unique_ptr<ThreadRing>> rings; ///< A ring for each thread that has logged
+		static std::vector<Record> drainedRecords; ///< Records moved out of the rings, reused for each drain
+		static std::unordered_map<const char *, std::uint16_t> messageIDs; ///< The message IDs defined in the binary output so far
+		static std::mutex ringsMutex; ///< Protects the list of rings
+		static std::mutex drainMutex; ///< Serializes draining and protects the binary output
+		static std::thread *drainThread; ///< The background thread
+		static std::ostream *binaryOutput; ///< The stream records are written to, or nullptr
+		static std::atomic<std::uint32_t> droppedRecords; ///< The number of records dropped because a ring was full
+		static std::atomic<std::uint32_t> drainPeriod_ms; ///< How often the background thread drains the rings
+		static std::atomic<bool> running; ///< If the background thread is running
+		static std::atomic<std::uint32_t> activeWriters; ///< The number of threads in log, which stop waits for before its final drain
+		static thread_local ThreadRingOwner threadRingOwner; ///< The ring of the calling thread
+	};
+} // namespace isobus
+
+#endif // CAN_STACK_ASYNC_LOGGER_HPP
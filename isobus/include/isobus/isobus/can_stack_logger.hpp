@@ -10,9 +10,80 @@
 #ifndef CAN_STACK_LOGGER_HPP
 #define CAN_STACK_LOGGER_HPP
 
+#include <atomic>
 #include <mutex>
 #include <string>
 
+/// @brief Log statements below this level are compiled out. 0 keeps Debug and up, 5 removes every level.
+#ifndef CAN_STACK_LOG_COMPILED_LEVEL
+#define CAN_STACK_LOG_COMPILED_LEVEL 0
+#endif
+
+/// @brief Lets GCC and Clang check the arguments of printf style log statements against their format
+#if defined(__GNUC__) || defined(__clang__)
+#define CAN_STACK_LOG_FORMAT_CHECK(formatIndex, firstArgumentIndex) __attribute__((format(printf, formatIndex, firstArgumentIndex)))
+#else
+#define CAN_STACK_LOG_FORMAT_CHECK(formatIndex, firstArgumentIndex)
+#endif
+
+/// @brief Logs a printf style message, evaluating the arguments only if the level is enabled
+/// @attention While CANStackAsyncLogger is running, each `%s` argument is stored in 8 bytes, so only its
+/// first 8 characters are logged. Pass longer text with the std::string functions of CANStackLogger instead.
+#define CAN_STACK_LOG_AT_LEVEL(level, ...)                                       \
+	do                                                                           \
+	{                                                                            \
+		if (isobus::CANStackLogger::get_is_log_level_enabled(level))             \
+		{                                                                        \
+			isobus::CANStackLogger::CAN_stack_log_formatted(level, __VA_ARGS__); \
+		}                                                                        \
+	} while (false)
+
+/// @brief Stands in for log statements that are compiled out. The arguments are never evaluated, but
+/// are still checked against the format, and variables only used for logging don't cause warnings.
+#define CAN_STACK_LOG_DISABLED(level, ...)                                       \
+	do                                                                           \
+	{                                                                            \
+		if (false)                                                               \
+		{                                                                        \
+			isobus::CANStackLogger::CAN_stack_log_formatted(level, __VA_ARGS__); \
+		}                                                                        \
+	} while (false)
+
+#if CAN_STACK_LOG_COMPILED_LEVEL <= 0
+/// @brief Logs a printf style message with `Debug` severity
+#define CAN_STACK_LOG_DEBUG(...) CAN_STACK_LOG_AT_LEVEL(isobus::CANStackLogger::LoggingLevel::Debug, __VA_ARGS__)
+#else
+#define CAN_STACK_LOG_DEBUG(...) CAN_STACK_LOG_DISABLED(isobus::CANStackLogger::LoggingLevel::Debug, __VA_ARGS__)
+#endif
+
+#if CAN_STACK_LOG_COMPILED_LEVEL <= 1
+/// @brief Logs a printf style message with `Info` severity
+#define CAN_STACK_LOG_INFO(...) CAN_STACK_LOG_AT_LEVEL(isobus::CANStackLogger::LoggingLevel::Info, __VA_ARGS__)
+#else
+#define CAN_STACK_LOG_INFO(...) CAN_STACK_LOG_DISABLED(isobus::CANStackLogger::LoggingLevel::Info, __VA_ARGS__)
+#endif
+
+#if CAN_STACK_LOG_COMPILED_LEVEL <= 2
+/// @brief Logs a printf style message with `Warning` severity
+#define CAN_STACK_LOG_WARNING(...) CAN_STACK_LOG_AT_LEVEL(isobus::CANStackLogger::LoggingLevel::Warning, __VA_ARGS__)
+#else
+#define CAN_STACK_LOG_WARNING(...) CAN_STACK_LOG_DISABLED(isobus::CANStackLogger::LoggingLevel::Warning, __VA_ARGS__)
+#endif
+
+#if CAN_STACK_LOG_COMPILED_LEVEL <= 3
+/// @brief Logs a printf style message with `Error` severity
+#define CAN_STACK_LOG_ERROR(...) CAN_STACK_LOG_AT_LEVEL(isobus::CANStackLogger::LoggingLevel::Error, __VA_ARGS__)
+#else
+#define CAN_STACK_LOG_ERROR(...) CAN_STACK_LOG_DISABLED(isobus::CANStackLogger::LoggingLevel::Error, __VA_ARGS__)
+#endif
+
+#if CAN_STACK_LOG_COMPILED_LEVEL <= 4
+/// @brief Logs a printf style message with `Critical` severity
+#define CAN_STACK_LOG_CRITICAL(...) CAN_STACK_LOG_AT_LEVEL(isobus::CANStackLogger::LoggingLevel::Critical, __VA_ARGS__)
+#else
+#define CAN_STACK_LOG_CRITICAL(...) CAN_STACK_LOG_DISABLED(isobus::CANStackLogger::LoggingLevel::Critical, __VA_ARGS__)
+#endif
+
 namespace isobus
 {
 	//================================================================================================
@@ -22,6 +93,9 @@ namespace isobus
 	/// @details The CAN stack prints helpful text that may inform you of issues in either the stack
 	/// or your application. You can override a function in this class to begin consuming this
 	/// logging text.
+	/// The stack logs through the CAN_STACK_LOG_ macros, which check the level before evaluating
+	/// any arguments and format into a stack buffer, so disabled levels cost a single comparison.
+	/// Define CAN_STACK_LOG_COMPILED_LEVEL to remove the levels below it from the build entirely.
 	//================================================================================================
 	class CANStackLogger
 	{
@@ -47,6 +121,19 @@ namespace isobus
 		/// @param[in] logText The text to be logged
 		static void CAN_stack_log(LoggingLevel level, const std::string &logText);
 
+		/// @brief Formats a printf style message and logs it. Used by the CAN_STACK_LOG_ macros.
+		/// @details The message is formatted into a stack buffer, and truncated to MAXIMUM_FORMATTED_LOG_LENGTH characters.
+		/// While CANStackAsyncLogger is running, the message is stored for its background thread instead.
+		/// @param[in] level The log level for this text
+		/// @param[in] format The printf style format of the text
+		static void CAN_stack_log_formatted(LoggingLevel level, const char *format, ...) CAN_STACK_LOG_FORMAT_CHECK(2, 3);
+
+		/// @brief Returns if text logged at a level would reach the log sink
+		/// @details This doesn't lock, so it is cheap enough to check before building a message
+		/// @param[in] level The log level to check
+		/// @returns true if a log sink is set or CANStackAsyncLogger is running, and the level is at or above the current log level
+		static bool get_is_log_level_enabled(LoggingLevel level);
+
 		/// @brief Logs a string to the log sink with `Debug` severity. Wraps sink_CAN_stack_log.
 		/// @param[in] logText The text to be logged at `Debug` severity
 		static void debug(const std::string &logText);
@@ -88,14 +175,16 @@ namespace isobus
 		/// @param[in] logText The information being logged
 		virtual void sink_CAN_stack_log(LoggingLevel level, const std::string &logText);
 
+		static constexpr std::size_t MAXIMUM_FORMATTED_LOG_LENGTH = 255; ///< Formatted log text is truncated to this many characters
+
 	private:
 		/// @brief Provides a pointer to the static instance of the logger, and returns if the pointer is valid
 		/// @param[out] canStackLogger The static logger instance
 		/// @returns true if the logger is not `nullptr` or false if it is `nullptr`
 		static bool get_can_stack_logger(CANStackLogger *&canStackLogger);
 
-		static CANStackLogger *logger; ///< A static pointer to an instance of a logger
-		static LoggingLevel currentLogLevel; ///< The current log level. Logs for levels below the current one will be dropped.
+		static std::atomic<CANStackLogger *> logger; ///< A static pointer to an instance of a logger
+		static std::atomic<LoggingLevel> currentLogLevel; ///< The current log level. Logs for levels below the current one will be dropped.
 		static std::mutex loggerMutex; ///< A mutex that protects the logger so it can be used from multiple threads
 	};
 } // namespace isobus
@@ -40,9 +40,13 @@
 #include "isobus/isobus/can_protocol.hpp"
 #include "isobus/utility/processing_flags.hpp"
 
+#include <array>
+#include <limits>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace isobus
 {
@@ -251,6 +255,8 @@ namespace isobus
 		void clear_software_id_fields();
 
 		/// @brief Returns if broadcasts are suspended for the specified CAN channel (requested by DM13)
+		/// @details Received DM13s are applied to the network manager's broadcast gate, so this also reports
+		/// suspensions made with CANNetworkManager::suspend_broadcasts, unless DM1 is exempt from them.
 		/// @param[in] canChannelIndex The CAN channel to check for suspended broadcasts
 		/// @returns `true` if broadcasts should are suspended for the specified channel
 		bool get_are_broadcasts_stopped_for_channel(std::uint8_t canChannelIndex) const;
@@ -372,6 +378,43 @@ namespace isobus
 			bool nack; ///< true if we are sending a NACK instead of PACK. Determines if we use nackIndicator
 		};
 
+		static constexpr std::size_t NUMBER_OF_LAMP_STATUSES = 13; ///< The number of values in LampStatus
+
+		/// @brief The list a DTC in the DTC store is in
+		enum class DTCListMembership : std::uint8_t
+		{
+			None, ///< The DTC was cleared, and is in neither list
+			Active, ///< The DTC is in the active list
+			Inactive ///< The DTC is in the previously active list
+		};
+
+		/// @brief A DTC in the DTC store, linked to its neighbours in the list it is in
+		struct StoredDTC
+		{
+			DiagnosticTroubleCode dtc; ///< The DTC, including its occurance count
+			std::size_t previous; ///< The store index of the previous DTC in the same list, or NO_DTC
+			std::size_t next; ///< The store index of the next DTC in the same list, or NO_DTC
+			DTCListMembership membership; ///< The list the DTC is in
+		};
+
+		/// @brief A list of DTCs in the DTC store, in the order they were added to it
+		struct DTCList
+		{
+			std::size_t first; ///< The store index of the first DTC in the list, or NO_DTC
+			std::size_t last; ///< The store index of the last DTC in the list, or NO_DTC
+			std::size_t size; ///< The number of DTCs in the list
+			std::array<std::uint16_t, NUMBER_OF_LAMP_STATUSES> lampStatusCounts; ///< The number of DTCs in the list with each lamp status
+			std::vector<std::uint8_t> payload; ///< The list encoded as a DM1 or DM2 payload
+			bool payloadValid; ///< The payload matches the list, and doesn't need to be encoded again
+		};
+
+		/// @brief An identification message, encoded when its fields are set so requests only have to send it
+		struct IdentificationPayload
+		{
+			std::shared_ptr<const std::vector<std::uint8_t>> encoded; ///< The current payload, replaced as a whole when a field changes, or nullptr if there is nothing to send
+			std::shared_ptr<const std::vector<std::uint8_t>> transmitting; ///< The payload the transport protocol is sending, or nullptr if no transfer is running
+		};
+
 		static constexpr std::uint32_t DM_MAX_FREQUENCY_MS = 1000; ///< You are techically allowed to send more than this under limited circumstances, but a hard limit saves 4 RAM bytes per DTC and has BAM benefits
 		static constexpr std::uint32_t DM13_HOLD_SIGNAL_TRANSMIT_INTERVAL_MS = 5000; ///< Defined in 5.7.13.13 SPN 1236
 		static constexpr std::uint32_t DM13_TIMEOUT_MS = 6000; ///< The timout in 5.7.13 after which nodes shall revert back to the normal broadcast state
@@ -381,6 +424,7 @@ namespace isobus
 		static constexpr std::uint8_t DM13_NUMBER_OF_J1939_NETWORKS = 11; ///< The number of networks in DM13 that are set aside for J1939
 		static constexpr std::uint8_t DM13_NETWORK_BITMASK = 0x03; ///< Used to mask the network SPN values
 		static constexpr std::uint8_t DM13_BITS_PER_NETWORK = 2; ///< Number of bits for the network SPNs
+		static constexpr std::size_t NO_DTC = std::numeric_limits<std::size_t>::max(); ///< Marks the end of a DTC list
 
 		/// @brief Lists the J1939 networks by index rather than by definition in J1939-73 5.7.13
 		static constexpr Network J1939NetworkIndicies[DM13_NUMBER_OF_J1939_NETWORKS] = { Network::SAEJ1939Network1PrimaryVehicleNetwork,
@@ -410,20 +454,45 @@ namespace isobus
 		void deregister_all_pgns();
 
 		/// @brief This is a way to find the overall lamp states to report
-		/// @details This searches the active DTC list to find if a lamp is on or off, and to find the overall flash state for that lamp.
-		/// Basically, since the lamp states are global to the CAN message, we need a way to resolve the "total" lamp state from the list.
-		/// @param[in] targetLamp The lamp to find the status of
-		/// @param[out] flash How the lamp should be flashing
-		/// @param[out] lampOn If the lamp state is on for any DTC
-		void get_active_list_lamp_state_and_flash_state(Lamps targetLamp, FlashState &flash, bool &lampOn);
-
-		/// @brief This is a way to find the overall lamp states to report
-		/// @details This searches the inactive DTC list to find if a lamp is on or off, and to find the overall flash state for that lamp.
-		/// Basically, since the lamp states are global to the CAN message, we need a way to resolve the "total" lamp state from the list.
+		/// @details Basically, since the lamp states are global to the CAN message, we need a way to resolve the "total" lamp state from the list.
+		/// The lists count how many of their DTCs have each lamp status, so this doesn't have to look at the DTCs themselves.
+		/// @param[in] list The DTC list to find the lamp state of
 		/// @param[in] targetLamp The lamp to find the status of
 		/// @param[out] flash How the lamp should be flashing
 		/// @param[out] lampOn If the lamp state is on for any DTC
-		void get_inactive_list_lamp_state_and_flash_state(Lamps targetLamp, FlashState &flash, bool &lampOn);
+		void get_lamp_state_and_flash_state(const DTCList &list, Lamps targetLamp, FlashState &flash, bool &lampOn) const;
+
+		/// @brief Returns the DM1 or DM2 payload for a DTC list, encoding it again only if the list changed
+		/// @param[in] list The DTC list to get the payload of
+		/// @returns The encoded payload, including the lamp bytes
+		const std::vector<std::uint8_t> &get_dtc_list_payload(DTCList &list);
+
+		/// @brief Returns the key a DTC is stored under in the DTC store index
+		/// @param[in] dtc The DTC to get the key of
+		/// @returns A key made from the DTC's SPN, FMI, and lamp state
+		static std::uint64_t get_dtc_key(const DiagnosticTroubleCode &dtc);
+
+		/// @brief Looks up a DTC in the DTC store
+		/// @param[in] dtc The DTC to find, matched on SPN, FMI, and lamp state
+		/// @returns The store index of the DTC, or NO_DTC if it was never set
+		std::size_t find_stored_dtc(const DiagnosticTroubleCode &dtc) const;
+
+		/// @brief Finds a DTC in one of the lists by SPN and FMI only, as DM22 requests do
+		/// @param[in] suspectParameterNumber The SPN of the DTC to find
+		/// @param[in] failureModeIdentifier The FMI of the DTC to find
+		/// @param[in] list The list to search
+		/// @returns The store index of the first matching DTC, or NO_DTC if there is none
+		std::size_t find_listed_dtc(std::uint32_t suspectParameterNumber, std::uint8_t failureModeIdentifier, DTCListMembership list) const;
+
+		/// @brief Moves a DTC in the store to the end of another list, or out of both lists
+		/// @param[in] index The store index of the DTC to move
+		/// @param[in] target The list to move the DTC to
+		void move_stored_dtc(std::size_t index, DTCListMembership target);
+
+		/// @brief Returns one of the DTC lists
+		/// @param[in] list Which list to return, active or inactive
+		/// @returns The requested list
+		DTCList &get_dtc_list(DTCListMembership list);
 
 		/// @brief The network manager calls this to see if the protocol can accept a non-raw CAN message for processing
 		/// @note In this protocol, we do not accept messages from the network manager for transmission
@@ -478,6 +547,55 @@ namespace isobus
 		/// @returns true if the message was sent, otherwise false
 		bool send_software_identification();
 
+		/// @brief Sends one of the pre-encoded identification messages
+		/// @details Payloads longer than a CAN frame are sent by the transport protocol straight from the
+		/// shared payload, which is kept alive until the transfer ends even if a field changes meanwhile
+		/// @param[in] parameterGroupNumber The PGN of the identification message
+		/// @param[in] payload The identification payload to send
+		/// @returns true if the message was sent, otherwise false
+		bool send_identification(std::uint32_t parameterGroupNumber, IdentificationPayload &payload);
+
+		/// @brief Encodes the ECU ID fields into the ECU ID payload
+		void encode_ecu_identification();
+
+		/// @brief Encodes the product identification strings into the product identification payload
+		void encode_product_identification();
+
+		/// @brief Encodes the software ID fields into the software ID payload
+		void encode_software_identification();
+
+		/// @brief Replaces an identification payload with a newly encoded one
+		/// @param[in] payload The identification payload to replace
+		/// @param[in] encodedString The new payload, or an empty string for no payload
+		void set_identification_payload(IdentificationPayload &payload, const std::string &encodedString);
+
+		/// @brief Copies a chunk of an identification payload into a transport protocol frame
+		/// @param[in] callbackIndex The number of times the callback has been called for this transfer
+		/// @param[in] bytesOffset The offset of the chunk in the payload
+		/// @param[in] numberOfBytesNeeded The number of bytes to copy
+		/// @param[out] chunkBuffer The buffer to copy the chunk into
+		/// @param[in] parentPointer A pointer to the identification payload being sent
+		/// @returns true if the chunk was copied
+		static bool process_identification_chunk(std::uint32_t callbackIndex,
+		                                         std::uint32_t bytesOffset,
+		                                         std::uint32_t numberOfBytesNeeded,
+		                                         std::uint8_t *chunkBuffer,
+		                                         void *parentPointer);
+
+		/// @brief Releases an identification payload once the transport protocol is done sending it
+		/// @param[in] parameterGroupNumber The PGN of the identification message
+		/// @param[in] dataLength The length of the payload
+		/// @param[in] sourceControlFunction The control function that sent the message
+		/// @param[in] destinationControlFunction The destination of the message
+		/// @param[in] successful true if the transfer completed
+		/// @param[in] parentPointer A pointer to the identification payload that was sent
+		static void process_identification_transmit_complete(std::uint32_t parameterGroupNumber,
+		                                                     std::uint32_t dataLength,
+		                                                     InternalControlFunction *sourceControlFunction,
+		                                                     ControlFunction *destinationControlFunction,
+		                                                     bool successful,
+		                                                     void *parentPointer);
+
 		/// @brief Processes any DM22 responses from the queue
 		/// @details We queue responses so that we can do Tx retries if needed
 		/// @returns true if queue was completely processed, false if messages remain that could not be sent
@@ -524,8 +642,10 @@ namespace isobus
 		static std::list<DiagnosticProtocol *> diagnosticProtocolList; ///< List of all diagnostic protocol instances (one per ICF)
 
 		std::shared_ptr<InternalControlFunction> myControlFunction; ///< The internal control function that this protocol will send from
-		std::vector<DiagnosticTroubleCode> activeDTCList; ///< Keeps track of all the active DTCs
-		std::vector<DiagnosticTroubleCode> inactiveDTCList; ///< Keeps track of all the previously active DTCs
+		std::vector<StoredDTC> dtcStore; ///< Every DTC that was ever set. Entries are never removed, so indices stay valid
+		std::unordered_map<std::uint64_t, std::size_t> dtcStoreIndex; ///< Maps DTC keys to their index in the DTC store
+		DTCList activeDTCList; ///< Keeps track of all the active DTCs
+		DTCList inactiveDTCList; ///< Keeps track of all the previously active DTCs
 		std::vector<DM22Data> dm22ResponseQueue; ///< Maintaining a list of DM22 responses we need to send to allow for retrying in case of Tx failures
 		std::vector<std::string> ecuIdentificationFields; ///< Stores the ECU ID fields so we can transmit them when ECUID's PGN is requested
 		std::vector<std::string> softwareIdentificationFields; ///< Stores the Software ID fields so we can transmit them when the PGN is requested
@@ -533,6 +653,10 @@ namespace isobus
 		std::string productIdentificationCode; ///< The product identification code for sending the product identification message
 		std::string productIdentificationBrand; ///< The product identification brand for sending the product identification message
 		std::string productIdentificationModel; ///< The product identification model name for sending the product identification message
+		IdentificationPayload ecuIdentificationPayload; ///< The encoded ECU ID message
+		IdentificationPayload softwareIdentificationPayload; ///< The encoded software ID message
+		IdentificationPayload productIdentificationPayload; ///< The encoded product identification message
+		std::mutex identificationMutex; ///< Protects the encoded identification payloads, which are set from the application's thread
 		std::uint32_t lastDM1SentTimestamp; ///< A timestamp in milliseconds of the last time a DM1 was sent
 		std::uint32_t stopBroadcastNetworkBitfield; ///< Bitfield for tracking the network broadcast states for DM13
 		std::uint32_t lastDM13ReceivedTimestamp; ///< A timestamp in milliseconds when we last got a DM13 message
@@ -0,0 +1,203 @@
+//================================================================================================
+/// @file isobus_diagnostic_trouble_code_reader.hpp
+///
+/// @brief Defines a class that collects the DTCs that other ECUs on the bus report
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#ifndef ISOBUS_DIAGNOSTIC_TROUBLE_CODE_READER_HPP
+#define ISOBUS_DIAGNOSTIC_TROUBLE_CODE_READER_HPP
+
+#include "isobus/isobus/can_internal_control_function.hpp"
+#include "isobus/isobus/can_message.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace isobus
+{
+	//================================================================================================
+	/// @class DiagnosticTroubleCodeReader
+	///
+	/// @brief Collects the DM1 and DM2 messages of every ECU on the bus into a table of active and
+	/// previously active DTCs per source address
+	/// @details Single frame and BAM/TP messages are both decoded. Each time an ECU's list changes,
+	/// the reader calls the registered callbacks once per DTC that was added, removed, or had its
+	/// occurrence count change. Decoding reuses the reader's buffers, so steady traffic doesn't allocate.
+	/// ECUs that stop sending DM1 are treated as having no active DTCs after DM1_TIMEOUT_MS, so call
+	/// update cyclically.
+	//================================================================================================
+	class DiagnosticTroubleCodeReader
+	{
+	public:
+		/// @brief The lists of DTCs an ECU reports
+		enum class DTCListType : std::uint8_t
+		{
+			Active, ///< The DTCs reported in DM1
+			PreviouslyActive ///< The DTCs reported in DM2
+		};
+
+		/// @brief The ways a DTC in an ECU's list can change
+		enum class DTCEventType : std::uint8_t
+		{
+			Added, ///< The DTC was not in the list before
+			Removed, ///< The DTC is no longer in the list
+			OccurrenceCountChanged ///< The DTC is still in the list with a new occurrence count
+		};
+
+		/// @brief A DTC as reported by another ECU
+		struct ReceivedDTC
+		{
+			std::uint32_t suspectParameterNumber; ///< The 19 bit SPN
+			std::uint8_t failureModeIdentifier; ///< The 5 bit FMI
+			std::uint8_t occurrenceCount; ///< The 7 bit occurrence count, 127 if not available
+		};
+
+		/// @brief Describes one change to an ECU's DTCs
+		struct DTCEvent
+		{
+			ReceivedDTC dtc; ///< The DTC that changed. For removed DTCs, the last values that were reported
+			std::uint8_t canPort; ///< The CAN channel the ECU is on
+			std::uint8_t sourceAddress; ///< The address of the ECU
+			DTCListType list; ///< The list that changed
+			DTCEventType type; ///< What happened to the DTC
+		};
+
+		/// @brief A callback for changes to the DTCs of any ECU
+		typedef void (*DTCEventCallback)(const DTCEvent &event, void *parentPointer);
+
+		static constexpr std::uint32_t DM1_TIMEOUT_MS = 3000; ///< An ECU's active DTCs are cleared if it sends no DM1 for this long
+
+		/// @brief Constructor for a reader, which starts listening for DM1 and DM2 messages right away
+		DiagnosticTroubleCodeReader();
+
+		/// @brief Destructor for a reader, which stops listening
+		~DiagnosticTroubleCodeReader();
+
+		/// @brief The reader registers itself with the network manager, so it can't be copied
+		DiagnosticTroubleCodeReader(const DiagnosticTroubleCodeReader &) = delete;
+
+		/// @brief The reader registers itself with the network manager, so it can't be copied
+		/// @returns A reference to the reader
+		DiagnosticTroubleCodeReader &operator=(const DiagnosticTroubleCodeReader &) = delete;
+
+		/// @brief Clears the active DTCs of ECUs that stopped sending DM1
+		void update();
+
+		/// @brief Adds a callback for changes to the DTCs of any ECU
+		/// @details Callbacks are called from the thread that processes received CAN messages, or from the
+		/// thread calling update for timeouts, with the DTC table and callback list unlocked. They may call
+		/// the reader's getters and add or remove callbacks, but not update.
+		/// @param[in] callback The callback to add
+		/// @param[in] parentPointer A generic context variable passed back to the callback
+		void add_dtc_event_callback(DTCEventCallback callback, void *parentPointer);
+
+		/// @brief Removes a callback added with add_dtc_event_callback
+		/// @param[in] callback The callback to remove
+		/// @param[in] parentPointer The context variable the callback was added with
+		void remove_dtc_event_callback(DTCEventCallback callback, void *parentPointer);
+
+		/// @brief Requests the previously active DTCs (DM2) of one or all ECUs
+		/// @param[in] source The internal control function to send the request from
+		/// @param[in] destination The ECU to request DM2 from, or nullptr to request it from every ECU
+		/// @returns true if the request was sent
+		static bool request_previously_active_dtcs(InternalControlFunction *source, ControlFunction *destination);
+
+		/// @brief Requests that one or all ECUs clear their active DTCs (DM11)
+		/// @details The ECUs report their new active DTCs in their next DM1
+		/// @param[in] source The internal control function to send the request from
+		/// @param[in] destination The ECU to clear the DTCs of, or nullptr to clear them on every ECU
+		/// @returns true if the request was sent
+		static bool request_clear_active_dtcs(InternalControlFunction *source, ControlFunction *destination);
+
+		/// @brief Returns the number of ECUs that reported DTCs or DM1 since the reader was created
+		/// @returns The number of ECUs in the DTC table
+		std::uint32_t get_number_known_sources();
+
+		/// @brief Copies the DTCs an ECU last reported in one of its lists
+		/// @param[in] canPort The CAN channel the ECU is on
+		/// @param[in] sourceAddress The address of the ECU
+		/// @param[in] list The list to copy
+		/// @param[out] dtcs The DTCs, in the order the ECU reported them. Its memory is reused.
+		/// @returns true if the ECU is known, false if it never reported the list
+		bool get_dtcs(std::uint8_t canPort, std::uint8_t sourceAddress, DTCListType list, std::vector<ReceivedDTC> &dtcs);
+
+		/// @brief Returns the J1939 lamp bytes of an ECU's last DM1
+		/// @param[in] canPort The CAN channel the ECU is on
+		/// @param[in] sourceAddress The address of the ECU
+		/// @param[out] lampStatus The lamp status in the low byte and the flash status in the high byte
+		/// @returns true if the ECU has sent a DM1
+		bool get_lamp_status(std::uint8_t canPort, std::uint8_t sourceAddress, std::uint16_t &lampStatus);
+
+	private:
+		/// @brief The DTCs one ECU reported
+		struct SourceDTCs
+		{
+			std::vector<ReceivedDTC> activeDTCs; ///< The DTCs from the last DM1
+			std::vector<ReceivedDTC> previouslyActiveDTCs; ///< The DTCs from the last DM2
+			std::uint32_t lastDM1Timestamp_ms; ///< When the last DM1 was received, or 0 if none was
+			std::uint16_t key; ///< The CAN channel in the high byte and the source address in the low byte
+			std::uint16_t lampStatus; ///< The lamp bytes of the last DM1
+			bool dm1Received; ///< If any DM1 was received
+			bool dm2Received; ///< If any DM2 was received
+		};
+
+		/// @brief A registered DTC event callback
+		struct CallbackInfo
+		{
+			DTCEventCallback callback; ///< The callback
+			void *parent; ///< The context variable for the callback
+		};
+
+		/// @brief Processes DM1 and DM2 messages from any ECU
+		/// @param[in] message The received message
+		/// @param[in] parentPointer A pointer to the reader
+		static void process_rx_message(CANMessage *message, void *parentPointer);
+
+		/// @brief Decodes a DM1 or DM2 message and updates the source's list
+		/// @param[in] message The received message
+		/// @param[in] list Which list the message reports
+		void process_dtc_message(CANMessage *message, DTCListType list);
+
+		/// @brief Replaces a list with newly decoded DTCs, recording an event for each difference
+		/// @param[in] source The ECU the list belongs to
+		/// @param[in] list Which list to replace
+		/// @param[in] newDTCs The DTCs the ECU just reported
+		void replace_list(SourceDTCs &source, DTCListType list, const std::vector<ReceivedDTC> &newDTCs);
+
+		/// @brief Finds the DTCs of an ECU, adding an entry if it isn't known yet
+		/// @param[in] key The CAN channel in the high byte and the source address in the low byte
+		/// @returns The ECU's DTCs
+		SourceDTCs &get_or_add_source(std::uint16_t key);
+
+		/// @brief Finds the DTCs of an ECU
+		/// @param[in] key The CAN channel in the high byte and the source address in the low byte
+		/// @returns The ECU's DTCs, or nullptr if it isn't known
+		const SourceDTCs *find_source(std::uint16_t key) const;
+
+		/// @brief Calls the callbacks for every recorded event, then forgets the events
+		/// @details The callbacks are called after the processing lock is released and without holding the
+		/// callback list lock, so they may use the reader's getters and add or remove callbacks.
+		/// @param[in] processingLock The held lock on processingMutex, which is released before the callbacks are called
+		void send_pending_events(std::unique_lock<std::mutex> &processingLock);
+
+		static constexpr std::uint8_t DM_LAMP_BYTES = 2; ///< The lamp and flash bytes at the start of DM1 and DM2
+		static constexpr std::uint8_t DM_PAYLOAD_BYTES_PER_DTC = 4; ///< The number of payload bytes per DTC
+
+		std::vector<SourceDTCs> sources; ///< The DTCs of each ECU, sorted by key
+		std::vector<ReceivedDTC> decodedDTCs; ///< The DTCs of the message being processed, reused for each message
+		std::vector<DTCEvent> pendingEvents; ///< The changes found while processing a message, reused for each message
+		std::vector<DTCEvent> sendingEvents; ///< The events being passed to the callbacks, reused for each message
+		std::vector<CallbackInfo> callbacks; ///< The registered DTC event callbacks
+		std::vector<CallbackInfo> sendingCallbacks; ///< A copy of the callbacks taken for each batch of events, reused for each message
+		std::mutex sourcesMutex; ///< Protects the DTC table, which the getters read from other threads
+		std::mutex processingMutex; ///< Serializes processing messages and timeouts, and protects the pending events
+		std::mutex callbacksMutex; ///< Protects the callback list
+		std::mutex sendingMutex; ///< Keeps events in order while they are passed to the callbacks, and protects the copies used to send them
+	};
+} // namespace isobus
+
+#endif // ISOBUS_DIAGNOSTIC_TROUBLE_CODE_READER_HPP
@@ -11,9 +11,15 @@
 
 #include "isobus/isobus/can_internal_control_function.hpp"
 #include "isobus/isobus/can_partnered_control_function.hpp"
+#include "isobus/isobus/isobus_virtual_terminal_graphics_context_batch.hpp"
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_scale_cache.hpp"
 #include "isobus/utility/processing_flags.hpp"
 
+#include <array>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -431,9 +437,10 @@ namespace isobus
 		/// This pertains to the visibility of the object as well as its
 		/// remembered state.If the object cannot be displayed due to references to missing
 		/// objects, the VT generates an error in the response.
+		/// The command is queued, see send_change_numeric_value.
 		/// @param[in] objectID The ID of the target object
 		/// @param[in] command The target hide/show state of the object
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_hide_show_object(std::uint16_t objectID, HideShowObjectCommand command);
 
 		/// @brief Sends an enable/disable object command
@@ -441,9 +448,10 @@ namespace isobus
 		/// or a Button object and pertains to the accessibility of an input field
 		/// object or Button object.This command is also used to enable or disable an Animation object.
 		/// It is allowed to enable already enabled objects and to disable already disabled objects.
+		/// The command is queued, see send_change_numeric_value.
 		/// @param[in] objectID The ID of the target object
 		/// @param[in] command The target enable/disable state of the object
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_enable_disable_object(std::uint16_t objectID, EnableDisableObjectCommand command);
 
 		/// @brief Sends a select input object command
@@ -529,9 +537,13 @@ namespace isobus
 		/// @brief Sends the change numeric value command
 		/// @details The size of the object shall not be changed by this command. Only the object indicated in the
 		/// command is to be changed, variables referenced by the object are not changed.
+		/// The command is queued and sent when the VT has responded to our previous command. If a change for the
+		/// same object is still waiting in the queue, it is replaced by this one. Object state commands, like hide/show,
+		/// the attribute changes, change active mask and change soft key mask, share the queue so they reach the VT in order.
+		/// Commands can only be queued while the client is connected.
 		/// @param[in] objectID The ID of the target object
 		/// @param[in] value The new numeric value of the object
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_numeric_value(std::uint16_t objectID, std::uint32_t value);
 
 		/// @brief Sends the change string value command
@@ -539,10 +551,12 @@ namespace isobus
 		/// command is to be changed, variables referenced by the object are not changed.
 		/// The transferred string is allowed to be smaller than the length of the value attribute of the target object and in
 		/// this case the VT shall pad the value attribute with space characters.
+		/// The command is queued and sent when the VT has responded to our previous command. If a change for the
+		/// same object is still waiting in the queue, it is replaced by this one.
 		/// @param[in] objectID The ID of the target object
 		/// @param[in] stringLength The length of the string to be sent
 		/// @param[in] value The string to be sent
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_string_value(std::uint16_t objectID, uint16_t stringLength, const char *value);
 
 		/// @brief Sends the change string value command (with a c++ string instead of buffer + length)
@@ -550,71 +564,81 @@ namespace isobus
 		/// command is to be changed, variables referenced by the object are not changed.
 		/// The transferred string is allowed to be smaller than the length of the value attribute of the target object and in
 		/// this case the VT shall pad the value attribute with space characters.
+		/// The command is queued and sent when the VT has responded to our previous command. If a change for the
+		/// same object is still waiting in the queue, it is replaced by this one.
 		/// @param[in] objectID The ID of the target object
 		/// @param[in] value The string to be sent
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_string_value(std::uint16_t objectID, const std::string &value);
 
 		/// @brief Sends the change endpoint command, which changes the end of an output line
+		/// @details The command is queued, see send_change_numeric_value.
 		/// @param[in] objectID The ID of the target object
 		/// @param[in] width_px The width to change the output line to
 		/// @param[in] height_px The height to change the output line to
 		/// @param[in] direction The line direction (refer to output line object attributes)
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_endpoint(std::uint16_t objectID, std::uint16_t width_px, std::uint16_t height_px, LineDirection direction);
 
 		/// @brief Sends the change font attributes command
 		/// @details This command is used to change the Font Attributes in a Font Attributes object.
+		/// The command is queued, see send_change_numeric_value.
 		/// @param[in] objectID The ID of the target object
 		/// @param[in] color See the standard VT colour palette for more details
 		/// @param[in] size Font size
 		/// @param[in] type Font Type
 		/// @param[in] styleBitfield The font style encoded as a bitfield
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_font_attributes(std::uint16_t objectID, std::uint8_t color, FontSize size, std::uint8_t type, std::uint8_t styleBitfield);
 
 		/// @brief Sends the change line attributes command
 		/// @details This command is used to change the Line Attributes in a Line Attributes object.
+		/// The command is queued, see send_change_numeric_value.
 		/// @param[in] objectID The ID of the target object
 		/// @param[in] color See the standard VT colour palette for more details
 		/// @param[in] width The line width
 		/// @param[in] lineArtBitmask The line art, encoded as a bitfield (See ISO11783-6 for details)
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_line_attributes(std::uint16_t objectID, std::uint8_t color, std::uint8_t width, std::uint16_t lineArtBitmask);
 
 		/// @brief Sends the change fill attributes command
 		/// @details This command is used to change the Fill Attributes in a Fill Attributes object.
+		/// The command is queued, see send_change_numeric_value.
 		/// @param[in] objectID The ID of the target object
 		/// @param[in] fillType The fill type
 		/// @param[in] color See the standard VT colour palette for more details
 		/// @param[in] fillPatternObjectID Object ID to a fill pattern or NULL_OBJECT_ID
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_fill_attributes(std::uint16_t objectID, FillType fillType, std::uint8_t color, std::uint16_t fillPatternObjectID);
 
 		/// @brief Sends the change active mask command
 		/// @details This command is used to change the active mask of a Working Set
 		/// to either a Data Mask object or an Alarm Mask object.
+		/// The command is queued, see send_change_numeric_value. A queued change for the same working set is replaced by this one.
 		/// @param[in] workingSetObjectID The ID of the working set
 		/// @param[in] newActiveMaskObjectID The object ID of the new active mask
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_active_mask(std::uint16_t workingSetObjectID, std::uint16_t newActiveMaskObjectID);
 
 		/// @brief Sends the change softkey mask command
 		/// @details This command is used to change the Soft Key Mask associated with a
 		/// Data Mask object or an Alarm Mask object.
+		/// The command is queued, see send_change_numeric_value. A queued change for the same mask is replaced by this one.
 		/// @param[in] type The mask type, alarm or data
 		/// @param[in] dataOrAlarmMaskObjectID The object ID of the target mask
 		/// @param[in] newSoftKeyMaskObjectID The object ID of the new softkey mask
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_softkey_mask(MaskType type, std::uint16_t dataOrAlarmMaskObjectID, std::uint16_t newSoftKeyMaskObjectID);
 
 		/// @brief Sends the change attribute command
 		/// @details This command is used to change any attribute with an assigned Attribute ID.
 		/// This message cannot be used to change strings.
+		/// The command is queued and sent when the VT has responded to our previous command. If a change for the
+		/// same object and attribute is still waiting in the queue, it is replaced by this one.
 		/// @param[in] objectID The ID of the target object
 		/// @param[in] attributeID The attribute ID of the attribute being changed
 		/// @param[in] value The new attribute value
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_attribute(std::uint16_t objectID, std::uint8_t attributeID, std::uint32_t value);
 
 		/// @brief Sends the change priority command
@@ -623,9 +647,10 @@ namespace isobus
 		/// may cause a change to a different mask if the Alarm Mask being changed
 		/// should either become the active Working Set and mask,
 		/// or should no longer be the active Working Set and mask.
+		/// The command is queued, see send_change_numeric_value.
 		/// @param[in] alarmMaskObjectID The object ID of the target alarm mask
 		/// @param[in] priority The new priority for the mask
-		/// @returns true if the message was sent successfully
+		/// @returns true if the command was queued successfully
 		bool send_change_priority(std::uint16_t alarmMaskObjectID, AlarmMaskPriority priority);
 
 		/// @brief Sends the change list item command
@@ -921,6 +946,15 @@ namespace isobus
 		/// @returns true if the message was sent successfully
 		bool send_copy_viewport_to_picture_graphic(std::uint16_t graphicsContextObjectID, std::uint16_t objectID);
 
+		/// @brief Queues the drawing operations recorded in a batch to be sent to its graphics context
+		/// @details The batch is encoded into as few messages as possible and emptied. The messages are
+		/// sent in order by the worker thread, and a message that needs a transport session is finished
+		/// before the next one is started so that nothing is drawn out of order.
+		/// @param[in] batch The batch to send
+		/// If the client is not connected, the batch keeps its recorded commands so they can be sent later.
+		/// @returns true if the batch was queued, false if it was empty or the client is not connected
+		bool send_graphics_context_batch(VirtualTerminalGraphicsContextBatch &batch);
+
 		// VT Querying
 		/// @brief Sends the get attribute value message
 		/// @param[in] objectID The object ID to query
@@ -928,6 +962,35 @@ namespace isobus
 		/// @returns true if the message was sent successfully
 		bool send_get_attribute_value(std::uint16_t objectID, std::uint8_t attributeID);
 
+		/// @brief Reads an attribute from the client's mirror of the objects on the VT
+		/// @details The mirror is updated whenever the VT accepts a change attribute command, and whenever
+		/// the VT responds to a get attribute value message. If the attribute isn't in the mirror yet, a get
+		/// attribute value message is sent, and the value can be read from the mirror once the VT responds.
+		/// Reading the attribute again before then doesn't send another message, unless the VT hasn't
+		/// responded within COMMAND_RESPONSE_TIMEOUT_MS.
+		/// @param[in] objectID The object ID to read
+		/// @param[in] attributeID The attribute to read
+		/// @param[out] value The current value of the attribute
+		/// @returns true if the value was in the mirror, false if the VT had to be asked for it
+		bool get_attribute_value(std::uint16_t objectID, std::uint8_t attributeID, std::uint32_t &value);
+
+		/// @brief Reads the value of a numeric object from the client's mirror of the objects on the VT
+		/// @details Values are seeded from the object pool when the client connects, and are updated whenever
+		/// the VT accepts a change numeric value command or reports that the operator changed a value.
+		/// Objects that take their value from a number variable are not seeded, read the variable object instead.
+		/// @param[in] objectID The object ID to read
+		/// @param[out] value The current value of the object
+		/// @returns true if the value was in the mirror
+		bool get_numeric_value(std::uint16_t objectID, std::uint32_t &value);
+
+		/// @brief Reads the value of a string object from the client's mirror of the objects on the VT
+		/// @details Values are seeded from the object pool when the client connects, and are updated whenever
+		/// the VT accepts a change string value command or reports that the operator changed a value.
+		/// @param[in] objectID The object ID to read
+		/// @param[out] value The current value of the object
+		/// @returns true if the value was in the mirror
+		bool get_string_value(std::uint16_t objectID, std::string &value);
+
 		// Get Softkeys Response
 		/// @brief Returns the number of X axis pixels in a softkey
 		/// @returns The number of X axis pixels in a softkey
@@ -1010,6 +1073,33 @@ namespace isobus
 		/// @returns true if the VT version is supported by the VT server
 		bool get_vt_version_supported(VTVersion value) const;
 
+		/// @brief Round trip statistics for one kind of queued VT command
+		struct CommandStatistics
+		{
+			std::uint32_t numberOfResponses; ///< The number of commands the VT responded to
+			std::uint32_t numberOfRetries; ///< The number of times a command was sent again because the VT didn't respond in time
+			std::uint32_t numberOfTimeouts; ///< The number of commands dropped because the VT never responded
+			std::uint32_t minimumLatency_ms; ///< The shortest time between sending a command and its response
+			std::uint32_t maximumLatency_ms; ///< The longest time between sending a command and its response
+			std::uint64_t totalLatency_ms; ///< The sum of all round trip times, divide by numberOfResponses for the average
+		};
+
+		/// @brief Returns the round trip statistics for one kind of queued command
+		/// @details Only the commands that go through the command queue are tracked. Those are the object
+		/// state commands, like change numeric value, change string value, change attribute and change active mask.
+		/// @param[in] functionCode The VT function code of the command, for example 0xA8 for change numeric value
+		/// @returns The statistics collected since the client was created
+		CommandStatistics get_command_statistics(std::uint8_t functionCode);
+
+		/// @brief Sets how many queued commands may wait for a VT response at the same time
+		/// @details ISO 11783-6 expects a working set to wait for the response to one command before sending
+		/// the next, which is the default. Some VTs can buffer several commands, which lets a busy application
+		/// keep them saturated. The limit only applies to VTs that support at least the specified version,
+		/// all other VTs get one command at a time.
+		/// @param[in] value The maximum number of commands in flight, at least 1
+		/// @param[in] minimumVTVersion The minimum VT version the VT server must support for the limit to apply
+		void set_maximum_commands_in_flight(std::uint8_t value, VTVersion minimumVTVersion);
+
 		// ************************************************
 		// Object Pool Interface
 		// ************************************************
@@ -1051,12 +1141,71 @@ namespace isobus
 		/// @param[in] value The data callback that will be used to get object pool data to upload.
 		void register_object_pool_data_chunk_callback(std::uint8_t poolIndex, VTVersion poolSupportedVTVersion, std::uint32_t poolTotalSize, DataChunkCallback value);
 
+		/// @brief Scales object pools to the connected VT's resolution as they are uploaded
+		/// @details Sizes and positions are scaled from the sizes the pool was designed for to the data mask and
+		/// soft key sizes reported by the VT, and fonts are swapped for the closest font size the VT supports.
+		/// The pool itself is never modified, so one pool buffer can be shared by clients for several VTs, and the
+		/// scaled variant for each resolution is only prepared once. Only pools assigned with a buffer are scaled, pools that are
+		/// uploaded through a data chunk callback are uploaded as is. Pass 0 for all sizes to disable scaling.
+		/// @param[in] originalDataMaskSize_px The data mask width and height the pools were designed for
+		/// @param[in] originalSoftKeyWidth_px The soft key width the pools were designed for
+		/// @param[in] originalSoftKeyHeight_px The soft key height the pools were designed for
+		void set_object_pool_scaling(std::uint16_t originalDataMaskSize_px, std::uint16_t originalSoftKeyWidth_px, std::uint16_t originalSoftKeyHeight_px);
+
+		/// @brief Supplies the last version of an object pool that was stored on VTs, so that only changed objects are uploaded
+		/// @details If the VT doesn't have the current pool's version label but does have this one, the client loads
+		/// this version, uploads only the objects that are new or different from it, and then stores the current pool
+		/// under its own label. This needs a VT that supports version 4 or later, and both pools must be assigned
+		/// with a buffer. Otherwise the whole pool is uploaded as usual.
+		/// @param[in] poolIndex The index of the pool the stored version belongs to
+		/// @param[in] pool A pointer to the stored version of the pool. Must remain valid until client is connected!
+		/// @param[in] size The size of the stored version of the pool
+		/// @param[in] version The version label the stored version was saved under. Must be the same for all pools!
+		void set_object_pool_delta_base(std::uint8_t poolIndex, const std::uint8_t *pool, std::uint32_t size, std::string version);
+
 		/// @brief Periodic Update Function (worker thread may call this)
 		/// @details This class can spawn a thread, or you can supply your own to run this function.
 		/// To configure that behavior, see the initialize function.
 		void update();
 
 	private:
+		/// @brief A command waiting in the outbound command queue
+		struct QueuedCommand
+		{
+			std::vector<std::uint8_t> data; ///< The full command payload, starting with the function code
+			std::uint16_t objectID; ///< The object ID the command targets
+			std::uint8_t attributeID; ///< The attribute ID the command targets, or 0xFF if it doesn't target an attribute
+		};
+
+		/// @brief An attribute or numeric value in the mirror of the objects on the VT
+		struct MirroredAttribute
+		{
+			std::uint32_t key; ///< The object ID in the upper bits and the attribute ID in the lowest byte
+			std::uint32_t value; ///< The attribute's current value
+		};
+
+		/// @brief A string value in the mirror of the objects on the VT
+		struct MirroredString
+		{
+			std::uint16_t objectID; ///< The object ID of the string object
+			std::string value; ///< The object's current value
+		};
+
+		/// @brief A get attribute value message the VT hasn't answered yet
+		struct PendingAttributeQuery
+		{
+			std::uint32_t key; ///< The object ID in the upper bits and the attribute ID in the lowest byte
+			std::uint32_t timestamp_ms; ///< When the query was sent
+		};
+
+		/// @brief A queued command that was sent and is waiting for the VT to respond
+		struct InFlightCommand
+		{
+			QueuedCommand command; ///< The command that was sent
+			std::uint32_t sentTimestamp_ms; ///< When the command was last sent
+			std::uint8_t retries; ///< How many times the command has been sent again
+		};
+
 		/// @brief The internal state machine state of the VT client
 		enum class StateMachineState : std::uint8_t
 		{
@@ -1219,6 +1368,13 @@ namespace isobus
 			bool uploaded; ///< The upload state of this pool
 		};
 
+		/// @brief The previously stored version of an object pool, used to upload only changed objects
+		struct ObjectPoolDeltaBase
+		{
+			const std::uint8_t *objectPoolDataPointer; ///< A pointer to the stored version of the pool
+			std::uint32_t objectPoolSize; ///< The size of the stored version of the pool
+		};
+
 		/// @brief A struct for storing information about an auxiliary input device
 		struct AuxiliaryInputDevice
 		{
@@ -1287,6 +1443,11 @@ namespace isobus
 		/// @returns true if the message was sent
 		bool send_delete_version(std::array<std::uint8_t, 7> versionLabel);
 
+		/// @brief Pads or truncates a version label to the 7 characters sent to the VT
+		/// @param[in] label The version label
+		/// @returns The version label, padded with spaces
+		static std::array<std::uint8_t, 7> get_version_label_buffer(const std::string &label);
+
 		/// @brief Sends the get extended versions message
 		/// @returns true if the message was sent
 		bool send_extended_get_versions();
@@ -1325,6 +1486,75 @@ namespace isobus
 		/// @returns true if the message was sent successfully
 		bool send_aux_n_assignment_response(std::uint16_t functionObjectID, bool hasError, bool isAlreadyAssigned);
 
+		/// @brief Adds a command to the outbound command queue, replacing any queued command with the same target
+		/// @details Commands are matched on their function code, object ID, and attribute ID. A replaced command
+		/// keeps its place in the queue so that frequently updated objects cannot starve the others.
+		/// The command is written into a buffer that is reused after the VT responds, so that commands
+		/// sent at a steady rate don't allocate memory.
+		/// Commands can only be queued while connected, and the queue is cleared when the connection ends.
+		/// @param[in] header The start of the command payload, starting with the function code
+		/// @param[in] headerLength The number of bytes in the header, at least 1
+		/// @param[in] payload Bytes to send after the header, such as a string value, or nullptr if there are none
+		/// @param[in] payloadLength The number of bytes in the payload
+		/// @param[in] objectID The object ID the command targets, like the working set for change active mask
+		/// @param[in] attributeID The attribute ID the command targets, or 0xFF if it doesn't target an attribute
+		/// @returns true if the command was queued, false if the client isn't connected or the command is invalid
+		bool queue_command(const std::uint8_t *header, std::uint8_t headerLength, const std::uint8_t *payload, std::uint16_t payloadLength, std::uint16_t objectID, std::uint8_t attributeID);
+
+		/// @brief Retries or drops commands the VT hasn't responded to, then sends queued commands while there is room in flight
+		void process_command_queue();
+
+		/// @brief Sends queued graphics context messages until one needs a transport session or the bus is busy
+		void process_graphics_context_queue();
+
+		/// @brief Matches a VT response to a command in flight and records its round trip time
+		/// @param[in] message The VT to ECU message that might be a response
+		void process_command_response(CANMessage *message);
+
+		/// @brief Checks if two queued commands change the same thing on the same object
+		/// @param[in] first The first command to compare
+		/// @param[in] second The second command to compare
+		/// @returns true if the commands have the same function code, object ID, and attribute ID
+		static bool get_is_same_command_target(const QueuedCommand &first, const QueuedCommand &second);
+
+		/// @brief Sends a queued command to the VT
+		/// @details Commands longer than one frame are copied to the transfer buffer and streamed from there
+		/// by the transport protocol, so only one of them can be sent at a time.
+		/// @param[in] data The full command payload
+		/// @returns true if the message was sent
+		bool send_queued_command(const std::vector<std::uint8_t> &data);
+
+		/// @brief Checks if a command longer than one frame is still being sent
+		/// @returns true if the transfer buffer is in use
+		bool get_is_transfer_in_progress();
+
+		/// @brief Returns a buffer for a new queued command, reusing one from an earlier command if possible
+		/// @returns An empty buffer, which might already have memory reserved
+		std::vector<std::uint8_t> get_spare_command_buffer();
+
+		/// @brief Updates the attribute mirror with a command the VT accepted
+		/// @param[in] command The command that was sent
+		/// @param[in] response The VT's response to the command
+		void update_attribute_mirror(const QueuedCommand &command, CANMessage *response);
+
+		/// @brief Stores an attribute or numeric value in the attribute mirror
+		/// @details A pending get attribute value query for the attribute is answered by this.
+		/// @param[in] objectID The object ID the value belongs to
+		/// @param[in] attributeID The attribute ID, or VALUE_ATTRIBUTE_ID for the object's value
+		/// @param[in] value The value to store
+		void set_mirrored_attribute(std::uint16_t objectID, std::uint8_t attributeID, std::uint32_t value);
+
+		/// @brief Stores a string value in the attribute mirror
+		/// @param[in] objectID The object ID the value belongs to
+		/// @param[in] value The value to store
+		void set_mirrored_string(std::uint16_t objectID, const std::string &value);
+
+		/// @brief Fills the attribute mirror with the values in the object pools after connecting
+		/// @details Parsing the pools is too slow for the thread that receives messages, so connecting only
+		/// clears the mirror and this is called from update. Values the VT reported in between are newer
+		/// than the pools, so they are kept.
+		void seed_attribute_mirror();
+
 		/// @brief Sets the state machine state and updates the associated timestamp
 		/// @param[in] value The new state for the state machine
 		void set_state(StateMachineState value);
@@ -1455,6 +1685,40 @@ namespace isobus
 		                             bool successful,
 		                             void *parentPointer);
 
+		/// @brief The callback the transport protocol uses to read a multi-frame command from the transfer buffer
+		/// @param[in] callbackIndex The number of times the callback has been called
+		/// @param[in] bytesOffset The offset of the chunk in the command
+		/// @param[in] numberOfBytesNeeded The number of bytes to copy
+		/// @param[out] chunkBuffer The buffer to copy the bytes into
+		/// @param[in] parentPointer A context variable to find the relevant VT client class
+		/// @returns true if the bytes were copied
+		static bool process_transfer_chunk(std::uint32_t callbackIndex,
+		                                   std::uint32_t bytesOffset,
+		                                   std::uint32_t numberOfBytesNeeded,
+		                                   std::uint8_t *chunkBuffer,
+		                                   void *parentPointer);
+
+		/// @brief Gets the parameters to scale the object pools for the connected VT with
+		/// @param[out] parameters The scaling parameters
+		/// @returns true if the application asked for the object pools to be scaled
+		bool get_object_pool_scaling_parameters(VirtualTerminalObjectPoolScaleCache::ScalingParameters &parameters) const;
+
+		/// @brief Sets up the object pool scaler for a pool that is about to be uploaded
+		/// @param[in] pool The object pool that is about to be uploaded
+		void prepare_object_pool_scaling(const ObjectPoolDataStruct &pool);
+
+		/// @brief Checks if the object pools can be uploaded as changes to the delta base version
+		/// @returns true if the VT and every pool support uploading only changed objects
+		bool get_is_delta_upload_possible() const;
+
+		/// @brief Collects the objects in a pool that are new or changed since the delta base version
+		/// @details The objects are copied, with any scaling applied, into the changed objects buffer.
+		/// Scaling an object can depend on the rest of its pool, so the delta base is scaled the same way
+		/// and the scaled objects are compared.
+		/// @param[in] poolIndex The index of the pool to compare to its delta base
+		/// @returns true if both pools were parsed and the buffer holds the changed objects
+		bool build_changed_objects(std::uint32_t poolIndex);
+
 		/// @brief The data callback passed to the network manger's send function for the transport layer messages
 		/// @details We upload the data with callbacks to avoid making a complete copy of the pool to
 		/// accommodate the multiplexor that needs to get passed to the transport layer message's first byte.
@@ -1473,8 +1737,27 @@ namespace isobus
 		/// @brief The worker thread will execute this function when it runs, if applicable
 		void worker_thread_function();
 
+		/// @brief Wakes the worker thread so that it runs the state machine without waiting for its next timer
+		void wake_worker_thread();
+
+		/// @brief Returns how long the worker thread can sleep before one of the client's timers is due
+		/// @details Only the timers the current state acts on are counted
+		/// @returns The time until the next timer is due in milliseconds, at least WORKER_THREAD_MINIMUM_SLEEP_MS
+		std::uint32_t get_worker_thread_sleep_time_ms();
+
+		/// @brief Returns how much of a timeout is left
+		/// @param[in] timestamp_ms The timestamp the timeout started from
+		/// @param[in] timeout_ms The length of the timeout
+		/// @returns The time left before the timeout expires in milliseconds, or 0 if it already expired
+		static std::uint32_t get_time_remaining_ms(std::uint32_t timestamp_ms, std::uint32_t timeout_ms);
+
 		static constexpr std::uint32_t VT_STATUS_TIMEOUT_MS = 3000; ///< The max allowable time between VT status messages before its considered offline
 		static constexpr std::uint32_t WORKING_SET_MAINTENANCE_TIMEOUT_MS = 1000; ///< The frequency at which we send the working set maintenance message
+		static constexpr std::uint32_t COMMAND_RESPONSE_TIMEOUT_MS = 1500; ///< How long to wait for the VT to respond to a queued command before retrying it
+		static constexpr std::uint32_t WORKER_THREAD_MAXIMUM_SLEEP_MS = 50; ///< The longest the worker thread sleeps when nothing wakes it up
+		static constexpr std::uint32_t WORKER_THREAD_MINIMUM_SLEEP_MS = 1; ///< The shortest the worker thread sleeps, so a timer that stays expired can't make it spin
+		static constexpr std::uint8_t MAX_COMMAND_RETRIES = 2; ///< How many times a queued command is sent again before giving up on it
+		static constexpr std::uint8_t VALUE_ATTRIBUTE_ID = 0xFF; ///< The attribute ID used for an object's value in the command queue and attribute mirror
 
 		std::shared_ptr<PartneredControlFunction> partnerControlFunction; ///< The partner control function this client will send to
 		std::shared_ptr<InternalControlFunction> myControlFunction; ///< The internal control function the client uses to send from
@@ -1516,9 +1799,39 @@ namespace isobus
 		std::vector<ObjectPoolDataStruct> objectPools; ///< A container to hold all object pools that have been assigned to the interface
 		std::vector<AuxiliaryInputDevice> auxiliaryInputDevices; ///< A container to hold all auxiliary input devices known
 		std::thread *workerThread; ///< The worker thread that updates this interface
+		std::vector<QueuedCommand> commandQueue; ///< Commands waiting to be sent to the VT, at most one per target
+		std::vector<InFlightCommand> commandsInFlight; ///< Queued commands that were sent and are waiting for a VT response
+		std::array<CommandStatistics, 256> commandStatistics; ///< Round trip statistics, indexed by function code
+		std::mutex commandQueueMutex; ///< A mutex to protect the command queue, commands in flight, and statistics
+		VTVersion pipelinedCommandsMinimumVTVersion; ///< The VT version needed before more than one command may be in flight
+		std::uint8_t maximumCommandsInFlight; ///< How many commands may be in flight on a VT that supports pipelining
+		std::deque<std::vector<std::uint8_t>> graphicsContextQueue; ///< Graphics context messages waiting to be sent, in drawing order
+		std::vector<std::uint16_t> graphicsContextsDrawn; ///< The graphics contexts batches were sent to since connecting, sorted by object ID
+		std::mutex graphicsContextQueueMutex; ///< A mutex to protect the graphics context queue and the drawn graphics contexts
+		std::vector<std::vector<std::uint8_t>> spareCommandBuffers; ///< Buffers of commands the VT has responded to, kept for new commands to reuse
+		std::vector<std::uint8_t> transferBuffer; ///< The multi-frame command being sent, read by the transport protocol
+		std::mutex transferMutex; ///< A mutex to protect the transfer buffer
+		bool transferInProgress; ///< The transfer buffer is being sent and must not be changed
+		std::vector<MirroredAttribute> attributeMirror; ///< The known attributes and numeric values of objects on the VT, sorted by key
+		std::vector<MirroredString> stringMirror; ///< The known string values of objects on the VT, sorted by object ID
+		std::vector<PendingAttributeQuery> pendingAttributeQueries; ///< Attribute reads sent to the VT that it hasn't answered yet
+		std::mutex attributeMirrorMutex; ///< A mutex to protect the attribute mirror and the pending attribute queries
+		bool attributeMirrorNeedsSeeding; ///< The client connected, so update must seed the attribute mirror from the object pools
+		std::shared_ptr<const VirtualTerminalObjectPoolScaler> objectPoolScaler; ///< Scales the object pool that is being uploaded, shared with clients of VTs with the same resolution
+		std::uint16_t originalDataMaskSize_px; ///< The data mask size the object pools were designed for, or 0 to not scale them
+		std::uint16_t originalSoftKeyWidth_px; ///< The soft key width the object pools were designed for
+		std::uint16_t originalSoftKeyHeight_px; ///< The soft key height the object pools were designed for
+		std::vector<ObjectPoolDeltaBase> objectPoolDeltaBases; ///< The previously stored versions of the object pools
+		std::string deltaBaseVersionLabel; ///< The version label the delta base pools were stored under
+		std::vector<std::uint8_t> changedObjectsBuffer; ///< The changed objects of the pool being uploaded as a delta
+		bool deltaUploadActive; ///< The delta base version is loaded, and only changed objects are being uploaded
+		bool uploadingChangedObjects; ///< The current transfer is sending the changed objects buffer instead of the whole pool
 		bool initialized; ///< Stores the client initialization state
 		bool sendWorkingSetMaintenenace; ///< Used internally to enable and disable cyclic sending of the maintenance message
 		bool shouldTerminate; ///< Used to determine if the client should exit and join the worker thread
+		std::mutex workerThreadMutex; ///< A mutex for the worker thread's condition variable
+		std::condition_variable workerThreadCondition; ///< Wakes the worker thread when a message is received or a Tx completes
+		bool workerThreadWakeRequested; ///< Set when something happened that the worker thread should react to
 
 		// Activation event callbacks
 		std::vector<VTKeyEventCallback> buttonEventCallbacks; ///< A list of all button event callbacks
@@ -0,0 +1,201 @@
+//================================================================================================
+/// @file isobus_virtual_terminal_graphics_context_batch.hpp
+///
+/// @brief Defines a class that records graphics context commands and sends them as few messages
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#ifndef ISOBUS_VIRTUAL_TERMINAL_GRAPHICS_CONTEXT_BATCH_HPP
+#define ISOBUS_VIRTUAL_TERMINAL_GRAPHICS_CONTEXT_BATCH_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace isobus
+{
+	//================================================================================================
+	/// @class VirtualTerminalGraphicsContextBatch
+	///
+	/// @brief Records drawing operations for one graphics context object and encodes them as the
+	/// fewest graphics context command messages that draw the same thing.
+	/// @details Colour and attribute changes that don't change anything are dropped, cursor moves
+	/// are combined, and runs of lines are sent as a single open polygon once that takes fewer frames
+	/// than sending each line. Send a batch with VirtualTerminalClient::send_graphics_context_batch.
+	/// The batch remembers the colours and attributes it set, so keep using the same batch for the
+	/// same graphics context, and call forget_state if anything else draws on it.
+	//================================================================================================
+	class VirtualTerminalGraphicsContextBatch
+	{
+	public:
+		/// @brief Constructor for a batch of commands for one graphics context
+		/// @param[in] graphicsContextObjectID The object ID of the graphics context to draw on
+		explicit VirtualTerminalGraphicsContextBatch(std::uint16_t graphicsContextObjectID);
+
+		/// @brief Returns the object ID of the graphics context the batch draws on
+		/// @returns The graphics context object ID
+		std::uint16_t get_object_id() const;
+
+		/// @brief Sets the graphics cursor to an absolute position
+		/// @param[in] xPosition The new X position (px)
+		/// @param[in] yPosition The new Y position (px)
+		void set_graphics_cursor(std::int16_t xPosition, std::int16_t yPosition);
+
+		/// @brief Moves the graphics cursor relative to its current position
+		/// @param[in] xOffset The X offset (px)
+		/// @param[in] yOffset The Y offset (px)
+		void move_graphics_cursor(std::int16_t xOffset, std::int16_t yOffset);
+
+		/// @brief Sets the foreground colour
+		/// @param[in] colour See standard colour palette, 0-255
+		void set_foreground_colour(std::uint8_t colour);
+
+		/// @brief Sets the background colour
+		/// @param[in] colour See standard colour palette, 0-255
+		void set_background_colour(std::uint8_t colour);
+
+		/// @brief Sets the line attributes object used by the drawing commands that follow
+		/// @param[in] lineAttributesObjectID The line attributes object ID, or NULL for no lines
+		void set_line_attributes_object_id(std::uint16_t lineAttributesObjectID);
+
+		/// @brief Sets the fill attributes object used by the drawing commands that follow
+		/// @param[in] fillAttributesObjectID The fill attributes object ID, or NULL for no filling
+		void set_fill_attributes_object_id(std::uint16_t fillAttributesObjectID);
+
+		/// @brief Sets the font attributes object used by the text commands that follow
+		/// @param[in] fontAttributesObjectID The font attributes object ID
+		void set_font_attributes_object_id(std::uint16_t fontAttributesObjectID);
+
+		/// @brief Fills a rectangle at the graphics cursor with the background colour
+		/// @param[in] width The width of the rectangle (px)
+		/// @param[in] height The height of the rectangle (px)
+		void erase_rectangle(std::uint16_t width, std::uint16_t height);
+
+		/// @brief Sets a pixel to the foreground colour and moves the cursor to it
+		/// @param[in] xOffset The pixel X offset relative to the cursor
+		/// @param[in] yOffset The pixel Y offset relative to the cursor
+		void draw_point(std::int16_t xOffset, std::int16_t yOffset);
+
+		/// @brief Draws a line from the graphics cursor and moves the cursor to its end
+		/// @param[in] xOffset The end pixel X offset relative to the cursor
+		/// @param[in] yOffset The end pixel Y offset relative to the cursor
+		void draw_line(std::int16_t xOffset, std::int16_t yOffset);
+
+		/// @brief Draws a rectangle at the graphics cursor
+		/// @param[in] width The width of the rectangle (px)
+		/// @param[in] height The height of the rectangle (px)
+		void draw_rectangle(std::uint16_t width, std::uint16_t height);
+
+		/// @brief Draws a closed ellipse bounded by a rectangle at the graphics cursor
+		/// @param[in] width The width of the ellipse (px)
+		/// @param[in] height The height of the ellipse (px)
+		void draw_closed_ellipse(std::uint16_t width, std::uint16_t height);
+
+		/// @brief Draws a polygon from the graphics cursor through a list of points
+		/// @param[in] numberOfPoints The number of points in the polygon
+		/// @param[in] listOfXOffsetsRelativeToCursor A list of X offsets for the points, relative to the cursor
+		/// @param[in] listOfYOffsetsRelativeToCursor A list of Y offsets for the points, relative to the cursor
+		void draw_polygon(std::uint8_t numberOfPoints, const std::int16_t *listOfXOffsetsRelativeToCursor, const std::int16_t *listOfYOffsetsRelativeToCursor);
+
+		/// @brief Draws text at the graphics cursor with the current font attributes
+		/// @param[in] transparent Denotes if the text background is transparent
+		/// @param[in] value The text to draw, up to 255 characters
+		void draw_text(bool transparent, const std::string &value);
+
+		/// @brief Draws a VT object at the graphics cursor
+		/// @param[in] vtObjectID The object ID to draw
+		void draw_vt_object(std::uint16_t vtObjectID);
+
+		/// @brief Forgets the colours and attributes the batch set, so that the next ones are always sent
+		void forget_state();
+
+		/// @brief Puts the colours and attributes the batch had set before its recorded commands back in
+		/// front of them, for a VT that lost them. The client does this for the first batch it sends to
+		/// a graphics context after connecting, so commands that were left out as redundant still hold.
+		void resend_state();
+
+		/// @brief Encodes everything recorded so far and empties the batch
+		/// @returns The graphics context command messages, in the order they must be sent
+		std::vector<std::vector<std::uint8_t>> take_messages();
+
+	private:
+		/// @brief The graphics context sub-commands, with the values defined by ISO 11783-6
+		enum class SubCommand : std::uint8_t
+		{
+			SetGraphicsCursor = 0x00, ///< Sets the graphics cursor x/y attributes
+			MoveGraphicsCursor = 0x01, ///< Moves the cursor relative to current location
+			SetForegroundColour = 0x02, ///< Sets the foreground colour
+			SetBackgroundColour = 0x03, ///< Sets the background colour
+			SetLineAttributesObjectID = 0x04, ///< Sets the line attribute object ID
+			SetFillAttributesObjectID = 0x05, ///< Sets the fill attribute object ID
+			SetFontAttributesObjectID = 0x06, ///< Sets the font attribute object ID
+			EraseRectangle = 0x07, ///< Erases a rectangle
+			DrawPoint = 0x08, ///< Draws a point
+			DrawLine = 0x09, ///< Draws a line
+			DrawRectangle = 0x0A, ///< Draws a rectangle
+			DrawClosedEllipse = 0x0B, ///< Draws a closed ellipse
+			DrawPolygon = 0x0C, ///< Draws polygon
+			DrawText = 0x0D, ///< Draws text
+			DrawVTObject = 0x12 ///< Draws a VT object
+		};
+
+		/// @brief A colour or attribute object the VT is known to be using
+		struct KnownState
+		{
+			std::uint16_t value; ///< The colour or object ID
+			bool known; ///< If the value is known
+		};
+
+		/// @brief A point in a run of lines, relative to where the run started
+		struct LinePoint
+		{
+			std::int32_t x; ///< The X offset from the start of the run
+			std::int32_t y; ///< The Y offset from the start of the run
+		};
+
+		/// @brief Sets a colour or attribute, unless the VT already uses that value
+		/// @param[in] command The set command to send
+		/// @param[in] value The colour or object ID
+		/// @param[in] numberOfBytes The number of value bytes in the command, 1 for colours and 2 for object IDs
+		void set_state(SubCommand command, std::uint16_t value, std::uint8_t numberOfBytes);
+
+		/// @brief Sends the pending cursor change, if there is one
+		void flush_cursor();
+
+		/// @brief Sends the pending run of lines, as a polygon if that is shorter
+		void flush_lines();
+
+		/// @brief Adds a message with 16 bit parameters
+		/// @param[in] command The sub-command to send
+		/// @param[in] firstValue The first parameter
+		/// @param[in] secondValue The second parameter
+		void add_message(SubCommand command, std::uint16_t firstValue, std::uint16_t secondValue);
+
+		/// @brief Starts a new message with the graphics context header
+		/// @param[in] command The sub-command to send
+		/// @returns The new message, for the caller to add parameters to
+		std::vector<std::uint8_t> &start_message(SubCommand command);
+
+		/// @brief Pads the last message to a full CAN frame if it is shorter
+		void finish_message();
+
+		static constexpr std::uint8_t GRAPHICS_CONTEXT_COMMAND = 0xB8; ///< The VT function code of the graphics context command
+		static constexpr std::uint8_t MINIMUM_POLYGON_LINES = 4; ///< A run needs this many lines before a polygon takes fewer frames than separate lines
+		static constexpr std::uint8_t MAXIMUM_POLYGON_POINTS = 255; ///< The most points a polygon command can hold
+
+		std::vector<std::vector<std::uint8_t>> messages; ///< The encoded messages
+		std::vector<LinePoint> pendingLines; ///< The end points of a run of lines that hasn't been sent yet
+		std::array<KnownState, 5> knownState; ///< The colours and attributes the VT uses, indexed from the set foreground colour sub-command
+		std::array<KnownState, 5> sentState; ///< The colours and attributes set by the messages already taken, which the recorded messages rely on
+		std::int32_t pendingCursorX; ///< The pending cursor X position or offset
+		std::int32_t pendingCursorY; ///< The pending cursor Y position or offset
+		std::uint16_t objectID; ///< The graphics context object ID
+		bool cursorPending; ///< If a cursor change is waiting to be sent
+		bool pendingCursorIsAbsolute; ///< If the pending cursor change sets the position instead of moving it
+	};
+} // namespace isobus
+
+#endif // ISOBUS_VIRTUAL_TERMINAL_GRAPHICS_CONTEXT_BATCH_HPP
@@ -0,0 +1,211 @@
+//================================================================================================
+/// @file isobus_virtual_terminal_object_pool_index.hpp
+///
+/// @brief Defines an index of the objects inside an ISO11783-6 object pool
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#ifndef ISOBUS_VIRTUAL_TERMINAL_OBJECT_POOL_INDEX_HPP
+#define ISOBUS_VIRTUAL_TERMINAL_OBJECT_POOL_INDEX_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace isobus
+{
+	//================================================================================================
+	/// @class VirtualTerminalObjectPoolIndex
+	///
+	/// @brief Parses an object pool and records where each object is, what type it is, and how
+	/// the objects reference each other.
+	/// @details The pool is walked once and is not copied, so it can be parsed straight out of
+	/// a memory mapped IOP file. The index only stores offsets into the pool, so the pool must
+	/// stay valid for as long as object data is read through the offsets.
+	/// Children are the objects an object lists as its contents, like the object list of a data
+	/// mask, the keys of a soft key mask, the items of a list, or the target of an object pointer.
+	/// Attribute references like font attributes or variable references are not children.
+	//================================================================================================
+	class VirtualTerminalObjectPoolIndex
+	{
+	public:
+		/// @brief Enumerates the object types defined by ISO11783-6
+		enum class ObjectType : std::uint8_t
+		{
+			WorkingSet = 0, ///< Top level object that describes an implement's ECU or group of ECUs
+			DataMask = 1, ///< Top level object that contains other objects
+			AlarmMask = 2, ///< Top level object that describes an alarm display
+			Container = 3, ///< Used to group objects
+			SoftKeyMask = 4, ///< Top level object that contains key objects
+			Key = 5, ///< Used to describe a soft key
+			Button = 6, ///< Used to describe a button control
+			InputBoolean = 7, ///< Used to input a true/false value
+			InputString = 8, ///< Used to input a character string
+			InputNumber = 9, ///< Used to input an integer or float numeric
+			InputList = 10, ///< Used to select an item from a pre-defined list
+			OutputString = 11, ///< Used to output a character string
+			OutputNumber = 12, ///< Used to output an integer or float numeric
+			OutputLine = 13, ///< Used to output a line
+			OutputRectangle = 14, ///< Used to output a rectangle or square
+			OutputEllipse = 15, ///< Used to output an ellipse or circle
+			OutputPolygon = 16, ///< Used to output a polygon
+			OutputMeter = 17, ///< Used to output a meter
+			OutputLinearBarGraph = 18, ///< Used to output a linear bar graph
+			OutputArchedBarGraph = 19, ///< Used to output an arched bar graph
+			PictureGraphic = 20, ///< Used to output a picture graphic (bitmap)
+			NumberVariable = 21, ///< Used to store a 32-bit unsigned integer value
+			StringVariable = 22, ///< Used to store a fixed length string value
+			FontAttributes = 23, ///< Used to group font based attributes
+			LineAttributes = 24, ///< Used to group line based attributes
+			FillAttributes = 25, ///< Used to group fill based attributes
+			InputAttributes = 26, ///< Used to specify a list of valid characters
+			ObjectPointer = 27, ///< Used to reference another object
+			Macro = 28, ///< Special object that contains a list of commands that can be executed in response to an event
+			AuxiliaryFunctionType1 = 29, ///< Defines the designator and function type for an auxiliary function
+			AuxiliaryInputType1 = 30, ///< Defines the designator, key number, and function type for an auxiliary input
+			AuxiliaryFunctionType2 = 31, ///< Defines the designator and function type for an auxiliary function
+			AuxiliaryInputType2 = 32, ///< Defines the designator, key number, and function type for an auxiliary input
+			AuxiliaryControlDesignatorType2 = 33, ///< References an auxiliary object to be used as a designator
+			WindowMask = 34, ///< Special object that contains objects for a user layout window
+			KeyGroup = 35, ///< Special object that groups keys for a user layout
+			GraphicsContext = 36, ///< Special object that can be drawn on with graphics commands
+			OutputList = 37, ///< Used to output a list item
+			ExtendedInputAttributes = 38, ///< Used to specify a list of valid WideChar characters
+			ColourMap = 39, ///< Used to specify a colour table
+			ObjectLabelReferenceList = 40, ///< Used to specify an object label
+			ExternalObjectDefinition = 41, ///< Used to list the objects that may be referenced from another working set
+			ExternalReferenceNAME = 42, ///< Used to identify the working set master of a working set that can be referenced
+			ExternalObjectPointer = 43, ///< Used to reference an object in another working set
+			Animation = 44, ///< Special object that displays its children in sequence
+			ColourPalette = 45, ///< Used to define the colour palette
+			GraphicData = 46, ///< Used to define graphic data in a compressed format
+			WorkingSetSpecialControls = 47, ///< Used to specify special controls for a working set
+			ScaledGraphic = 48 ///< Used to display a scaled graphic data object
+		};
+
+		/// @brief Describes where an object is in the pool
+		struct ObjectEntry
+		{
+			std::uint32_t offset; ///< The byte offset of the object's ID in the pool
+			std::uint32_t length; ///< The number of bytes the object occupies in the pool
+			std::uint32_t firstChildIndex; ///< Where this object's children start in the child list
+			std::uint16_t numberOfChildren; ///< The number of children the object has
+			std::uint16_t objectID; ///< The object's ID
+			ObjectType type; ///< The object's type
+		};
+
+		/// @brief Constructor for an empty object pool index
+		VirtualTerminalObjectPoolIndex();
+
+		/// @brief Parses an object pool and replaces the index with its contents
+		/// @details On failure the index is left empty. A pool fails to parse if it is truncated,
+		/// contains an unknown object type, or contains the same object ID twice.
+		/// @param[in] pool A pointer to the object pool data
+		/// @param[in] size The number of bytes in the object pool
+		/// @returns true if the whole pool was parsed
+		bool parse(const std::uint8_t *pool, std::uint32_t size);
+
+		/// @brief Parses an object pool and replaces the index with its contents
+		/// @param[in] pool The object pool data
+		/// @returns true if the whole pool was parsed
+		bool parse(const std::vector<std::uint8_t> &pool);
+
+		/// @brief Empties the index
+		void clear();
+
+		/// @brief Returns the offset into the pool where parsing failed
+		/// @returns The offset of the object that could not be parsed, or 0 if the last parse succeeded
+		std::uint32_t get_parse_error_offset() const;
+
+		/// @brief Returns the number of objects in the index
+		/// @returns The number of objects in the index
+		std::uint32_t get_number_objects() const;
+
+		/// @brief Returns an object by its position in the pool
+		/// @param[in] index The position of the object, objects are in the order they appear in the pool
+		/// @returns The object at that position, or nullptr if the index is out of range
+		const ObjectEntry *get_object_by_index(std::uint32_t index) const;
+
+		/// @brief Looks up an object by its ID
+		/// @param[in] objectID The ID of the object to find
+		/// @returns The object, or nullptr if the pool doesn't contain that ID
+		const ObjectEntry *get_object(std::uint16_t objectID) const;
+
+		/// @brief Finds an object's position in the pool by its ID
+		/// @param[in] objectID The ID of the object to find
+		/// @returns The object's position, or the number of objects if the pool doesn't contain that ID
+		std::uint32_t get_object_index(std::uint16_t objectID) const;
+
+		/// @brief Returns the ID of one of an object's children
+		/// @param[in] object The object whose child to get
+		/// @param[in] childIndex The position of the child in the object's child list
+		/// @returns The child's object ID, or NULL_OBJECT_ID if the child index is out of range
+		std::uint16_t get_child_object_id(const ObjectEntry &object, std::uint16_t childIndex) const;
+
+		/// @brief Returns the number of objects that list an object as a child
+		/// @param[in] objectID The ID of the object whose parents to count
+		/// @returns The number of parents the object has
+		std::uint16_t get_number_parents(std::uint16_t objectID) const;
+
+		/// @brief Returns the ID of one of the objects that list an object as a child
+		/// @param[in] objectID The ID of the object whose parent to get
+		/// @param[in] parentIndex The position of the parent in the object's parent list
+		/// @returns The parent's object ID, or NULL_OBJECT_ID if the parent index is out of range
+		std::uint16_t get_parent_object_id(std::uint16_t objectID, std::uint16_t parentIndex) const;
+
+		/// @brief Reads the initial value of a numeric object from the pool
+		/// @details Objects that take their value from a variable object have no value of their own
+		/// @param[in] pool The object pool the index was parsed from
+		/// @param[in] object The object to read
+		/// @param[out] value The object's value
+		/// @returns true if the object has a numeric value of its own
+		static bool get_numeric_value(const std::uint8_t *pool, const ObjectEntry &object, std::uint32_t &value);
+
+		/// @brief Reads the initial value of a string object from the pool
+		/// @details Objects that take their value from a variable object have no value of their own
+		/// @param[in] pool The object pool the index was parsed from
+		/// @param[in] object The object to read
+		/// @param[out] value The object's value
+		/// @returns true if the object has a string value of its own
+		static bool get_string_value(const std::uint8_t *pool, const ObjectEntry &object, std::string &value);
+
+		static constexpr std::uint16_t NULL_OBJECT_ID = 0xFFFF; ///< The object ID that means "no object"
+
+	private:
+		/// @brief Pairs an object ID with the object's position, for looking up objects by ID
+		struct ObjectIDLookup
+		{
+			std::uint16_t objectID; ///< The object's ID
+			std::uint32_t index; ///< The object's position in the object list
+		};
+
+		/// @brief Works out an object's length and records its children
+		/// @param[in] object A pointer to the start of the object in the pool
+		/// @param[in] bytesRemaining The number of bytes left in the pool, starting at the object
+		/// @param[out] entry The entry to fill in with the object's type, length, and children
+		/// @returns true if the object is a known type and fits in the remaining bytes
+		bool parse_object(const std::uint8_t *object, std::uint32_t bytesRemaining, ObjectEntry &entry);
+
+		/// @brief Records the object IDs in a list of objects as children of the object being parsed
+		/// @param[in] list A pointer to the first list entry
+		/// @param[in] numberOfEntries The number of entries in the list
+		/// @param[in] entrySize The size of each entry, the object ID is the first two bytes
+		/// @param[in,out] entry The entry of the object being parsed
+		void add_children(const std::uint8_t *list, std::uint32_t numberOfEntries, std::uint32_t entrySize, ObjectEntry &entry);
+
+		/// @brief Builds the ID lookup table and the parent lists once all objects are parsed
+		/// @returns true if no object ID was used twice
+		bool build_lookups();
+
+		std::vector<ObjectEntry> objects; ///< All objects, in the order they appear in the pool
+		std::vector<ObjectIDLookup> objectIDLookup; ///< Object positions sorted by object ID
+		std::vector<std::uint16_t> childObjectIDs; ///< The children of all objects, each object has a contiguous range
+		std::vector<std::uint32_t> firstParentIndex; ///< Where each object's parents start in the parent list, plus one extra entry for the end
+		std::vector<std::uint16_t> parentObjectIDs; ///< The parents of all objects, each object has a contiguous range
+		std::uint32_t parseErrorOffset; ///< The offset of the object that failed to parse
+	};
+} // namespace isobus
+
+#endif // ISOBUS_VIRTUAL_TERMINAL_OBJECT_POOL_INDEX_HPP
@@ -0,0 +1,81 @@
+//================================================================================================
+/// @file isobus_virtual_terminal_object_pool_scale_cache.hpp
+///
+/// @brief Defines a cache of scaled object pools that is shared by all VT clients
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#ifndef ISOBUS_VIRTUAL_TERMINAL_OBJECT_POOL_SCALE_CACHE_HPP
+#define ISOBUS_VIRTUAL_TERMINAL_OBJECT_POOL_SCALE_CACHE_HPP
+
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_scaler.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace isobus
+{
+	//================================================================================================
+	/// @class VirtualTerminalObjectPoolScaleCache
+	///
+	/// @brief Shares prepared object pool scalers between VT clients
+	/// @details When one ECU serves several VTs, each client would otherwise parse and scale the same
+	/// pool on its own. The cache keeps one scaler per pool and resolution, so VTs with the same
+	/// resolution share the work and the memory. Scalers are only kept while a client is using them.
+	//================================================================================================
+	class VirtualTerminalObjectPoolScaleCache
+	{
+	public:
+		/// @brief The sizes a pool was designed for and the sizes of the VT it is scaled for
+		struct ScalingParameters
+		{
+			std::uint16_t originalDataMaskSize_px; ///< The data mask width and height the pool was designed for
+			std::uint16_t dataMaskSize_px; ///< The data mask width and height of the VT
+			std::uint16_t originalSoftKeyWidth_px; ///< The soft key width the pool was designed for
+			std::uint16_t originalSoftKeyHeight_px; ///< The soft key height the pool was designed for
+			std::uint16_t softKeyWidth_px; ///< The soft key width of the VT
+			std::uint16_t softKeyHeight_px; ///< The soft key height of the VT
+			std::uint8_t smallFontSizes; ///< The small font sizes the VT supports
+			std::uint8_t largeFontSizes; ///< The large font sizes the VT supports
+		};
+
+		/// @brief Returns a prepared scaler for a pool, preparing it only if no other client already has
+		/// @param[in] pool A pointer to the object pool data
+		/// @param[in] size The number of bytes in the object pool
+		/// @param[in] parameters The sizes to scale the pool between
+		/// @returns A scaler prepared for the pool, or nullptr if the pool could not be parsed
+		static std::shared_ptr<const VirtualTerminalObjectPoolScaler> get_scaler(const std::uint8_t *pool, std::uint32_t size, const ScalingParameters &parameters);
+
+		/// @brief Returns the number of scalers currently in use
+		/// @returns The number of distinct pool and resolution combinations in the cache
+		static std::uint32_t get_number_cached_scalers();
+
+	private:
+		/// @brief A scaler prepared for one pool and resolution
+		struct CacheEntry
+		{
+			const std::uint8_t *pool; ///< The pool the scaler was prepared for
+			std::uint32_t size; ///< The size of the pool
+			ScalingParameters parameters; ///< The sizes the pool was scaled between
+			std::weak_ptr<const VirtualTerminalObjectPoolScaler> scaler; ///< The scaler, if a client still uses it
+		};
+
+		/// @brief Compares two sets of scaling parameters
+		/// @param[in] first The first set of parameters
+		/// @param[in] second The second set of parameters
+		/// @returns true if the parameters produce the same scaled pool
+		static bool get_is_same_parameters(const ScalingParameters &first, const ScalingParameters &second);
+
+		/// @brief Removes the entries whose scalers are no longer used by any client
+		static void remove_unused_entries();
+
+		static std::vector<CacheEntry> cache; ///< The prepared scalers
+		static std::mutex cacheMutex; ///< A mutex to protect the cache when several clients' threads use it
+	};
+} // namespace isobus
+
+#endif // ISOBUS_VIRTUAL_TERMINAL_OBJECT_POOL_SCALE_CACHE_HPP
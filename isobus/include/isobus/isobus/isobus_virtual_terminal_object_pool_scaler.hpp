@@ -0,0 +1,155 @@
+//================================================================================================
+/// @file isobus_virtual_terminal_object_pool_scaler.hpp
+///
+/// @brief Defines a class that scales an object pool to a VT's resolution while it is uploaded
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#ifndef ISOBUS_VIRTUAL_TERMINAL_OBJECT_POOL_SCALER_HPP
+#define ISOBUS_VIRTUAL_TERMINAL_OBJECT_POOL_SCALER_HPP
+
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_index.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace isobus
+{
+	//================================================================================================
+	/// @class VirtualTerminalObjectPoolScaler
+	///
+	/// @brief Scales the sizes, positions, and fonts in an object pool without copying it
+	/// @details Scaling never changes the length of an object, so instead of rewriting the pool
+	/// this class works out which bytes change and patches them into each chunk of the pool as it
+	/// is copied into the upload buffer. Objects inside soft key masks and the working set designator
+	/// are scaled to the VT's soft key size, everything else is scaled to the VT's data mask size. Fonts are snapped to the
+	/// largest font the VT supports that fits in the scaled font size. Picture graphics are scaled
+	/// through their displayed width, the VT resamples the bitmap itself.
+	/// All math is integer only, so it is cheap on small processors without an FPU.
+	//================================================================================================
+	class VirtualTerminalObjectPoolScaler
+	{
+	public:
+		/// @brief Constructor for a scaler that doesn't change anything
+		VirtualTerminalObjectPoolScaler();
+
+		/// @brief Sets the data mask size the pool was designed for and the size to scale it to
+		/// @param[in] originalSize_px The data mask width and height the pool was designed for
+		/// @param[in] newSize_px The data mask width and height of the VT
+		void set_data_mask_scaling(std::uint16_t originalSize_px, std::uint16_t newSize_px);
+
+		/// @brief Sets the soft key size the pool was designed for and the size to scale it to
+		/// @param[in] originalWidth_px The soft key width the pool was designed for
+		/// @param[in] originalHeight_px The soft key height the pool was designed for
+		/// @param[in] newWidth_px The soft key width of the VT
+		/// @param[in] newHeight_px The soft key height of the VT
+		void set_soft_key_scaling(std::uint16_t originalWidth_px, std::uint16_t originalHeight_px, std::uint16_t newWidth_px, std::uint16_t newHeight_px);
+
+		/// @brief Sets which fonts the VT supports, using the bitfields from the get text font data response
+		/// @param[in] smallFontSizesBitfield The small font sizes supported by the VT
+		/// @param[in] largeFontSizesBitfield The large font sizes supported by the VT
+		void set_supported_font_sizes(std::uint8_t smallFontSizesBitfield, std::uint8_t largeFontSizesBitfield);
+
+		/// @brief Works out which bytes of a pool change when it is scaled
+		/// @details The pool itself is not modified. It only has to stay valid during this call.
+		/// @param[in] pool A pointer to the object pool data
+		/// @param[in] size The number of bytes in the object pool
+		/// @returns true if the pool was parsed and can be scaled, false if it will be uploaded as is
+		bool prepare(const std::uint8_t *pool, std::uint32_t size);
+
+		/// @brief Patches the scaled values into a chunk of the pool
+		/// @param[in] poolOffset The offset in the pool of the first byte in the buffer
+		/// @param[in,out] buffer A copy of the pool data starting at poolOffset
+		/// @param[in] length The number of bytes in the buffer
+		void apply(std::uint32_t poolOffset, std::uint8_t *buffer, std::uint32_t length) const;
+
+		/// @brief Returns the number of bytes in the pool that scaling changes
+		/// @returns The number of bytes that will be patched
+		std::uint32_t get_number_patched_bytes() const;
+
+		/// @brief Forgets the prepared pool, so that apply does nothing
+		void clear();
+
+	private:
+		/// @brief A single byte that is different in the scaled pool
+		struct Patch
+		{
+			std::uint32_t offset; ///< The offset of the byte in the pool
+			std::uint8_t value; ///< The scaled byte
+		};
+
+		/// @brief A ratio to multiply values by
+		struct ScaleFactor
+		{
+			std::uint32_t numerator; ///< The size to scale to
+			std::uint32_t denominator; ///< The size the pool was designed for
+		};
+
+		/// @brief The scale factors that apply to an area of the VT's screen
+		struct AreaScaling
+		{
+			ScaleFactor x; ///< The horizontal scale factor
+			ScaleFactor y; ///< The vertical scale factor
+		};
+
+		/// @brief Works out the patches for one object
+		/// @param[in] pool A pointer to the object pool data
+		/// @param[in] object The object to scale
+		/// @param[in] scaling The scale factors for the area the object is shown in
+		void scale_object(const std::uint8_t *pool, const VirtualTerminalObjectPoolIndex::ObjectEntry &object, const AreaScaling &scaling);
+
+		/// @brief Scales the X and Y positions of each entry in an object list
+		/// @param[in] pool A pointer to the object pool data
+		/// @param[in] listOffset The pool offset of the first entry
+		/// @param[in] numberOfEntries The number of entries in the list
+		/// @param[in] scaling The scale factors to apply
+		void scale_object_positions(const std::uint8_t *pool, std::uint32_t listOffset, std::uint32_t numberOfEntries, const AreaScaling &scaling);
+
+		/// @brief Scales an unsigned 16 bit size at an offset in the pool
+		/// @param[in] pool A pointer to the object pool data
+		/// @param[in] offset The offset of the value in the pool
+		/// @param[in] factor The scale factor to apply
+		void scale_uint16(const std::uint8_t *pool, std::uint32_t offset, const ScaleFactor &factor);
+
+		/// @brief Scales a signed 16 bit position at an offset in the pool
+		/// @param[in] pool A pointer to the object pool data
+		/// @param[in] offset The offset of the value in the pool
+		/// @param[in] factor The scale factor to apply
+		void scale_int16(const std::uint8_t *pool, std::uint32_t offset, const ScaleFactor &factor);
+
+		/// @brief Scales an unsigned 8 bit size at an offset in the pool
+		/// @param[in] pool A pointer to the object pool data
+		/// @param[in] offset The offset of the value in the pool
+		/// @param[in] factor The scale factor to apply
+		void scale_uint8(const std::uint8_t *pool, std::uint32_t offset, const ScaleFactor &factor);
+
+		/// @brief Picks a supported font for a font attributes object
+		/// @param[in] pool A pointer to the object pool data
+		/// @param[in] object The font attributes object
+		/// @param[in] scaling The scale factors for the area the font is shown in
+		void scale_font(const std::uint8_t *pool, const VirtualTerminalObjectPoolIndex::ObjectEntry &object, const AreaScaling &scaling);
+
+		/// @brief Records a byte that is different in the scaled pool
+		/// @param[in] pool A pointer to the object pool data
+		/// @param[in] offset The offset of the byte in the pool
+		/// @param[in] value The scaled byte
+		void add_patch(const std::uint8_t *pool, std::uint32_t offset, std::uint8_t value);
+
+		/// @brief Multiplies a value by a scale factor, rounding to the nearest integer
+		/// @param[in] value The value to scale
+		/// @param[in] factor The scale factor
+		/// @returns The scaled value
+		static std::int32_t scale_value(std::int32_t value, const ScaleFactor &factor);
+
+		VirtualTerminalObjectPoolIndex poolIndex; ///< The index of the pool being scaled
+		std::vector<Patch> patches; ///< The bytes that change, sorted by offset
+		AreaScaling dataMaskScaling; ///< The scale factors for the data mask area
+		AreaScaling softKeyScaling; ///< The scale factors for the soft key area
+		std::uint8_t smallFontSizes; ///< The small font sizes the VT supports
+		std::uint8_t largeFontSizes; ///< The large font sizes the VT supports
+	};
+} // namespace isobus
+
+#endif // ISOBUS_VIRTUAL_TERMINAL_OBJECT_POOL_SCALER_HPP
@@ -29,69 +29,108 @@ namespace isobus
 
 	bool NAMEFilter::check_name_matches_filter(const NAME &nameToCompare) const
 	{
+		std::uint64_t mask = 0;
+		std::uint64_t rawValue = 0;
 		bool retVal = false;
 
+		if (get_raw_name_mask_and_value(mask, rawValue))
+		{
+			retVal = ((nameToCompare.get_full_name() & mask) == rawValue);
+		}
+		return retVal;
+	}
+
+	bool NAMEFilter::get_raw_name_mask_and_value(std::uint64_t &mask, std::uint64_t &value) const
+	{
+		std::uint32_t fieldMaximum = 0;
+		std::uint8_t fieldOffset = 0;
+		std::uint32_t fieldValue = this->value;
+		bool retVal = true;
+
 		switch (parameter)
 		{
 			case NAME::NAMEParameters::IdentityNumber:
 			{
-				retVal = (nameToCompare.get_identity_number() == value);
+				fieldMaximum = 0x1FFFFF;
+				fieldOffset = 0;
 			}
 			break;
 
 			case NAME::NAMEParameters::ManufacturerCode:
 			{
-				retVal = (nameToCompare.get_manufacturer_code() == value);
+				fieldMaximum = 0x07FF;
+				fieldOffset = 21;
 			}
 			break;
 
 			case NAME::NAMEParameters::EcuInstance:
 			{
-				retVal = (nameToCompare.get_ecu_instance() == value);
+				fieldMaximum = 0x07;
+				fieldOffset = 32;
 			}
 			break;
 
 			case NAME::NAMEParameters::FunctionInstance:
 			{
-				retVal = (nameToCompare.get_function_instance() == value);
+				fieldMaximum = 0x1F;
+				fieldOffset = 35;
 			}
 			break;
 
 			case NAME::NAMEParameters::FunctionCode:
 			{
-				retVal = (nameToCompare.get_function_code() == value);
+				fieldMaximum = 0xFF;
+				fieldOffset = 40;
 			}
 			break;
 
 			case NAME::NAMEParameters::DeviceClass:
 			{
-				retVal = (nameToCompare.get_device_class() == value);
+				fieldMaximum = 0x7F;
+				fieldOffset = 49;
 			}
 			break;
 
 			case NAME::NAMEParameters::DeviceClassInstance:
 			{
-				retVal = (nameToCompare.get_device_class_instance() == value);
+				fieldMaximum = 0x0F;
+				fieldOffset = 56;
 			}
 			break;
 
 			case NAME::NAMEParameters::IndustryGroup:
 			{
-				retVal = (nameToCompare.get_industry_group() == value);
+				fieldMaximum = 0x07;
+				fieldOffset = 60;
 			}
 			break;
 
 			case NAME::NAMEParameters::ArbitraryAddressCapable:
 			{
-				retVal = (nameToCompare.get_arbitrary_address_capable() == (0 != value));
+				fieldMaximum = 0x01;
+				fieldOffset = 63;
+				fieldValue = (0 != fieldValue) ? 1 : 0;
 			}
 			break;
 
 			default:
 			{
+				retVal = false;
 			}
 			break;
 		}
+
+		if (fieldValue > fieldMaximum)
+		{
+			// The NAME component can never hold this value, so nothing can match it
+			retVal = false;
+		}
+
+		if (retVal)
+		{
+			mask = static_cast<std::uint64_t>(fieldMaximum) << fieldOffset;
+			value = static_cast<std::uint64_t>(fieldValue) << fieldOffset;
+		}
 		return retVal;
 	}
 
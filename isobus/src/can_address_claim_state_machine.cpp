@@ -21,7 +21,8 @@ namespace isobus
 	AddressClaimStateMachine::AddressClaimStateMachine(std::uint8_t preferredAddressValue, NAME ControlFunctionNAME, std::uint8_t portIndex) :
 	  m_isoname(ControlFunctionNAME),
 	  m_currentState(State::None),
-	  m_timestamp_ms(0),
+	  m_timestamp_us(0),
+	  m_randomClaimDelay_us(0),
 	  m_portIndex(portIndex),
 	  m_preferredAddress(preferredAddressValue),
 	  m_claimedAddress(NULL_CAN_ADDRESS),
@@ -30,9 +31,8 @@ namespace isobus
 		assert(m_preferredAddress != BROADCAST_CAN_ADDRESS);
 		assert(m_preferredAddress != NULL_CAN_ADDRESS);
 		assert(portIndex < CAN_PORT_MAXIMUM);
-		std::default_random_engine generator;
-		std::uniform_int_distribution<unsigned int> distribution(0, 255);
-		m_randomClaimDelay_ms = distribution(generator) * 0.6f; // Defined by ISO part 5
+
+		m_randomClaimDelay_us = get_random_claim_delay_us(m_isoname);
 		CANNetworkManager::CANNetwork.add_global_parameter_group_number_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ParameterGroupNumberRequest), process_rx_message, this);
 		CANNetworkManager::CANNetwork.add_global_parameter_group_number_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim), process_rx_message, this);
 	}
@@ -63,6 +63,14 @@ namespace isobus
 		return m_claimedAddress;
 	}
 
+	std::uint32_t AddressClaimStateMachine::get_random_claim_delay_us(const NAME &isoNAME)
+	{
+		// Seed the generator with the NAME so that ECUs running identical firmware don't all pick the same delay
+		const std::uint64_t rawNAME = isoNAME.get_full_name();
+		std::minstd_rand generator(static_cast<std::uint32_t>(rawNAME ^ (rawNAME >> 32)));
+		return (generator() % 256) * 600; // Defined by ISO part 5, 0 to 153 ms in steps of 0.6 ms
+	}
+
 	void AddressClaimStateMachine::update()
 	{
 		if (get_enabled())
@@ -77,11 +85,11 @@ namespace isobus
 
 				case State::WaitForClaim:
 				{
-					if (0 == m_timestamp_ms)
+					if (0 == m_timestamp_us)
 					{
-						m_timestamp_ms = SystemTiming::get_timestamp_ms();
+						m_timestamp_us = SystemTiming::get_timestamp_us();
 					}
-					if (SystemTiming::time_expired_ms(m_timestamp_ms, m_randomClaimDelay_ms))
+					if (SystemTiming::time_expired_us(m_timestamp_us, m_randomClaimDelay_us))
 					{
 						set_current_state(State::SendRequestForClaim);
 					}
@@ -99,9 +107,9 @@ namespace isobus
 
 				case State::WaitForRequestContentionPeriod:
 				{
-					const std::uint32_t addressContentionTime_ms = 250;
+					const std::uint32_t addressContentionTime_us = 250000;
 
-					if (SystemTiming::time_expired_ms(m_timestamp_ms, addressContentionTime_ms + m_randomClaimDelay_ms))
+					if (SystemTiming::time_expired_us(m_timestamp_us, addressContentionTime_us + m_randomClaimDelay_us))
 					{
 						ControlFunction *deviceAtOurPreferredAddress = CANNetworkManager::CANNetwork.get_control_function(m_portIndex, m_preferredAddress, {});
 						// Time to find a free address
@@ -172,6 +180,16 @@ namespace isobus
 				}
 				break;
 
+				case State::WaitForReclaimDelay:
+				{
+					// Each internal control function waits its own NAME derived delay, so a gateway's claims don't all go out in one burst
+					if (SystemTiming::time_expired_us(m_timestamp_us, m_randomClaimDelay_us))
+					{
+						set_current_state(State::SendReclaimAddressOnRequest);
+					}
+				}
+				break;
+
 				case State::SendReclaimAddressOnRequest:
 				{
 					if (send_address_claim(m_claimedAddress))
@@ -223,7 +241,17 @@ namespace isobus
 						if ((static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim) == requestedPGN) &&
 						    (State::AddressClaimingComplete == parent->get_current_state()))
 						{
-							parent->set_current_state(State::SendReclaimAddressOnRequest);
+							if (BROADCAST_CAN_ADDRESS == message->get_identifier().get_destination_address())
+							{
+								// Every ECU answers a global request, so spread our answer out
+								parent->m_timestamp_us = SystemTiming::get_timestamp_us();
+								parent->set_current_state(State::WaitForReclaimDelay);
+							}
+							else
+							{
+								// Only we answer a request sent to us, so there's no burst to avoid
+								parent->set_current_state(State::SendReclaimAddressOnRequest);
+							}
 						}
 					}
 					break;
@@ -267,6 +295,11 @@ namespace isobus
 
 	void AddressClaimStateMachine::set_current_state(State value)
 	{
+		if (State::None == value)
+		{
+			// Claiming starts over, so WaitForClaim must time its random delay from the restart, not the first attempt
+			m_timestamp_us = 0;
+		}
 		m_currentState = value;
 	}
 
@@ -10,6 +10,7 @@
 #include "isobus/isobus/can_internal_control_function.hpp"
 
 #include "isobus/isobus/can_constants.hpp"
+#include "isobus/isobus/can_network_manager.hpp"
 
 #include <algorithm>
 
@@ -42,6 +43,7 @@ namespace isobus
 		const std::lock_guard<std::mutex> lock(ControlFunction::controlFunctionProcessingMutex);
 		auto thisObject = std::find(internalControlFunctionList.begin(), internalControlFunctionList.end(), this);
 		*thisObject = nullptr; // Don't erase, just null it out. Erase could cause a double free.
+		CANNetworkManager::CANNetwork.on_internal_control_function_deleted(this, {}); // Tell the network manager to purge this ICF from all tables
 	}
 
 	InternalControlFunction *InternalControlFunction::get_internal_control_function(std::uint32_t index)
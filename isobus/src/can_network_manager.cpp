@@ -22,6 +22,8 @@
 
 #include <algorithm>
 #include <cstring>
+#include <thread>
+
 namespace isobus
 {
 	CANNetworkManager CANNetworkManager::CANNetwork;
@@ -84,6 +86,113 @@ namespace isobus
 		}
 	}
 
+	void CANNetworkManager::add_control_function_event_callback(ControlFunctionEventCallback callback, void *parent)
+	{
+		if (nullptr != callback)
+		{
+			std::lock_guard<std::mutex> lock(controlFunctionEventCallbacksMutex);
+			controlFunctionEventCallbacks.push_back({ callback, parent });
+		}
+	}
+
+	void CANNetworkManager::remove_control_function_event_callback(ControlFunctionEventCallback callback, void *parent)
+	{
+		std::lock_guard<std::mutex> lock(controlFunctionEventCallbacksMutex);
+		for (auto currentCallback = controlFunctionEventCallbacks.begin(); currentCallback != controlFunctionEventCallbacks.end(); currentCallback++)
+		{
+			if ((callback == currentCallback->callback) &&
+			    (parent == currentCallback->parent))
+			{
+				controlFunctionEventCallbacks.erase(currentCallback);
+				break;
+			}
+		}
+	}
+
+	void CANNetworkManager::suspend_broadcasts(std::uint8_t canPort, std::uint32_t duration_ms)
+	{
+		if (canPort < CAN_PORT_MAXIMUM)
+		{
+			const std::lock_guard<std::mutex> lock(broadcastGateMutex);
+			broadcastSuspensionTimestamps_ms[canPort] = SystemTiming::get_timestamp_ms();
+			broadcastSuspensionDurations_ms[canPort] = duration_ms;
+			broadcastsSuspended[canPort] = true;
+		}
+	}
+
+	void CANNetworkManager::resume_broadcasts(std::uint8_t canPort)
+	{
+		if (canPort < CAN_PORT_MAXIMUM)
+		{
+			const std::lock_guard<std::mutex> lock(broadcastGateMutex);
+			broadcastsSuspended[canPort] = false;
+		}
+	}
+
+	bool CANNetworkManager::get_are_broadcasts_suspended(std::uint8_t canPort)
+	{
+		bool retVal = false;
+
+		if (canPort < CAN_PORT_MAXIMUM)
+		{
+			const std::lock_guard<std::mutex> lock(broadcastGateMutex);
+			retVal = update_broadcast_suspension(canPort);
+		}
+		return retVal;
+	}
+
+	bool CANNetworkManager::get_is_broadcast_allowed(std::uint8_t canPort, std::uint32_t parameterGroupNumber)
+	{
+		bool retVal = true;
+
+		if (canPort < CAN_PORT_MAXIMUM)
+		{
+			// One lock for both checks, so a suspension can't start or end between them
+			const std::lock_guard<std::mutex> lock(broadcastGateMutex);
+
+			if (update_broadcast_suspension(canPort))
+			{
+				retVal = std::binary_search(broadcastSuspensionExemptions.begin(), broadcastSuspensionExemptions.end(), parameterGroupNumber);
+			}
+		}
+		return retVal;
+	}
+
+	void CANNetworkManager::add_broadcast_suspension_exemption(std::uint32_t parameterGroupNumber)
+	{
+		const std::lock_guard<std::mutex> lock(broadcastGateMutex);
+		auto location = std::lower_bound(broadcastSuspensionExemptions.begin(), broadcastSuspensionExemptions.end(), parameterGroupNumber);
+
+		if ((broadcastSuspensionExemptions.end() == location) ||
+		    (parameterGroupNumber != *location))
+		{
+			broadcastSuspensionExemptions.insert(location, parameterGroupNumber);
+		}
+	}
+
+	void CANNetworkManager::remove_broadcast_suspension_exemption(std::uint32_t parameterGroupNumber)
+	{
+		const std::lock_guard<std::mutex> lock(broadcastGateMutex);
+		auto location = std::lower_bound(broadcastSuspensionExemptions.begin(), broadcastSuspensionExemptions.end(), parameterGroupNumber);
+
+		if ((broadcastSuspensionExemptions.end() != location) &&
+		    (parameterGroupNumber == *location))
+		{
+			broadcastSuspensionExemptions.erase(location);
+		}
+	}
+
+	bool CANNetworkManager::update_broadcast_suspension(std::uint8_t canPort)
+	{
+		if ((broadcastsSuspended[canPort]) &&
+		    (0 != broadcastSuspensionDurations_ms[canPort]) &&
+		    (SystemTiming::time_expired_ms(broadcastSuspensionTimestamps_ms[canPort], broadcastSuspensionDurations_ms[canPort])))
+		{
+			broadcastsSuspended[canPort] = false;
+		}
+		return broadcastsSuspended[canPort];
+	}
+
 	InternalControlFunction *CANNetworkManager::get_internal_control_function(ControlFunction *controlFunction)
 	{
 		InternalControlFunction *retVal = nullptr;
@@ -164,7 +273,7 @@ namespace isobus
 		return retVal;
 	}
 
-	void CANNetworkManager::receive_can_message(CANMessage &message)
+	void CANNetworkManager::receive_can_message(CANLibManagedMessage &message)
 	{
 		if (initialized)
 		{
@@ -205,7 +314,7 @@ namespace isobus
 					}
 					if (currentInternalControlFunction->get_changed_address_since_last_update({}))
 					{
-						update_address_table(currentInternalControlFunction->get_can_port(), currentInternalControlFunction->get_address());
+						process_internal_control_function_address_change(currentInternalControlFunction);
 					}
 				}
 			}
@@ -254,28 +363,30 @@ namespace isobus
 	{
 		CANLibManagedMessage tempCANMessage(rxFrame.channel);
 
-		CANNetworkManager::CANNetwork.update_control_functions(rxFrame);
-
-		tempCANMessage.set_identifier(CANIdentifier(rxFrame.identifier));
+		std::atomic<std::uint32_t> *readerCount = nullptr;
 
-		// Note, if this is an address claim message, the address to CF table might be stale.
-		// We don't want to update that here though, as we're maybe in some other thread in this callback.
-		// So for now, manually search all of them to line up the appropriate CF. A bit unfortunate in that we may have a lot of CFs, but saves pain later so we don't have to
-		// do some gross cast to CANLibManagedMessage to edit the CFs.
-		// At least address claiming should be infrequent, so this should not happen a ton.
-		if (static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim) == tempCANMessage.get_identifier().get_parameter_group_number())
+		// Announce that this thread is reading the address table, so that a control function
+		// being deleted isn't freed while it's being attached to this message.
+		// If a purge advanced the epoch between reading it and counting ourselves, that purge may
+		// already have checked our counter, so count again in the new epoch.
+		while (nullptr == readerCount)
 		{
-			for (std::uint32_t i = 0; i < CANNetworkManager::CANNetwork.activeControlFunctions.size(); i++)
+			const std::uint32_t epoch = CANNetworkManager::CANNetwork.addressTableEpoch;
+
+			readerCount = &CANNetworkManager::CANNetwork.addressTableReaderCounts[epoch & 1];
+			(*readerCount)++;
+			if (epoch != CANNetworkManager::CANNetwork.addressTableEpoch)
 			{
-				if ((CANNetworkManager::CANNetwork.activeControlFunctions[i]->get_can_port() == tempCANMessage.get_can_port_index()) &&
-				    (CANNetworkManager::CANNetwork.activeControlFunctions[i]->get_address() == tempCANMessage.get_identifier().get_source_address()))
-				{
-					tempCANMessage.set_source_control_function(CANNetworkManager::CANNetwork.activeControlFunctions[i]);
-					break;
-				}
+				(*readerCount)--;
+				readerCount = nullptr;
 			}
 		}
-		else
+
+		tempCANMessage.set_identifier(CANIdentifier(rxFrame.identifier));
+
+		// Address claims are resolved to a control function later by process_rx_address_claim,
+		// which is the only place the address table is changed for external control functions.
+		if (static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim) != tempCANMessage.get_identifier().get_parameter_group_number())
 		{
 			tempCANMessage.set_source_control_function(CANNetworkManager::CANNetwork.get_control_function(rxFrame.channel, tempCANMessage.get_identifier().get_source_address()));
 			tempCANMessage.set_destination_control_function(CANNetworkManager::CANNetwork.get_control_function(rxFrame.channel, tempCANMessage.get_identifier().get_destination_address()));
@@ -283,39 +394,97 @@ namespace isobus
 		tempCANMessage.set_data(rxFrame.data, rxFrame.dataLength);
 
 		CANNetworkManager::CANNetwork.receive_can_message(tempCANMessage);
+		(*readerCount)--;
 	}
 
 	void CANNetworkManager::on_partner_deleted(PartneredControlFunction *partner, CANLibBadge<PartneredControlFunction>)
 	{
-		CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug, "[NM]: Partner " + isobus::to_string(static_cast<int>(partner->get_address())) + " was deleted.");
+		ControlFunction *replacementControlFunction = nullptr;
+		CAN_STACK_LOG_DEBUG("[NM]: Partner %u was deleted.", static_cast<unsigned int>(partner->get_address()));
 
 		for (auto activeControlFunction = activeControlFunctions.begin(); activeControlFunction != activeControlFunctions.end(); activeControlFunction++)
 		{
-			if ((partner->get_can_port() == (*activeControlFunction)->get_can_port()) &&
-			    (partner->get_NAME() == (*activeControlFunction)->get_NAME()))
+			if (partner == (*activeControlFunction))
 			{
 				(*activeControlFunction) = nullptr;
 				activeControlFunctions.erase(activeControlFunction);
 				if (partner->address < NULL_CAN_ADDRESS)
 				{
-					controlFunctionTable[partner->get_can_port()][partner->address] = nullptr;
 					// If the control function was active, replace it with an external control function
-					activeControlFunctions.push_back(new ControlFunction(partner->get_NAME(), partner->get_address(), partner->get_can_port()));
-					CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug, "[NM]: Since the deleted partner was active, it has been replaced with an external control function.");
+					replacementControlFunction = new ControlFunction(partner->get_NAME(), partner->get_address(), partner->get_can_port());
+					activeControlFunctions.push_back(replacementControlFunction);
+					controlFunctionTable[partner->get_can_port()][partner->address] = replacementControlFunction;
+					CAN_STACK_LOG_DEBUG("[NM]: Since the deleted partner was active, it has been replaced with an external control function.");
 				}
 				break;
 			}
 		}
 		for (auto inactiveControlFunction = inactiveControlFunctions.begin(); inactiveControlFunction != inactiveControlFunctions.end(); inactiveControlFunction++)
 		{
-			if ((partner->get_can_port() == (*inactiveControlFunction)->get_can_port()) &&
-			    (partner->get_NAME() == (*inactiveControlFunction)->get_NAME()))
+			if (partner == (*inactiveControlFunction))
 			{
 				(*inactiveControlFunction) = nullptr;
 				inactiveControlFunctions.erase(inactiveControlFunction);
 				break;
 			}
 		}
+		purge_control_function(partner, replacementControlFunction);
+	}
+
+	void CANNetworkManager::on_internal_control_function_deleted(InternalControlFunction *internalControlFunction, CANLibBadge<InternalControlFunction>)
+	{
+		auto activeLocation = std::find(activeControlFunctions.begin(), activeControlFunctions.end(), internalControlFunction);
+
+		if (activeControlFunctions.end() != activeLocation)
+		{
+			activeControlFunctions.erase(activeLocation);
+		}
+		purge_control_function(internalControlFunction, nullptr);
+	}
+
+	void CANNetworkManager::purge_control_function(ControlFunction *controlFunction, ControlFunction *replacement)
+	{
+		const std::uint8_t CANPort = controlFunction->get_can_port();
+
+		notify_control_function_event(controlFunction, ControlFunctionEvent::Deleted, controlFunction->get_address());
+
+		if (CANPort < CAN_PORT_MAXIMUM)
+		{
+			for (auto &tableEntry : controlFunctionTable[CANPort])
+			{
+				if (controlFunction == tableEntry)
+				{
+					tableEntry = replacement;
+				}
+			}
+		}
+
+		{
+			const std::lock_guard<std::mutex> purgeLock(addressTablePurgeMutex);
+
+			// An Rx thread is only counted once it has seen its epoch is still current after counting itself.
+			// So every reader that can still hold the old pointer is in the retired epoch's counter, and any
+			// reader that starts later reads the table after it was updated.
+			const std::uint32_t retiredEpoch = (addressTableEpoch++ & 1);
+
+			while (0 != addressTableReaderCounts[retiredEpoch])
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		const std::lock_guard<std::mutex> lock(receiveMessageMutex);
+		for (auto &currentMessage : receiveMessageList)
+		{
+			if (controlFunction == currentMessage.get_source_control_function())
+			{
+				currentMessage.set_source_control_function(replacement);
+			}
+			if (controlFunction == currentMessage.get_destination_control_function())
+			{
+				currentMessage.set_destination_control_function(replacement);
+			}
+		}
 	}
 
 	bool CANNetworkManager::add_protocol_parameter_group_number_callback(std::uint32_t parameterGroupNumber, CANLibCallback callback, void *parentPointer)
@@ -355,165 +524,197 @@ namespace isobus
 	}
 
 	CANNetworkManager::CANNetworkManager() :
+	  addressTableEpoch(0),
 	  updateTimestamp_ms(0),
 	  initialized(false)
 	{
-		controlFunctionTable.fill({ nullptr });
+		for (auto &portTable : controlFunctionTable)
+		{
+			for (auto &tableEntry : portTable)
+			{
+				tableEntry = nullptr;
+			}
+		}
+		for (auto &readerCount : addressTableReaderCounts)
+		{
+			readerCount = 0;
+		}
+		broadcastSuspensionTimestamps_ms.fill(0);
+		broadcastSuspensionDurations_ms.fill(0);
+		broadcastsSuspended.fill(false);
 	}
 
-	void CANNetworkManager::update_address_table(CANMessage &message)
+	void CANNetworkManager::process_rx_address_claim(CANLibManagedMessage &message)
 	{
-		std::uint8_t CANPort = message.get_can_port_index();
+		const std::uint8_t CANPort = message.get_can_port_index();
+		const std::uint8_t claimedAddress = message.get_identifier().get_source_address();
 
-		if ((static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim) == message.get_identifier().get_parameter_group_number()) &&
-		    (CANPort < CAN_PORT_MAXIMUM))
+		if ((CAN_DATA_LENGTH == message.get_data_length()) &&
+		    (CANPort < CAN_PORT_MAXIMUM) &&
+		    (claimedAddress < NULL_CAN_ADDRESS))
 		{
-			std::uint8_t messageSourceAddress = message.get_identifier().get_source_address();
+			const std::uint64_t claimedNAME = message.get_uint64_at(0);
+			ControlFunction *foundControlFunction = nullptr;
 
-			if ((nullptr != controlFunctionTable[CANPort][messageSourceAddress]) &&
-			    (CANIdentifier::NULL_ADDRESS == controlFunctionTable[CANPort][messageSourceAddress]->get_address()))
+			for (auto currentControlFunction : activeControlFunctions)
 			{
-				// Someone is at that spot in the table, but their address was stolen
-				// Need to evict them from the table
-				controlFunctionTable[CANPort][messageSourceAddress]->address = NULL_CAN_ADDRESS;
-				controlFunctionTable[CANPort][messageSourceAddress] = nullptr;
+				if ((claimedNAME == currentControlFunction->controlFunctionNAME.get_full_name()) &&
+				    (CANPort == currentControlFunction->get_can_port()))
+				{
+					// Device already in the active list
+					foundControlFunction = currentControlFunction;
+					break;
+				}
 			}
 
-			// Now, check for either a free spot in the table or recent eviction and populate if needed
-			if (nullptr == controlFunctionTable[CANPort][messageSourceAddress])
+			if (nullptr == foundControlFunction)
 			{
-				// Look through active CFs, maybe we've heard of this ECU before
-				for (auto currentControlFunction : activeControlFunctions)
+				// Maybe it's in the inactive list (device reconnected)
+				for (auto currentControlFunction : inactiveControlFunctions)
 				{
-					if (currentControlFunction->get_address() == messageSourceAddress)
+					if ((claimedNAME == currentControlFunction->controlFunctionNAME.get_full_name()) &&
+					    (CANPort == currentControlFunction->get_can_port()))
 					{
-						// ECU has claimed since the last update, add it to the table
-						controlFunctionTable[CANPort][messageSourceAddress] = currentControlFunction;
-						currentControlFunction->address = messageSourceAddress;
+						foundControlFunction = currentControlFunction;
 						break;
 					}
 				}
 			}
-		}
-	}
 
-	void CANNetworkManager::update_address_table(std::uint8_t CANPort, std::uint8_t claimedAddress)
-	{
-		if (CANPort < CAN_PORT_MAXIMUM)
-		{
-			if ((nullptr != controlFunctionTable[CANPort][claimedAddress]) &&
-			    (CANIdentifier::NULL_ADDRESS == controlFunctionTable[CANPort][claimedAddress]->get_address()))
-			{
-				// Someone is at that spot in the table, but their address was stolen
-				// Need to evict them from the table
-				controlFunctionTable[CANPort][claimedAddress]->address = NULL_CAN_ADDRESS;
-				controlFunctionTable[CANPort][claimedAddress] = nullptr;
-			}
-
-			// Now, check for either a free spot in the table or recent eviction and populate if needed
-			if (nullptr == controlFunctionTable[CANPort][claimedAddress])
+			if (nullptr == foundControlFunction)
 			{
-				// Look through active CFs, maybe we've heard of this ECU before
-				for (auto currentControlFunction : activeControlFunctions)
+				// If we still haven't found it, it might be a partner. Check the list of partners that aren't bound to another device yet.
+				for (auto currentPartner : PartneredControlFunction::partneredControlFunctionList)
 				{
-					if (currentControlFunction->get_address() == claimedAddress)
+					if ((nullptr != currentPartner) &&
+					    (CANPort == currentPartner->get_can_port()) &&
+					    (currentPartner->check_matches_name(NAME(claimedNAME))) &&
+					    (activeControlFunctions.end() == std::find(activeControlFunctions.begin(), activeControlFunctions.end(), currentPartner)) &&
+					    (inactiveControlFunctions.end() == std::find(inactiveControlFunctions.begin(), inactiveControlFunctions.end(), currentPartner)))
 					{
-						// ECU has claimed since the last update, add it to the table
-						controlFunctionTable[CANPort][claimedAddress] = currentControlFunction;
-						currentControlFunction->address = claimedAddress;
+						currentPartner->controlFunctionNAME = NAME(claimedNAME);
+						activeControlFunctions.push_back(currentPartner);
+						foundControlFunction = currentPartner;
+						CAN_STACK_LOG_DEBUG("[NM]: A Partner Has Claimed %u", static_cast<unsigned int>(claimedAddress));
+						notify_control_function_event(currentPartner, ControlFunctionEvent::PartnerBound, currentPartner->address);
 						break;
 					}
 				}
+
+				if (nullptr == foundControlFunction)
+				{
+					// New device, need to start keeping track of it
+					foundControlFunction = new ControlFunction(NAME(claimedNAME), NULL_CAN_ADDRESS, CANPort);
+					activeControlFunctions.push_back(foundControlFunction);
+					CAN_STACK_LOG_DEBUG("[NM]: New Control function %u", static_cast<unsigned int>(claimedAddress));
+				}
 			}
-		}
-	}
 
-	void CANNetworkManager::update_control_functions(HardwareInterfaceCANFrame &rxFrame)
-	{
-		if ((static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim) == CANIdentifier(rxFrame.identifier).get_parameter_group_number()) &&
-		    (CAN_DATA_LENGTH == rxFrame.dataLength) &&
-		    (rxFrame.channel < CAN_PORT_MAXIMUM))
-		{
-			std::uint64_t claimedNAME;
-			ControlFunction *foundControlFunction = nullptr;
+			// Whoever held this address before has lost it to the claimant
+			ControlFunction *previousHolder = controlFunctionTable[CANPort][claimedAddress];
 
-			claimedNAME = rxFrame.data[0];
-			claimedNAME |= (static_cast<std::uint64_t>(rxFrame.data[1]) << 8);
-			claimedNAME |= (static_cast<std::uint64_t>(rxFrame.data[2]) << 16);
-			claimedNAME |= (static_cast<std::uint64_t>(rxFrame.data[3]) << 24);
-			claimedNAME |= (static_cast<std::uint64_t>(rxFrame.data[4]) << 32);
-			claimedNAME |= (static_cast<std::uint64_t>(rxFrame.data[5]) << 40);
-			claimedNAME |= (static_cast<std::uint64_t>(rxFrame.data[6]) << 48);
-			claimedNAME |= (static_cast<std::uint64_t>(rxFrame.data[7]) << 56);
+			if ((nullptr != previousHolder) &&
+			    (foundControlFunction != previousHolder))
+			{
+				evict_control_function_from_address_table(previousHolder);
+			}
 
-			for (std::size_t i = 0; i < activeControlFunctions.size(); i++)
+			if (ControlFunction::Type::Internal != foundControlFunction->get_type())
 			{
-				if ((claimedNAME == activeControlFunctions[i]->controlFunctionNAME.get_full_name()) &&
-				    (rxFrame.channel == activeControlFunctions[i]->get_can_port()))
-				{
-					// Device already in the active list
-					foundControlFunction = activeControlFunctions[i];
-					break;
-				}
-				else if ((activeControlFunctions[i]->address == CANIdentifier(rxFrame.identifier).get_source_address()) &&
-				         (rxFrame.channel == activeControlFunctions[i]->get_can_port()))
+				const std::uint8_t previousAddress = foundControlFunction->address;
+
+				if (previousAddress != claimedAddress)
 				{
-					// If this CF has the same address as the one claiming, we need set it to 0xFE (null address)
-					activeControlFunctions[i]->address = CANIdentifier::NULL_ADDRESS;
+					if ((previousAddress < NULL_CAN_ADDRESS) &&
+					    (foundControlFunction == controlFunctionTable[CANPort][previousAddress]))
+					{
+						controlFunctionTable[CANPort][previousAddress] = nullptr;
+					}
+					foundControlFunction->address = claimedAddress;
+					notify_control_function_event(foundControlFunction,
+					                              (previousAddress < NULL_CAN_ADDRESS) ? ControlFunctionEvent::AddressChanged : ControlFunctionEvent::AddressClaimed,
+					                              previousAddress);
 				}
 			}
+			controlFunctionTable[CANPort][claimedAddress] = foundControlFunction;
+			message.set_source_control_function(foundControlFunction);
+		}
+	}
+
+	void CANNetworkManager::process_internal_control_function_address_change(InternalControlFunction *internalControlFunction)
+	{
+		const std::uint8_t CANPort = internalControlFunction->get_can_port();
+		const std::uint8_t newAddress = internalControlFunction->get_address();
+		std::uint8_t previousAddress = NULL_CAN_ADDRESS;
 
-			// Maybe it's in the inactive list (device reconnected)
-			// Always have to iterate the list to check for duplicate addresses
-			for (std::size_t i = 0; i < inactiveControlFunctions.size(); i++)
+		if (CANPort < CAN_PORT_MAXIMUM)
+		{
+			for (std::uint32_t i = 0; i < NULL_CAN_ADDRESS; i++)
 			{
-				if ((claimedNAME == inactiveControlFunctions[i]->controlFunctionNAME.get_full_name()) &&
-				    (rxFrame.channel == inactiveControlFunctions[i]->get_can_port()))
+				if ((internalControlFunction == controlFunctionTable[CANPort][i]) &&
+				    (i != newAddress))
 				{
-					// Device already in the inactive list
-					foundControlFunction = inactiveControlFunctions[i];
-					break;
-				}
-				else if (rxFrame.channel == inactiveControlFunctions[i]->get_can_port())
-				{
-					// If this CF has the same address as the one claiming, we need set it to 0xFE (null address)
-					inactiveControlFunctions[i]->address = CANIdentifier::NULL_ADDRESS;
+					controlFunctionTable[CANPort][i] = nullptr;
+					previousAddress = static_cast<std::uint8_t>(i);
 				}
 			}
 
-			if (nullptr == foundControlFunction)
+			if (newAddress < NULL_CAN_ADDRESS)
 			{
-				// If we still haven't found it, it might be a partner. Check the list of partners.
-				for (std::size_t i = 0; i < PartneredControlFunction::partneredControlFunctionList.size(); i++)
-				{
-					if ((nullptr != PartneredControlFunction::partneredControlFunctionList[i]) &&
-					    (PartneredControlFunction::partneredControlFunctionList[i]->get_can_port() == rxFrame.channel) &&
-					    (PartneredControlFunction::partneredControlFunctionList[i]->check_matches_name(NAME(claimedNAME))))
-					{
-						PartneredControlFunction::partneredControlFunctionList[i]->address = CANIdentifier(rxFrame.identifier).get_source_address();
-						PartneredControlFunction::partneredControlFunctionList[i]->controlFunctionNAME = NAME(claimedNAME);
-						activeControlFunctions.push_back(PartneredControlFunction::partneredControlFunctionList[i]);
-						foundControlFunction = PartneredControlFunction::partneredControlFunctionList[i];
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug, "[NM]: A Partner Has Claimed " + isobus::to_string(static_cast<int>(CANIdentifier(rxFrame.identifier).get_source_address())));
-						break;
-					}
-				}
+				ControlFunction *previousHolder = controlFunctionTable[CANPort][newAddress];
 
-				if (nullptr == foundControlFunction)
+				if ((nullptr != previousHolder) &&
+				    (internalControlFunction != previousHolder))
 				{
-					// New device, need to start keeping track of it
-					activeControlFunctions.push_back(new ControlFunction(NAME(claimedNAME), CANIdentifier(rxFrame.identifier).get_source_address(), rxFrame.channel));
-					CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug, "[NM]: New Control function " + isobus::to_string(static_cast<int>(CANIdentifier(rxFrame.identifier).get_source_address())));
+					evict_control_function_from_address_table(previousHolder);
 				}
+				controlFunctionTable[CANPort][newAddress] = internalControlFunction;
+				notify_control_function_event(internalControlFunction,
+				                              (previousAddress < NULL_CAN_ADDRESS) ? ControlFunctionEvent::AddressChanged : ControlFunctionEvent::AddressClaimed,
+				                              previousAddress);
 			}
-
-			if (nullptr != foundControlFunction)
+			else if (previousAddress < NULL_CAN_ADDRESS)
 			{
-				foundControlFunction->address = CANIdentifier(rxFrame.identifier).get_source_address();
+				notify_control_function_event(internalControlFunction, ControlFunctionEvent::AddressLost, previousAddress);
 			}
 		}
 	}
 
+	void CANNetworkManager::evict_control_function_from_address_table(ControlFunction *controlFunction)
+	{
+		const std::uint8_t previousAddress = controlFunction->address;
+
+		if ((previousAddress < NULL_CAN_ADDRESS) &&
+		    (controlFunction == controlFunctionTable[controlFunction->get_can_port()][previousAddress]))
+		{
+			controlFunctionTable[controlFunction->get_can_port()][previousAddress] = nullptr;
+		}
+
+		// Internal control functions' addresses are owned by their address claim state machine
+		if ((ControlFunction::Type::Internal != controlFunction->get_type()) &&
+		    (previousAddress < NULL_CAN_ADDRESS))
+		{
+			controlFunction->address = NULL_CAN_ADDRESS;
+			notify_control_function_event(controlFunction, ControlFunctionEvent::AddressLost, previousAddress);
+		}
+	}
+
+	void CANNetworkManager::notify_control_function_event(ControlFunction *controlFunction, ControlFunctionEvent event, std::uint8_t previousAddress)
+	{
+		std::vector<ControlFunctionEventCallbackData> callbacksToCall;
+
+		// Callbacks are called without the lock, so they can add or remove event callbacks themselves
+		{
+			const std::lock_guard<std::mutex> lock(controlFunctionEventCallbacksMutex);
+			callbacksToCall = controlFunctionEventCallbacks;
+		}
+
+		for (const auto &currentCallback : callbacksToCall)
+		{
+			currentCallback.callback(controlFunction, event, previousAddress, currentCallback.parent);
+		}
+	}
+
 	void CANNetworkManager::update_new_partners()
 	{
 		if (PartneredControlFunction::anyPartnerNeedsInitializing)
@@ -534,13 +735,14 @@ namespace isobus
 							foundReplaceableControlFunction = true;
 
 							// This CF matches the filter and is not an internal or already partnered CF
-							CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug, "[NM]: Remapping new partner control function to inactive external control function at address " + isobus::to_string(static_cast<int>((*currentInactiveControlFunction)->get_address())));
+							CAN_STACK_LOG_DEBUG("[NM]: Remapping new partner control function to inactive external control function at address %u", static_cast<unsigned int>((*currentInactiveControlFunction)->get_address()));
 
 							// Populate the partner's data
 							partner->address = (*currentInactiveControlFunction)->get_address();
 							partner->controlFunctionNAME = (*currentInactiveControlFunction)->get_NAME();
 							partner->initialized = true;
 							inactiveControlFunctions.erase(currentInactiveControlFunction);
+							notify_control_function_event(partner, ControlFunctionEvent::PartnerBound, partner->address);
 							break;
 						}
 					}
@@ -554,7 +756,7 @@ namespace isobus
 							    (ControlFunction::Type::External == (*currentActiveControlFunction)->get_type()))
 							{
 								// This CF matches the filter and is not an internal or already partnered CF
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug, "[NM]: Remapping new partner control function to an active external control function at address " + isobus::to_string(static_cast<int>((*currentActiveControlFunction)->get_address())));
+								CAN_STACK_LOG_DEBUG("[NM]: Remapping new partner control function to an active external control function at address %u", static_cast<unsigned int>((*currentActiveControlFunction)->get_address()));
 
 								// Populate the partner's data
 								partner->address = (*currentActiveControlFunction)->get_address();
@@ -563,6 +765,7 @@ namespace isobus
 								controlFunctionTable[partner->get_can_port()][partner->address] = partner;
 								activeControlFunctions.erase(currentActiveControlFunction);
 								activeControlFunctions.push_back(partner);
+								notify_control_function_event(partner, ControlFunctionEvent::PartnerBound, partner->address);
 								break;
 							}
 						}
@@ -614,10 +817,8 @@ namespace isobus
 				}
 				else
 				{
-					CANStackLogger::warn("[NM]: Cannot send a message with PGN " +
-					                     isobus::to_string(static_cast<int>(parameterGroupNumber)) +
-					                     " as a destination specific message. " +
-					                     "Try resending it using nullptr as your destination control function.");
+					CAN_STACK_LOG_WARNING("[NM]: Cannot send a message with PGN %u as a destination specific message. "
+					                     "Try resending it using nullptr as your destination control function.", static_cast<unsigned int>(parameterGroupNumber));
 					identifier = DEFAULT_IDENTIFIER;
 				}
 			}
@@ -645,10 +846,10 @@ namespace isobus
 		return retVal;
 	}
 
-	CANMessage CANNetworkManager::get_next_can_message_from_rx_queue()
+	CANLibManagedMessage CANNetworkManager::get_next_can_message_from_rx_queue()
 	{
 		std::lock_guard<std::mutex> lock(receiveMessageMutex);
-		CANMessage retVal = receiveMessageList.front();
+		CANLibManagedMessage retVal = receiveMessageList.front();
 		receiveMessageList.pop_front();
 		return retVal;
 	}
@@ -743,9 +944,12 @@ namespace isobus
 	{
 		while (0 != get_number_can_messages_in_rx_queue())
 		{
-			CANMessage currentMessage = get_next_can_message_from_rx_queue();
+			CANLibManagedMessage currentMessage = get_next_can_message_from_rx_queue();
 
-			update_address_table(currentMessage);
+			if (static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim) == currentMessage.get_identifier().get_parameter_group_number())
+			{
+				process_rx_address_claim(currentMessage);
+			}
 
 			// Update Special Callbacks, like protocols and non-cf specific ones
 			process_protocol_pgn_callbacks(currentMessage);
@@ -771,6 +975,10 @@ namespace isobus
 
 	void CANNetworkManager::protocol_message_callback(CANMessage *protocolMessage)
 	{
+		if (nullptr != protocolMessage)
+		{
+			process_any_control_function_pgn_callbacks(*protocolMessage);
+		}
 		process_can_message_for_global_and_partner_callbacks(protocolMessage);
 	}
 
@@ -11,6 +11,7 @@
 #include "isobus/isobus/can_parameter_group_number_request_protocol.hpp"
 #include "isobus/isobus/can_general_parameter_group_numbers.hpp"
 #include "isobus/isobus/can_stack_logger.hpp"
+#include "isobus/utility/system_timing.hpp"
 #include "isobus/utility/to_string.hpp"
 
 #include <algorithm>
@@ -18,6 +19,8 @@
 namespace isobus
 {
 	std::list<ParameterGroupNumberRequestProtocol *> ParameterGroupNumberRequestProtocol::pgnRequestProtocolList;
+	constexpr std::uint16_t ParameterGroupNumberRequestProtocol::MINIMUM_REPETITION_RATE_MS;
+	constexpr std::size_t ParameterGroupNumberRequestProtocol::MAXIMUM_PENDING_GLOBAL_RESPONSES;
 
 	void ParameterGroupNumberRequestProtocol::initialize(CANLibBadge<CANNetworkManager>)
 	{
@@ -122,10 +125,15 @@ namespace isobus
 		bool retVal = false;
 		const std::lock_guard<std::mutex> lock(pgnRequestMutex);
 
-		if ((nullptr != callback) && (pgnRequestCallbacks.end() == std::find(pgnRequestCallbacks.begin(), pgnRequestCallbacks.end(), pgnCallback)))
+		if (nullptr != callback)
 		{
-			pgnRequestCallbacks.push_back(pgnCallback);
-			retVal = true;
+			std::vector<PGNRequestCallbackInfo> &callbacks = pgnRequestCallbacks[pgn];
+
+			if (callbacks.end() == std::find(callbacks.begin(), callbacks.end(), pgnCallback))
+			{
+				callbacks.push_back(pgnCallback);
+				retVal = true;
+			}
 		}
 		return retVal;
 	}
@@ -136,10 +144,15 @@ namespace isobus
 		bool retVal = false;
 		const std::lock_guard<std::mutex> lock(pgnRequestMutex);
 
-		if ((nullptr != callback) && (repetitionRateCallbacks.end() == std::find(repetitionRateCallbacks.begin(), repetitionRateCallbacks.end(), repetitionRateCallback)))
+		if (nullptr != callback)
 		{
-			repetitionRateCallbacks.push_back(repetitionRateCallback);
-			retVal = true;
+			std::vector<PGNRequestForRepetitionRateCallbackInfo> &callbacks = repetitionRateCallbacks[pgn];
+
+			if (callbacks.end() == std::find(callbacks.begin(), callbacks.end(), repetitionRateCallback))
+			{
+				callbacks.push_back(repetitionRateCallback);
+				retVal = true;
+			}
 		}
 		return retVal;
 	}
@@ -150,12 +163,22 @@ namespace isobus
 		bool retVal = false;
 		const std::lock_guard<std::mutex> lock(pgnRequestMutex);
 
-		auto callbackLocation = find(pgnRequestCallbacks.begin(), pgnRequestCallbacks.end(), repetitionRateCallback);
+		auto callbacks = pgnRequestCallbacks.find(pgn);
 
-		if (pgnRequestCallbacks.end() != callbackLocation)
+		if (pgnRequestCallbacks.end() != callbacks)
 		{
-			pgnRequestCallbacks.erase(callbackLocation);
-			retVal = true;
+			auto callbackLocation = find(callbacks->second.begin(), callbacks->second.end(), repetitionRateCallback);
+
+			if (callbacks->second.end() != callbackLocation)
+			{
+				callbacks->second.erase(callbackLocation);
+				retVal = true;
+
+				if (callbacks->second.empty())
+				{
+					pgnRequestCallbacks.erase(callbacks);
+				}
+			}
 		}
 		return retVal;
 	}
@@ -166,28 +189,155 @@ namespace isobus
 		bool retVal = false;
 		const std::lock_guard<std::mutex> lock(pgnRequestMutex);
 
-		auto callbackLocation = find(repetitionRateCallbacks.begin(), repetitionRateCallbacks.end(), repetitionRateCallback);
+		auto callbacks = repetitionRateCallbacks.find(pgn);
+
+		if (repetitionRateCallbacks.end() != callbacks)
+		{
+			auto callbackLocation = find(callbacks->second.begin(), callbacks->second.end(), repetitionRateCallback);
+
+			if (callbacks->second.end() != callbackLocation)
+			{
+				callbacks->second.erase(callbackLocation);
+				retVal = true;
+
+				if (callbacks->second.empty())
+				{
+					repetitionRateCallbacks.erase(callbacks);
+				}
+			}
+		}
+		return retVal;
+	}
+
+	bool ParameterGroupNumberRequestProtocol::register_periodic_pgn(std::uint32_t pgn, std::uint16_t defaultRate_ms, PeriodicPGNCallback callback, void *parentPointer)
+	{
+		bool retVal = false;
+		const std::lock_guard<std::mutex> lock(periodicPGNMutex);
+
+		if ((nullptr != callback) &&
+		    (periodicPGNs.end() == std::find_if(periodicPGNs.begin(), periodicPGNs.end(), [pgn](const PeriodicPGN &periodicPGN) { return pgn == periodicPGN.pgn; })))
+		{
+			periodicPGNs.push_back({ callback, parentPointer, pgn, defaultRate_ms });
+
+			if (0 != defaultRate_ms)
+			{
+				PeriodicPGNSchedule newSchedule;
+
+				newSchedule.statistics = { 0, 0, 0, 0 };
+				newSchedule.consecutiveFailures = 0;
+				newSchedule.destination = nullptr;
+				newSchedule.pgn = pgn;
+				newSchedule.nextTransmission_ms = SystemTiming::get_timestamp_ms();
+				newSchedule.rate_ms = std::max(defaultRate_ms, MINIMUM_REPETITION_RATE_MS);
+				periodicSchedule.push_back(newSchedule);
+				std::push_heap(periodicSchedule.begin(), periodicSchedule.end(), is_due_later);
+			}
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	bool ParameterGroupNumberRequestProtocol::remove_periodic_pgn(std::uint32_t pgn)
+	{
+		bool retVal = false;
+		const std::lock_guard<std::mutex> lock(periodicPGNMutex);
+
+		auto periodicPGN = std::find_if(periodicPGNs.begin(), periodicPGNs.end(), [pgn](const PeriodicPGN &entry) { return pgn == entry.pgn; });
 
-		if (repetitionRateCallbacks.end() != callbackLocation)
+		if (periodicPGNs.end() != periodicPGN)
 		{
-			repetitionRateCallbacks.erase(callbackLocation);
+			periodicPGNs.erase(periodicPGN);
+			periodicSchedule.erase(std::remove_if(periodicSchedule.begin(), periodicSchedule.end(), [pgn](const PeriodicPGNSchedule &entry) { return pgn == entry.pgn; }), periodicSchedule.end());
+			std::make_heap(periodicSchedule.begin(), periodicSchedule.end(), is_due_later);
 			retVal = true;
 		}
 		return retVal;
 	}
 
+	bool ParameterGroupNumberRequestProtocol::get_periodic_pgn_statistics(std::uint32_t pgn, const ControlFunction *destination, PeriodicPGNStatistics &statistics)
+	{
+		bool retVal = false;
+		const std::lock_guard<std::mutex> lock(periodicPGNMutex);
+
+		for (const auto &entry : periodicSchedule)
+		{
+			if ((pgn == entry.pgn) &&
+			    (destination == entry.destination))
+			{
+				statistics = entry.statistics;
+				retVal = true;
+				break;
+			}
+		}
+		return retVal;
+	}
+
+	std::size_t ParameterGroupNumberRequestProtocol::get_number_periodic_pgn_schedules()
+	{
+		const std::lock_guard<std::mutex> lock(periodicPGNMutex);
+		return periodicSchedule.size();
+	}
+
+	void ParameterGroupNumberRequestProtocol::set_global_response_spreading(std::uint16_t window_ms, bool useNAMEOffset)
+	{
+		const std::lock_guard<std::mutex> lock(pgnRequestMutex);
+
+		// J1939-21 requires a response within 200 ms, so a longer window would make requesters time out
+		globalResponseWindow_ms = window_ms;
+		if (globalResponseWindow_ms > MAXIMUM_GLOBAL_RESPONSE_WINDOW_MS)
+		{
+			globalResponseWindow_ms = MAXIMUM_GLOBAL_RESPONSE_WINDOW_MS;
+		}
+		useNAMEResponseOffset = useNAMEOffset;
+		nameResponseOffset_ms = 0;
+
+		if ((0 != globalResponseWindow_ms) && (nullptr != myControlFunction))
+		{
+			// Seeded the same way as the address claim delay, so identical firmware on several ECUs still spreads out
+			const std::uint64_t rawNAME = myControlFunction->get_NAME().get_full_name();
+			responseDelayGenerator.seed(static_cast<std::uint32_t>(rawNAME ^ (rawNAME >> 32)));
+			nameResponseOffset_ms = responseDelayGenerator() % (static_cast<std::uint32_t>(globalResponseWindow_ms) + 1);
+		}
+	}
+
+	void ParameterGroupNumberRequestProtocol::set_global_response_priority(std::uint32_t pgn, CANIdentifier::CANPriority priority)
+	{
+		const std::lock_guard<std::mutex> lock(pgnRequestMutex);
+		globalResponsePriorities[pgn] = static_cast<std::uint8_t>(priority);
+	}
+
+	std::size_t ParameterGroupNumberRequestProtocol::get_number_pending_global_responses()
+	{
+		const std::lock_guard<std::mutex> lock(pgnRequestMutex);
+		return pendingGlobalResponses.size();
+	}
+
 	std::size_t ParameterGroupNumberRequestProtocol::get_number_registered_pgn_request_callbacks() const
 	{
-		return pgnRequestCallbacks.size();
+		std::size_t retVal = 0;
+
+		for (const auto &callbacks : pgnRequestCallbacks)
+		{
+			retVal += callbacks.second.size();
+		}
+		return retVal;
 	}
 
 	std::size_t ParameterGroupNumberRequestProtocol::get_number_registered_request_for_repetition_rate_callbacks() const
 	{
-		return repetitionRateCallbacks.size();
+		std::size_t retVal = 0;
+
+		for (const auto &callbacks : repetitionRateCallbacks)
+		{
+			retVal += callbacks.second.size();
+		}
+		return retVal;
 	}
 
 	void ParameterGroupNumberRequestProtocol::update(CANLibBadge<CANNetworkManager>)
 	{
+		update_global_responses();
+		update_periodic_pgns();
 	}
 
 	ParameterGroupNumberRequestProtocol::PGNRequestCallbackInfo::PGNRequestCallbackInfo(PGNRequestCallback callback, std::uint32_t parameterGroupNumber, void *parentPointer) :
@@ -231,21 +381,18 @@ namespace isobus
 						std::vector<std::uint8_t> &data = message->get_data();
 						std::uint32_t requestedPGN = data[0];
 						requestedPGN |= (static_cast<std::uint32_t>(data[1]) << 8);
-						requestedPGN |= (static_cast<std::uint32_t>(data[2]) << 8);
+						requestedPGN |= (static_cast<std::uint32_t>(data[2]) << 16);
 
 						std::uint16_t requestedRate = data[3];
 						requestedRate |= (static_cast<std::uint16_t>(data[4]) << 8);
 
+						process_repetition_rate_request(requestedPGN, message->get_source_control_function(), requestedRate);
+
 						const std::lock_guard<std::mutex> lock(pgnRequestMutex);
 
-						for (auto repetitionRateCallback : repetitionRateCallbacks)
+						if (!call_repetition_rate_callbacks(requestedPGN, requestedPGN, message->get_source_control_function(), requestedRate))
 						{
-							if (((repetitionRateCallback.pgn == requestedPGN) ||
-							     (static_cast<std::uint32_t>(isobus::CANLibParameterGroupNumber::Any) == repetitionRateCallback.pgn)) &&
-							    (repetitionRateCallback.callbackFunction(requestedPGN, message->get_source_control_function(), requestedRate, repetitionRateCallback.parent)))
-							{
-								break;
-							}
+							call_repetition_rate_callbacks(static_cast<std::uint32_t>(isobus::CANLibParameterGroupNumber::Any), requestedPGN, message->get_source_control_function(), requestedRate);
 						}
 
 						// We can just ignore requests for repetition rate if we don't support them for this PGN. No need to NACK.
@@ -255,7 +402,7 @@ namespace isobus
 					}
 					else
 					{
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[PR]: Received a malformed or broadcast request for repetition rate message. The message will not be processed.");
+						CAN_STACK_LOG_WARNING("[PR]: Received a malformed or broadcast request for repetition rate message. The message will not be processed.");
 					}
 				}
 				break;
@@ -270,31 +417,40 @@ namespace isobus
 						std::vector<std::uint8_t> &data = message->get_data();
 						std::uint32_t requestedPGN = data[0];
 						requestedPGN |= (static_cast<std::uint32_t>(data[1]) << 8);
-						requestedPGN |= (static_cast<std::uint32_t>(data[2]) << 8);
+						requestedPGN |= (static_cast<std::uint32_t>(data[2]) << 16);
 
 						const std::lock_guard<std::mutex> lock(pgnRequestMutex);
 
-						for (auto pgnRequestCallback : pgnRequestCallbacks)
+						if (get_is_duplicate_request(requestedPGN, message))
 						{
-							if (((pgnRequestCallback.pgn == requestedPGN) ||
-							     (static_cast<std::uint32_t>(isobus::CANLibParameterGroupNumber::Any) == pgnRequestCallback.pgn)) &&
-							    (pgnRequestCallback.callbackFunction(requestedPGN, message->get_source_control_function(), shouldAck, ackType, pgnRequestCallback.parent)))
+							// An identical request was just answered, so the requester already has (or will get) our response
+							anyCallbackProcessed = true;
+						}
+						else if ((nullptr == message->get_destination_control_function()) &&
+						         (defer_global_response(requestedPGN, message->get_source_control_function())))
+						{
+							// The response will be sent from update once its delay expires. Global requests are never acknowledged.
+							anyCallbackProcessed = true;
+						}
+						else
+						{
+							// Callbacks for the specific PGN get the first chance to handle it, then the ones for any PGN
+							anyCallbackProcessed = call_pgn_request_callbacks(requestedPGN, requestedPGN, message->get_source_control_function(), shouldAck, ackType);
+
+							if ((!anyCallbackProcessed) &&
+							    (static_cast<std::uint32_t>(isobus::CANLibParameterGroupNumber::Any) != requestedPGN))
+							{
+								anyCallbackProcessed = call_pgn_request_callbacks(static_cast<std::uint32_t>(isobus::CANLibParameterGroupNumber::Any), requestedPGN, message->get_source_control_function(), shouldAck, ackType);
+							}
+
+							// We should not ACK messages that send the actual PGN as a result of requesting it. This behavior is up to
+							// the application layer to do properly.
+							if ((anyCallbackProcessed) && (shouldAck) && (nullptr != message->get_destination_control_function()))
 							{
-								// If we're here, the callback was able to process the PGN request.
-								anyCallbackProcessed = true;
-
-								// Now we need to know if we shoulc ACK it.
-								// We should not ACK messages that send the actual PGN as a result of requesting it. This behavior is up to
-								// the application layer to do properly.
-								if ((shouldAck) && (nullptr != message->get_destination_control_function()))
-								{
-									send_acknowledgement(ackType,
-									                     requestedPGN,
-									                     reinterpret_cast<InternalControlFunction *>(message->get_destination_control_function()),
-									                     message->get_source_control_function());
-								}
-								// If this callback was able to process the PGN request, stop processing more.
-								break;
+								send_acknowledgement(ackType,
+								                     requestedPGN,
+								                     reinterpret_cast<InternalControlFunction *>(message->get_destination_control_function()),
+								                     message->get_source_control_function());
 							}
 						}
 
@@ -304,12 +460,12 @@ namespace isobus
 							                     requestedPGN,
 							                     reinterpret_cast<InternalControlFunction *>(message->get_destination_control_function()),
 							                     message->get_source_control_function());
-							CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[PR]: NACK-ing PGN request for PGN " + isobus::to_string(requestedPGN) + " because no callback could handle it.");
+							CAN_STACK_LOG_WARNING("[PR]: NACK-ing PGN request for PGN %u because no callback could handle it.", static_cast<unsigned int>(requestedPGN));
 						}
 					}
 					else
 					{
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[PR]: Received a malformed PGN request message. The message will not be processed.");
+						CAN_STACK_LOG_WARNING("[PR]: Received a malformed PGN request message. The message will not be processed.");
 					}
 				}
 				break;
@@ -323,12 +479,25 @@ namespace isobus
 	}
 
 	ParameterGroupNumberRequestProtocol::ParameterGroupNumberRequestProtocol(std::shared_ptr<InternalControlFunction> internalControlFunction) :
-	  myControlFunction(internalControlFunction)
+	  myControlFunction(internalControlFunction),
+	  nextRecentRequest(0),
+	  nameResponseOffset_ms(0),
+	  globalResponseWindow_ms(0),
+	  useNAMEResponseOffset(false)
 	{
+		pendingGlobalResponses.reserve(MAXIMUM_PENDING_GLOBAL_RESPONSES);
+
+		for (auto &recentRequest : recentRequests)
+		{
+			recentRequest.valid = false;
+		}
+		CANNetworkManager::CANNetwork.add_control_function_event_callback(process_control_function_event, this);
 	}
 
 	ParameterGroupNumberRequestProtocol ::~ParameterGroupNumberRequestProtocol()
 	{
+		CANNetworkManager::CANNetwork.remove_control_function_event_callback(process_control_function_event, this);
+
 		if (initialized)
 		{
 			CANNetworkManager::CANNetwork.remove_protocol_parameter_group_number_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ParameterGroupNumberRequest), process_message, this);
@@ -356,6 +525,293 @@ namespace isobus
 		return false; // This protocol is not a transport layer, so just return false
 	}
 
+	bool ParameterGroupNumberRequestProtocol::call_pgn_request_callbacks(std::uint32_t callbackPGN, std::uint32_t requestedPGN, ControlFunction *requester, bool &shouldAck, AcknowledgementType &ackType)
+	{
+		bool retVal = false;
+		auto callbacks = pgnRequestCallbacks.find(callbackPGN);
+
+		if (pgnRequestCallbacks.end() != callbacks)
+		{
+			for (const auto &pgnRequestCallback : callbacks->second)
+			{
+				if (pgnRequestCallback.callbackFunction(requestedPGN, requester, shouldAck, ackType, pgnRequestCallback.parent))
+				{
+					// If this callback was able to process the PGN request, stop processing more.
+					retVal = true;
+					break;
+				}
+			}
+		}
+		return retVal;
+	}
+
+	bool ParameterGroupNumberRequestProtocol::call_repetition_rate_callbacks(std::uint32_t callbackPGN, std::uint32_t requestedPGN, ControlFunction *requester, std::uint16_t requestedRate_ms)
+	{
+		bool retVal = false;
+		auto callbacks = repetitionRateCallbacks.find(callbackPGN);
+
+		if (repetitionRateCallbacks.end() != callbacks)
+		{
+			for (const auto &repetitionRateCallback : callbacks->second)
+			{
+				if (repetitionRateCallback.callbackFunction(requestedPGN, requester, requestedRate_ms, repetitionRateCallback.parent))
+				{
+					retVal = true;
+					break;
+				}
+			}
+		}
+		return retVal;
+	}
+
+	bool ParameterGroupNumberRequestProtocol::get_is_duplicate_request(std::uint32_t pgn, const CANMessage *message)
+	{
+		bool retVal = false;
+
+		// Global requests are answered to global, so one answer covers every global requester.
+		// A destination specific request is always answered, a repeat usually means the requester missed our ACK or NACK.
+		if (nullptr == message->get_destination_control_function())
+		{
+			for (const auto &recentRequest : recentRequests)
+			{
+				if ((recentRequest.valid) &&
+				    (pgn == recentRequest.pgn) &&
+				    (!SystemTiming::time_expired_ms(recentRequest.timestamp_ms, REQUEST_DEDUPLICATION_WINDOW_MS)))
+				{
+					retVal = true;
+					break;
+				}
+			}
+
+			if (!retVal)
+			{
+				RecentRequest &newRequest = recentRequests[nextRecentRequest];
+
+				newRequest.pgn = pgn;
+				newRequest.timestamp_ms = SystemTiming::get_timestamp_ms();
+				newRequest.valid = true;
+				nextRecentRequest = (nextRecentRequest + 1) % recentRequests.size();
+			}
+		}
+		return retVal;
+	}
+
+	bool ParameterGroupNumberRequestProtocol::defer_global_response(std::uint32_t pgn, ControlFunction *requester)
+	{
+		bool retVal = false;
+
+		if ((0 != globalResponseWindow_ms) &&
+		    (pendingGlobalResponses.size() < MAXIMUM_PENDING_GLOBAL_RESPONSES))
+		{
+			PendingGlobalResponse newResponse;
+			auto priority = globalResponsePriorities.find(pgn);
+
+			newResponse.requester = requester;
+			newResponse.pgn = pgn;
+			newResponse.dueTimestamp_ms = SystemTiming::get_timestamp_ms();
+			newResponse.priority = (globalResponsePriorities.end() != priority) ? priority->second : static_cast<std::uint8_t>(CANIdentifier::CANPriority::PriorityDefault6);
+
+			if (useNAMEResponseOffset)
+			{
+				newResponse.dueTimestamp_ms += nameResponseOffset_ms;
+			}
+			else
+			{
+				newResponse.dueTimestamp_ms += responseDelayGenerator() % (static_cast<std::uint32_t>(globalResponseWindow_ms) + 1);
+			}
+			pendingGlobalResponses.push_back(newResponse);
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	void ParameterGroupNumberRequestProtocol::update_global_responses()
+	{
+		const std::lock_guard<std::mutex> lock(pgnRequestMutex);
+		const std::uint32_t currentTime_ms = SystemTiming::get_timestamp_ms();
+
+		for (std::uint8_t i = 0; (i < MAXIMUM_GLOBAL_RESPONSES_PER_UPDATE) && (!pendingGlobalResponses.empty()); i++)
+		{
+			auto nextResponse = pendingGlobalResponses.end();
+
+			// The list is short, so finding the best due response by scanning is cheaper than keeping it sorted
+			for (auto response = pendingGlobalResponses.begin(); response != pendingGlobalResponses.end(); response++)
+			{
+				if ((static_cast<std::int32_t>(currentTime_ms - response->dueTimestamp_ms) >= 0) &&
+				    ((pendingGlobalResponses.end() == nextResponse) ||
+				     (response->priority < nextResponse->priority) ||
+				     ((response->priority == nextResponse->priority) &&
+				      (static_cast<std::int32_t>(response->dueTimestamp_ms - nextResponse->dueTimestamp_ms) < 0))))
+				{
+					nextResponse = response;
+				}
+			}
+
+			if (pendingGlobalResponses.end() == nextResponse)
+			{
+				break;
+			}
+
+			const PendingGlobalResponse response = *nextResponse;
+			bool shouldAck = false;
+			AcknowledgementType ackType = AcknowledgementType::Negative;
+
+			pendingGlobalResponses.erase(nextResponse);
+
+			if (!call_pgn_request_callbacks(response.pgn, response.pgn, response.requester, shouldAck, ackType))
+			{
+				call_pgn_request_callbacks(static_cast<std::uint32_t>(isobus::CANLibParameterGroupNumber::Any), response.pgn, response.requester, shouldAck, ackType);
+			}
+		}
+	}
+
+	bool ParameterGroupNumberRequestProtocol::is_due_later(const PeriodicPGNSchedule &first, const PeriodicPGNSchedule &second)
+	{
+		// Compared as a signed difference so the order stays correct when the millisecond timestamp wraps
+		return (static_cast<std::int32_t>(first.nextTransmission_ms - second.nextTransmission_ms) > 0);
+	}
+
+	void ParameterGroupNumberRequestProtocol::process_control_function_event(ControlFunction *controlFunction, ControlFunctionEvent event, std::uint8_t, void *parent)
+	{
+		if ((ControlFunctionEvent::Deleted == event) &&
+		    (nullptr != parent))
+		{
+			ParameterGroupNumberRequestProtocol *protocol = reinterpret_cast<ParameterGroupNumberRequestProtocol *>(parent);
+
+			{
+				const std::lock_guard<std::mutex> lock(protocol->periodicPGNMutex);
+
+				// The schedule is keyed by the requester's pointer, which is about to dangle
+				protocol->periodicSchedule.erase(std::remove_if(protocol->periodicSchedule.begin(), protocol->periodicSchedule.end(), [controlFunction](const PeriodicPGNSchedule &entry) { return controlFunction == entry.destination; }), protocol->periodicSchedule.end());
+				std::make_heap(protocol->periodicSchedule.begin(), protocol->periodicSchedule.end(), is_due_later);
+			}
+
+			// So are the deferred responses to its requests, which would pass it to the callbacks
+			const std::lock_guard<std::mutex> lock(protocol->pgnRequestMutex);
+			protocol->pendingGlobalResponses.erase(std::remove_if(protocol->pendingGlobalResponses.begin(), protocol->pendingGlobalResponses.end(), [controlFunction](const PendingGlobalResponse &entry) { return controlFunction == entry.requester; }), protocol->pendingGlobalResponses.end());
+		}
+	}
+
+	bool ParameterGroupNumberRequestProtocol::process_repetition_rate_request(std::uint32_t pgn, ControlFunction *requester, std::uint16_t requestedRate_ms)
+	{
+		bool retVal = false;
+		const std::lock_guard<std::mutex> lock(periodicPGNMutex);
+
+		if ((nullptr != requester) &&
+		    (periodicPGNs.end() != std::find_if(periodicPGNs.begin(), periodicPGNs.end(), [pgn](const PeriodicPGN &entry) { return pgn == entry.pgn; })))
+		{
+			auto requesterSchedule = std::find_if(periodicSchedule.begin(), periodicSchedule.end(), [pgn, requester](const PeriodicPGNSchedule &entry) { return ((pgn == entry.pgn) && (requester == entry.destination)); });
+
+			if (periodicSchedule.end() != requesterSchedule)
+			{
+				periodicSchedule.erase(requesterSchedule);
+				std::make_heap(periodicSchedule.begin(), periodicSchedule.end(), is_due_later);
+			}
+
+			if ((DEFAULT_REPETITION_RATE != requestedRate_ms) &&
+			    (0 != requestedRate_ms))
+			{
+				PeriodicPGNSchedule newSchedule;
+
+				newSchedule.statistics = { 0, 0, 0, 0 };
+				newSchedule.consecutiveFailures = 0;
+				newSchedule.destination = requester;
+				newSchedule.pgn = pgn;
+				newSchedule.nextTransmission_ms = SystemTiming::get_timestamp_ms();
+				newSchedule.rate_ms = std::max(requestedRate_ms, MINIMUM_REPETITION_RATE_MS);
+				periodicSchedule.push_back(newSchedule);
+				std::push_heap(periodicSchedule.begin(), periodicSchedule.end(), is_due_later);
+			}
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	void ParameterGroupNumberRequestProtocol::update_periodic_pgns()
+	{
+		const std::lock_guard<std::mutex> lock(periodicPGNMutex);
+		const std::uint32_t currentTime_ms = SystemTiming::get_timestamp_ms();
+		auto heapEnd = periodicSchedule.end();
+
+		// Move every due entry behind the heap, so each is sent at most once per update even if its callback fails
+		while ((periodicSchedule.begin() != heapEnd) &&
+		       (static_cast<std::int32_t>(currentTime_ms - periodicSchedule.front().nextTransmission_ms) >= 0))
+		{
+			std::pop_heap(periodicSchedule.begin(), heapEnd, is_due_later);
+			heapEnd--;
+		}
+
+		bool anyScheduleDropped = false;
+
+		for (auto dueEntry = heapEnd; dueEntry != periodicSchedule.end(); dueEntry++)
+		{
+			const std::uint32_t pgn = dueEntry->pgn;
+			auto periodicPGN = std::find_if(periodicPGNs.begin(), periodicPGNs.end(), [pgn](const PeriodicPGN &entry) { return pgn == entry.pgn; });
+
+			if ((nullptr != dueEntry->destination) &&
+			    (!dueEntry->destination->get_address_valid()))
+			{
+				// The requester lost its address, so nobody is listening for its rate any more
+				dueEntry->consecutiveFailures = MAXIMUM_CONSECUTIVE_PERIODIC_FAILURES;
+				anyScheduleDropped = true;
+			}
+			else if ((nullptr == dueEntry->destination) &&
+			         (nullptr != myControlFunction) &&
+			         (!CANNetworkManager::CANNetwork.get_is_broadcast_allowed(myControlFunction->get_can_port(), pgn)))
+			{
+				// Broadcasts are suspended, so skip this transmission without counting it as a failure.
+				// Transmissions directed at a requester are not broadcasts, so they carry on.
+				dueEntry->nextTransmission_ms = currentTime_ms + dueEntry->rate_ms;
+			}
+			else if ((periodicPGNs.end() != periodicPGN) &&
+			         (periodicPGN->callbackFunction(pgn, dueEntry->destination, periodicPGN->parent)))
+			{
+				const std::uint32_t jitter_ms = currentTime_ms - dueEntry->nextTransmission_ms;
+
+				dueEntry->consecutiveFailures = 0;
+				dueEntry->statistics.numberOfTransmissions++;
+				dueEntry->statistics.totalJitter_ms += jitter_ms;
+				dueEntry->statistics.maximumJitter_ms = std::max(dueEntry->statistics.maximumJitter_ms, jitter_ms);
+
+				if (jitter_ms < dueEntry->rate_ms)
+				{
+					// Planning from the due time instead of the send time keeps the average rate exact
+					dueEntry->nextTransmission_ms += dueEntry->rate_ms;
+				}
+				else
+				{
+					// A whole period was missed, so start again from now instead of sending a burst to catch up
+					dueEntry->nextTransmission_ms = currentTime_ms + dueEntry->rate_ms;
+				}
+			}
+			else
+			{
+				// Wait for the next period instead of retrying on every update and flooding a busy bus
+				dueEntry->statistics.numberOfFailedTransmissions++;
+				dueEntry->nextTransmission_ms = currentTime_ms + dueEntry->rate_ms;
+
+				if (dueEntry->consecutiveFailures < MAXIMUM_CONSECUTIVE_PERIODIC_FAILURES)
+				{
+					dueEntry->consecutiveFailures++;
+				}
+
+				if ((nullptr != dueEntry->destination) &&
+				    (MAXIMUM_CONSECUTIVE_PERIODIC_FAILURES <= dueEntry->consecutiveFailures))
+				{
+					anyScheduleDropped = true;
+				}
+			}
+			std::push_heap(periodicSchedule.begin(), dueEntry + 1, is_due_later);
+		}
+
+		if (anyScheduleDropped)
+		{
+			// Requested rates that keep failing are dropped, the default broadcast is kept so it recovers by itself
+			periodicSchedule.erase(std::remove_if(periodicSchedule.begin(), periodicSchedule.end(), [](const PeriodicPGNSchedule &entry) { return ((nullptr != entry.destination) && (MAXIMUM_CONSECUTIVE_PERIODIC_FAILURES <= entry.consecutiveFailures)); }), periodicSchedule.end());
+			std::make_heap(periodicSchedule.begin(), periodicSchedule.end(), is_due_later);
+		}
+	}
+
 	bool ParameterGroupNumberRequestProtocol::send_acknowledgement(AcknowledgementType type, std::uint32_t parameterGroupNumber, InternalControlFunction *source, ControlFunction *destination)
 	{
 		bool retVal = false;
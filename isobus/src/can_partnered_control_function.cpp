@@ -22,11 +22,15 @@ namespace isobus
 	PartneredControlFunction::PartneredControlFunction(std::uint8_t CANPort, const std::vector<NAMEFilter> NAMEFilters) :
 	  ControlFunction(NAME(0), NULL_CAN_ADDRESS, CANPort),
 	  NAMEFilterList(NAMEFilters),
+	  compiledNAMEFilterMask(0),
+	  compiledNAMEFilterValue(0),
+	  compiledNAMEFilterCanMatch(false),
 	  initialized(false)
 	{
 		const std::lock_guard<std::mutex> lock(ControlFunction::controlFunctionProcessingMutex);
 		bool emptyPartnerSlotFound = false;
 		controlFunctionType = Type::Partnered;
+		compile_name_filters();
 
 		for (auto &partner : partneredControlFunctionList)
 		{
@@ -107,86 +111,14 @@ namespace isobus
 
 	bool PartneredControlFunction::check_matches_name(NAME NAMEToCheck) const
 	{
-		std::uint32_t currentFilterValue;
-		NAME::NAMEParameters currentFilterParameter;
-		bool retVal = true;
+		const std::uint64_t rawNAME = NAMEToCheck.get_full_name();
+		bool retVal = (compiledNAMEFilterCanMatch &&
+		               ((rawNAME & compiledNAMEFilterMask) == compiledNAMEFilterValue));
 
-		if (0 == get_number_name_filters())
+		for (std::size_t i = 0; (retVal) && (i < compiledNAMEFilterValueSets.size()); i++)
 		{
-			retVal = false;
-		}
-
-		for (std::uint32_t i = 0; i < get_number_name_filters(); i++)
-		{
-			get_name_filter_parameter(i, currentFilterParameter, currentFilterValue);
-
-			switch (currentFilterParameter)
-			{
-				case NAME::NAMEParameters::IdentityNumber:
-				{
-					retVal = (currentFilterValue == NAMEToCheck.get_identity_number());
-				}
-				break;
-
-				case NAME::NAMEParameters::ManufacturerCode:
-				{
-					retVal = (currentFilterValue == NAMEToCheck.get_manufacturer_code());
-				}
-				break;
-
-				case NAME::NAMEParameters::EcuInstance:
-				{
-					retVal = (currentFilterValue == NAMEToCheck.get_ecu_instance());
-				}
-				break;
-
-				case NAME::NAMEParameters::FunctionInstance:
-				{
-					retVal = (currentFilterValue == NAMEToCheck.get_function_instance());
-				}
-				break;
-
-				case NAME::NAMEParameters::FunctionCode:
-				{
-					retVal = (currentFilterValue == NAMEToCheck.get_function_code());
-				}
-				break;
-
-				case NAME::NAMEParameters::DeviceClass:
-				{
-					retVal = (currentFilterValue == NAMEToCheck.get_device_class());
-				}
-				break;
-
-				case NAME::NAMEParameters::DeviceClassInstance:
-				{
-					retVal = (currentFilterValue == NAMEToCheck.get_device_class_instance());
-				}
-				break;
-
-				case NAME::NAMEParameters::IndustryGroup:
-				{
-					retVal = (currentFilterValue == NAMEToCheck.get_industry_group());
-				}
-				break;
-
-				case NAME::NAMEParameters::ArbitraryAddressCapable:
-				{
-					retVal = ((0 != currentFilterValue) == NAMEToCheck.get_arbitrary_address_capable());
-				}
-				break;
-
-				default:
-				{
-					retVal = false;
-				}
-				break;
-			}
-
-			if (false == retVal)
-			{
-				break;
-			}
+			const NAMEFilterValueSet &currentSet = compiledNAMEFilterValueSets[i];
+			retVal = (currentSet.values.end() != std::find(currentSet.values.begin(), currentSet.values.end(), rawNAME & currentSet.mask));
 		}
 		return retVal;
 	}
@@ -221,4 +153,72 @@ namespace isobus
 		return retVal;
 	}
 
+	void PartneredControlFunction::compile_name_filters()
+	{
+		const NAME::NAMEParameters allParameters[] = { NAME::NAMEParameters::IdentityNumber,
+			                                            NAME::NAMEParameters::ManufacturerCode,
+			                                            NAME::NAMEParameters::EcuInstance,
+			                                            NAME::NAMEParameters::FunctionInstance,
+			                                            NAME::NAMEParameters::FunctionCode,
+			                                            NAME::NAMEParameters::DeviceClass,
+			                                            NAME::NAMEParameters::DeviceClassInstance,
+			                                            NAME::NAMEParameters::IndustryGroup,
+			                                            NAME::NAMEParameters::ArbitraryAddressCapable };
+
+		compiledNAMEFilterMask = 0;
+		compiledNAMEFilterValue = 0;
+		compiledNAMEFilterValueSets.clear();
+		std::size_t numberOfKnownFilters = 0;
+		compiledNAMEFilterCanMatch = (!NAMEFilterList.empty());
+
+		for (const auto &currentParameter : allParameters)
+		{
+			NAMEFilterValueSet parameterSet = { 0, {} };
+			bool parameterFiltered = false;
+
+			for (const auto &currentFilter : NAMEFilterList)
+			{
+				std::uint64_t mask = 0;
+				std::uint64_t value = 0;
+
+				if (currentParameter == currentFilter.get_parameter())
+				{
+					parameterFiltered = true;
+					numberOfKnownFilters++;
+
+					if ((currentFilter.get_raw_name_mask_and_value(mask, value)) &&
+					    (parameterSet.values.end() == std::find(parameterSet.values.begin(), parameterSet.values.end(), value)))
+					{
+						parameterSet.mask = mask;
+						parameterSet.values.push_back(value);
+					}
+				}
+			}
+
+			if (parameterFiltered)
+			{
+				if (parameterSet.values.empty())
+				{
+					// Every filter on this parameter has a value the NAME can't hold
+					compiledNAMEFilterCanMatch = false;
+				}
+				else if (1 == parameterSet.values.size())
+				{
+					compiledNAMEFilterMask |= parameterSet.mask;
+					compiledNAMEFilterValue |= parameterSet.values.front();
+				}
+				else
+				{
+					compiledNAMEFilterValueSets.push_back(parameterSet);
+				}
+			}
+		}
+
+		if (numberOfKnownFilters != NAMEFilterList.size())
+		{
+			// A filter on a parameter the NAME doesn't have can never be satisfied
+			compiledNAMEFilterCanMatch = false;
+		}
+	}
+
 } // namespace isobus
@@ -0,0 +1,599 @@
+//================================================================================================
+/// @file can_stack_async_logger.cpp
+///
+/// @brief Implements an asynchronous backend for the CAN stack logger. Log statements are stored as
+/// compact binary records and formatted on a background thread.
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#include "isobus/isobus/can_stack_async_logger.hpp"
+
+#include "isobus/utility/system_timing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace isobus
+{
+	std::vector<std::unique_ptr<CANStackAsyncLogger::ThreadRing>> CANStackAsyncLogger::rings;
+	std::vector<CANStackAsyncLogger::Record> CANStackAsyncLogger::drainedRecords;
+	std::unordered_map<const char *, std::uint16_t> CANStackAsyncLogger::messageIDs;
+	std::mutex CANStackAsyncLogger::ringsMutex;
+	std::mutex CANStackAsyncLogger::drainMutex;
+	std::thread *CANStackAsyncLogger::drainThread = nullptr;
+	std::ostream *CANStackAsyncLogger::binaryOutput = nullptr;
+	std::atomic<std::uint32_t> CANStackAsyncLogger::droppedRecords(0);
+	std::atomic<std::uint32_t> CANStackAsyncLogger::drainPeriod_ms(DEFAULT_DRAIN_PERIOD_MS);
+	std::atomic<bool> CANStackAsyncLogger::running(false);
+	std::atomic<std::uint32_t> CANStackAsyncLogger::activeWriters(0);
+	thread_local CANStackAsyncLogger::ThreadRingOwner CANStackAsyncLogger::threadRingOwner = { nullptr };
+
+	/// @brief Writes a value to a binary stream in little endian byte order
+	/// @param[in] output The stream to write to
+	/// @param[in] value The value to write
+	/// @param[in] numberOfBytes The number of bytes of the value to write
+	static void write_little_endian(std::ostream &output, std::uint64_t value, std::uint8_t numberOfBytes)
+	{
+		for (std::uint8_t i = 0; i < numberOfBytes; i++)
+		{
+			output.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+		}
+	}
+
+	/// @brief Reads a value from a binary stream in little endian byte order
+	/// @param[in] input The stream to read from
+	/// @param[out] value The value that was read
+	/// @param[in] numberOfBytes The number of bytes of the value to read
+	/// @returns true if all the bytes were read
+	static bool read_little_endian(std::istream &input, std::uint64_t &value, std::uint8_t numberOfBytes)
+	{
+		char bytes[8];
+		bool retVal = false;
+
+		value = 0;
+		if (input.read(bytes, numberOfBytes))
+		{
+			for (std::uint8_t i = 0; i < numberOfBytes; i++)
+			{
+				value |= (static_cast<std::uint64_t>(static_cast<std::uint8_t>(bytes[i])) << (8 * i));
+			}
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	CANStackAsyncLogger::ThreadRingOwner::~ThreadRingOwner()
+	{
+		if (nullptr != ring)
+		{
+			ring->inUse = false;
+		}
+	}
+
+	bool CANStackAsyncLogger::start(std::uint32_t newDrainPeriod_ms)
+	{
+		const std::lock_guard<std::mutex> lock(ringsMutex);
+		bool retVal = false;
+
+		if (nullptr == drainThread)
+		{
+			drainPeriod_ms = std::max(newDrainPeriod_ms, static_cast<std::uint32_t>(1));
+			running = true;
+			drainThread = new std::thread(drain_thread_function);
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	bool CANStackAsyncLogger::stop()
+	{
+		std::thread *threadToJoin = nullptr;
+		bool retVal = false;
+
+		{
+			const std::lock_guard<std::mutex> lock(ringsMutex);
+
+			if (nullptr != drainThread)
+			{
+				threadToJoin = drainThread;
+				drainThread = nullptr;
+				running = false;
+			}
+		}
+
+		if (nullptr != threadToJoin)
+		{
+			threadToJoin->join();
+			delete threadToJoin;
+
+			// A thread that saw running just before it was cleared may still be writing its record
+			while (0 != activeWriters)
+			{
+				std::this_thread::yield();
+			}
+
+			// Pick up anything logged between the thread's last drain and running being cleared
+			drain();
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	bool CANStackAsyncLogger::get_is_running()
+	{
+		return running;
+	}
+
+	void CANStackAsyncLogger::set_binary_output(std::ostream *output)
+	{
+		const std::lock_guard<std::mutex> lock(drainMutex);
+
+		binaryOutput = output;
+		messageIDs.clear();
+		if (nullptr != binaryOutput)
+		{
+			binaryOutput->write("CSL", 3);
+			binaryOutput->put(static_cast<char>(BINARY_VERSION));
+		}
+	}
+
+	std::uint32_t CANStackAsyncLogger::get_number_dropped_records()
+	{
+		return droppedRecords;
+	}
+
+	bool CANStackAsyncLogger::log(CANStackLogger::LoggingLevel level, const char *format, va_list arguments)
+	{
+		bool retVal = false;
+
+		// Counted before running is checked, so stop either sees this writer or this writer sees running cleared
+		activeWriters++;
+		if ((running) &&
+		    (nullptr != format))
+		{
+			ThreadRing *ring = get_thread_ring();
+			const std::uint32_t writeIndex = ring->writeIndex.load(std::memory_order_relaxed);
+
+			if ((writeIndex - ring->readIndex.load(std::memory_order_acquire)) < RECORDS_PER_THREAD)
+			{
+				Record &record = ring->records[writeIndex & (RECORDS_PER_THREAD - 1)];
+				const char *conversion = format;
+
+				record.timestamp_us = SystemTiming::get_timestamp_us();
+				record.format = format;
+				record.level = level;
+				record.numberOfArguments = 0;
+
+				// Only the argument types are needed here, the rest of each conversion is applied when the record is formatted
+				while ((record.numberOfArguments < MAXIMUM_ARGUMENTS) &&
+				       (nullptr != conversion) &&
+				       (nullptr != (conversion = std::strchr(conversion, '%'))))
+				{
+					std::uint8_t numberOfLongs = 0;
+
+					conversion++;
+					if ('%' == *conversion)
+					{
+						conversion++;
+						continue;
+					}
+					conversion += std::strspn(conversion, "-+ #0123456789.");
+					while (('\0' != *conversion) &&
+					       (nullptr != std::strchr("hlLjzt", *conversion)))
+					{
+						if ('l' == *conversion)
+						{
+							numberOfLongs++;
+						}
+						conversion++;
+					}
+
+					std::uint64_t &argument = record.arguments[record.numberOfArguments];
+					argument = 0;
+					switch (*conversion)
+					{
+						case 'd':
+						case 'i':
+						{
+							if (numberOfLongs >= 2)
+							{
+								argument = static_cast<std::uint64_t>(va_arg(arguments, long long));
+							}
+							else if (1 == numberOfLongs)
+							{
+								argument = static_cast<std::uint64_t>(static_cast<long long>(va_arg(arguments, long)));
+							}
+							else
+							{
+								argument = static_cast<std::uint64_t>(static_cast<long long>(va_arg(arguments, int)));
+							}
+						}
+						break;
+
+						case 'u':
+						case 'x':
+						case 'X':
+						case 'o':
+						case 'c':
+						{
+							if (numberOfLongs >= 2)
+							{
+								argument = va_arg(arguments, unsigned long long);
+							}
+							else if (1 == numberOfLongs)
+							{
+								argument = va_arg(arguments, unsigned long);
+							}
+							else
+							{
+								argument = va_arg(arguments, unsigned int);
+							}
+						}
+						break;
+
+						case 's':
+						{
+							const char *text = va_arg(arguments, const char *);
+
+							if (nullptr != text)
+							{
+								std::memcpy(&argument, text, std::min(std::strlen(text), sizeof(argument)));
+							}
+						}
+						break;
+
+						case 'p':
+						{
+							argument = reinterpret_cast<std::uintptr_t>(va_arg(arguments, void *));
+						}
+						break;
+
+						case 'f':
+						case 'F':
+						case 'e':
+						case 'E':
+						case 'g':
+						case 'G':
+						case 'a':
+						case 'A':
+						{
+							const double value = va_arg(arguments, double);
+							std::memcpy(&argument, &value, sizeof(argument));
+						}
+						break;
+
+						default:
+						{
+							// An unsupported conversion, so the arguments after it can't be located
+							conversion = nullptr;
+						}
+						break;
+					}
+
+					if (nullptr != conversion)
+					{
+						record.numberOfArguments++;
+					}
+				}
+				ring->writeIndex.store(writeIndex + 1, std::memory_order_release);
+			}
+			else
+			{
+				droppedRecords++;
+			}
+			retVal = true;
+		}
+		activeWriters--;
+		return retVal;
+	}
+
+	void CANStackAsyncLogger::format_record(const char *format, const Record &record, char *buffer, std::size_t bufferSize)
+	{
+		std::size_t length = 0;
+		std::uint8_t argumentIndex = 0;
+
+		if ((nullptr != buffer) &&
+		    (0 != bufferSize))
+		{
+			buffer[0] = '\0';
+			while ((nullptr != format) &&
+			       ('\0' != *format) &&
+			       ((length + 1) < bufferSize))
+			{
+				if ('%' != *format)
+				{
+					buffer[length] = *format;
+					length++;
+					format++;
+					continue;
+				}
+				else if ('%' == format[1])
+				{
+					buffer[length] = '%';
+					length++;
+					format += 2;
+					continue;
+				}
+
+				// Rebuild the conversion with the width of the stored argument
+				char conversion[24] = "%";
+				const char *flagsEnd = format + 1 + std::strspn(format + 1, "-+ #0123456789.");
+				const char *type = flagsEnd + std::strspn(flagsEnd, "hlLjzt");
+				const std::size_t flagsLength = std::min(static_cast<std::size_t>(flagsEnd - format - 1), sizeof(conversion) - 5);
+				int written = 0;
+
+				std::memcpy(&conversion[1], format + 1, flagsLength);
+				conversion[flagsLength + 1] = '\0';
+				format = ('\0' != *type) ? (type + 1) : type;
+
+				if (argumentIndex >= record.numberOfArguments)
+				{
+					written = snprintf(&buffer[length], bufferSize - length, "?");
+				}
+				else
+				{
+					const std::uint64_t argument = record.arguments[argumentIndex];
+
+					switch (*type)
+					{
+						case 'd':
+						case 'i':
+						case 'u':
+						case 'x':
+						case 'X':
+						case 'o':
+						{
+							std::strcat(conversion, "ll");
+							std::strncat(conversion, type, 1);
+							if (('d' == *type) || ('i' == *type))
+							{
+								written = snprintf(&buffer[length], bufferSize - length, conversion, static_cast<long long>(argument));
+							}
+							else
+							{
+								written = snprintf(&buffer[length], bufferSize - length, conversion, static_cast<unsigned long long>(argument));
+							}
+						}
+						break;
+
+						case 'c':
+						{
+							std::strcat(conversion, "c");
+							written = snprintf(&buffer[length], bufferSize - length, conversion, static_cast<int>(argument));
+						}
+						break;
+
+						case 's':
+						{
+							char text[sizeof(argument) + 1] = { 0 };
+
+							std::memcpy(text, &argument, sizeof(argument));
+							std::strcat(conversion, "s");
+							written = snprintf(&buffer[length], bufferSize - length, conversion, text);
+						}
+						break;
+
+						case 'p':
+						{
+							written = snprintf(&buffer[length], bufferSize - length, "0x%llx", static_cast<unsigned long long>(argument));
+						}
+						break;
+
+						case 'f':
+						case 'F':
+						case 'e':
+						case 'E':
+						case 'g':
+						case 'G':
+						case 'a':
+						case 'A':
+						{
+							double value;
+
+							std::memcpy(&value, &argument, sizeof(value));
+							std::strncat(conversion, type, 1);
+							written = snprintf(&buffer[length], bufferSize - length, conversion, value);
+						}
+						break;
+
+						default:
+						{
+							written = snprintf(&buffer[length], bufferSize - length, "?");
+						}
+						break;
+					}
+				}
+				argumentIndex++;
+
+				if (written > 0)
+				{
+					length = std::min(length + static_cast<std::size_t>(written), bufferSize - 1);
+				}
+			}
+			buffer[length] = '\0';
+		}
+	}
+
+	bool CANStackAsyncLogger::decode(std::istream &input, std::ostream &output)
+	{
+		static const char *levelNames[] = { "Debug", "Info", "Warning", "Error", "Critical" };
+		std::vector<std::string> formats;
+		char header[4];
+		char text[CANStackLogger::MAXIMUM_FORMATTED_LOG_LENGTH + 1];
+		bool retVal = false;
+
+		if ((input.read(header, sizeof(header))) &&
+		    (0 == std::memcmp(header, "CSL", 3)) &&
+		    (BINARY_VERSION == static_cast<std::uint8_t>(header[3])))
+		{
+			int tag;
+
+			retVal = true;
+			while ((retVal) &&
+			       (std::char_traits<char>::eof() != (tag = input.get())))
+			{
+				std::uint64_t messageID = 0;
+				std::uint64_t value = 0;
+
+				retVal = false;
+				if (static_cast<int>(BinaryTag::Format) == tag)
+				{
+					if ((read_little_endian(input, messageID, 2)) &&
+					    (read_little_endian(input, value, 2)))
+					{
+						std::string format(static_cast<std::size_t>(value), '\0');
+
+						if ((formats.size() == messageID) &&
+						    ((0 == value) || (input.read(&format[0], static_cast<std::streamsize>(value)))))
+						{
+							formats.push_back(format);
+							retVal = true;
+						}
+					}
+				}
+				else if (static_cast<int>(BinaryTag::Record) == tag)
+				{
+					Record record;
+					std::uint64_t level = 0;
+					std::uint64_t numberOfArguments = 0;
+
+					if ((read_little_endian(input, record.timestamp_us, 8)) &&
+					    (read_little_endian(input, level, 1)) &&
+					    (read_little_endian(input, messageID, 2)) &&
+					    (read_little_endian(input, numberOfArguments, 1)) &&
+					    (level < (sizeof(levelNames) / sizeof(levelNames[0]))) &&
+					    (messageID < formats.size()) &&
+					    (numberOfArguments <= MAXIMUM_ARGUMENTS))
+					{
+						record.numberOfArguments = static_cast<std::uint8_t>(numberOfArguments);
+						retVal = true;
+						for (std::uint8_t i = 0; i < record.numberOfArguments; i++)
+						{
+							retVal = retVal && read_little_endian(input, record.arguments[i], 8);
+						}
+
+						if (retVal)
+						{
+							format_record(formats[static_cast<std::size_t>(messageID)].c_str(), record, text, sizeof(text));
+							output << "[" << record.timestamp_us << "] [" << levelNames[level] << "] " << text << "\n";
+						}
+					}
+				}
+			}
+		}
+		return retVal;
+	}
+
+	CANStackAsyncLogger::ThreadRing *CANStackAsyncLogger::get_thread_ring()
+	{
+		if (nullptr == threadRingOwner.ring)
+		{
+			const std::lock_guard<std::mutex> lock(ringsMutex);
+
+			for (auto &ring : rings)
+			{
+				if (!ring->inUse)
+				{
+					// The old owner is gone, and the indices carry on, so records it left are still drained in order
+					threadRingOwner.ring = ring.get();
+					break;
+				}
+			}
+
+			if (nullptr == threadRingOwner.ring)
+			{
+				rings.push_back(std::unique_ptr<ThreadRing>(new ThreadRing()));
+				threadRingOwner.ring = rings.back().get();
+				threadRingOwner.ring->writeIndex = 0;
+				threadRingOwner.ring->readIndex = 0;
+			}
+			threadRingOwner.ring->inUse = true;
+		}
+		return threadRingOwner.ring;
+	}
+
+	void CANStackAsyncLogger::drain_thread_function()
+	{
+		while (running)
+		{
+			drain();
+			std::this_thread::sleep_for(std::chrono::milliseconds(drainPeriod_ms));
+		}
+	}
+
+	void CANStackAsyncLogger::drain()
+	{
+		const std::lock_guard<std::mutex> drainLock(drainMutex);
+		char text[CANStackLogger::MAXIMUM_FORMATTED_LOG_LENGTH + 1];
+
+		drainedRecords.clear();
+		{
+			const std::lock_guard<std::mutex> lock(ringsMutex);
+
+			for (auto &ring : rings)
+			{
+				std::uint32_t readIndex = ring->readIndex.load(std::memory_order_relaxed);
+				const std::uint32_t writeIndex = ring->writeIndex.load(std::memory_order_acquire);
+
+				for (; readIndex != writeIndex; readIndex++)
+				{
+					drainedRecords.push_back(ring->records[readIndex & (RECORDS_PER_THREAD - 1)]);
+				}
+				ring->readIndex.store(readIndex, std::memory_order_release);
+			}
+		}
+
+		// Each ring is already in order, so this only interleaves the threads
+		std::stable_sort(drainedRecords.begin(), drainedRecords.end(), [](const Record &first, const Record &second) { return first.timestamp_us < second.timestamp_us; });
+
+		for (const auto &record : drainedRecords)
+		{
+			if (nullptr != binaryOutput)
+			{
+				write_binary_record(record);
+			}
+			format_record(record.format, record, text, sizeof(text));
+			CANStackLogger::CAN_stack_log(record.level, text);
+		}
+
+		if ((nullptr != binaryOutput) &&
+		    (!drainedRecords.empty()))
+		{
+			binaryOutput->flush();
+		}
+	}
+
+	void CANStackAsyncLogger::write_binary_record(const Record &record)
+	{
+		auto messageID = messageIDs.find(record.format);
+
+		if (messageIDs.end() == messageID)
+		{
+			const std::size_t formatLength = std::min(std::strlen(record.format), static_cast<std::size_t>(0xFFFF));
+
+			messageID = messageIDs.emplace(record.format, static_cast<std::uint16_t>(messageIDs.size())).first;
+			binaryOutput->put(static_cast<char>(BinaryTag::Format));
+			write_little_endian(*binaryOutput, messageID->second, 2);
+			write_little_endian(*binaryOutput, formatLength, 2);
+			binaryOutput->write(record.format, static_cast<std::streamsize>(formatLength));
+		}
+
+		binaryOutput->put(static_cast<char>(BinaryTag::Record));
+		write_little_endian(*binaryOutput, record.timestamp_us, 8);
+		write_little_endian(*binaryOutput, static_cast<std::uint64_t>(record.level), 1);
+		write_little_endian(*binaryOutput, messageID->second, 2);
+		write_little_endian(*binaryOutput, record.numberOfArguments, 1);
+		for (std::uint8_t i = 0; i < record.numberOfArguments; i++)
+		{
+			write_little_endian(*binaryOutput, record.arguments[i], 8);
+		}
+	}
+
+} // namespace isobus
@@ -9,12 +9,16 @@
 //================================================================================================
 #include "isobus/isobus/can_stack_logger.hpp"
 
+#include "isobus/isobus/can_stack_async_logger.hpp"
+
+#include <cstdarg>
+#include <cstdio>
 #include <iostream>
 
 namespace isobus
 {
-	CANStackLogger *CANStackLogger::logger = nullptr;
-	CANStackLogger::LoggingLevel CANStackLogger::currentLogLevel = LoggingLevel::Info;
+	std::atomic<CANStackLogger *> CANStackLogger::logger(nullptr);
+	std::atomic<CANStackLogger::LoggingLevel> CANStackLogger::currentLogLevel(LoggingLevel::Info);
 	std::mutex CANStackLogger::loggerMutex;
 
 	CANStackLogger::CANStackLogger()
@@ -37,6 +41,28 @@ namespace isobus
 		}
 	}
 
+	void CANStackLogger::CAN_stack_log_formatted(LoggingLevel level, const char *format, ...)
+	{
+		char buffer[MAXIMUM_FORMATTED_LOG_LENGTH + 1];
+		va_list arguments;
+
+		va_start(arguments, format);
+		if (!CANStackAsyncLogger::log(level, format, arguments))
+		{
+			if (vsnprintf(buffer, sizeof(buffer), format, arguments) >= 0)
+			{
+				CAN_stack_log(level, buffer);
+			}
+		}
+		va_end(arguments);
+	}
+
+	bool CANStackLogger::get_is_log_level_enabled(LoggingLevel level)
+	{
+		return (((nullptr != logger.load()) || (CANStackAsyncLogger::get_is_running())) &&
+		        (level >= currentLogLevel.load()));
+	}
+
 	void CANStackLogger::debug(const std::string &logText)
 	{
 		CAN_stack_log(LoggingLevel::Debug, logText);
@@ -99,20 +99,18 @@ namespace isobus
 									newSession->state = StateMachineState::RxDataSession;
 									newSession->timestamp_ms = SystemTiming::get_timestamp_ms();
 									activeSessions.push_back(newSession);
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug,
-									                              "[TP]: New Rx BAM Session. Source: " +
-									                                isobus::to_string(static_cast<int>(newSession->sessionMessage.get_source_control_function()->get_address())));
+									CAN_STACK_LOG_DEBUG("[TP]: New Rx BAM Session. Source: %u", static_cast<unsigned int>(newSession->sessionMessage.get_source_control_function()->get_address()));
 								}
 								else
 								{
 									// Don't send an abort, they're probably expecting a CTS so it'll timeout
 									// Or maybe if we already had a session they sent a second BAM? Also bad
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Can't Create an Rx BAM session");
+									CAN_STACK_LOG_ERROR("[TP]: Can't Create an Rx BAM session");
 								}
 							}
 							else
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Bad BAM Message Length");
+								CAN_STACK_LOG_ERROR("[TP]: Bad BAM Message Length");
 							}
 						}
 						break;
@@ -142,20 +140,20 @@ namespace isobus
 								         (ControlFunction::Type::Internal == message->get_destination_control_function()->get_type()))
 								{
 									abort_session(pgn, ConnectionAbortReason::AlreadyInCMSession, reinterpret_cast<InternalControlFunction *>(message->get_destination_control_function()), message->get_source_control_function());
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Sent abort, RTS when already in CM session");
+									CAN_STACK_LOG_ERROR("[TP]: Sent abort, RTS when already in CM session");
 								}
 								else if ((activeSessions.size() >= CANNetworkConfiguration::get_max_number_transport_protcol_sessions()) &&
 								         (nullptr != message->get_destination_control_function()) &&
 								         (ControlFunction::Type::Internal == message->get_destination_control_function()->get_type()))
 								{
 									abort_session(pgn, ConnectionAbortReason::SystemResourcesNeeded, reinterpret_cast<InternalControlFunction *>(message->get_destination_control_function()), message->get_source_control_function());
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Sent abort, No Sessions Available");
+									CAN_STACK_LOG_ERROR("[TP]: Sent abort, No Sessions Available");
 								}
 							}
 							else
 							{
 								// Bad RTS message length. Can't really abort? Not sure what the PGN is if length < 8
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Received Bad Message Length for an RTS");
+								CAN_STACK_LOG_ERROR("[TP]: Received Bad Message Length for an RTS");
 							}
 						}
 						break;
@@ -188,7 +186,7 @@ namespace isobus
 										// The session exists, but we're probably already in the TxDataSession state. Need to abort
 										// In the case of Rx'ing a CTS, we're the source in the session
 										abort_session(pgn, ConnectionAbortReason::ClearToSendReceivedWhileTransferInProgress, reinterpret_cast<InternalControlFunction *>(message->get_destination_control_function()), message->get_source_control_function());
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Sent abort, CTS while in data session, PGN: " + isobus::to_string(pgn));
+										CAN_STACK_LOG_ERROR("[TP]: Sent abort, CTS while in data session, PGN: %u", static_cast<unsigned int>(pgn));
 									}
 								}
 								else
@@ -196,12 +194,12 @@ namespace isobus
 									// We got a CTS but no session exists. Aborting clears up the situation faster than waiting for them to timeout
 									// In the case of Rx'ing a CTS, we're the source in the session
 									abort_session(pgn, ConnectionAbortReason::AnyOtherError, reinterpret_cast<InternalControlFunction *>(message->get_destination_control_function()), message->get_source_control_function());
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Sent abort, CTS With no matching session, PGN: " + isobus::to_string(pgn));
+									CAN_STACK_LOG_ERROR("[TP]: Sent abort, CTS With no matching session, PGN: %u", static_cast<unsigned int>(pgn));
 								}
 							}
 							else
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[TP]: Received an Invalid CTS");
+								CAN_STACK_LOG_WARNING("[TP]: Received an Invalid CTS");
 							}
 						}
 						break;
@@ -225,18 +223,18 @@ namespace isobus
 									{
 										abort_session(pgn, ConnectionAbortReason::AnyOtherError, reinterpret_cast<InternalControlFunction *>(message->get_destination_control_function()), message->get_source_control_function());
 										close_session(session, false);
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Sent abort, received EOM in wrong session state, PGN: " + isobus::to_string(pgn));
+										CAN_STACK_LOG_ERROR("[TP]: Sent abort, received EOM in wrong session state, PGN: %u", static_cast<unsigned int>(pgn));
 									}
 								}
 								else
 								{
 									abort_session(pgn, ConnectionAbortReason::AnyOtherError, reinterpret_cast<InternalControlFunction *>(message->get_destination_control_function()), message->get_source_control_function());
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Sent abort, received EOM without matching session, PGN: " + isobus::to_string(pgn));
+									CAN_STACK_LOG_ERROR("[TP]: Sent abort, received EOM without matching session, PGN: %u", static_cast<unsigned int>(pgn));
 								}
 							}
 							else
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[TP]: Bad EOM received");
+								CAN_STACK_LOG_WARNING("[TP]: Bad EOM received");
 							}
 						}
 						break;
@@ -245,19 +243,19 @@ namespace isobus
 						{
 							if (get_session(session, message->get_destination_control_function(), message->get_source_control_function(), pgn))
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Received an abort for an session with PGN: " + isobus::to_string(pgn));
+								CAN_STACK_LOG_ERROR("[TP]: Received an abort for an session with PGN: %u", static_cast<unsigned int>(pgn));
 								close_session(session, false);
 							}
 							else
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[TP]: Received an abort with no matching session with PGN: " + isobus::to_string(pgn));
+								CAN_STACK_LOG_WARNING("[TP]: Received an abort with no matching session with PGN: %u", static_cast<unsigned int>(pgn));
 							}
 						}
 						break;
 
 						default:
 						{
-							CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[TP]: Bad Mux in Transport Protocol Command");
+							CAN_STACK_LOG_WARNING("[TP]: Bad Mux in Transport Protocol Command");
 						}
 						break;
 					}
@@ -293,25 +291,29 @@ namespace isobus
 								CANNetworkManager::CANNetwork.protocol_message_callback(&tempSession->sessionMessage);
 								close_session(tempSession, true);
 							}
-							tempSession->timestamp_ms = SystemTiming::get_timestamp_ms();
+							else
+							{
+								// close_session deletes a completed session, so only refresh the timeout of one still in progress
+								tempSession->timestamp_ms = SystemTiming::get_timestamp_ms();
+							}
 						}
 						else if (message->get_data()[SEQUENCE_NUMBER_DATA_INDEX] == (tempSession->lastPacketNumber))
 						{
 							// Sequence number is duplicate of the last one
-							CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Aborting session due to duplciate sequence number");
+							CAN_STACK_LOG_ERROR("[TP]: Aborting session due to duplciate sequence number");
 							abort_session(tempSession, ConnectionAbortReason::DuplicateSequenceNumber);
 							close_session(tempSession, false);
 						}
 						else
 						{
-							CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Aborting session due to bad sequence number");
+							CAN_STACK_LOG_ERROR("[TP]: Aborting session due to bad sequence number");
 							abort_session(tempSession, ConnectionAbortReason::BadSequenceNumber);
 							close_session(tempSession, false);
 						}
 					}
 					else
 					{
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[TP]: Invalid BAM TP Data Received");
+						CAN_STACK_LOG_WARNING("[TP]: Invalid BAM TP Data Received");
 						if (get_session(tempSession, message->get_source_control_function(), message->get_destination_control_function()))
 						{
 							// If a session matches and ther was an error, get rid of the session
@@ -325,7 +327,7 @@ namespace isobus
 				{
 					// This is not a runtime error, should never happen.
 					// Bad PGN passed to protocol. Check PGN registrations.
-					CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[TP]: Received an unexpected PGN");
+					CAN_STACK_LOG_WARNING("[TP]: Received an unexpected PGN");
 				}
 				break;
 			}
@@ -485,7 +487,7 @@ namespace isobus
 			{
 				activeSessions.erase(sessionLocation);
 				delete session;
-				CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug, "[TP]: Session Closed");
+				CAN_STACK_LOG_DEBUG("[TP]: Session Closed");
 			}
 		}
 	}
@@ -622,7 +624,7 @@ namespace isobus
 		}
 		else
 		{
-			CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[TP]: Attempted to send EOM to null session");
+			CAN_STACK_LOG_WARNING("[TP]: Attempted to send EOM to null session");
 		}
 		return retVal;
 	}
@@ -690,7 +692,7 @@ namespace isobus
 				{
 					if (SystemTiming::time_expired_ms(session->timestamp_ms, T2_T3_TIMEOUT_MS))
 					{
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: Timeout");
+						CAN_STACK_LOG_ERROR("[TP]: Timeout");
 						abort_session(session, ConnectionAbortReason::Timeout);
 						close_session(session, false);
 					}
@@ -838,7 +840,7 @@ namespace isobus
 						// BAM Timeout check
 						if (SystemTiming::time_expired_ms(session->timestamp_ms, T1_TIMEOUT_MS))
 						{
-							CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: BAM Rx Timeout");
+							CAN_STACK_LOG_ERROR("[TP]: BAM Rx Timeout");
 							close_session(session, false);
 						}
 					}
@@ -847,7 +849,7 @@ namespace isobus
 						// CM TP Timeout check
 						if (SystemTiming::time_expired_ms(session->timestamp_ms, MESSAGE_TR_TIMEOUT_MS))
 						{
-							CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[TP]: CM Rx Timeout");
+							CAN_STACK_LOG_ERROR("[TP]: CM Rx Timeout");
 							abort_session(session, ConnectionAbortReason::Timeout);
 							close_session(session, false);
 						}
@@ -42,11 +42,13 @@
 #include "isobus/utility/system_timing.hpp"
 
 #include <algorithm>
+#include <cstring>
 
 namespace isobus
 {
 	std::list<DiagnosticProtocol *> DiagnosticProtocol::diagnosticProtocolList;
 	constexpr DiagnosticProtocol::Network DiagnosticProtocol::J1939NetworkIndicies[DM13_NUMBER_OF_J1939_NETWORKS];
+	constexpr std::size_t DiagnosticProtocol::NO_DTC;
 
 	DiagnosticProtocol::DiagnosticTroubleCode::DiagnosticTroubleCode() :
 	  suspectParameterNumber(0xFFFFFFFF),
@@ -76,6 +78,8 @@ namespace isobus
 
 	DiagnosticProtocol::DiagnosticProtocol(std::shared_ptr<InternalControlFunction> internalControlFunction) :
 	  myControlFunction(internalControlFunction),
+	  activeDTCList({ NO_DTC, NO_DTC, 0, {}, {}, false }),
+	  inactiveDTCList({ NO_DTC, NO_DTC, 0, {}, {}, false }),
 	  txFlags(static_cast<std::uint32_t>(TransmitFlags::NumberOfFlags), process_flags, this),
 	  lastDM1SentTimestamp(0),
 	  stopBroadcastNetworkBitfield(0),
@@ -85,10 +89,12 @@ namespace isobus
 		diagnosticProtocolList.push_back(this);
 		ecuIdentificationFields.resize(static_cast<std::size_t>(ECUIdentificationFields::NumberOfFields));
 
-		for (auto ecuIDField : ecuIdentificationFields)
+		for (auto &ecuIDField : ecuIdentificationFields)
 		{
 			ecuIDField = "*";
 		}
+		encode_ecu_identification();
+		encode_product_identification();
 	}
 
 	DiagnosticProtocol::~DiagnosticProtocol()
@@ -99,7 +105,7 @@ namespace isobus
 		{
 			// If we're being destructed but have not been deassigned, that is not ideal.
 			// So, we'll log it here, and try to clean ourselves up.
-			CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[DP]: DiagnosticProtocol instance is being destroyed without being deassigned first! It is suggested that you deassign the protocol before deleting this object!");
+			CAN_STACK_LOG_WARNING("[DP]: DiagnosticProtocol instance is being destroyed without being deassigned first! It is suggested that you deassign the protocol before deleting this object!");
 			deregister_all_pgns();
 		}
 
@@ -132,8 +138,8 @@ namespace isobus
 
 		if (retVal)
 		{
+			// The constructor adds the new instance to the list of protocols
 			DiagnosticProtocol *newProtocol = new DiagnosticProtocol(internalControlFunction);
-			diagnosticProtocolList.push_back(newProtocol);
 			// PGN protocol will check for duplicates, so no worries if there's already a request protocol registered.
 			ParameterGroupNumberRequestProtocol::assign_pgn_request_protocol_to_internal_control_function(internalControlFunction);
 			ParameterGroupNumberRequestProtocol::get_pgn_request_protocol_by_internal_control_function(internalControlFunction)->register_pgn_request_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage2), process_parameter_group_number_request, newProtocol);
@@ -170,8 +176,11 @@ namespace isobus
 
 	void DiagnosticProtocol::deassign_all_diagnostic_protocol_to_internal_control_functions()
 	{
-		for (isobus::DiagnosticProtocol *protocol : diagnosticProtocolList)
+		// The destructor removes each instance from the list of protocols
+		while (!diagnosticProtocolList.empty())
 		{
+			isobus::DiagnosticProtocol *protocol = diagnosticProtocolList.front();
+
 			// First, remove callbacks from PGN requests
 			protocol->deregister_all_pgns();
 			delete protocol;
@@ -269,6 +278,12 @@ namespace isobus
 
 	void DiagnosticProtocol::set_j1939_mode(bool value)
 	{
+		if (value != j1939Mode)
+		{
+			// The lamp bytes are only encoded in J1939 mode
+			activeDTCList.payloadValid = false;
+			inactiveDTCList.payloadValid = false;
+		}
 		j1939Mode = value;
 	}
 
@@ -279,8 +294,10 @@ namespace isobus
 
 	void DiagnosticProtocol::clear_active_diagnostic_trouble_codes()
 	{
-		inactiveDTCList.insert(std::end(inactiveDTCList), std::begin(activeDTCList), std::end(activeDTCList));
-		activeDTCList.clear();
+		while (NO_DTC != activeDTCList.first)
+		{
+			move_stored_dtc(activeDTCList.first, DTCListMembership::Inactive);
+		}
 
 		if (!get_are_broadcasts_stopped_for_channel(myControlFunction->get_can_port()))
 		{
@@ -290,12 +307,16 @@ namespace isobus
 
 	void DiagnosticProtocol::clear_inactive_diagnostic_trouble_codes()
 	{
-		inactiveDTCList.clear();
+		while (NO_DTC != inactiveDTCList.first)
+		{
+			move_stored_dtc(inactiveDTCList.first, DTCListMembership::None);
+		}
 	}
 
 	void DiagnosticProtocol::clear_software_id_fields()
 	{
 		softwareIdentificationFields.clear();
+		encode_software_identification();
 	}
 
 	bool DiagnosticProtocol::get_are_broadcasts_stopped_for_channel(std::uint8_t canChannelIndex) const
@@ -304,92 +325,77 @@ namespace isobus
 
 		if ((canChannelIndex < CAN_PORT_MAXIMUM) && (canChannelIndex < DM13_NUMBER_OF_J1939_NETWORKS))
 		{
-			retVal = (0 != (static_cast<std::uint32_t>(1 << canChannelIndex) & stopBroadcastNetworkBitfield));
+			retVal = (!CANNetworkManager::CANNetwork.get_is_broadcast_allowed(canChannelIndex, static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage1)));
 		}
 		return retVal;
 	}
 
 	void DiagnosticProtocol::set_ecu_id_field(ECUIdentificationFields field, std::string value)
 	{
-		if (field <= ECUIdentificationFields::NumberOfFields)
+		if (field < ECUIdentificationFields::NumberOfFields)
 		{
 			ecuIdentificationFields[static_cast<std::size_t>(field)] = value + "*";
+			encode_ecu_identification();
 		}
 	}
 
 	bool DiagnosticProtocol::set_diagnostic_trouble_code_active(const DiagnosticTroubleCode &dtc, bool active)
 	{
+		std::size_t index = find_stored_dtc(dtc);
 		bool retVal = false;
 
 		if (active)
 		{
-			// First check to see if it's already active
-			auto activeLocation = std::find(activeDTCList.begin(), activeDTCList.end(), dtc);
-
-			if (activeDTCList.end() == activeLocation)
+			if (NO_DTC == index)
 			{
-				// Not already active. This is valid
-				auto inactiveLocation = std::find(inactiveDTCList.begin(), inactiveDTCList.end(), dtc);
-
-				if (inactiveDTCList.end() != inactiveLocation)
-				{
-					inactiveLocation->occuranceCount++;
-					activeDTCList.push_back(*inactiveLocation);
-					inactiveDTCList.erase(inactiveLocation);
-				}
-				else
-				{
-					activeDTCList.push_back(dtc);
-					activeDTCList[activeDTCList.size() - 1].occuranceCount = 1;
+				// The DTC stays in the store for good, so toggling it later never has to search or allocate
+				const StoredDTC newDTC = { dtc, NO_DTC, NO_DTC, DTCListMembership::None };
 
-					if ((SystemTiming::get_time_elapsed_ms(lastDM1SentTimestamp) > DM_MAX_FREQUENCY_MS) &&
-					    (!get_are_broadcasts_stopped_for_channel(myControlFunction->get_can_port())))
-					{
-						txFlags.set_flag(static_cast<std::uint32_t>(TransmitFlags::DM1));
-						lastDM1SentTimestamp = SystemTiming::get_timestamp_ms();
-					}
-				}
+				index = dtcStore.size();
+				dtcStore.push_back(newDTC);
+				dtcStoreIndex[get_dtc_key(dtc)] = index;
 			}
-			else
+
+			if (DTCListMembership::Inactive == dtcStore[index].membership)
 			{
-				// Already active!
-				retVal = false;
+				dtcStore[index].dtc.occuranceCount++;
+				move_stored_dtc(index, DTCListMembership::Active);
+				retVal = true;
 			}
-		}
-		else
-		{
-			/// First check to see if it's already in the inactive list
-			auto inactiveLocation = std::find(inactiveDTCList.begin(), inactiveDTCList.end(), dtc);
-
-			if (inactiveDTCList.end() == inactiveLocation)
+			else if (DTCListMembership::None == dtcStore[index].membership)
 			{
-				auto activeLocation = std::find(activeDTCList.begin(), activeDTCList.end(), dtc);
+				dtcStore[index].dtc.occuranceCount = 1;
+				move_stored_dtc(index, DTCListMembership::Active);
+				retVal = true;
 
-				if (activeDTCList.end() != activeLocation)
+				if ((SystemTiming::get_time_elapsed_ms(lastDM1SentTimestamp) > DM_MAX_FREQUENCY_MS) &&
+				    (!get_are_broadcasts_stopped_for_channel(myControlFunction->get_can_port())))
 				{
-					inactiveDTCList.push_back(*activeLocation);
-					activeDTCList.erase(activeLocation);
+					txFlags.set_flag(static_cast<std::uint32_t>(TransmitFlags::DM1));
+					lastDM1SentTimestamp = SystemTiming::get_timestamp_ms();
 				}
 			}
 			else
 			{
-				// Already inactive!
+				// Already active!
 				retVal = false;
 			}
 		}
+		else if ((NO_DTC != index) &&
+		         (DTCListMembership::Active == dtcStore[index].membership))
+		{
+			move_stored_dtc(index, DTCListMembership::Inactive);
+			retVal = true;
+		}
 		return retVal;
 	}
 
 	bool DiagnosticProtocol::get_diagnostic_trouble_code_active(const DiagnosticTroubleCode &dtc)
 	{
-		auto activeLocation = std::find(activeDTCList.begin(), activeDTCList.end(), dtc);
-		bool retVal = false;
+		const std::size_t index = find_stored_dtc(dtc);
 
-		if (activeDTCList.end() != activeLocation)
-		{
-			retVal = true;
-		}
-		return retVal;
+		return ((NO_DTC != index) &&
+		        (DTCListMembership::Active == dtcStore[index].membership));
 	}
 
 	bool DiagnosticProtocol::set_product_identification_code(std::string value)
@@ -399,6 +405,7 @@ namespace isobus
 		if (value.size() < PRODUCT_IDENTIFICATION_MAX_STRING_LENGTH)
 		{
 			productIdentificationCode = value;
+			encode_product_identification();
 			retVal = true;
 		}
 		return retVal;
@@ -411,6 +418,7 @@ namespace isobus
 		if (value.size() < PRODUCT_IDENTIFICATION_MAX_STRING_LENGTH)
 		{
 			productIdentificationBrand = value;
+			encode_product_identification();
 			retVal = true;
 		}
 		return retVal;
@@ -423,6 +431,7 @@ namespace isobus
 		if (value.size() < PRODUCT_IDENTIFICATION_MAX_STRING_LENGTH)
 		{
 			productIdentificationModel = value;
+			encode_product_identification();
 			retVal = true;
 		}
 		return retVal;
@@ -442,6 +451,7 @@ namespace isobus
 			}
 		}
 		softwareIdentificationFields[index] = value;
+		encode_software_identification();
 	}
 
 	bool DiagnosticProtocol::suspend_broadcasts(std::uint8_t canChannelIndex, InternalControlFunction *sourceControlFunction, std::uint16_t suspendTime_seconds)
@@ -474,7 +484,7 @@ namespace isobus
 			}
 			else
 			{
-				if ((0 != activeDTCList.size()) &&
+				if ((0 != activeDTCList.size) &&
 				    (SystemTiming::time_expired_ms(lastDM1SentTimestamp, DM_MAX_FREQUENCY_MS)))
 				{
 					txFlags.set_flag(static_cast<std::uint32_t>(TransmitFlags::DM1));
@@ -534,216 +544,237 @@ namespace isobus
 		}
 	}
 
-	void DiagnosticProtocol::get_active_list_lamp_state_and_flash_state(Lamps targetLamp, FlashState &flash, bool &lampOn)
+	void DiagnosticProtocol::get_lamp_state_and_flash_state(const DTCList &list, Lamps targetLamp, FlashState &flash, bool &lampOn) const
 	{
-		flash = FlashState::Solid;
-		lampOn = false;
+		LampStatus solidStatus = LampStatus::None;
+		LampStatus slowFlashStatus = LampStatus::None;
+		LampStatus fastFlashStatus = LampStatus::None;
 
-		for (auto dtc : activeDTCList)
+		switch (targetLamp)
 		{
-			switch (targetLamp)
+			case Lamps::AmberWarningLamp:
 			{
-				case Lamps::AmberWarningLamp:
-				{
-					if (dtc.lampState == LampStatus::AmberWarningLampSolid)
-					{
-						lampOn = true;
-					}
-					else if (dtc.lampState == LampStatus::AmberWarningLampSlowFlash)
-					{
-						lampOn = true;
-						if (flash != FlashState::Fast)
-						{
-							flash = FlashState::Slow;
-						}
-					}
-					else if (dtc.lampState == LampStatus::AmberWarningLampFastFlash)
-					{
-						lampOn = true;
-						flash = FlashState::Fast;
-					}
-				}
-				break;
+				solidStatus = LampStatus::AmberWarningLampSolid;
+				slowFlashStatus = LampStatus::AmberWarningLampSlowFlash;
+				fastFlashStatus = LampStatus::AmberWarningLampFastFlash;
+			}
+			break;
 
-				case Lamps::MalfunctionIndicatorLamp:
-				{
-					if (dtc.lampState == LampStatus::MalfunctionIndicatorLampSolid)
-					{
-						lampOn = true;
-					}
-					else if (dtc.lampState == LampStatus::MalfuctionIndicatorLampSlowFlash)
-					{
-						lampOn = true;
-						if (flash != FlashState::Fast)
-						{
-							flash = FlashState::Slow;
-						}
-					}
-					else if (dtc.lampState == LampStatus::MalfunctionIndicatorLampFastFlash)
-					{
-						lampOn = true;
-						flash = FlashState::Fast;
-					}
-				}
-				break;
+			case Lamps::MalfunctionIndicatorLamp:
+			{
+				solidStatus = LampStatus::MalfunctionIndicatorLampSolid;
+				slowFlashStatus = LampStatus::MalfuctionIndicatorLampSlowFlash;
+				fastFlashStatus = LampStatus::MalfunctionIndicatorLampFastFlash;
+			}
+			break;
 
-				case Lamps::ProtectLamp:
-				{
-					if (dtc.lampState == LampStatus::EngineProtectLampSolid)
-					{
-						lampOn = true;
-					}
-					else if (dtc.lampState == LampStatus::EngineProtectLampSlowFlash)
-					{
-						lampOn = true;
-						if (flash != FlashState::Fast)
-						{
-							flash = FlashState::Slow;
-						}
-					}
-					else if (dtc.lampState == LampStatus::EngineProtectLampFastFlash)
-					{
-						lampOn = true;
-						flash = FlashState::Fast;
-					}
-				}
-				break;
+			case Lamps::ProtectLamp:
+			{
+				solidStatus = LampStatus::EngineProtectLampSolid;
+				slowFlashStatus = LampStatus::EngineProtectLampSlowFlash;
+				fastFlashStatus = LampStatus::EngineProtectLampFastFlash;
+			}
+			break;
 
-				case Lamps::RedStopLamp:
-				{
-					if (dtc.lampState == LampStatus::RedStopLampSolid)
-					{
-						lampOn = true;
-					}
-					else if (dtc.lampState == LampStatus::RedStopLampSlowFlash)
-					{
-						lampOn = true;
-						if (flash != FlashState::Fast)
-						{
-							flash = FlashState::Slow;
-						}
-					}
-					else if (dtc.lampState == LampStatus::RedStopLampFastFlash)
-					{
-						lampOn = true;
-						flash = FlashState::Fast;
-					}
-				}
-				break;
+			case Lamps::RedStopLamp:
+			{
+				solidStatus = LampStatus::RedStopLampSolid;
+				slowFlashStatus = LampStatus::RedStopLampSlowFlash;
+				fastFlashStatus = LampStatus::RedStopLampFastFlash;
+			}
+			break;
 
-				default:
-				{
-				}
-				break;
+			default:
+			{
+			}
+			break;
+		}
+
+		const std::uint16_t numberSolid = (LampStatus::None == solidStatus) ? 0 : list.lampStatusCounts[static_cast<std::size_t>(solidStatus)];
+		const std::uint16_t numberSlowFlash = (LampStatus::None == slowFlashStatus) ? 0 : list.lampStatusCounts[static_cast<std::size_t>(slowFlashStatus)];
+		const std::uint16_t numberFastFlash = (LampStatus::None == fastFlashStatus) ? 0 : list.lampStatusCounts[static_cast<std::size_t>(fastFlashStatus)];
+
+		// A fast flash wins over a slow one, which wins over a solid lamp
+		lampOn = ((0 != numberSolid) || (0 != numberSlowFlash) || (0 != numberFastFlash));
+		if (0 != numberFastFlash)
+		{
+			flash = FlashState::Fast;
+		}
+		else if (0 != numberSlowFlash)
+		{
+			flash = FlashState::Slow;
+		}
+		else
+		{
+			flash = FlashState::Solid;
+		}
+	}
+
+	const std::vector<std::uint8_t> &DiagnosticProtocol::get_dtc_list_payload(DTCList &list)
+	{
+		if (!list.payloadValid)
+		{
+			std::vector<std::uint8_t> &payload = list.payload;
+			std::size_t i = 0;
+
+			// Resizing keeps the capacity from earlier encodings, so this only allocates when the list grows
+			payload.resize(2 + (DM_PAYLOAD_BYTES_PER_DTC * list.size));
+
+			if (get_j1939_mode())
+			{
+				bool tempLampState = false;
+				FlashState tempLampFlashState = FlashState::Solid;
+				get_lamp_state_and_flash_state(list, Lamps::ProtectLamp, tempLampFlashState, tempLampState);
+
+				/// Encode Protect state and flash
+				payload[0] = tempLampState;
+				payload[1] = convert_flash_state_to_byte(tempLampFlashState);
+
+				get_lamp_state_and_flash_state(list, Lamps::AmberWarningLamp, tempLampFlashState, tempLampState);
+
+				/// Encode amber warning lamp state and flash
+				payload[0] |= (tempLampState << 2);
+				payload[1] |= (convert_flash_state_to_byte(tempLampFlashState) << 2);
+
+				get_lamp_state_and_flash_state(list, Lamps::RedStopLamp, tempLampFlashState, tempLampState);
+
+				/// Encode red stop lamp state and flash
+				payload[0] |= (tempLampState << 4);
+				payload[1] |= (convert_flash_state_to_byte(tempLampFlashState) << 4);
+
+				get_lamp_state_and_flash_state(list, Lamps::MalfunctionIndicatorLamp, tempLampFlashState, tempLampState);
+
+				/// Encode malfunction indicator lamp state and flash
+				payload[0] |= (tempLampState << 6);
+				payload[1] |= (convert_flash_state_to_byte(tempLampFlashState) << 6);
+			}
+			else
+			{
+				// ISO 11783 does not use lamp state or lamp flash bytes
+				payload[0] = 0xFF;
+				payload[1] = 0xFF;
+			}
+
+			for (std::size_t index = list.first; NO_DTC != index; index = dtcStore[index].next)
+			{
+				const DiagnosticTroubleCode &dtc = dtcStore[index].dtc;
+
+				payload[2 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = static_cast<std::uint8_t>(dtc.suspectParameterNumber & 0xFF);
+				payload[3 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = static_cast<std::uint8_t>((dtc.suspectParameterNumber >> 8) & 0xFF);
+				payload[4 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = ((static_cast<std::uint8_t>((dtc.suspectParameterNumber >> 16) & 0xFF) << 5) | static_cast<std::uint8_t>(dtc.failureModeIdentifier & 0x1F));
+				payload[5 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = (dtc.occuranceCount & 0x7F);
+				i++;
+			}
+
+			if (0 == list.size)
+			{
+				// No DTCs is encoded as a single all zero DTC
+				payload.resize(CAN_DATA_LENGTH, 0x00);
+				payload[6] = 0xFF;
+				payload[7] = 0xFF;
+			}
+			else if (payload.size() < CAN_DATA_LENGTH)
+			{
+				payload.resize(CAN_DATA_LENGTH, 0xFF);
 			}
+			list.payloadValid = true;
+		}
+		return list.payload;
+	}
+
+	std::uint64_t DiagnosticProtocol::get_dtc_key(const DiagnosticTroubleCode &dtc)
+	{
+		return (static_cast<std::uint64_t>(dtc.suspectParameterNumber) |
+		        (static_cast<std::uint64_t>(dtc.failureModeIdentifier) << 32) |
+		        (static_cast<std::uint64_t>(dtc.lampState) << 40));
+	}
+
+	std::size_t DiagnosticProtocol::find_stored_dtc(const DiagnosticTroubleCode &dtc) const
+	{
+		auto location = dtcStoreIndex.find(get_dtc_key(dtc));
+		std::size_t retVal = NO_DTC;
+
+		if (dtcStoreIndex.end() != location)
+		{
+			retVal = location->second;
 		}
+		return retVal;
 	}
 
-	void DiagnosticProtocol::get_inactive_list_lamp_state_and_flash_state(Lamps targetLamp, FlashState &flash, bool &lampOn)
+	std::size_t DiagnosticProtocol::find_listed_dtc(std::uint32_t suspectParameterNumber, std::uint8_t failureModeIdentifier, DTCListMembership list) const
 	{
-		flash = FlashState::Solid;
-		lampOn = false;
+		std::size_t retVal = (DTCListMembership::Active == list) ? activeDTCList.first : inactiveDTCList.first;
 
-		for (auto dtc : inactiveDTCList)
+		while ((NO_DTC != retVal) &&
+		       ((suspectParameterNumber != dtcStore[retVal].dtc.suspectParameterNumber) ||
+		        (failureModeIdentifier != dtcStore[retVal].dtc.failureModeIdentifier)))
 		{
-			switch (targetLamp)
+			retVal = dtcStore[retVal].next;
+		}
+		return retVal;
+	}
+
+	void DiagnosticProtocol::move_stored_dtc(std::size_t index, DTCListMembership target)
+	{
+		StoredDTC &storedDTC = dtcStore[index];
+
+		if (DTCListMembership::None != storedDTC.membership)
+		{
+			DTCList &currentList = get_dtc_list(storedDTC.membership);
+
+			currentList.lampStatusCounts[static_cast<std::size_t>(storedDTC.dtc.lampState)]--;
+			currentList.payloadValid = false;
+
+			if (NO_DTC == storedDTC.previous)
 			{
-				case Lamps::AmberWarningLamp:
-				{
-					if (dtc.lampState == LampStatus::AmberWarningLampSolid)
-					{
-						lampOn = true;
-					}
-					else if (dtc.lampState == LampStatus::AmberWarningLampSlowFlash)
-					{
-						lampOn = true;
-						if (flash != FlashState::Fast)
-						{
-							flash = FlashState::Slow;
-						}
-					}
-					else if (dtc.lampState == LampStatus::AmberWarningLampFastFlash)
-					{
-						lampOn = true;
-						flash = FlashState::Fast;
-					}
-				}
-				break;
+				currentList.first = storedDTC.next;
+			}
+			else
+			{
+				dtcStore[storedDTC.previous].next = storedDTC.next;
+			}
 
-				case Lamps::MalfunctionIndicatorLamp:
-				{
-					if (dtc.lampState == LampStatus::MalfunctionIndicatorLampSolid)
-					{
-						lampOn = true;
-					}
-					else if (dtc.lampState == LampStatus::MalfuctionIndicatorLampSlowFlash)
-					{
-						lampOn = true;
-						if (flash != FlashState::Fast)
-						{
-							flash = FlashState::Slow;
-						}
-					}
-					else if (dtc.lampState == LampStatus::MalfunctionIndicatorLampFastFlash)
-					{
-						lampOn = true;
-						flash = FlashState::Fast;
-					}
-				}
-				break;
+			if (NO_DTC == storedDTC.next)
+			{
+				currentList.last = storedDTC.previous;
+			}
+			else
+			{
+				dtcStore[storedDTC.next].previous = storedDTC.previous;
+			}
+			currentList.size--;
+		}
 
-				case Lamps::ProtectLamp:
-				{
-					if (dtc.lampState == LampStatus::EngineProtectLampSolid)
-					{
-						lampOn = true;
-					}
-					else if (dtc.lampState == LampStatus::EngineProtectLampSlowFlash)
-					{
-						lampOn = true;
-						if (flash != FlashState::Fast)
-						{
-							flash = FlashState::Slow;
-						}
-					}
-					else if (dtc.lampState == LampStatus::EngineProtectLampFastFlash)
-					{
-						lampOn = true;
-						flash = FlashState::Fast;
-					}
-				}
-				break;
+		storedDTC.previous = NO_DTC;
+		storedDTC.next = NO_DTC;
+		storedDTC.membership = target;
 
-				case Lamps::RedStopLamp:
-				{
-					if (dtc.lampState == LampStatus::RedStopLampSolid)
-					{
-						lampOn = true;
-					}
-					else if (dtc.lampState == LampStatus::RedStopLampSlowFlash)
-					{
-						lampOn = true;
-						if (flash != FlashState::Fast)
-						{
-							flash = FlashState::Slow;
-						}
-					}
-					else if (dtc.lampState == LampStatus::RedStopLampFastFlash)
-					{
-						lampOn = true;
-						flash = FlashState::Fast;
-					}
-				}
-				break;
+		if (DTCListMembership::None != target)
+		{
+			// Appending keeps the lists in the order DTCs joined them, which is the order they are encoded in
+			DTCList &targetList = get_dtc_list(target);
 
-				default:
-				{
-				}
-				break;
+			storedDTC.previous = targetList.last;
+			if (NO_DTC == targetList.last)
+			{
+				targetList.first = index;
 			}
+			else
+			{
+				dtcStore[targetList.last].next = index;
+			}
+			targetList.last = index;
+			targetList.size++;
+			targetList.lampStatusCounts[static_cast<std::size_t>(storedDTC.dtc.lampState)]++;
+			targetList.payloadValid = false;
 		}
 	}
 
+	DiagnosticProtocol::DTCList &DiagnosticProtocol::get_dtc_list(DTCListMembership list)
+	{
+		return (DTCListMembership::Active == list) ? activeDTCList : inactiveDTCList;
+	}
+
 	bool DiagnosticProtocol::protocol_transmit_message(std::uint32_t,
 	                                                   const std::uint8_t *,
 	                                                   std::uint32_t,
@@ -762,83 +793,14 @@ namespace isobus
 
 		if (nullptr != myControlFunction)
 		{
-			std::uint16_t payloadSize = (activeDTCList.size() * DM_PAYLOAD_BYTES_PER_DTC) + 2; // 2 Bytes (0 and 1) are reserved
+			const std::vector<std::uint8_t> &payload = get_dtc_list_payload(activeDTCList);
 
-			if (payloadSize <= MAX_PAYLOAD_SIZE_BYTES)
+			if (payload.size() <= MAX_PAYLOAD_SIZE_BYTES)
 			{
-				std::vector<std::uint8_t> buffer;
-				buffer.resize(payloadSize);
-
-				if (get_j1939_mode())
-				{
-					bool tempLampState = false;
-					FlashState tempLampFlashState = FlashState::Solid;
-					get_active_list_lamp_state_and_flash_state(Lamps::ProtectLamp, tempLampFlashState, tempLampState);
-
-					/// Encode Protect state and flash
-					buffer[0] = tempLampState;
-					buffer[1] = convert_flash_state_to_byte(tempLampFlashState);
-
-					get_active_list_lamp_state_and_flash_state(Lamps::AmberWarningLamp, tempLampFlashState, tempLampState);
-
-					/// Encode amber warning lamp state and flash
-					buffer[0] |= (tempLampState << 2);
-					buffer[1] |= (convert_flash_state_to_byte(tempLampFlashState) << 2);
-
-					get_active_list_lamp_state_and_flash_state(Lamps::RedStopLamp, tempLampFlashState, tempLampState);
-
-					/// Encode red stop lamp state and flash
-					buffer[0] |= (tempLampState << 4);
-					buffer[1] |= (convert_flash_state_to_byte(tempLampFlashState) << 4);
-
-					get_active_list_lamp_state_and_flash_state(Lamps::MalfunctionIndicatorLamp, tempLampFlashState, tempLampState);
-
-					/// Encode malfunction indicator lamp state and flash
-					buffer[0] |= (tempLampState << 6);
-					buffer[1] |= (convert_flash_state_to_byte(tempLampFlashState) << 6);
-				}
-				else
-				{
-					// ISO 11783 does not use lamp state or lamp flash bytes
-					buffer[0] = 0xFF;
-					buffer[1] = 0xFF;
-				}
-
-				if (0 == activeDTCList.size())
-				{
-					buffer[2] = 0x00;
-					buffer[3] = 0x00;
-					buffer[4] = 0x00;
-					buffer[5] = 0x00;
-					buffer[6] = 0xFF;
-					buffer[7] = 0xFF;
-					retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage1),
-					                                                        buffer.data(),
-					                                                        CAN_DATA_LENGTH,
-					                                                        myControlFunction.get());
-				}
-				else
-				{
-					for (std::size_t i = 0; i < activeDTCList.size(); i++)
-					{
-						buffer[2 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = static_cast<std::uint8_t>(activeDTCList[i].suspectParameterNumber & 0xFF);
-						buffer[3 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = static_cast<std::uint8_t>((activeDTCList[i].suspectParameterNumber >> 8) & 0xFF);
-						buffer[4 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = ((static_cast<std::uint8_t>((activeDTCList[i].suspectParameterNumber >> 16) & 0xFF) << 5) | static_cast<std::uint8_t>(activeDTCList[i].failureModeIdentifier & 0x1F));
-						buffer[5 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = (activeDTCList[i].occuranceCount & 0x7F);
-					}
-
-					if (payloadSize < CAN_DATA_LENGTH)
-					{
-						buffer[6] = 0xFF;
-						buffer[7] = 0xFF;
-						payloadSize = CAN_DATA_LENGTH;
-					}
-
-					retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage1),
-					                                                        buffer.data(),
-					                                                        payloadSize,
-					                                                        myControlFunction.get());
-				}
+				retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage1),
+				                                                        payload.data(),
+				                                                        payload.size(),
+				                                                        myControlFunction.get());
 			}
 		}
 		return retVal;
@@ -850,83 +812,14 @@ namespace isobus
 
 		if (nullptr != myControlFunction)
 		{
-			std::uint16_t payloadSize = (inactiveDTCList.size() * DM_PAYLOAD_BYTES_PER_DTC) + 2; // 2 Bytes (0 and 1) are reserved or used for lamp + flash
+			const std::vector<std::uint8_t> &payload = get_dtc_list_payload(inactiveDTCList);
 
-			if (payloadSize <= MAX_PAYLOAD_SIZE_BYTES)
+			if (payload.size() <= MAX_PAYLOAD_SIZE_BYTES)
 			{
-				std::vector<std::uint8_t> buffer;
-				buffer.resize(payloadSize);
-
-				if (get_j1939_mode())
-				{
-					bool tempLampState = false;
-					FlashState tempLampFlashState = FlashState::Solid;
-					get_inactive_list_lamp_state_and_flash_state(Lamps::ProtectLamp, tempLampFlashState, tempLampState);
-
-					/// Encode Protect state and flash
-					buffer[0] = tempLampState;
-					buffer[1] = convert_flash_state_to_byte(tempLampFlashState);
-
-					get_inactive_list_lamp_state_and_flash_state(Lamps::AmberWarningLamp, tempLampFlashState, tempLampState);
-
-					/// Encode amber warning lamp state and flash
-					buffer[0] |= (tempLampState << 2);
-					buffer[1] |= (convert_flash_state_to_byte(tempLampFlashState) << 2);
-
-					get_inactive_list_lamp_state_and_flash_state(Lamps::RedStopLamp, tempLampFlashState, tempLampState);
-
-					/// Encode red stop lamp state and flash
-					buffer[0] |= (tempLampState << 4);
-					buffer[1] |= (convert_flash_state_to_byte(tempLampFlashState) << 4);
-
-					get_inactive_list_lamp_state_and_flash_state(Lamps::MalfunctionIndicatorLamp, tempLampFlashState, tempLampState);
-
-					/// Encode malfunction indicator lamp state and flash
-					buffer[0] |= (tempLampState << 6);
-					buffer[1] |= (convert_flash_state_to_byte(tempLampFlashState) << 6);
-				}
-				else
-				{
-					// ISO 11783 does not use lamp state or lamp flash bytes
-					buffer[0] = 0xFF;
-					buffer[1] = 0xFF;
-				}
-
-				if (0 == inactiveDTCList.size())
-				{
-					buffer[2] = 0x00;
-					buffer[3] = 0x00;
-					buffer[4] = 0x00;
-					buffer[5] = 0x00;
-					buffer[6] = 0xFF;
-					buffer[7] = 0xFF;
-					retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage2),
-					                                                        buffer.data(),
-					                                                        CAN_DATA_LENGTH,
-					                                                        myControlFunction.get());
-				}
-				else
-				{
-					for (std::size_t i = 0; i < inactiveDTCList.size(); i++)
-					{
-						buffer[2 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = static_cast<std::uint8_t>(inactiveDTCList[i].suspectParameterNumber & 0xFF);
-						buffer[3 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = static_cast<std::uint8_t>((inactiveDTCList[i].suspectParameterNumber >> 8) & 0xFF);
-						buffer[4 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = ((static_cast<std::uint8_t>((inactiveDTCList[i].suspectParameterNumber >> 16) & 0xFF) << 5) | static_cast<std::uint8_t>(inactiveDTCList[i].failureModeIdentifier & 0x1F));
-						buffer[5 + (DM_PAYLOAD_BYTES_PER_DTC * i)] = (inactiveDTCList[i].occuranceCount & 0x7F);
-					}
-
-					if (payloadSize < CAN_DATA_LENGTH)
-					{
-						buffer[6] = 0xFF;
-						buffer[7] = 0xFF;
-						payloadSize = CAN_DATA_LENGTH;
-					}
-
-					retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage2),
-					                                                        buffer.data(),
-					                                                        payloadSize,
-					                                                        myControlFunction.get());
-				}
+				retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage2),
+				                                                        payload.data(),
+				                                                        payload.size(),
+				                                                        myControlFunction.get());
 			}
 		}
 		return retVal;
@@ -971,55 +864,140 @@ namespace isobus
 	}
 
 	bool DiagnosticProtocol::send_ecu_identification()
+	{
+		return send_identification(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUIdentificationInformation), ecuIdentificationPayload);
+	}
+
+	bool DiagnosticProtocol::send_product_identification()
+	{
+		return send_identification(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ProductIdentification), productIdentificationPayload);
+	}
+
+	bool DiagnosticProtocol::send_software_identification()
+	{
+		return send_identification(static_cast<std::uint32_t>(CANLibParameterGroupNumber::SoftwareIdentification), softwareIdentificationPayload);
+	}
+
+	bool DiagnosticProtocol::send_identification(std::uint32_t parameterGroupNumber, IdentificationPayload &payload)
+	{
+		std::shared_ptr<const std::vector<std::uint8_t>> encoded;
+		bool retVal = false;
+
+		{
+			const std::lock_guard<std::mutex> lock(identificationMutex);
+			encoded = payload.encoded;
+		}
+
+		// A transfer of this message that is still running will fail the send, so the flag retries it later
+		if ((nullptr != encoded) &&
+		    (nullptr == payload.transmitting))
+		{
+			if (encoded->size() <= CAN_DATA_LENGTH)
+			{
+				retVal = CANNetworkManager::CANNetwork.send_can_message(parameterGroupNumber,
+				                                                        encoded->data(),
+				                                                        encoded->size(),
+				                                                        myControlFunction.get());
+			}
+			else
+			{
+				payload.transmitting = encoded;
+				retVal = CANNetworkManager::CANNetwork.send_can_message(parameterGroupNumber,
+				                                                        nullptr,
+				                                                        encoded->size(),
+				                                                        myControlFunction.get(),
+				                                                        nullptr,
+				                                                        CANIdentifier::CANPriority::PriorityDefault6,
+				                                                        process_identification_transmit_complete,
+				                                                        &payload,
+				                                                        process_identification_chunk);
+
+				if (!retVal)
+				{
+					payload.transmitting.reset();
+				}
+			}
+		}
+		return retVal;
+	}
+
+	void DiagnosticProtocol::encode_ecu_identification()
 	{
 		std::string ecuIdString = "";
 
-		for (auto stringComponent : ecuIdentificationFields)
+		for (const auto &stringComponent : ecuIdentificationFields)
 		{
 			ecuIdString.append(stringComponent);
 		}
+		set_identification_payload(ecuIdentificationPayload, ecuIdString);
+	}
 
-		std::vector<std::uint8_t> buffer(ecuIdString.begin(), ecuIdString.end());
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUIdentificationInformation),
-		                                                      buffer.data(),
-		                                                      buffer.size(),
-		                                                      myControlFunction.get());
+	void DiagnosticProtocol::encode_product_identification()
+	{
+		set_identification_payload(productIdentificationPayload, productIdentificationCode + "*" + productIdentificationBrand + "*" + productIdentificationModel + "*");
 	}
 
-	bool DiagnosticProtocol::send_product_identification()
+	void DiagnosticProtocol::encode_software_identification()
 	{
-		std::string productIdString = productIdentificationCode + "*" + productIdentificationBrand + "*" + productIdentificationModel + "*";
-		std::vector<std::uint8_t> buffer(productIdString.begin(), productIdString.end());
+		std::string softIDString = "";
 
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ProductIdentification),
-		                                                      buffer.data(),
-		                                                      buffer.size(),
-		                                                      myControlFunction.get());
+		for (const auto &softIdString : softwareIdentificationFields)
+		{
+			softIDString.append(softIdString);
+			softIDString.append("*");
+		}
+		set_identification_payload(softwareIdentificationPayload, softIDString);
 	}
 
-	bool DiagnosticProtocol::send_software_identification()
+	void DiagnosticProtocol::set_identification_payload(IdentificationPayload &payload, const std::string &encodedString)
+	{
+		std::shared_ptr<const std::vector<std::uint8_t>> newPayload;
+
+		if (!encodedString.empty())
+		{
+			newPayload = std::make_shared<const std::vector<std::uint8_t>>(encodedString.begin(), encodedString.end());
+		}
+
+		const std::lock_guard<std::mutex> lock(identificationMutex);
+		payload.encoded = newPayload;
+	}
+
+	bool DiagnosticProtocol::process_identification_chunk(std::uint32_t,
+	                                                      std::uint32_t bytesOffset,
+	                                                      std::uint32_t numberOfBytesNeeded,
+	                                                      std::uint8_t *chunkBuffer,
+	                                                      void *parentPointer)
 	{
 		bool retVal = false;
 
-		if (0 != softwareIdentificationFields.size())
+		if ((nullptr != parentPointer) &&
+		    (nullptr != chunkBuffer))
 		{
-			std::string softIDString = "";
+			const IdentificationPayload *payload = reinterpret_cast<IdentificationPayload *>(parentPointer);
 
-			for (auto softIdString = softwareIdentificationFields.begin(); softIdString != softwareIdentificationFields.end(); softIdString++)
+			if ((nullptr != payload->transmitting) &&
+			    ((bytesOffset + numberOfBytesNeeded) <= payload->transmitting->size()))
 			{
-				softIDString.append(*softIdString);
-				softIDString.append("*");
+				memcpy(chunkBuffer, payload->transmitting->data() + bytesOffset, numberOfBytesNeeded);
+				retVal = true;
 			}
-
-			std::vector<std::uint8_t> buffer(softIDString.begin(), softIDString.end());
-			retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::SoftwareIdentification),
-			                                                        buffer.data(),
-			                                                        buffer.size(),
-			                                                        myControlFunction.get());
 		}
 		return retVal;
 	}
 
+	void DiagnosticProtocol::process_identification_transmit_complete(std::uint32_t,
+	                                                                  std::uint32_t,
+	                                                                  InternalControlFunction *,
+	                                                                  ControlFunction *,
+	                                                                  bool,
+	                                                                  void *parentPointer)
+	{
+		if (nullptr != parentPointer)
+		{
+			reinterpret_cast<IdentificationPayload *>(parentPointer)->transmitting.reset();
+		}
+	}
+
 	bool DiagnosticProtocol::process_all_dm22_responses()
 	{
 		bool retVal = false;
@@ -1093,9 +1071,25 @@ namespace isobus
 			{
 				case static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage13):
 				{
+					const std::uint32_t previousNetworkStates = stopBroadcastNetworkBitfield;
+
 					if (parse_j1939_network_states(message, stopBroadcastNetworkBitfield))
 					{
 						lastDM13ReceivedTimestamp = SystemTiming::get_timestamp_ms();
+
+						// Mirror the DM13 into the network manager's broadcast gate, which every periodic sender checks
+						for (std::uint8_t i = 0; (i < CAN_PORT_MAXIMUM) && (i < DM13_NUMBER_OF_J1939_NETWORKS); i++)
+						{
+							if (0 != (stopBroadcastNetworkBitfield & (1 << i)))
+							{
+								// Every DM13 restarts the timeout, which is how the hold signal keeps broadcasts suspended
+								CANNetworkManager::CANNetwork.suspend_broadcasts(i, DM13_TIMEOUT_MS);
+							}
+							else if (0 != (previousNetworkStates & (1 << i)))
+							{
+								CANNetworkManager::CANNetwork.resume_broadcasts(i);
+							}
+						}
 					}
 				}
 				break;
@@ -1123,20 +1117,16 @@ namespace isobus
 							{
 								tempDM22Data.clearActive = true;
 
-								for (auto dtc = activeDTCList.begin(); dtc != activeDTCList.end(); dtc++)
+								const std::size_t index = find_listed_dtc(tempDM22Data.suspectParameterNumber, tempDM22Data.failureModeIdentifier, DTCListMembership::Active);
+
+								if (NO_DTC != index)
 								{
-									if ((tempDM22Data.suspectParameterNumber == dtc->suspectParameterNumber) &&
-									    (tempDM22Data.failureModeIdentifier == dtc->failureModeIdentifier))
-									{
-										inactiveDTCList.push_back(*dtc);
-										activeDTCList.erase(dtc);
-										wasDTCCleared = true;
-										tempDM22Data.nack = false;
-
-										dm22ResponseQueue.push_back(tempDM22Data);
-										txFlags.set_flag(static_cast<std::uint32_t>(TransmitFlags::DM22));
-										break;
-									}
+									move_stored_dtc(index, DTCListMembership::Inactive);
+									wasDTCCleared = true;
+									tempDM22Data.nack = false;
+
+									dm22ResponseQueue.push_back(tempDM22Data);
+									txFlags.set_flag(static_cast<std::uint32_t>(TransmitFlags::DM22));
 								}
 
 								if (!wasDTCCleared)
@@ -1144,15 +1134,10 @@ namespace isobus
 									tempDM22Data.nack = true;
 
 									// Since we didn't find the DTC in the active list, we check the inactive to determine the proper NACK reason
-									for (auto dtc : inactiveDTCList)
+									if (NO_DTC != find_listed_dtc(tempDM22Data.suspectParameterNumber, tempDM22Data.failureModeIdentifier, DTCListMembership::Inactive))
 									{
-										if ((tempDM22Data.suspectParameterNumber == dtc.suspectParameterNumber) &&
-										    (tempDM22Data.failureModeIdentifier == dtc.failureModeIdentifier))
-										{
-											// The DTC was active, but is inactive now, so we NACK with the proper reason
-											tempDM22Data.nackIndicator = static_cast<std::uint8_t>(DM22NegativeAcknowledgeIndicator::DTCNoLongerActive);
-											break;
-										}
+										// The DTC was active, but is inactive now, so we NACK with the proper reason
+										tempDM22Data.nackIndicator = static_cast<std::uint8_t>(DM22NegativeAcknowledgeIndicator::DTCNoLongerActive);
 									}
 
 									if (0 != tempDM22Data.nackIndicator)
@@ -1168,19 +1153,16 @@ namespace isobus
 
 							case static_cast<std::uint8_t>(DM22ControlByte::RequestToClearPreviouslyActiveDTC):
 							{
-								for (auto dtc = inactiveDTCList.begin(); dtc != inactiveDTCList.end(); dtc++)
+								const std::size_t index = find_listed_dtc(tempDM22Data.suspectParameterNumber, tempDM22Data.failureModeIdentifier, DTCListMembership::Inactive);
+
+								if (NO_DTC != index)
 								{
-									if ((tempDM22Data.suspectParameterNumber == dtc->suspectParameterNumber) &&
-									    (tempDM22Data.failureModeIdentifier == dtc->failureModeIdentifier))
-									{
-										inactiveDTCList.erase(dtc);
-										wasDTCCleared = true;
-										tempDM22Data.nack = false;
+									move_stored_dtc(index, DTCListMembership::None);
+									wasDTCCleared = true;
+									tempDM22Data.nack = false;
 
-										dm22ResponseQueue.push_back(tempDM22Data);
-										txFlags.set_flag(static_cast<std::uint32_t>(TransmitFlags::DM22));
-										break;
-									}
+									dm22ResponseQueue.push_back(tempDM22Data);
+									txFlags.set_flag(static_cast<std::uint32_t>(TransmitFlags::DM22));
 								}
 
 								if (!wasDTCCleared)
@@ -1188,15 +1170,10 @@ namespace isobus
 									tempDM22Data.nack = true;
 
 									// Since we didn't find the DTC in the inactive list, we check the active to determine the proper NACK reason
-									for (auto dtc : activeDTCList)
+									if (NO_DTC != find_listed_dtc(tempDM22Data.suspectParameterNumber, tempDM22Data.failureModeIdentifier, DTCListMembership::Active))
 									{
-										if ((tempDM22Data.suspectParameterNumber == dtc.suspectParameterNumber) &&
-										    (tempDM22Data.failureModeIdentifier == dtc.failureModeIdentifier))
-										{
-											// The DTC was inactive, but is active now, so we NACK with the proper reason
-											tempDM22Data.nackIndicator = static_cast<std::uint8_t>(DM22NegativeAcknowledgeIndicator::DTCUNoLongerPreviouslyActive);
-											break;
-										}
+										// The DTC was inactive, but is active now, so we NACK with the proper reason
+										tempDM22Data.nackIndicator = static_cast<std::uint8_t>(DM22NegativeAcknowledgeIndicator::DTCUNoLongerPreviouslyActive);
 									}
 
 									if (0 != tempDM22Data.nackIndicator)
@@ -0,0 +1,329 @@
+//================================================================================================
+/// @file isobus_diagnostic_trouble_code_reader.cpp
+///
+/// @brief Implements a class that collects the DTCs that other ECUs on the bus report
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#include "isobus/isobus/isobus_diagnostic_trouble_code_reader.hpp"
+
+#include "isobus/isobus/can_general_parameter_group_numbers.hpp"
+#include "isobus/isobus/can_network_manager.hpp"
+#include "isobus/isobus/can_parameter_group_number_request_protocol.hpp"
+#include "isobus/utility/system_timing.hpp"
+
+#include <algorithm>
+
+namespace isobus
+{
+	DiagnosticTroubleCodeReader::DiagnosticTroubleCodeReader()
+	{
+		CANNetworkManager::CANNetwork.add_any_control_function_parameter_group_number_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage1), process_rx_message, this);
+		CANNetworkManager::CANNetwork.add_any_control_function_parameter_group_number_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage2), process_rx_message, this);
+	}
+
+	DiagnosticTroubleCodeReader::~DiagnosticTroubleCodeReader()
+	{
+		CANNetworkManager::CANNetwork.remove_any_control_function_parameter_group_number_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage1), process_rx_message, this);
+		CANNetworkManager::CANNetwork.remove_any_control_function_parameter_group_number_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage2), process_rx_message, this);
+	}
+
+	void DiagnosticTroubleCodeReader::update()
+	{
+		std::unique_lock<std::mutex> processingLock(processingMutex);
+
+		{
+			const std::lock_guard<std::mutex> lock(sourcesMutex);
+
+			for (auto &source : sources)
+			{
+				// In ISO 11783 mode an ECU may stop sending DM1 once it has no active DTCs
+				if ((!source.activeDTCs.empty()) &&
+				    (SystemTiming::time_expired_ms(source.lastDM1Timestamp_ms, DM1_TIMEOUT_MS)))
+				{
+					decodedDTCs.clear();
+					replace_list(source, DTCListType::Active, decodedDTCs);
+					source.lampStatus = 0;
+				}
+			}
+		}
+		send_pending_events(processingLock);
+	}
+
+	void DiagnosticTroubleCodeReader::add_dtc_event_callback(DTCEventCallback callback, void *parentPointer)
+	{
+		const std::lock_guard<std::mutex> lock(callbacksMutex);
+
+		if (nullptr != callback)
+		{
+			callbacks.push_back({ callback, parentPointer });
+		}
+	}
+
+	void DiagnosticTroubleCodeReader::remove_dtc_event_callback(DTCEventCallback callback, void *parentPointer)
+	{
+		const std::lock_guard<std::mutex> lock(callbacksMutex);
+
+		for (auto callbackInfo = callbacks.begin(); callbackInfo != callbacks.end(); callbackInfo++)
+		{
+			if ((callback == callbackInfo->callback) &&
+			    (parentPointer == callbackInfo->parent))
+			{
+				callbacks.erase(callbackInfo);
+				break;
+			}
+		}
+	}
+
+	bool DiagnosticTroubleCodeReader::request_previously_active_dtcs(InternalControlFunction *source, ControlFunction *destination)
+	{
+		return ParameterGroupNumberRequestProtocol::request_parameter_group_number(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage2), source, destination);
+	}
+
+	bool DiagnosticTroubleCodeReader::request_clear_active_dtcs(InternalControlFunction *source, ControlFunction *destination)
+	{
+		return ParameterGroupNumberRequestProtocol::request_parameter_group_number(static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage11), source, destination);
+	}
+
+	std::uint32_t DiagnosticTroubleCodeReader::get_number_known_sources()
+	{
+		const std::lock_guard<std::mutex> lock(sourcesMutex);
+		return static_cast<std::uint32_t>(sources.size());
+	}
+
+	bool DiagnosticTroubleCodeReader::get_dtcs(std::uint8_t canPort, std::uint8_t sourceAddress, DTCListType list, std::vector<ReceivedDTC> &dtcs)
+	{
+		const std::lock_guard<std::mutex> lock(sourcesMutex);
+		const SourceDTCs *source = find_source(static_cast<std::uint16_t>((canPort << 8) | sourceAddress));
+		bool retVal = false;
+
+		dtcs.clear();
+		if (nullptr != source)
+		{
+			if (DTCListType::Active == list)
+			{
+				dtcs.assign(source->activeDTCs.begin(), source->activeDTCs.end());
+				retVal = source->dm1Received;
+			}
+			else
+			{
+				dtcs.assign(source->previouslyActiveDTCs.begin(), source->previouslyActiveDTCs.end());
+				retVal = source->dm2Received;
+			}
+		}
+		return retVal;
+	}
+
+	bool DiagnosticTroubleCodeReader::get_lamp_status(std::uint8_t canPort, std::uint8_t sourceAddress, std::uint16_t &lampStatus)
+	{
+		const std::lock_guard<std::mutex> lock(sourcesMutex);
+		const SourceDTCs *source = find_source(static_cast<std::uint16_t>((canPort << 8) | sourceAddress));
+		bool retVal = false;
+
+		lampStatus = 0;
+		if ((nullptr != source) &&
+		    (source->dm1Received))
+		{
+			lampStatus = source->lampStatus;
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	void DiagnosticTroubleCodeReader::process_rx_message(CANMessage *message, void *parentPointer)
+	{
+		if ((nullptr != message) &&
+		    (nullptr != parentPointer) &&
+		    (message->get_data_length() >= DM_LAMP_BYTES))
+		{
+			DiagnosticTroubleCodeReader *reader = reinterpret_cast<DiagnosticTroubleCodeReader *>(parentPointer);
+
+			switch (message->get_identifier().get_parameter_group_number())
+			{
+				case static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage1):
+				{
+					reader->process_dtc_message(message, DTCListType::Active);
+				}
+				break;
+
+				case static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage2):
+				{
+					reader->process_dtc_message(message, DTCListType::PreviouslyActive);
+				}
+				break;
+
+				default:
+					break;
+			}
+		}
+	}
+
+	void DiagnosticTroubleCodeReader::process_dtc_message(CANMessage *message, DTCListType list)
+	{
+		std::unique_lock<std::mutex> processingLock(processingMutex);
+		const std::uint32_t dataLength = message->get_data_length();
+
+		decodedDTCs.clear();
+		for (std::uint32_t i = DM_LAMP_BYTES; (i + DM_PAYLOAD_BYTES_PER_DTC) <= dataLength; i += DM_PAYLOAD_BYTES_PER_DTC)
+		{
+			ReceivedDTC dtc;
+
+			dtc.suspectParameterNumber = (message->get_uint8_at(i) |
+			                              (static_cast<std::uint32_t>(message->get_uint8_at(i + 1)) << 8) |
+			                              (static_cast<std::uint32_t>(message->get_uint8_at(i + 2) >> 5) << 16));
+			dtc.failureModeIdentifier = (message->get_uint8_at(i + 2) & 0x1F);
+			dtc.occurrenceCount = (message->get_uint8_at(i + 3) & 0x7F);
+
+			// A single all zero DTC means there are no DTCs, and 0xFF padding is not a DTC either
+			if (((0 != dtc.suspectParameterNumber) || (0 != dtc.failureModeIdentifier)) &&
+			    ((0x7FFFF != dtc.suspectParameterNumber) || (0x1F != dtc.failureModeIdentifier)))
+			{
+				decodedDTCs.push_back(dtc);
+			}
+		}
+
+		{
+			const std::lock_guard<std::mutex> lock(sourcesMutex);
+			SourceDTCs &source = get_or_add_source(static_cast<std::uint16_t>((message->get_can_port_index() << 8) | message->get_identifier().get_source_address()));
+
+			if (DTCListType::Active == list)
+			{
+				source.lampStatus = static_cast<std::uint16_t>(message->get_uint8_at(0) | (message->get_uint8_at(1) << 8));
+				source.lastDM1Timestamp_ms = SystemTiming::get_timestamp_ms();
+				source.dm1Received = true;
+			}
+			else
+			{
+				source.dm2Received = true;
+			}
+			replace_list(source, list, decodedDTCs);
+		}
+		send_pending_events(processingLock);
+	}
+
+	void DiagnosticTroubleCodeReader::replace_list(SourceDTCs &source, DTCListType list, const std::vector<ReceivedDTC> &newDTCs)
+	{
+		std::vector<ReceivedDTC> &oldDTCs = (DTCListType::Active == list) ? source.activeDTCs : source.previouslyActiveDTCs;
+		DTCEvent event;
+
+		event.canPort = static_cast<std::uint8_t>(source.key >> 8);
+		event.sourceAddress = static_cast<std::uint8_t>(source.key & 0xFF);
+		event.list = list;
+
+		// Lists are short, so comparing every pair is cheaper than sorting or hashing them
+		for (const auto &oldDTC : oldDTCs)
+		{
+			bool found = false;
+
+			for (const auto &newDTC : newDTCs)
+			{
+				if ((oldDTC.suspectParameterNumber == newDTC.suspectParameterNumber) &&
+				    (oldDTC.failureModeIdentifier == newDTC.failureModeIdentifier))
+				{
+					if (oldDTC.occurrenceCount != newDTC.occurrenceCount)
+					{
+						event.dtc = newDTC;
+						event.type = DTCEventType::OccurrenceCountChanged;
+						pendingEvents.push_back(event);
+					}
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+			{
+				event.dtc = oldDTC;
+				event.type = DTCEventType::Removed;
+				pendingEvents.push_back(event);
+			}
+		}
+
+		for (const auto &newDTC : newDTCs)
+		{
+			bool found = false;
+
+			for (const auto &oldDTC : oldDTCs)
+			{
+				if ((oldDTC.suspectParameterNumber == newDTC.suspectParameterNumber) &&
+				    (oldDTC.failureModeIdentifier == newDTC.failureModeIdentifier))
+				{
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+			{
+				event.dtc = newDTC;
+				event.type = DTCEventType::Added;
+				pendingEvents.push_back(event);
+			}
+		}
+
+		// Assigning keeps the list's memory, so an ECU that keeps sending the same number of DTCs doesn't allocate
+		oldDTCs.assign(newDTCs.begin(), newDTCs.end());
+	}
+
+	DiagnosticTroubleCodeReader::SourceDTCs &DiagnosticTroubleCodeReader::get_or_add_source(std::uint16_t key)
+	{
+		auto source = std::lower_bound(sources.begin(), sources.end(), key, [](const SourceDTCs &entry, std::uint16_t searchKey) { return entry.key < searchKey; });
+
+		if ((sources.end() == source) ||
+		    (key != source->key))
+		{
+			SourceDTCs newSource;
+
+			newSource.lastDM1Timestamp_ms = 0;
+			newSource.key = key;
+			newSource.lampStatus = 0;
+			newSource.dm1Received = false;
+			newSource.dm2Received = false;
+			source = sources.insert(source, std::move(newSource));
+		}
+		return *source;
+	}
+
+	const DiagnosticTroubleCodeReader::SourceDTCs *DiagnosticTroubleCodeReader::find_source(std::uint16_t key) const
+	{
+		auto source = std::lower_bound(sources.begin(), sources.end(), key, [](const SourceDTCs &entry, std::uint16_t searchKey) { return entry.key < searchKey; });
+		const SourceDTCs *retVal = nullptr;
+
+		if ((sources.end() != source) &&
+		    (key == source->key))
+		{
+			retVal = &(*source);
+		}
+		return retVal;
+	}
+
+	void DiagnosticTroubleCodeReader::send_pending_events(std::unique_lock<std::mutex> &processingLock)
+	{
+		if (!pendingEvents.empty())
+		{
+			// Taken before the processing lock is released, so events from the CAN thread and from update are sent in the order they were found
+			const std::lock_guard<std::mutex> sendingLock(sendingMutex);
+
+			sendingEvents.swap(pendingEvents);
+			pendingEvents.clear();
+			processingLock.unlock();
+
+			{
+				// A copy lets callbacks add or remove callbacks, including themselves
+				const std::lock_guard<std::mutex> lock(callbacksMutex);
+				sendingCallbacks.assign(callbacks.begin(), callbacks.end());
+			}
+
+			for (const auto &event : sendingEvents)
+			{
+				for (const auto &callbackInfo : sendingCallbacks)
+				{
+					callbackInfo.callback(event, callbackInfo.parent);
+				}
+			}
+		}
+	}
+
+} // namespace isobus
@@ -16,6 +16,8 @@
 
 #include <algorithm>
 #include <cstring>
+#include <iterator>
+#include <utility>
 
 namespace isobus
 {
@@ -46,9 +48,20 @@ namespace isobus
 	  stateMachineTimestamp_ms(0),
 	  lastWorkingSetMaintenanceTimestamp_ms(0),
 	  workerThread(nullptr),
+	  commandStatistics(),
+	  pipelinedCommandsMinimumVTVersion(VTVersion::ReservedOrUnknown),
+	  maximumCommandsInFlight(1),
+	  transferInProgress(false),
+	  attributeMirrorNeedsSeeding(false),
+	  originalDataMaskSize_px(0),
+	  originalSoftKeyWidth_px(0),
+	  originalSoftKeyHeight_px(0),
+	  deltaUploadActive(false),
+	  uploadingChangedObjects(false),
 	  initialized(false),
 	  sendWorkingSetMaintenenace(false),
 	  shouldTerminate(false),
+	  workerThreadWakeRequested(false),
 	  objectPoolDataCallback(nullptr),
 	  objectPoolSize_bytes(0),
 	  lastObjectPoolIndex(0)
@@ -111,6 +124,7 @@ namespace isobus
 
 			if (nullptr != workerThread)
 			{
+				wake_worker_thread();
 				workerThread->join();
 				delete workerThread;
 				workerThread = nullptr;
@@ -118,6 +132,19 @@ namespace isobus
 		}
 	}
 
+	VirtualTerminalClient::CommandStatistics VirtualTerminalClient::get_command_statistics(std::uint8_t functionCode)
+	{
+		const std::lock_guard<std::mutex> lock(commandQueueMutex);
+		return commandStatistics[functionCode];
+	}
+
+	void VirtualTerminalClient::set_maximum_commands_in_flight(std::uint8_t value, VTVersion minimumVTVersion)
+	{
+		const std::lock_guard<std::mutex> lock(commandQueueMutex);
+		maximumCommandsInFlight = std::max<std::uint8_t>(value, 1);
+		pipelinedCommandsMinimumVTVersion = minimumVTVersion;
+	}
+
 	void VirtualTerminalClient::register_vt_soft_key_event_callback(VTKeyEventCallback value)
 	{
 		softKeyEventCallbacks.push_back(value);
@@ -319,12 +346,8 @@ namespace isobus
 			                                             0xFF,
 			                                             0xFF };
 
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		// The command sets the object's whole state, so it is queued and replaced like a value change
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, objectID, VALUE_ATTRIBUTE_ID);
 	}
 
 	bool VirtualTerminalClient::send_enable_disable_object(std::uint16_t objectID, EnableDisableObjectCommand command)
@@ -337,12 +360,7 @@ namespace isobus
 			                                             0xFF,
 			                                             0xFF,
 			                                             0xFF };
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, objectID, VALUE_ATTRIBUTE_ID);
 	}
 
 	bool VirtualTerminalClient::send_select_input_object(std::uint16_t objectID, SelectInputObjectOptions option)
@@ -509,12 +527,7 @@ namespace isobus
 			static_cast<std::uint8_t>((value >> 16) & 0xFF),
 			static_cast<std::uint8_t>((value >> 24) & 0xFF),
 		};
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, objectID, VALUE_ATTRIBUTE_ID);
 	}
 
 	bool VirtualTerminalClient::send_change_string_value(std::uint16_t objectID, uint16_t stringLength, const char *value)
@@ -523,23 +536,14 @@ namespace isobus
 
 		if (nullptr != value)
 		{
-			std::uint8_t *buffer = new std::uint8_t[5 + stringLength];
-			buffer[0] = static_cast<std::uint8_t>(Function::ChangeStringValueCommand);
-			buffer[1] = static_cast<std::uint8_t>(objectID & 0xFF);
-			buffer[2] = static_cast<std::uint8_t>(objectID >> 8);
-			buffer[3] = static_cast<std::uint8_t>(stringLength & 0xFF);
-			buffer[4] = static_cast<std::uint8_t>(stringLength >> 8);
-			for (uint16_t i = 0; i < stringLength; i++)
-			{
-				buffer[5 + i] = value[i];
-			}
-			retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-			                                                        buffer,
-			                                                        5 + stringLength,
-			                                                        myControlFunction.get(),
-			                                                        partnerControlFunction.get(),
-			                                                        CANIdentifier::PriorityLowest7);
-			delete[] buffer;
+			const std::uint8_t header[5] = { static_cast<std::uint8_t>(Function::ChangeStringValueCommand),
+				                               static_cast<std::uint8_t>(objectID & 0xFF),
+				                               static_cast<std::uint8_t>(objectID >> 8),
+				                               static_cast<std::uint8_t>(stringLength & 0xFF),
+				                               static_cast<std::uint8_t>(stringLength >> 8) };
+
+			// The string goes straight into the queued command, so no temporary copy is made
+			retVal = queue_command(header, sizeof(header), reinterpret_cast<const std::uint8_t *>(value), stringLength, objectID, VALUE_ATTRIBUTE_ID);
 		}
 		return retVal;
 	}
@@ -559,12 +563,7 @@ namespace isobus
 			                                             static_cast<std::uint8_t>(height_px & 0xFF),
 			                                             static_cast<std::uint8_t>(height_px >> 8),
 			                                             static_cast<std::uint8_t>(direction) };
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, objectID, VALUE_ATTRIBUTE_ID);
 	}
 
 	bool VirtualTerminalClient::send_change_font_attributes(std::uint16_t objectID, std::uint8_t color, FontSize size, std::uint8_t type, std::uint8_t styleBitfield)
@@ -577,12 +576,7 @@ namespace isobus
 			                                             type,
 			                                             styleBitfield,
 			                                             0xFF };
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, objectID, VALUE_ATTRIBUTE_ID);
 	}
 
 	bool VirtualTerminalClient::send_change_line_attributes(std::uint16_t objectID, std::uint8_t color, std::uint8_t width, std::uint16_t lineArtBitmask)
@@ -595,12 +589,7 @@ namespace isobus
 			                                             static_cast<std::uint8_t>(lineArtBitmask & 0xFF),
 			                                             static_cast<std::uint8_t>(lineArtBitmask >> 8),
 			                                             0xFF };
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, objectID, VALUE_ATTRIBUTE_ID);
 	}
 
 	bool VirtualTerminalClient::send_change_fill_attributes(std::uint16_t objectID, FillType fillType, std::uint8_t color, std::uint16_t fillPatternObjectID)
@@ -613,12 +602,7 @@ namespace isobus
 			                                             static_cast<std::uint8_t>(fillPatternObjectID & 0xFF),
 			                                             static_cast<std::uint8_t>(fillPatternObjectID >> 8),
 			                                             0xFF };
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, objectID, VALUE_ATTRIBUTE_ID);
 	}
 
 	bool VirtualTerminalClient::send_change_active_mask(std::uint16_t workingSetObjectID, std::uint16_t newActiveMaskObjectID)
@@ -631,12 +615,7 @@ namespace isobus
 			                                             0xFF,
 			                                             0xFF,
 			                                             0xFF };
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, workingSetObjectID, VALUE_ATTRIBUTE_ID);
 	}
 
 	bool VirtualTerminalClient::send_change_softkey_mask(MaskType type, std::uint16_t dataOrAlarmMaskObjectID, std::uint16_t newSoftKeyMaskObjectID)
@@ -649,12 +628,7 @@ namespace isobus
 			                                             static_cast<std::uint8_t>(newSoftKeyMaskObjectID >> 8),
 			                                             0xFF,
 			                                             0xFF };
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, dataOrAlarmMaskObjectID, VALUE_ATTRIBUTE_ID);
 	}
 
 	bool VirtualTerminalClient::send_change_attribute(std::uint16_t objectID, std::uint8_t attributeID, std::uint32_t value)
@@ -667,12 +641,7 @@ namespace isobus
 			                                             static_cast<std::uint8_t>((value >> 8) & 0xFF),
 			                                             static_cast<std::uint8_t>((value >> 16) & 0xFF),
 			                                             static_cast<std::uint8_t>((value >> 24) & 0xFF) };
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, objectID, attributeID);
 	}
 
 	bool VirtualTerminalClient::send_change_priority(std::uint16_t alarmMaskObjectID, AlarmMaskPriority priority)
@@ -685,12 +654,7 @@ namespace isobus
 			                                             0xFF,
 			                                             0xFF,
 			                                             0xFF };
-		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                      buffer,
-		                                                      CAN_DATA_LENGTH,
-		                                                      myControlFunction.get(),
-		                                                      partnerControlFunction.get(),
-		                                                      CANIdentifier::PriorityLowest7);
+		return queue_command(buffer, CAN_DATA_LENGTH, nullptr, 0, alarmMaskObjectID, VALUE_ATTRIBUTE_ID);
 	}
 
 	bool VirtualTerminalClient::send_change_list_item(std::uint16_t objectID, std::uint8_t listIndex, std::uint16_t newObjectID)
@@ -1081,7 +1045,7 @@ namespace isobus
 		    (nullptr != listOfYOffsetsRelativeToCursor))
 
 		{
-			const std::uint16_t messageLength = (9 + (4 * numberOfPoints));
+			const std::uint16_t messageLength = (5 + (4 * numberOfPoints));
 			std::uint8_t *buffer = new std::uint8_t[messageLength];
 			buffer[0] = static_cast<std::uint8_t>(Function::GraphicsContextCommand);
 			buffer[1] = static_cast<std::uint8_t>(objectID & 0xFF);
@@ -1090,10 +1054,10 @@ namespace isobus
 			buffer[4] = numberOfPoints;
 			for (uint8_t i = 0; i < numberOfPoints; i++)
 			{
-				buffer[5 + i] = static_cast<std::uint8_t>(listOfXOffsetsRelativeToCursor[0] & 0xFF);
-				buffer[6 + i] = static_cast<std::uint8_t>((listOfXOffsetsRelativeToCursor[0] >> 8) & 0xFF);
-				buffer[7 + i] = static_cast<std::uint8_t>(listOfYOffsetsRelativeToCursor[0] & 0xFF);
-				buffer[8 + i] = static_cast<std::uint8_t>((listOfYOffsetsRelativeToCursor[0] >> 8) & 0xFF);
+				buffer[5 + (4 * i)] = static_cast<std::uint8_t>(listOfXOffsetsRelativeToCursor[i] & 0xFF);
+				buffer[6 + (4 * i)] = static_cast<std::uint8_t>((listOfXOffsetsRelativeToCursor[i] >> 8) & 0xFF);
+				buffer[7 + (4 * i)] = static_cast<std::uint8_t>(listOfYOffsetsRelativeToCursor[i] & 0xFF);
+				buffer[8 + (4 * i)] = static_cast<std::uint8_t>((listOfYOffsetsRelativeToCursor[i] >> 8) & 0xFF);
 			}
 			retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
 			                                                        buffer,
@@ -1121,7 +1085,7 @@ namespace isobus
 			buffer[3] = static_cast<std::uint8_t>(GraphicsContextSubCommandID::DrawText);
 			buffer[4] = static_cast<std::uint8_t>(transparent);
 			buffer[5] = textLength;
-			memcpy(buffer, value, textLength);
+			memcpy(&buffer[6], value, textLength);
 			retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
 			                                                        buffer,
 			                                                        messageLength,
@@ -1285,6 +1249,44 @@ namespace isobus
 		                                                      CANIdentifier::PriorityLowest7);
 	}
 
+	bool VirtualTerminalClient::send_graphics_context_batch(VirtualTerminalGraphicsContextBatch &batch)
+	{
+		bool retVal = false;
+
+		if (StateMachineState::Connected == state)
+		{
+			{
+				const std::lock_guard<std::mutex> lock(graphicsContextQueueMutex);
+				auto drawnGraphicsContext = std::lower_bound(graphicsContextsDrawn.begin(), graphicsContextsDrawn.end(), batch.get_object_id());
+
+				// The pool was uploaded again since this graphics context was last drawn on, so it lost what the batch set
+				if ((graphicsContextsDrawn.end() == drawnGraphicsContext) ||
+				    (batch.get_object_id() != *drawnGraphicsContext))
+				{
+					graphicsContextsDrawn.insert(drawnGraphicsContext, batch.get_object_id());
+					batch.resend_state();
+				}
+
+				for (auto &message : batch.take_messages())
+				{
+					graphicsContextQueue.push_back(std::move(message));
+					retVal = true;
+				}
+			}
+
+			if (retVal)
+			{
+				wake_worker_thread();
+			}
+		}
+		else
+		{
+			// The recorded messages stay in the batch, but don't rely on anything set before now
+			batch.forget_state();
+		}
+		return retVal;
+	}
+
 	bool VirtualTerminalClient::send_get_attribute_value(std::uint16_t objectID, std::uint8_t attributeID)
 	{
 		const std::uint8_t buffer[CAN_DATA_LENGTH] = { static_cast<std::uint8_t>(Function::GetAttributeValueMessage),
@@ -1303,6 +1305,72 @@ namespace isobus
 		                                                      CANIdentifier::PriorityLowest7);
 	}
 
+	bool VirtualTerminalClient::get_attribute_value(std::uint16_t objectID, std::uint8_t attributeID, std::uint32_t &value)
+	{
+		const std::uint32_t key = (static_cast<std::uint32_t>(objectID) << 8) | attributeID;
+		bool sendQuery = false;
+		bool retVal = false;
+
+		{
+			const std::lock_guard<std::mutex> lock(attributeMirrorMutex);
+			auto attribute = std::lower_bound(attributeMirror.begin(), attributeMirror.end(), key, [](const MirroredAttribute &entry, std::uint32_t searchKey) { return entry.key < searchKey; });
+
+			if ((attributeMirror.end() != attribute) &&
+			    (key == attribute->key))
+			{
+				value = attribute->value;
+				retVal = true;
+			}
+			else if ((VALUE_ATTRIBUTE_ID != attributeID) &&
+			         (StateMachineState::Connected == state))
+			{
+				// Read through to the VT, unless a query for the attribute is already waiting for its response.
+				// The VT doesn't say which attribute it couldn't read, so a query is only retried once it times out.
+				auto query = std::find_if(pendingAttributeQueries.begin(), pendingAttributeQueries.end(), [key](const PendingAttributeQuery &entry) { return key == entry.key; });
+
+				if (pendingAttributeQueries.end() == query)
+				{
+					pendingAttributeQueries.push_back({ key, SystemTiming::get_timestamp_ms() });
+					sendQuery = true;
+				}
+				else if (SystemTiming::time_expired_ms(query->timestamp_ms, COMMAND_RESPONSE_TIMEOUT_MS))
+				{
+					query->timestamp_ms = SystemTiming::get_timestamp_ms();
+					sendQuery = true;
+				}
+			}
+		}
+
+		if ((sendQuery) &&
+		    (!send_get_attribute_value(objectID, attributeID)))
+		{
+			// Nothing was sent, so let the next read try again
+			const std::lock_guard<std::mutex> lock(attributeMirrorMutex);
+			pendingAttributeQueries.erase(std::remove_if(pendingAttributeQueries.begin(), pendingAttributeQueries.end(), [key](const PendingAttributeQuery &entry) { return key == entry.key; }), pendingAttributeQueries.end());
+		}
+		return retVal;
+	}
+
+	bool VirtualTerminalClient::get_numeric_value(std::uint16_t objectID, std::uint32_t &value)
+	{
+		return get_attribute_value(objectID, VALUE_ATTRIBUTE_ID, value);
+	}
+
+	bool VirtualTerminalClient::get_string_value(std::uint16_t objectID, std::string &value)
+	{
+		const std::lock_guard<std::mutex> lock(attributeMirrorMutex);
+		auto stringValue = std::lower_bound(stringMirror.begin(), stringMirror.end(), objectID, [](const MirroredString &entry, std::uint16_t searchID) { return entry.objectID < searchID; });
+		bool retVal = false;
+
+		if ((stringMirror.end() != stringValue) &&
+		    (objectID == stringValue->objectID))
+		{
+			value = stringValue->value;
+			retVal = true;
+		}
+		return retVal;
+	}
+
 	std::uint8_t VirtualTerminalClient::get_softkey_x_axis_pixels() const
 	{
 		return softKeyXAxisPixels;
@@ -1557,6 +1625,33 @@ namespace isobus
 		}
 	}
 
+	void VirtualTerminalClient::set_object_pool_scaling(std::uint16_t originalDataMaskSize_px, std::uint16_t originalSoftKeyWidth_px, std::uint16_t originalSoftKeyHeight_px)
+	{
+		this->originalDataMaskSize_px = originalDataMaskSize_px;
+		this->originalSoftKeyWidth_px = originalSoftKeyWidth_px;
+		this->originalSoftKeyHeight_px = originalSoftKeyHeight_px;
+	}
+
+	void VirtualTerminalClient::set_object_pool_delta_base(std::uint8_t poolIndex, const std::uint8_t *pool, std::uint32_t size, std::string version)
+	{
+		if ((nullptr != pool) &&
+		    (0 != size) &&
+		    (!version.empty()))
+		{
+			ObjectPoolDeltaBase tempData;
+
+			tempData.objectPoolDataPointer = pool;
+			tempData.objectPoolSize = size;
+
+			if (poolIndex >= objectPoolDeltaBases.size())
+			{
+				objectPoolDeltaBases.resize(poolIndex + 1, { nullptr, 0 });
+			}
+			objectPoolDeltaBases[poolIndex] = tempData;
+			deltaBaseVersionLabel = version;
+		}
+	}
+
 	void VirtualTerminalClient::update()
 	{
 		if (nullptr != partnerControlFunction)
@@ -1599,7 +1694,7 @@ namespace isobus
 					// so the state machine cannot progress.
 					if (SystemTiming::time_expired_ms(lastVTStatusTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Ready to upload pool, but VT server has timed out. Disconnecting.");
+						CAN_STACK_LOG_ERROR("[VT]: Ready to upload pool, but VT server has timed out. Disconnecting.");
 						set_state(StateMachineState::Disconnected);
 					}
 
@@ -1634,7 +1729,7 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Get Memory Response Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Get Memory Response Timeout");
 					}
 				}
 				break;
@@ -1653,7 +1748,7 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Get Number Softkeys Response Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Get Number Softkeys Response Timeout");
 					}
 				}
 				break;
@@ -1672,7 +1767,7 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Get Text Font Data Response Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Get Text Font Data Response Timeout");
 					}
 				}
 				break;
@@ -1691,7 +1786,7 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Get Hardware Response Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Get Hardware Response Timeout");
 					}
 				}
 				break;
@@ -1701,7 +1796,7 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Get Versions Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Get Versions Timeout");
 					}
 					else if ((!objectPools.empty()) &&
 					         (!objectPools[0].versionLabel.empty()) &&
@@ -1717,7 +1812,7 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Get Versions Response Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Get Versions Response Timeout");
 					}
 				}
 				break;
@@ -1727,28 +1822,14 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Send Load Version Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Send Load Version Timeout");
 					}
 					else
 					{
-						constexpr std::uint8_t VERSION_LABEL_LENGTH = 7;
-						std::array<std::uint8_t, VERSION_LABEL_LENGTH> tempVersionBuffer;
-
-						// Unused bytes filled with spaces
-						tempVersionBuffer[0] = ' ';
-						tempVersionBuffer[1] = ' ';
-						tempVersionBuffer[2] = ' ';
-						tempVersionBuffer[3] = ' ';
-						tempVersionBuffer[4] = ' ';
-						tempVersionBuffer[5] = ' ';
-						tempVersionBuffer[6] = ' ';
-
-						for (std::size_t i = 0; ((i < VERSION_LABEL_LENGTH) && (i < objectPools[0].versionLabel.size())); i++)
-						{
-							tempVersionBuffer[i] = objectPools[0].versionLabel[i];
-						}
+						// When uploading only changed objects, the version to start from is the delta base
+						const std::string &versionLabel = deltaUploadActive ? deltaBaseVersionLabel : objectPools[0].versionLabel;
 
-						if (send_load_version(tempVersionBuffer))
+						if (send_load_version(get_version_label_buffer(versionLabel)))
 						{
 							set_state(StateMachineState::WaitForLoadVersionResponse);
 						}
@@ -1761,7 +1842,7 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Load Version Response Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Load Version Response Timeout");
 					}
 				}
 				break;
@@ -1771,28 +1852,11 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Send Store Version Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Send Store Version Timeout");
 					}
 					else
 					{
-						constexpr std::uint8_t VERSION_LABEL_LENGTH = 7;
-						std::array<std::uint8_t, VERSION_LABEL_LENGTH> tempVersionBuffer;
-
-						// Unused bytes filled with spaces
-						tempVersionBuffer[0] = ' ';
-						tempVersionBuffer[1] = ' ';
-						tempVersionBuffer[2] = ' ';
-						tempVersionBuffer[3] = ' ';
-						tempVersionBuffer[4] = ' ';
-						tempVersionBuffer[5] = ' ';
-						tempVersionBuffer[6] = ' ';
-
-						for (std::size_t i = 0; ((i < VERSION_LABEL_LENGTH) && (i < objectPools[0].versionLabel.size())); i++)
-						{
-							tempVersionBuffer[i] = objectPools[0].versionLabel[i];
-						}
-
-						if (send_store_version(tempVersionBuffer))
+						if (send_store_version(get_version_label_buffer(objectPools[0].versionLabel)))
 						{
 							set_state(StateMachineState::WaitForStoreVersionResponse);
 						}
@@ -1805,7 +1869,7 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Store Version Response Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Store Version Response Timeout");
 					}
 				}
 				break;
@@ -1829,17 +1893,40 @@ namespace isobus
 							{
 								if (!objectPools[i].uploaded)
 								{
-									bool transmitSuccessful = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-									                                                                         nullptr,
-									                                                                         objectPools[i].objectPoolSize + 1, // Account for Mux byte
-									                                                                         myControlFunction.get(),
-									                                                                         partnerControlFunction.get(),
-									                                                                         CANIdentifier::CANPriority::PriorityLowest7,
-									                                                                         process_callback,
-									                                                                         this,
-									                                                                         process_internal_object_pool_upload_callback);
-
-									if (transmitSuccessful)
+									std::uint32_t uploadSize = objectPools[i].objectPoolSize;
+
+									prepare_object_pool_scaling(objectPools[i]);
+									uploadingChangedObjects = false;
+
+									if (deltaUploadActive)
+									{
+										if (build_changed_objects(i))
+										{
+											uploadingChangedObjects = true;
+											uploadSize = static_cast<std::uint32_t>(changedObjectsBuffer.size());
+											CAN_STACK_LOG_INFO("[VT]: Uploading %u bytes of changed objects instead of %u bytes.", static_cast<unsigned int>(uploadSize), static_cast<unsigned int>(objectPools[i].objectPoolSize));
+										}
+										else
+										{
+											// Re-sending every object replaces the loaded version entirely
+											CAN_STACK_LOG_WARNING("[VT]: Could not compare an object pool to its delta base. Uploading the whole pool.");
+										}
+									}
+
+									if (0 == uploadSize)
+									{
+										// Nothing changed in this pool since the delta base version
+										objectPools[i].uploaded = true;
+									}
+									else if (CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
+									                                                        nullptr,
+									                                                        uploadSize + 1, // Account for Mux byte
+									                                                        myControlFunction.get(),
+									                                                        partnerControlFunction.get(),
+									                                                        CANIdentifier::CANPriority::PriorityLowest7,
+									                                                        process_callback,
+									                                                        this,
+									                                                        process_internal_object_pool_upload_callback))
 									{
 										currentObjectPoolState = CurrentObjectPoolUploadState::InProgress;
 									}
@@ -1857,7 +1944,7 @@ namespace isobus
 							else if (CurrentObjectPoolUploadState::Failed == currentObjectPoolState)
 							{
 								currentObjectPoolState = CurrentObjectPoolUploadState::Uninitialized;
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: An object pool failed to upload. Resetting connection to VT.");
+								CAN_STACK_LOG_ERROR("[VT]: An object pool failed to upload. Resetting connection to VT.");
 								set_state(StateMachineState::Disconnected);
 							}
 							else
@@ -1868,7 +1955,7 @@ namespace isobus
 						}
 						else
 						{
-							CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: An object pool was supplied with an invalid size or pointer. Ignoring it.");
+							CAN_STACK_LOG_WARNING("[VT]: An object pool was supplied with an invalid size or pointer. Ignoring it.");
 							objectPools[i].uploaded = true;
 						}
 					}
@@ -1894,7 +1981,7 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Failed);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Get End of Object Pool Response Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Get End of Object Pool Response Timeout");
 					}
 				}
 				break;
@@ -1905,7 +1992,13 @@ namespace isobus
 					if (SystemTiming::time_expired_ms(lastVTStatusTimestamp_ms, VT_STATUS_TIMEOUT_MS))
 					{
 						set_state(StateMachineState::Disconnected);
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Status Timeout");
+						CAN_STACK_LOG_ERROR("[VT]: Status Timeout");
+					}
+					else
+					{
+						seed_attribute_mirror();
+						process_command_queue();
+						process_graphics_context_queue();
 					}
 				}
 				break;
@@ -1918,7 +2011,7 @@ namespace isobus
 					// Retry connecting after a while
 					if (SystemTiming::time_expired_ms(stateMachineTimestamp_ms, VT_STATE_MACHINE_RETRY_TIMEOUT_MS))
 					{
-						CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[VT]: Resetting Failed VT Connection");
+						CAN_STACK_LOG_INFO("[VT]: Resetting Failed VT Connection");
 						set_state(StateMachineState::Disconnected);
 					}
 				}
@@ -1938,6 +2031,7 @@ namespace isobus
 		if ((sendWorkingSetMaintenenace) &&
 		    (SystemTiming::time_expired_ms(lastWorkingSetMaintenanceTimestamp_ms, WORKING_SET_MAINTENANCE_TIMEOUT_MS)))
 		{
+			// Maintenance is a directed keep-alive, not a broadcast, so DM13 doesn't stop it. The VT drops the working set after 3 s without it.
 			txFlags.set_flag(static_cast<std::uint32_t>(TransmitFlags::SendWorkingSetMaintenance));
 		}
 		txFlags.process_all_flags();
@@ -2213,6 +2307,20 @@ namespace isobus
 		                                                      CANIdentifier::PriorityLowest7);
 	}
 
+	std::array<std::uint8_t, 7> VirtualTerminalClient::get_version_label_buffer(const std::string &label)
+	{
+		std::array<std::uint8_t, 7> retVal;
+
+		// Unused bytes filled with spaces
+		retVal.fill(' ');
+
+		for (std::size_t i = 0; ((i < retVal.size()) && (i < label.size())); i++)
+		{
+			retVal[i] = static_cast<std::uint8_t>(label[i]);
+		}
+		return retVal;
+	}
+
 	bool VirtualTerminalClient::send_extended_get_versions()
 	{
 		const std::uint8_t buffer[CAN_DATA_LENGTH] = { static_cast<std::uint8_t>(Function::ExtendedDeleteVersionCommand),
@@ -2233,53 +2341,44 @@ namespace isobus
 
 	bool VirtualTerminalClient::send_extended_store_version(std::array<std::uint8_t, 32> versionLabel)
 	{
-		bool retVal;
+		std::array<std::uint8_t, 33> buffer;
 
-		std::uint8_t *buffer = new std::uint8_t[33];
 		buffer[0] = static_cast<std::uint8_t>(Function::ExtendedStoreVersionCommand);
-		memcpy(&buffer[1], versionLabel.data(), 32);
-		retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                        buffer,
-		                                                        33,
-		                                                        myControlFunction.get(),
-		                                                        partnerControlFunction.get(),
-		                                                        CANIdentifier::PriorityLowest7);
-		delete[] buffer;
-		return retVal;
+		memcpy(&buffer[1], versionLabel.data(), versionLabel.size());
+		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
+		                                                      buffer.data(),
+		                                                      buffer.size(),
+		                                                      myControlFunction.get(),
+		                                                      partnerControlFunction.get(),
+		                                                      CANIdentifier::PriorityLowest7);
 	}
 
 	bool VirtualTerminalClient::send_extended_load_version(std::array<std::uint8_t, 32> versionLabel)
 	{
-		bool retVal;
+		std::array<std::uint8_t, 33> buffer;
 
-		std::uint8_t *buffer = new std::uint8_t[33];
 		buffer[0] = static_cast<std::uint8_t>(Function::ExtendedLoadVersionCommand);
-		memcpy(&buffer[1], versionLabel.data(), 32);
-		retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                        buffer,
-		                                                        33,
-		                                                        myControlFunction.get(),
-		                                                        partnerControlFunction.get(),
-		                                                        CANIdentifier::PriorityLowest7);
-		delete[] buffer;
-		return retVal;
+		memcpy(&buffer[1], versionLabel.data(), versionLabel.size());
+		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
+		                                                      buffer.data(),
+		                                                      buffer.size(),
+		                                                      myControlFunction.get(),
+		                                                      partnerControlFunction.get(),
+		                                                      CANIdentifier::PriorityLowest7);
 	}
 
 	bool VirtualTerminalClient::send_extended_delete_version(std::array<std::uint8_t, 32> versionLabel)
 	{
-		bool retVal;
+		std::array<std::uint8_t, 33> buffer;
 
-		std::uint8_t *buffer = new std::uint8_t[33];
 		buffer[0] = static_cast<std::uint8_t>(Function::ExtendedDeleteVersionCommand);
-		memcpy(&buffer[1], versionLabel.data(), 32);
-		retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
-		                                                        buffer,
-		                                                        33,
-		                                                        myControlFunction.get(),
-		                                                        partnerControlFunction.get(),
-		                                                        CANIdentifier::PriorityLowest7);
-		delete[] buffer;
-		return retVal;
+		memcpy(&buffer[1], versionLabel.data(), versionLabel.size());
+		return CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
+		                                                      buffer.data(),
+		                                                      buffer.size(),
+		                                                      myControlFunction.get(),
+		                                                      partnerControlFunction.get(),
+		                                                      CANIdentifier::PriorityLowest7);
 	}
 
 	bool VirtualTerminalClient::send_end_of_object_pool()
@@ -2362,67 +2461,482 @@ namespace isobus
 		                                                      CANIdentifier::PriorityLowest7);
 	}
 
-	void VirtualTerminalClient::set_state(StateMachineState value)
+	bool VirtualTerminalClient::queue_command(const std::uint8_t *header, std::uint8_t headerLength, const std::uint8_t *payload, std::uint16_t payloadLength, std::uint16_t objectID, std::uint8_t attributeID)
 	{
-		stateMachineTimestamp_ms = SystemTiming::get_timestamp_ms();
-		state = value;
+		bool retVal = false;
 
-		if (StateMachineState::Disconnected == value)
+		if ((nullptr != header) &&
+		    (0 != headerLength) &&
+		    ((nullptr != payload) ||
+		     (0 == payloadLength)))
 		{
-			lastVTStatusTimestamp_ms = 0;
-			for (std::size_t i = 0; i < objectPools.size(); i++)
+			const std::uint8_t functionCode = header[0];
+			const std::lock_guard<std::mutex> lock(commandQueueMutex);
+
+			// The queue is cleared when the connection ends, so a command queued without one would never be sent
+			if (StateMachineState::Connected == state)
 			{
-				objectPools[i].uploaded = false;
+				auto queuedCommand = std::find_if(commandQueue.begin(), commandQueue.end(), [functionCode, objectID, attributeID](const QueuedCommand &command) {
+					return ((command.data[0] == functionCode) &&
+					        (command.objectID == objectID) &&
+					        (command.attributeID == attributeID));
+				});
+
+				if (commandQueue.end() == queuedCommand)
+				{
+					commandQueue.push_back({ get_spare_command_buffer(), objectID, attributeID });
+					queuedCommand = commandQueue.end() - 1;
+				}
+
+				// Only the newest value matters, so overwrite the one that hasn't been sent yet.
+				// Assigning keeps the buffer's memory, so a steady stream of updates doesn't allocate.
+				queuedCommand->data.assign(header, header + headerLength);
+				queuedCommand->data.insert(queuedCommand->data.end(), payload, payload + payloadLength);
+				retVal = true;
 			}
 		}
-	}
 
-	void VirtualTerminalClient::process_button_event_callback(KeyActivationCode keyEvent, std::uint8_t keyNumber, std::uint16_t objectID, std::uint16_t parentObjectID, VirtualTerminalClient *parentPointer)
-	{
-		for (std::size_t i = 0; i < parentPointer->buttonEventCallbacks.size(); i++)
+		if (retVal)
 		{
-			if (nullptr != parentPointer->buttonEventCallbacks[i])
-			{
-				parentPointer->buttonEventCallbacks[i](keyEvent, keyNumber, objectID, parentObjectID, parentPointer);
-			}
+			wake_worker_thread();
 		}
+		return retVal;
 	}
 
-	void VirtualTerminalClient::process_softkey_event_callback(KeyActivationCode keyEvent, std::uint8_t keyNumber, std::uint16_t objectID, std::uint16_t parentObjectID, VirtualTerminalClient *parentPointer)
+	void VirtualTerminalClient::process_command_queue()
 	{
-		for (std::size_t i = 0; i < parentPointer->softKeyEventCallbacks.size(); i++)
+		const std::lock_guard<std::mutex> lock(commandQueueMutex);
+		std::size_t commandsInFlightLimit = 1;
+
+		if (get_vt_version_supported(pipelinedCommandsMinimumVTVersion))
 		{
-			if (nullptr != parentPointer->softKeyEventCallbacks[i])
-			{
-				parentPointer->softKeyEventCallbacks[i](keyEvent, keyNumber, objectID, parentObjectID, parentPointer);
-			}
+			commandsInFlightLimit = maximumCommandsInFlight;
 		}
-	}
 
-	void VirtualTerminalClient::process_pointing_event_callback(KeyActivationCode keyEvent,
-	                                                            std::uint16_t xPosition,
-	                                                            std::uint16_t yPosition,
-	                                                            std::uint16_t parentMaskObjectID,
-	                                                            VirtualTerminalClient *parentPointer)
-	{
-		for (std::size_t i = 0; i < parentPointer->pointingEventCallbacks.size(); i++)
+		for (auto inFlightCommand = commandsInFlight.begin(); inFlightCommand != commandsInFlight.end();)
 		{
-			if (nullptr != parentPointer->pointingEventCallbacks[i])
+			bool dropCommand = false;
+
+			if (SystemTiming::time_expired_ms(inFlightCommand->sentTimestamp_ms, COMMAND_RESPONSE_TIMEOUT_MS))
 			{
-				parentPointer->pointingEventCallbacks[i](keyEvent, xPosition, yPosition, parentMaskObjectID, parentPointer);
+				const QueuedCommand &command = inFlightCommand->command;
+				const bool newerCommandQueued = commandQueue.end() != std::find_if(commandQueue.begin(), commandQueue.end(), [&command](const QueuedCommand &queuedCommand) { return get_is_same_command_target(queuedCommand, command); });
+
+				// No point repeating an old value if a newer one is waiting to be sent
+				if ((inFlightCommand->retries < MAX_COMMAND_RETRIES) &&
+				    (!newerCommandQueued))
+				{
+					if (send_queued_command(command.data))
+					{
+						inFlightCommand->retries++;
+						inFlightCommand->sentTimestamp_ms = SystemTiming::get_timestamp_ms();
+						commandStatistics[command.data[0]].numberOfRetries++;
+					}
+				}
+				else
+				{
+					CAN_STACK_LOG_WARNING("[VT]: Timeout waiting for a response to command %u for object %u", static_cast<unsigned int>(command.data[0]), static_cast<unsigned int>(command.objectID));
+					commandStatistics[command.data[0]].numberOfTimeouts++;
+					dropCommand = true;
+				}
 			}
-		}
-	}
 
-	void VirtualTerminalClient::process_select_input_object_callback(std::uint16_t objectID, bool objectSelected, bool objectOpenForInput, VirtualTerminalClient *parentPointer)
-	{
-		for (std::size_t i = 0; i < parentPointer->selectInputObjectCallbacks.size(); i++)
-		{
-			if (nullptr != parentPointer->selectInputObjectCallbacks[i])
+			if (dropCommand)
 			{
-				parentPointer->selectInputObjectCallbacks[i](objectID, objectSelected, objectOpenForInput, parentPointer);
+				spareCommandBuffers.push_back(std::move(inFlightCommand->command.data));
+				inFlightCommand = commandsInFlight.erase(inFlightCommand);
 			}
-		}
+			else
+			{
+				inFlightCommand++;
+			}
+		}
+
+		for (auto queuedCommand = commandQueue.begin(); (queuedCommand != commandQueue.end()) && (commandsInFlight.size() < commandsInFlightLimit);)
+		{
+			const bool sameTargetInFlight = commandsInFlight.end() != std::find_if(commandsInFlight.begin(), commandsInFlight.end(), [&queuedCommand](const InFlightCommand &inFlightCommand) { return get_is_same_command_target(inFlightCommand.command, *queuedCommand); });
+
+			// Commands for the same target are kept in order, so they can't overtake each other
+			if (sameTargetInFlight)
+			{
+				queuedCommand++;
+			}
+			else if (send_queued_command(queuedCommand->data))
+			{
+				commandsInFlight.push_back({ std::move(*queuedCommand), SystemTiming::get_timestamp_ms(), 0 });
+				queuedCommand = commandQueue.erase(queuedCommand);
+			}
+			else
+			{
+				break;
+			}
+		}
+	}
+
+	void VirtualTerminalClient::process_graphics_context_queue()
+	{
+		const std::lock_guard<std::mutex> lock(graphicsContextQueueMutex);
+		bool sendFailed = false;
+
+		while ((!sendFailed) &&
+		       (!graphicsContextQueue.empty()))
+		{
+			// Later messages wait for a multi-frame message to finish, or they would be drawn first
+			if ((!get_is_transfer_in_progress()) &&
+			    (send_queued_command(graphicsContextQueue.front())))
+			{
+				graphicsContextQueue.pop_front();
+			}
+			else
+			{
+				sendFailed = true;
+			}
+		}
+	}
+
+	void VirtualTerminalClient::process_command_response(CANMessage *message)
+	{
+		const std::uint8_t functionCode = message->get_uint8_at(0);
+		const std::lock_guard<std::mutex> lock(commandQueueMutex);
+
+		if (!commandsInFlight.empty())
+		{
+			// Most responses echo the object ID right after the function code, but change string value has two reserved bytes first
+			const std::uint16_t objectID = message->get_uint16_at((static_cast<std::uint8_t>(Function::ChangeStringValueCommand) == functionCode) ? 3 : 1);
+			const bool matchAttribute = (static_cast<std::uint8_t>(Function::ChangeAttributeCommand) == functionCode);
+			const std::uint8_t attributeID = message->get_uint8_at(3);
+
+			// The change active mask response echoes the new mask instead of the working set the command was queued for.
+			// Only one command per working set can be in flight, so its function code is enough to match it.
+			const bool matchObjectID = (static_cast<std::uint8_t>(Function::ChangeActiveMaskCommand) != functionCode);
+
+			// Several attributes of one object can be changed at once, so change attribute responses must match the attribute too
+			auto inFlightCommand = std::find_if(commandsInFlight.begin(), commandsInFlight.end(), [functionCode, objectID, matchObjectID, matchAttribute, attributeID](const InFlightCommand &command) {
+				return ((command.command.data[0] == functionCode) &&
+				        ((!matchObjectID) || (command.command.objectID == objectID)) &&
+				        ((!matchAttribute) || (command.command.attributeID == attributeID)));
+			});
+
+			if (commandsInFlight.end() != inFlightCommand)
+			{
+				CommandStatistics &statistics = commandStatistics[functionCode];
+				const std::uint32_t latency_ms = SystemTiming::get_time_elapsed_ms(inFlightCommand->sentTimestamp_ms);
+
+				if ((0 == statistics.numberOfResponses) ||
+				    (latency_ms < statistics.minimumLatency_ms))
+				{
+					statistics.minimumLatency_ms = latency_ms;
+				}
+				if (latency_ms > statistics.maximumLatency_ms)
+				{
+					statistics.maximumLatency_ms = latency_ms;
+				}
+				statistics.totalLatency_ms += latency_ms;
+				statistics.numberOfResponses++;
+				update_attribute_mirror(inFlightCommand->command, message);
+				spareCommandBuffers.push_back(std::move(inFlightCommand->command.data));
+				commandsInFlight.erase(inFlightCommand);
+			}
+		}
+	}
+
+	bool VirtualTerminalClient::get_is_same_command_target(const QueuedCommand &first, const QueuedCommand &second)
+	{
+		return ((first.data[0] == second.data[0]) &&
+		        (first.objectID == second.objectID) &&
+		        (first.attributeID == second.attributeID));
+	}
+
+	bool VirtualTerminalClient::send_queued_command(const std::vector<std::uint8_t> &data)
+	{
+		bool retVal = false;
+
+		if (data.size() <= CAN_DATA_LENGTH)
+		{
+			retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
+			                                                        data.data(),
+			                                                        data.size(),
+			                                                        myControlFunction.get(),
+			                                                        partnerControlFunction.get(),
+			                                                        CANIdentifier::PriorityLowest7);
+		}
+		else
+		{
+			const std::lock_guard<std::mutex> lock(transferMutex);
+
+			// Only one transport session to the VT can run at a time, and it is still reading the buffer
+			if (!transferInProgress)
+			{
+				// The session reads frames from the transfer buffer, which keeps its memory between commands
+				transferBuffer.assign(data.begin(), data.end());
+				retVal = CANNetworkManager::CANNetwork.send_can_message(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal),
+				                                                        nullptr,
+				                                                        transferBuffer.size(),
+				                                                        myControlFunction.get(),
+				                                                        partnerControlFunction.get(),
+				                                                        CANIdentifier::PriorityLowest7,
+				                                                        process_callback,
+				                                                        this,
+				                                                        process_transfer_chunk);
+				transferInProgress = retVal;
+			}
+		}
+		return retVal;
+	}
+
+	bool VirtualTerminalClient::get_is_transfer_in_progress()
+	{
+		const std::lock_guard<std::mutex> lock(transferMutex);
+		return transferInProgress;
+	}
+
+	std::vector<std::uint8_t> VirtualTerminalClient::get_spare_command_buffer()
+	{
+		std::vector<std::uint8_t> retVal;
+
+		if (!spareCommandBuffers.empty())
+		{
+			retVal = std::move(spareCommandBuffers.back());
+			spareCommandBuffers.pop_back();
+		}
+		return retVal;
+	}
+
+	void VirtualTerminalClient::update_attribute_mirror(const QueuedCommand &command, CANMessage *response)
+	{
+		switch (command.data[0])
+		{
+			case static_cast<std::uint8_t>(Function::ChangeNumericValueCommand):
+			{
+				if (0 == response->get_uint8_at(3))
+				{
+					set_mirrored_attribute(command.objectID, VALUE_ATTRIBUTE_ID, response->get_uint32_at(4));
+				}
+			}
+			break;
+
+			case static_cast<std::uint8_t>(Function::ChangeAttributeCommand):
+			{
+				if (0 == response->get_uint8_at(4))
+				{
+					const std::uint32_t value = static_cast<std::uint32_t>(command.data[4]) |
+					  (static_cast<std::uint32_t>(command.data[5]) << 8) |
+					  (static_cast<std::uint32_t>(command.data[6]) << 16) |
+					  (static_cast<std::uint32_t>(command.data[7]) << 24);
+					set_mirrored_attribute(command.objectID, command.attributeID, value);
+				}
+			}
+			break;
+
+			case static_cast<std::uint8_t>(Function::ChangeStringValueCommand):
+			{
+				if (0 == response->get_uint8_at(5))
+				{
+					set_mirrored_string(command.objectID, std::string(command.data.begin() + 5, command.data.end()));
+				}
+			}
+			break;
+
+			default:
+			{
+				// Other commands aren't mirrored
+			}
+			break;
+		}
+	}
+
+	void VirtualTerminalClient::set_mirrored_attribute(std::uint16_t objectID, std::uint8_t attributeID, std::uint32_t value)
+	{
+		const std::uint32_t key = (static_cast<std::uint32_t>(objectID) << 8) | attributeID;
+		const std::lock_guard<std::mutex> lock(attributeMirrorMutex);
+		auto attribute = std::lower_bound(attributeMirror.begin(), attributeMirror.end(), key, [](const MirroredAttribute &entry, std::uint32_t searchKey) { return entry.key < searchKey; });
+
+		if ((attributeMirror.end() != attribute) &&
+		    (key == attribute->key))
+		{
+			attribute->value = value;
+		}
+		else
+		{
+			attributeMirror.insert(attribute, { key, value });
+		}
+		pendingAttributeQueries.erase(std::remove_if(pendingAttributeQueries.begin(), pendingAttributeQueries.end(), [key](const PendingAttributeQuery &entry) { return key == entry.key; }), pendingAttributeQueries.end());
+	}
+
+	void VirtualTerminalClient::set_mirrored_string(std::uint16_t objectID, const std::string &value)
+	{
+		const std::lock_guard<std::mutex> lock(attributeMirrorMutex);
+		auto stringValue = std::lower_bound(stringMirror.begin(), stringMirror.end(), objectID, [](const MirroredString &entry, std::uint16_t searchID) { return entry.objectID < searchID; });
+
+		if ((stringMirror.end() != stringValue) &&
+		    (objectID == stringValue->objectID))
+		{
+			stringValue->value = value;
+		}
+		else
+		{
+			stringMirror.insert(stringValue, { objectID, value });
+		}
+	}
+
+	void VirtualTerminalClient::seed_attribute_mirror()
+	{
+		bool needsSeeding = false;
+
+		{
+			const std::lock_guard<std::mutex> lock(attributeMirrorMutex);
+			needsSeeding = attributeMirrorNeedsSeeding;
+			attributeMirrorNeedsSeeding = false;
+		}
+
+		if (needsSeeding)
+		{
+			VirtualTerminalObjectPoolIndex poolIndex;
+			std::vector<MirroredAttribute> poolAttributes;
+			std::vector<MirroredString> poolStrings;
+			std::string stringValue;
+
+			for (const auto &pool : objectPools)
+			{
+				if ((!pool.useDataCallback) &&
+				    (poolIndex.parse(pool.objectPoolDataPointer, pool.objectPoolSize)))
+				{
+					for (std::uint32_t i = 0; i < poolIndex.get_number_objects(); i++)
+					{
+						const VirtualTerminalObjectPoolIndex::ObjectEntry &object = *poolIndex.get_object_by_index(i);
+						std::uint32_t numericValue = 0;
+
+						// Objects that reference a variable get their value from it, so only their own value is mirrored
+						if (VirtualTerminalObjectPoolIndex::get_numeric_value(pool.objectPoolDataPointer, object, numericValue))
+						{
+							poolAttributes.push_back({ (static_cast<std::uint32_t>(object.objectID) << 8) | VALUE_ATTRIBUTE_ID, numericValue });
+						}
+						else if (VirtualTerminalObjectPoolIndex::get_string_value(pool.objectPoolDataPointer, object, stringValue))
+						{
+							poolStrings.push_back({ object.objectID, stringValue });
+						}
+					}
+				}
+			}
+
+			const auto attributeLess = [](const MirroredAttribute &first, const MirroredAttribute &second) { return first.key < second.key; };
+			const auto stringLess = [](const MirroredString &first, const MirroredString &second) { return first.objectID < second.objectID; };
+			std::vector<MirroredAttribute> seededAttributes;
+			std::vector<MirroredString> seededStrings;
+
+			std::stable_sort(poolAttributes.begin(), poolAttributes.end(), attributeLess);
+			std::stable_sort(poolStrings.begin(), poolStrings.end(), stringLess);
+
+			// set_union takes equal entries from the mirror, so values the VT reported since connecting win over the pools
+			const std::lock_guard<std::mutex> lock(attributeMirrorMutex);
+			std::set_union(attributeMirror.begin(), attributeMirror.end(), poolAttributes.begin(), poolAttributes.end(), std::back_inserter(seededAttributes), attributeLess);
+			std::set_union(stringMirror.begin(), stringMirror.end(), poolStrings.begin(), poolStrings.end(), std::back_inserter(seededStrings), stringLess);
+			attributeMirror.swap(seededAttributes);
+			stringMirror.swap(seededStrings);
+		}
+	}
+
+	void VirtualTerminalClient::set_state(StateMachineState value)
+	{
+		stateMachineTimestamp_ms = SystemTiming::get_timestamp_ms();
+
+		if ((StateMachineState::Connected == value) &&
+		    (StateMachineState::Connected != state))
+		{
+			// The VT now shows the pool as it was uploaded. This may run on the receiving thread, so update seeds the mirror.
+			const std::lock_guard<std::mutex> lock(attributeMirrorMutex);
+			attributeMirror.clear();
+			stringMirror.clear();
+			pendingAttributeQueries.clear();
+			attributeMirrorNeedsSeeding = true;
+		}
+
+		if ((StateMachineState::Connected == state) &&
+		    (StateMachineState::Connected != value))
+		{
+			const std::lock_guard<std::mutex> lock(commandQueueMutex);
+
+			// A reconnected VT starts from the uploaded pool again, so changes for the old session must not be sent to it
+			for (auto &queuedCommand : commandQueue)
+			{
+				spareCommandBuffers.push_back(std::move(queuedCommand.data));
+			}
+			for (auto &inFlightCommand : commandsInFlight)
+			{
+				spareCommandBuffers.push_back(std::move(inFlightCommand.command.data));
+			}
+			commandQueue.clear();
+			commandsInFlight.clear();
+			state = value;
+		}
+		else
+		{
+			state = value;
+		}
+
+		if (StateMachineState::Disconnected == value)
+		{
+			lastVTStatusTimestamp_ms = 0;
+			deltaUploadActive = false;
+			uploadingChangedObjects = false;
+			for (std::size_t i = 0; i < objectPools.size(); i++)
+			{
+				objectPools[i].uploaded = false;
+			}
+
+			// Whatever was drawn is gone along with the connection
+			const std::lock_guard<std::mutex> graphicsContextLock(graphicsContextQueueMutex);
+			graphicsContextQueue.clear();
+			graphicsContextsDrawn.clear();
+		}
+	}
+
+	void VirtualTerminalClient::process_button_event_callback(KeyActivationCode keyEvent, std::uint8_t keyNumber, std::uint16_t objectID, std::uint16_t parentObjectID, VirtualTerminalClient *parentPointer)
+	{
+		for (std::size_t i = 0; i < parentPointer->buttonEventCallbacks.size(); i++)
+		{
+			if (nullptr != parentPointer->buttonEventCallbacks[i])
+			{
+				parentPointer->buttonEventCallbacks[i](keyEvent, keyNumber, objectID, parentObjectID, parentPointer);
+			}
+		}
+	}
+
+	void VirtualTerminalClient::process_softkey_event_callback(KeyActivationCode keyEvent, std::uint8_t keyNumber, std::uint16_t objectID, std::uint16_t parentObjectID, VirtualTerminalClient *parentPointer)
+	{
+		for (std::size_t i = 0; i < parentPointer->softKeyEventCallbacks.size(); i++)
+		{
+			if (nullptr != parentPointer->softKeyEventCallbacks[i])
+			{
+				parentPointer->softKeyEventCallbacks[i](keyEvent, keyNumber, objectID, parentObjectID, parentPointer);
+			}
+		}
+	}
+
+	void VirtualTerminalClient::process_pointing_event_callback(KeyActivationCode keyEvent,
+	                                                            std::uint16_t xPosition,
+	                                                            std::uint16_t yPosition,
+	                                                            std::uint16_t parentMaskObjectID,
+	                                                            VirtualTerminalClient *parentPointer)
+	{
+		for (std::size_t i = 0; i < parentPointer->pointingEventCallbacks.size(); i++)
+		{
+			if (nullptr != parentPointer->pointingEventCallbacks[i])
+			{
+				parentPointer->pointingEventCallbacks[i](keyEvent, xPosition, yPosition, parentMaskObjectID, parentPointer);
+			}
+		}
+	}
+
+	void VirtualTerminalClient::process_select_input_object_callback(std::uint16_t objectID, bool objectSelected, bool objectOpenForInput, VirtualTerminalClient *parentPointer)
+	{
+		for (std::size_t i = 0; i < parentPointer->selectInputObjectCallbacks.size(); i++)
+		{
+			if (nullptr != parentPointer->selectInputObjectCallbacks[i])
+			{
+				parentPointer->selectInputObjectCallbacks[i](objectID, objectSelected, objectOpenForInput, parentPointer);
+			}
+		}
 	}
 
 	void VirtualTerminalClient::process_esc_message_callback(std::uint16_t objectID, ESCMessageErrorCode errorCode, VirtualTerminalClient *parentPointer)
@@ -2594,7 +3108,7 @@ namespace isobus
 						std::uint32_t targetParameterGroupNumber = message->get_uint24_at(5);
 						if (static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal) == targetParameterGroupNumber)
 						{
-							CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: The VT Server is NACK-ing our VT messages. Disconnecting.");
+							CAN_STACK_LOG_ERROR("[VT]: The VT Server is NACK-ing our VT messages. Disconnecting.");
 							parentVT->set_state(StateMachineState::Disconnected);
 						}
 					}
@@ -2603,6 +3117,8 @@ namespace isobus
 
 				case static_cast<std::uint32_t>(CANLibParameterGroupNumber::VirtualTerminalToECU):
 				{
+					parentVT->process_command_response(message);
+
 					switch (message->get_uint8_at(0))
 					{
 						case static_cast<std::uint8_t>(Function::SoftKeyActivationMessage):
@@ -2717,6 +3233,7 @@ namespace isobus
 							{
 								//! @todo process TAN
 							}
+							parentVT->set_mirrored_attribute(objectID, VALUE_ATTRIBUTE_ID, value);
 							parentVT->process_change_numeric_value_callback(objectID, value, parentVT);
 						}
 						break;
@@ -2764,12 +3281,25 @@ namespace isobus
 						}
 						break;
 
+						case static_cast<std::uint8_t>(Function::GetAttributeValueMessage):
+						{
+							const std::uint8_t attributeID = message->get_uint8_at(3);
+
+							// The VT returns an attribute ID of 0xFF if the object or attribute doesn't exist
+							if (0xFF != attributeID)
+							{
+								parentVT->set_mirrored_attribute(message->get_uint16_at(1), attributeID, message->get_uint32_at(4));
+							}
+						}
+						break;
+
 						case static_cast<std::uint8_t>(Function::VTChangeStringValueMessage):
 						{
 							std::uint16_t objectID = message->get_uint16_at(1);
 							std::uint8_t stringLength = message->get_uint8_at(3);
 							std::string value = std::string(message->get_data().begin() + 4, message->get_data().begin() + 4 + stringLength);
 
+							parentVT->set_mirrored_string(objectID, value);
 							parentVT->process_change_string_value_callback(objectID, value, parentVT);
 						}
 						break;
@@ -2813,33 +3343,33 @@ namespace isobus
 						{
 							if (message->get_bool_at(1, 0))
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[AUX-N]: Preferred Assignment Error - Auxiliary Input Unit(s) (NAME or Model Identification Code) not valid");
+								CAN_STACK_LOG_ERROR("[AUX-N]: Preferred Assignment Error - Auxiliary Input Unit(s) (NAME or Model Identification Code) not valid");
 							}
 							if (message->get_bool_at(3, 1))
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[AUX-N]: Preferred Assignment Error - Function Object ID(S) not valid");
+								CAN_STACK_LOG_ERROR("[AUX-N]: Preferred Assignment Error - Function Object ID(S) not valid");
 							}
 							if (message->get_bool_at(3, 2))
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[AUX-N]: Preferred Assignment Error - Input Object ID(s) not valid");
+								CAN_STACK_LOG_ERROR("[AUX-N]: Preferred Assignment Error - Input Object ID(s) not valid");
 							}
 							if (message->get_bool_at(3, 3))
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[AUX-N]: Preferred Assignment Error - Duplicate Object ID of Auxiliary Function");
+								CAN_STACK_LOG_ERROR("[AUX-N]: Preferred Assignment Error - Duplicate Object ID of Auxiliary Function");
 							}
 							if (message->get_bool_at(3, 4))
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[AUX-N]: Preferred Assignment Error - Other");
+								CAN_STACK_LOG_ERROR("[AUX-N]: Preferred Assignment Error - Other");
 							}
 
 							if (0 != message->get_uint8_at(1))
 							{
 								std::uint16_t faultyObjectID = message->get_uint16_at(2);
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[AUX-N]: Auxiliary Function Object ID of faulty assignment: " + isobus::to_string(faultyObjectID));
+								CAN_STACK_LOG_ERROR("[AUX-N]: Auxiliary Function Object ID of faulty assignment: %u", static_cast<unsigned int>(faultyObjectID));
 							}
 							else
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug, "[AUX-N]: Preferred Assignment OK");
+								CAN_STACK_LOG_DEBUG("[AUX-N]: Preferred Assignment OK");
 								//! @todo load the preferred assignment into parentVT->auxiliaryInputDevices
 							}
 						}
@@ -2867,7 +3397,7 @@ namespace isobus
 											//! @todo save preferred assignment to persistent configuration
 										}
 									}
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[AUX-N] Unassigned all functions");
+									CAN_STACK_LOG_INFO("[AUX-N] Unassigned all functions");
 								}
 								else if (0x1F == functionType)
 								{
@@ -2880,7 +3410,7 @@ namespace isobus
 											{
 												//! @todo save preferred assignment to persistent configuration
 											}
-											CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[AUX-N] Unassigned function " + isobus::to_string(static_cast<int>(functionObjectID)) + " from input " + isobus::to_string(static_cast<int>(inputObjectID)));
+											CAN_STACK_LOG_INFO("[AUX-N] Unassigned function %u from input %u", static_cast<unsigned int>(functionObjectID), static_cast<unsigned int>(inputObjectID));
 											break;
 										}
 									}
@@ -2900,7 +3430,7 @@ namespace isobus
 													{
 														//! @todo save preferred assignment to persistent configuration
 													}
-													CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[AUX-N] Unassigned function " + isobus::to_string(static_cast<int>(functionObjectID)) + " from input " + isobus::to_string(static_cast<int>(inputObjectID)));
+													CAN_STACK_LOG_INFO("[AUX-N] Unassigned function %u from input %u", static_cast<unsigned int>(functionObjectID), static_cast<unsigned int>(inputObjectID));
 												}
 											}
 										}
@@ -2921,7 +3451,7 @@ namespace isobus
 													{
 														//! @todo save preferred assignment to persistent configuration
 													}
-													CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[AUX-N] Unassigned function " + isobus::to_string(static_cast<int>(functionObjectID)) + " from input " + isobus::to_string(static_cast<int>(inputObjectID)));
+													CAN_STACK_LOG_INFO("[AUX-N] Unassigned function %u from input %u", static_cast<unsigned int>(functionObjectID), static_cast<unsigned int>(inputObjectID));
 												}
 											}
 										}
@@ -2946,19 +3476,19 @@ namespace isobus
 													{
 														//! @todo save preferred assignment to persistent configuration
 													}
-													CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[AUX-N]: Assigned function " + isobus::to_string(static_cast<int>(functionObjectID)) + " to input " + isobus::to_string(static_cast<int>(inputObjectID)));
+													CAN_STACK_LOG_INFO("[AUX-N]: Assigned function %u to input %u", static_cast<unsigned int>(functionObjectID), static_cast<unsigned int>(inputObjectID));
 												}
 												else
 												{
 													hasError = true;
 													isAlreadyAssigned = true;
-													CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[AUX-N]: Unable to store preferred assignment due to missing auxiliary input device with name: " + isobus::to_string(isoName));
+													CAN_STACK_LOG_WARNING("[AUX-N]: Unable to store preferred assignment due to missing auxiliary input device with name: %llu", static_cast<unsigned long long>(isoName));
 												}
 											}
 											else
 											{
 												hasError = true;
-												CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[AUX-N]: Unable to store preferred assignment due to unsupported function type: " + isobus::to_string(functionType));
+												CAN_STACK_LOG_WARNING("[AUX-N]: Unable to store preferred assignment due to unsupported function type: %u", static_cast<unsigned int>(functionType));
 											}
 											break;
 										}
@@ -2967,14 +3497,14 @@ namespace isobus
 									{
 										hasError = true;
 										//! @todo prettier logging of NAME
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[AUX-N]: Unable to store preferred assignment due to missing auxiliary input device with name: " + isobus::to_string(isoName));
+										CAN_STACK_LOG_WARNING("[AUX-N]: Unable to store preferred assignment due to missing auxiliary input device with name: %llu", static_cast<unsigned long long>(isoName));
 									}
 								}
 								parentVT->send_aux_n_assignment_response(functionObjectID, hasError, isAlreadyAssigned);
 							}
 							else
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[AUX-N]: Received AuxiliaryAssignmentTypeTwoCommand with wrong data length: " + isobus::to_string(message->get_data_length()) + " but expected 14.");
+								CAN_STACK_LOG_WARNING("[AUX-N]: Received AuxiliaryAssignmentTypeTwoCommand with wrong data length: %u but expected 14.", static_cast<unsigned int>(message->get_data_length()));
 							}
 						}
 						break;
@@ -3032,7 +3562,7 @@ namespace isobus
 								else
 								{
 									parentVT->set_state(StateMachineState::Failed);
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Connection Failed Not Enough Memory");
+									CAN_STACK_LOG_ERROR("[VT]: Connection Failed Not Enough Memory");
 								}
 							}
 						}
@@ -3103,6 +3633,9 @@ namespace isobus
 								{
 									// Check for label match
 									bool labelMatched = false;
+									bool deltaBaseMatched = false;
+									const bool deltaUploadPossible = parentVT->get_is_delta_upload_possible();
+									const std::array<std::uint8_t, LABEL_LENGTH> deltaBaseLabel = get_version_label_buffer(parentVT->deltaBaseVersionLabel);
 									const std::size_t remainingLength = (2 + (LABEL_LENGTH * numberOfLabels));
 
 									if (message->get_data_length() >= remainingLength)
@@ -3136,12 +3669,18 @@ namespace isobus
 											{
 												labelMatched = true;
 												parentVT->set_state(StateMachineState::SendLoadVersion);
-												CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[VT]: VT Server has a matching label for " + isobus::to_string(labelDecoded) + ". It will be loaded and upload will be skipped.");
+												CAN_STACK_LOG_INFO("[VT]: VT Server has a matching label for %s. It will be loaded and upload will be skipped.", labelDecoded.c_str());
 												break;
 											}
+											else if ((deltaUploadPossible) &&
+											         (std::string(deltaBaseLabel.begin(), deltaBaseLabel.end()) == labelDecoded))
+											{
+												// Keep this version, the pool can be uploaded as changes to it
+												deltaBaseMatched = true;
+											}
 											else
 											{
-												CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[VT]: VT Server has a label for " + isobus::to_string(labelDecoded) + ". This version will be deleted.");
+												CAN_STACK_LOG_INFO("[VT]: VT Server has a label for %s. This version will be deleted.", labelDecoded.c_str());
 												const std::array<std::uint8_t, 7> deleteBuffer = {
 													static_cast<std::uint8_t>(labelDecoded[0]),
 													static_cast<std::uint8_t>(labelDecoded[1]),
@@ -3153,30 +3692,37 @@ namespace isobus
 												};
 												if (!parentVT->send_delete_version(deleteBuffer))
 												{
-													CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Failed to send the delete version message for label " + isobus::to_string(labelDecoded));
+													CAN_STACK_LOG_WARNING("[VT]: Failed to send the delete version message for label %s", labelDecoded.c_str());
 												}
 											}
 										}
-										if (!labelMatched)
+										if ((!labelMatched) &&
+										    (deltaBaseMatched))
 										{
-											CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[VT]: No version label from the VT matched. Client will upload the pool and store it instead.");
+											CAN_STACK_LOG_INFO("[VT]: VT Server has the delta base label %s. It will be loaded and only changed objects will be uploaded.", parentVT->deltaBaseVersionLabel.c_str());
+											parentVT->deltaUploadActive = true;
+											parentVT->set_state(StateMachineState::SendLoadVersion);
+										}
+										else if (!labelMatched)
+										{
+											CAN_STACK_LOG_INFO("[VT]: No version label from the VT matched. Client will upload the pool and store it instead.");
 											parentVT->set_state(StateMachineState::UploadObjectPool);
 										}
 									}
 									else
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Get Versions Response length is not long enough. Message ignored.");
+										CAN_STACK_LOG_WARNING("[VT]: Get Versions Response length is not long enough. Message ignored.");
 									}
 								}
 								else
 								{
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[VT]: No version label from the VT matched. Client will upload the pool and store it instead.");
+									CAN_STACK_LOG_INFO("[VT]: No version label from the VT matched. Client will upload the pool and store it instead.");
 									parentVT->set_state(StateMachineState::UploadObjectPool);
 								}
 							}
 							else
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Get Versions Response ignored!");
+								CAN_STACK_LOG_WARNING("[VT]: Get Versions Response ignored!");
 							}
 						}
 						break;
@@ -3185,17 +3731,23 @@ namespace isobus
 						{
 							if (StateMachineState::WaitForLoadVersionResponse == parentVT->state)
 							{
-								if (0 == message->get_uint8_at(5))
+								if ((0 == message->get_uint8_at(5)) &&
+								    (parentVT->deltaUploadActive))
+								{
+									CAN_STACK_LOG_INFO("[VT]: Loaded delta base version from VT non-volatile memory. Uploading changed objects.");
+									parentVT->set_state(StateMachineState::UploadObjectPool);
+								}
+								else if (0 == message->get_uint8_at(5))
 								{
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[VT]: Loaded object pool version from VT non-volatile memory with no errors.");
+									CAN_STACK_LOG_INFO("[VT]: Loaded object pool version from VT non-volatile memory with no errors.");
 									parentVT->set_state(StateMachineState::Connected);
 									if (parentVT->send_aux_n_preferred_assignment())
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug, "[AUX-N]: Sent preferred assignments.");
+										CAN_STACK_LOG_DEBUG("[AUX-N]: Sent preferred assignments.");
 									}
 									else
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[AUX-N]: Failed to send preferred assignments.");
+										CAN_STACK_LOG_WARNING("[AUX-N]: Failed to send preferred assignments.");
 									}
 								}
 								else
@@ -3203,25 +3755,26 @@ namespace isobus
 									// At least one error is set
 									if (message->get_bool_at(5, 0))
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Load Versions Response error: File system error or corruption.");
+										CAN_STACK_LOG_WARNING("[VT]: Load Versions Response error: File system error or corruption.");
 									}
 									if (message->get_bool_at(5, 1))
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Load Versions Response error: Insufficient memory.");
+										CAN_STACK_LOG_WARNING("[VT]: Load Versions Response error: Insufficient memory.");
 									}
 									if (message->get_bool_at(5, 2))
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Load Versions Response error: Any other error.");
+										CAN_STACK_LOG_WARNING("[VT]: Load Versions Response error: Any other error.");
 									}
 
 									// Not sure what happened here... should be mostly impossible. Try to upload instead.
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Switching to pool upload instead.");
+									CAN_STACK_LOG_WARNING("[VT]: Switching to pool upload instead.");
+									parentVT->deltaUploadActive = false;
 									parentVT->set_state(StateMachineState::UploadObjectPool);
 								}
 							}
 							else
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Load Versions Response ignored!");
+								CAN_STACK_LOG_WARNING("[VT]: Load Versions Response ignored!");
 							}
 						}
 						break;
@@ -3234,28 +3787,38 @@ namespace isobus
 								{
 									// Stored with no error
 									parentVT->set_state(StateMachineState::Connected);
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[VT]: Stored object pool with no error.");
+									CAN_STACK_LOG_INFO("[VT]: Stored object pool with no error.");
+
+									if (parentVT->deltaUploadActive)
+									{
+										// The new version replaces the delta base, so the VT doesn't need to keep it
+										parentVT->deltaUploadActive = false;
+										if (!parentVT->send_delete_version(get_version_label_buffer(parentVT->deltaBaseVersionLabel)))
+										{
+											CAN_STACK_LOG_WARNING("[VT]: Failed to send the delete version message for label %s", parentVT->deltaBaseVersionLabel.c_str());
+										}
+									}
 								}
 								else
 								{
 									// At least one error is set
 									if (message->get_bool_at(5, 0))
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Store Versions Response error: Version label is not correct.");
+										CAN_STACK_LOG_WARNING("[VT]: Store Versions Response error: Version label is not correct.");
 									}
 									if (message->get_bool_at(5, 1))
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Store Versions Response error: Insufficient memory.");
+										CAN_STACK_LOG_WARNING("[VT]: Store Versions Response error: Insufficient memory.");
 									}
 									if (message->get_bool_at(5, 2))
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Store Versions Response error: Any other error.");
+										CAN_STACK_LOG_WARNING("[VT]: Store Versions Response error: Any other error.");
 									}
 								}
 							}
 							else
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Store Versions Response ignored!");
+								CAN_STACK_LOG_WARNING("[VT]: Store Versions Response ignored!");
 							}
 						}
 						break;
@@ -3264,17 +3827,17 @@ namespace isobus
 						{
 							if (0 == message->get_uint8_at(5))
 							{
-								CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[VT]: Delete Version Response OK!");
+								CAN_STACK_LOG_INFO("[VT]: Delete Version Response OK!");
 							}
 							else
 							{
 								if (message->get_bool_at(5, 1))
 								{
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Delete Version Response error: Version label is not correct, or unknown.");
+									CAN_STACK_LOG_WARNING("[VT]: Delete Version Response error: Version label is not correct, or unknown.");
 								}
 								if (message->get_bool_at(5, 3))
 								{
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Delete Version Response error: Any other error.");
+									CAN_STACK_LOG_WARNING("[VT]: Delete Version Response error: Any other error.");
 								}
 							}
 						}
@@ -3306,24 +3869,24 @@ namespace isobus
 
 									if (parentVT->send_aux_n_preferred_assignment())
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Debug, "[AUX-N]: Sent preferred assignments.");
+										CAN_STACK_LOG_DEBUG("[AUX-N]: Sent preferred assignments.");
 									}
 									else
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[AUX-N]: Failed to send preferred assignments.");
+										CAN_STACK_LOG_WARNING("[AUX-N]: Failed to send preferred assignments.");
 									}
 								}
 								else
 								{
 									parentVT->set_state(StateMachineState::Failed);
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Error in end of object pool message." + std::string("Faulty Object ") + isobus::to_string(static_cast<int>(objectIDOfFaultyObject)) + std::string(" Faulty Object Parent ") + isobus::to_string(static_cast<int>(parentObjectIDOfFaultyObject)) + std::string(" Pool error bitmask value ") + isobus::to_string(static_cast<int>(objectPoolErrorBitmask)));
+									CAN_STACK_LOG_ERROR("[VT]: Error in end of object pool message. Faulty Object %u Faulty Object Parent %u Pool error bitmask value %u", static_cast<unsigned int>(objectIDOfFaultyObject), static_cast<unsigned int>(parentObjectIDOfFaultyObject), static_cast<unsigned int>(objectPoolErrorBitmask));
 									if (vtRanOutOfMemory)
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Ran out of memory");
+										CAN_STACK_LOG_ERROR("[VT]: Ran out of memory");
 									}
 									if (otherErrors)
 									{
-										CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Error, "[VT]: Reported other errors in EOM response");
+										CAN_STACK_LOG_ERROR("[VT]: Reported other errors in EOM response");
 									}
 								}
 							}
@@ -3357,7 +3920,7 @@ namespace isobus
 									AuxiliaryInputDevice inputDevice{ message->get_source_control_function()->get_NAME().get_full_name(), modelIdentificationCode, {} };
 									parentVT->auxiliaryInputDevices.push_back(inputDevice);
 									//! @todo prettier logging of NAME
-									CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Info, "[AUX-N]: New auxiliary input device with name: " + isobus::to_string(inputDevice.name) + " and model identification code: " + std::to_string(modelIdentificationCode));
+									CAN_STACK_LOG_INFO("[AUX-N]: New auxiliary input device with name: %llu and model identification code: %u", static_cast<unsigned long long>(inputDevice.name), static_cast<unsigned int>(modelIdentificationCode));
 								}
 							}
 						}
@@ -3368,14 +3931,17 @@ namespace isobus
 
 				default:
 				{
-					CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: Client unknown message: " + isobus::to_string(static_cast<int>(message->get_identifier().get_parameter_group_number())));
+					CAN_STACK_LOG_WARNING("[VT]: Client unknown message: %u", static_cast<unsigned int>(message->get_identifier().get_parameter_group_number()));
 				}
 				break;
 			}
+
+			// Let the state machine react to the message right away
+			parentVT->wake_worker_thread();
 		}
 		else
 		{
-			CANStackLogger::CAN_stack_log(CANStackLogger::LoggingLevel::Warning, "[VT]: VT-ECU Client message invalid");
+			CAN_STACK_LOG_WARNING("[VT]: VT-ECU Client message invalid");
 		}
 	}
 
@@ -3391,8 +3957,17 @@ namespace isobus
 		    (nullptr != destinationControlFunction))
 		{
 			VirtualTerminalClient *parent = reinterpret_cast<VirtualTerminalClient *>(parentPointer);
+			bool commandTransferFinished = false;
 
-			if (StateMachineState::UploadObjectPool == parent->state)
+			{
+				// A command and the object pool can't be transferred at the same time, so this is one or the other
+				const std::lock_guard<std::mutex> lock(parent->transferMutex);
+				commandTransferFinished = parent->transferInProgress;
+				parent->transferInProgress = false;
+			}
+
+			if ((!commandTransferFinished) &&
+			    (StateMachineState::UploadObjectPool == parent->state))
 			{
 				if (successful)
 				{
@@ -3403,9 +3978,166 @@ namespace isobus
 					parent->currentObjectPoolState = CurrentObjectPoolUploadState::Failed;
 				}
 			}
+			parent->wake_worker_thread();
 		}
 	}
 
+	bool VirtualTerminalClient::process_transfer_chunk(std::uint32_t,
+	                                                   std::uint32_t bytesOffset,
+	                                                   std::uint32_t numberOfBytesNeeded,
+	                                                   std::uint8_t *chunkBuffer,
+	                                                   void *parentPointer)
+	{
+		bool retVal = false;
+
+		if ((nullptr != parentPointer) &&
+		    (nullptr != chunkBuffer))
+		{
+			VirtualTerminalClient *parent = reinterpret_cast<VirtualTerminalClient *>(parentPointer);
+			const std::lock_guard<std::mutex> lock(parent->transferMutex);
+
+			if ((bytesOffset + numberOfBytesNeeded) <= parent->transferBuffer.size())
+			{
+				memcpy(chunkBuffer, &parent->transferBuffer[bytesOffset], numberOfBytesNeeded);
+				retVal = true;
+			}
+		}
+		return retVal;
+	}
+
+	bool VirtualTerminalClient::get_object_pool_scaling_parameters(VirtualTerminalObjectPoolScaleCache::ScalingParameters &parameters) const
+	{
+		bool retVal = false;
+
+		if ((0 != originalDataMaskSize_px) ||
+		    ((0 != originalSoftKeyWidth_px) && (0 != originalSoftKeyHeight_px)))
+		{
+			parameters.originalDataMaskSize_px = originalDataMaskSize_px;
+			parameters.dataMaskSize_px = std::min(xPixels, yPixels);
+			parameters.originalSoftKeyWidth_px = originalSoftKeyWidth_px;
+			parameters.originalSoftKeyHeight_px = originalSoftKeyHeight_px;
+			parameters.softKeyWidth_px = softKeyXAxisPixels;
+			parameters.softKeyHeight_px = softKeyYAxisPixels;
+			parameters.smallFontSizes = smallFontSizesBitfield;
+			parameters.largeFontSizes = largeFontSizesBitfield;
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	void VirtualTerminalClient::prepare_object_pool_scaling(const ObjectPoolDataStruct &pool)
+	{
+		VirtualTerminalObjectPoolScaleCache::ScalingParameters parameters;
+
+		objectPoolScaler.reset();
+
+		if (get_object_pool_scaling_parameters(parameters))
+		{
+			if (pool.useDataCallback)
+			{
+				CAN_STACK_LOG_INFO("[VT]: Object pools uploaded with a data chunk callback are not scaled.");
+			}
+			else
+			{
+				// Other clients serving a VT with the same resolution may have already scaled this pool
+				objectPoolScaler = VirtualTerminalObjectPoolScaleCache::get_scaler(pool.objectPoolDataPointer, pool.objectPoolSize, parameters);
+
+				if (nullptr != objectPoolScaler)
+				{
+					CAN_STACK_LOG_DEBUG("[VT]: Scaling object pool, %u bytes changed.", static_cast<unsigned int>(objectPoolScaler->get_number_patched_bytes()));
+				}
+				else
+				{
+					CAN_STACK_LOG_WARNING("[VT]: Object pool could not be parsed for scaling. Uploading it unscaled.");
+				}
+			}
+		}
+	}
+
+	bool VirtualTerminalClient::get_is_delta_upload_possible() const
+	{
+		// Replacing objects in a loaded pool was added in VT version 4
+		bool retVal = ((!deltaBaseVersionLabel.empty()) &&
+		               (get_vt_version_supported(VTVersion::Version4)) &&
+		               (objectPoolDeltaBases.size() >= objectPools.size()));
+
+		for (std::size_t i = 0; ((retVal) && (i < objectPools.size())); i++)
+		{
+			if ((objectPools[i].useDataCallback) ||
+			    (nullptr == objectPools[i].objectPoolDataPointer) ||
+			    (nullptr == objectPoolDeltaBases[i].objectPoolDataPointer))
+			{
+				retVal = false;
+			}
+		}
+		return retVal;
+	}
+
+	bool VirtualTerminalClient::build_changed_objects(std::uint32_t poolIndex)
+	{
+		VirtualTerminalObjectPoolIndex currentPool;
+		VirtualTerminalObjectPoolIndex basePool;
+		std::shared_ptr<const VirtualTerminalObjectPoolScaler> baseScaler;
+		bool retVal = false;
+
+		changedObjectsBuffer.clear();
+
+		if ((poolIndex < objectPools.size()) &&
+		    (poolIndex < objectPoolDeltaBases.size()) &&
+		    (currentPool.parse(objectPools[poolIndex].objectPoolDataPointer, objectPools[poolIndex].objectPoolSize)) &&
+		    (basePool.parse(objectPoolDeltaBases[poolIndex].objectPoolDataPointer, objectPoolDeltaBases[poolIndex].objectPoolSize)))
+		{
+			const std::uint8_t *currentData = objectPools[poolIndex].objectPoolDataPointer;
+			const std::uint8_t *baseData = objectPoolDeltaBases[poolIndex].objectPoolDataPointer;
+			VirtualTerminalObjectPoolScaleCache::ScalingParameters parameters;
+			std::vector<std::uint8_t> baseObjectBuffer;
+
+			// The VT stored the delta base the way this VT scaled it when it was uploaded
+			retVal = true;
+			if ((nullptr != objectPoolScaler) &&
+			    (get_object_pool_scaling_parameters(parameters)))
+			{
+				baseScaler = VirtualTerminalObjectPoolScaleCache::get_scaler(baseData, objectPoolDeltaBases[poolIndex].objectPoolSize, parameters);
+				retVal = (nullptr != baseScaler);
+			}
+
+			for (std::uint32_t i = 0; ((retVal) && (i < currentPool.get_number_objects())); i++)
+			{
+				const VirtualTerminalObjectPoolIndex::ObjectEntry &object = *currentPool.get_object_by_index(i);
+				const VirtualTerminalObjectPoolIndex::ObjectEntry *baseObject = basePool.get_object(object.objectID);
+				const std::size_t bufferOffset = changedObjectsBuffer.size();
+
+				changedObjectsBuffer.insert(changedObjectsBuffer.end(), &currentData[object.offset], &currentData[object.offset + object.length]);
+				if (nullptr != objectPoolScaler)
+				{
+					objectPoolScaler->apply(object.offset, &changedObjectsBuffer[bufferOffset], object.length);
+				}
+
+				if ((nullptr != baseObject) &&
+				    (baseObject->length == object.length))
+				{
+					baseObjectBuffer.assign(&baseData[baseObject->offset], &baseData[baseObject->offset + baseObject->length]);
+					if (nullptr != baseScaler)
+					{
+						baseScaler->apply(baseObject->offset, baseObjectBuffer.data(), baseObject->length);
+					}
+
+					if (0 == memcmp(&changedObjectsBuffer[bufferOffset], baseObjectBuffer.data(), object.length))
+					{
+						// The VT already has this object as it would be uploaded
+						changedObjectsBuffer.resize(bufferOffset);
+					}
+				}
+			}
+
+			if (!retVal)
+			{
+				changedObjectsBuffer.clear();
+			}
+		}
+		return retVal;
+	}
+
 	bool VirtualTerminalClient::process_internal_object_pool_upload_callback(std::uint32_t callbackIndex,
 	                                                                         std::uint32_t bytesOffset,
 	                                                                         std::uint32_t numberOfBytesNeeded,
@@ -3420,6 +4152,7 @@ namespace isobus
 		{
 			VirtualTerminalClient *parentVTClient = reinterpret_cast<VirtualTerminalClient *>(parentPointer);
 			std::uint32_t poolIndex = std::numeric_limits<std::uint32_t>::max();
+			std::uint32_t uploadSize = 0;
 			bool usingExternalCallback = false;
 
 			// Need to figure out which pool we're currently uploading
@@ -3429,16 +4162,31 @@ namespace isobus
 				{
 					poolIndex = i;
 					usingExternalCallback = parentVTClient->objectPools[i].useDataCallback;
+					uploadSize = parentVTClient->uploadingChangedObjects ? static_cast<std::uint32_t>(parentVTClient->changedObjectsBuffer.size()) : parentVTClient->objectPools[i].objectPoolSize;
 					break;
 				}
 			}
 
 			// If pool index is FFs, something is wrong with the state machine state, return false.
 			if ((std::numeric_limits<std::uint32_t>::max() != poolIndex) &&
-			    (bytesOffset + numberOfBytesNeeded) <= parentVTClient->objectPools[poolIndex].objectPoolSize + 1)
+			    (bytesOffset + numberOfBytesNeeded) <= uploadSize + 1)
 			{
 				// We've got more data to transfer
-				if (usingExternalCallback)
+				if (parentVTClient->uploadingChangedObjects)
+				{
+					// The changed objects were already copied and scaled when the transfer started
+					retVal = true;
+					if (0 == bytesOffset)
+					{
+						chunkBuffer[0] = static_cast<std::uint8_t>(Function::ObjectPoolTransferMessage);
+						memcpy(&chunkBuffer[1], parentVTClient->changedObjectsBuffer.data(), numberOfBytesNeeded - 1);
+					}
+					else
+					{
+						memcpy(chunkBuffer, &parentVTClient->changedObjectsBuffer[bytesOffset - 1], numberOfBytesNeeded);
+					}
+				}
+				else if (usingExternalCallback)
 				{
 					// We're using the user's supplied callback to get a chunk of info
 					if (0 == bytesOffset)
@@ -3460,11 +4208,19 @@ namespace isobus
 					{
 						chunkBuffer[0] = static_cast<std::uint8_t>(Function::ObjectPoolTransferMessage);
 						memcpy(&chunkBuffer[1], &parentVTClient->objectPools[poolIndex].objectPoolDataPointer[bytesOffset], numberOfBytesNeeded - 1);
+						if (nullptr != parentVTClient->objectPoolScaler)
+						{
+							parentVTClient->objectPoolScaler->apply(bytesOffset, &chunkBuffer[1], numberOfBytesNeeded - 1);
+						}
 					}
 					else
 					{
 						// Subtract off 1 to account for the mux in the first byte of the message
 						memcpy(chunkBuffer, &parentVTClient->objectPools[poolIndex].objectPoolDataPointer[bytesOffset - 1], numberOfBytesNeeded);
+						if (nullptr != parentVTClient->objectPoolScaler)
+						{
+							parentVTClient->objectPoolScaler->apply(bytesOffset - 1, chunkBuffer, numberOfBytesNeeded);
+						}
 					}
 				}
 			}
@@ -3481,8 +4237,67 @@ namespace isobus
 				break;
 			}
 			update();
-			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+			// Sleep until a message or Tx completion wakes us up, or until the next timer is due
+			std::unique_lock<std::mutex> lock(workerThreadMutex);
+			workerThreadCondition.wait_for(lock, std::chrono::milliseconds(get_worker_thread_sleep_time_ms()), [this]() { return (workerThreadWakeRequested || shouldTerminate); });
+			workerThreadWakeRequested = false;
 		}
 	}
 
+	void VirtualTerminalClient::wake_worker_thread()
+	{
+		{
+			const std::lock_guard<std::mutex> lock(workerThreadMutex);
+			workerThreadWakeRequested = true;
+		}
+		workerThreadCondition.notify_one();
+	}
+
+	std::uint32_t VirtualTerminalClient::get_worker_thread_sleep_time_ms()
+	{
+		// Caps the sleep so that state machine timeouts measured in seconds are still noticed promptly
+		std::uint32_t retVal = WORKER_THREAD_MAXIMUM_SLEEP_MS;
+		const StateMachineState currentState = state;
+
+		// Only timers the current state acts on count, an expired timer nothing acts on would keep the thread awake
+		if (sendWorkingSetMaintenenace)
+		{
+			retVal = std::min(retVal, get_time_remaining_ms(lastWorkingSetMaintenanceTimestamp_ms, WORKING_SET_MAINTENANCE_TIMEOUT_MS));
+		}
+
+		if ((StateMachineState::ReadyForObjectPool == currentState) ||
+		    (StateMachineState::Connected == currentState))
+		{
+			retVal = std::min(retVal, get_time_remaining_ms(lastVTStatusTimestamp_ms, VT_STATUS_TIMEOUT_MS));
+		}
+
+		if (StateMachineState::Connected == currentState)
+		{
+			const std::lock_guard<std::mutex> lock(commandQueueMutex);
+			for (const InFlightCommand &command : commandsInFlight)
+			{
+				retVal = std::min(retVal, get_time_remaining_ms(command.sentTimestamp_ms, COMMAND_RESPONSE_TIMEOUT_MS));
+			}
+		}
+
+		if (retVal < WORKER_THREAD_MINIMUM_SLEEP_MS)
+		{
+			retVal = WORKER_THREAD_MINIMUM_SLEEP_MS;
+		}
+		return retVal;
+	}
+
+	std::uint32_t VirtualTerminalClient::get_time_remaining_ms(std::uint32_t timestamp_ms, std::uint32_t timeout_ms)
+	{
+		const std::uint32_t elapsedTime_ms = SystemTiming::get_time_elapsed_ms(timestamp_ms);
+		std::uint32_t retVal = 0;
+
+		if (elapsedTime_ms < timeout_ms)
+		{
+			retVal = timeout_ms - elapsedTime_ms;
+		}
+		return retVal;
+	}
+
 } // namespace isobus
@@ -0,0 +1,354 @@
+//================================================================================================
+/// @file isobus_virtual_terminal_graphics_context_batch.cpp
+///
+/// @brief Implements a class that records graphics context commands and sends them as few messages
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#include "isobus/isobus/isobus_virtual_terminal_graphics_context_batch.hpp"
+#include "isobus/isobus/can_constants.hpp"
+
+#include <limits>
+
+namespace isobus
+{
+	VirtualTerminalGraphicsContextBatch::VirtualTerminalGraphicsContextBatch(std::uint16_t graphicsContextObjectID) :
+	  pendingCursorX(0),
+	  pendingCursorY(0),
+	  objectID(graphicsContextObjectID),
+	  cursorPending(false),
+	  pendingCursorIsAbsolute(false)
+	{
+		forget_state();
+		sentState = knownState;
+	}
+
+	std::uint16_t VirtualTerminalGraphicsContextBatch::get_object_id() const
+	{
+		return objectID;
+	}
+
+	void VirtualTerminalGraphicsContextBatch::set_graphics_cursor(std::int16_t xPosition, std::int16_t yPosition)
+	{
+		flush_lines();
+
+		// Setting the position makes any earlier cursor change irrelevant
+		cursorPending = true;
+		pendingCursorIsAbsolute = true;
+		pendingCursorX = xPosition;
+		pendingCursorY = yPosition;
+	}
+
+	void VirtualTerminalGraphicsContextBatch::move_graphics_cursor(std::int16_t xOffset, std::int16_t yOffset)
+	{
+		flush_lines();
+
+		if ((cursorPending) &&
+		    (((pendingCursorX + xOffset) < std::numeric_limits<std::int16_t>::min()) ||
+		     ((pendingCursorX + xOffset) > std::numeric_limits<std::int16_t>::max()) ||
+		     ((pendingCursorY + yOffset) < std::numeric_limits<std::int16_t>::min()) ||
+		     ((pendingCursorY + yOffset) > std::numeric_limits<std::int16_t>::max())))
+		{
+			flush_cursor();
+		}
+
+		if (!cursorPending)
+		{
+			cursorPending = true;
+			pendingCursorIsAbsolute = false;
+			pendingCursorX = 0;
+			pendingCursorY = 0;
+		}
+		pendingCursorX += xOffset;
+		pendingCursorY += yOffset;
+	}
+
+	void VirtualTerminalGraphicsContextBatch::set_foreground_colour(std::uint8_t colour)
+	{
+		set_state(SubCommand::SetForegroundColour, colour, 1);
+	}
+
+	void VirtualTerminalGraphicsContextBatch::set_background_colour(std::uint8_t colour)
+	{
+		set_state(SubCommand::SetBackgroundColour, colour, 1);
+	}
+
+	void VirtualTerminalGraphicsContextBatch::set_line_attributes_object_id(std::uint16_t lineAttributesObjectID)
+	{
+		set_state(SubCommand::SetLineAttributesObjectID, lineAttributesObjectID, 2);
+	}
+
+	void VirtualTerminalGraphicsContextBatch::set_fill_attributes_object_id(std::uint16_t fillAttributesObjectID)
+	{
+		set_state(SubCommand::SetFillAttributesObjectID, fillAttributesObjectID, 2);
+	}
+
+	void VirtualTerminalGraphicsContextBatch::set_font_attributes_object_id(std::uint16_t fontAttributesObjectID)
+	{
+		set_state(SubCommand::SetFontAttributesObjectID, fontAttributesObjectID, 2);
+	}
+
+	void VirtualTerminalGraphicsContextBatch::erase_rectangle(std::uint16_t width, std::uint16_t height)
+	{
+		flush_lines();
+		flush_cursor();
+		add_message(SubCommand::EraseRectangle, width, height);
+	}
+
+	void VirtualTerminalGraphicsContextBatch::draw_point(std::int16_t xOffset, std::int16_t yOffset)
+	{
+		flush_lines();
+		flush_cursor();
+		add_message(SubCommand::DrawPoint, static_cast<std::uint16_t>(xOffset), static_cast<std::uint16_t>(yOffset));
+	}
+
+	void VirtualTerminalGraphicsContextBatch::draw_line(std::int16_t xOffset, std::int16_t yOffset)
+	{
+		LinePoint newPoint = { xOffset, yOffset };
+
+		flush_cursor();
+
+		if (!pendingLines.empty())
+		{
+			newPoint.x += pendingLines.back().x;
+			newPoint.y += pendingLines.back().y;
+
+			// Polygon points are relative to where the run started, so they have to fit in 16 bits
+			if ((MAXIMUM_POLYGON_POINTS == pendingLines.size()) ||
+			    (newPoint.x < std::numeric_limits<std::int16_t>::min()) ||
+			    (newPoint.x > std::numeric_limits<std::int16_t>::max()) ||
+			    (newPoint.y < std::numeric_limits<std::int16_t>::min()) ||
+			    (newPoint.y > std::numeric_limits<std::int16_t>::max()))
+			{
+				flush_lines();
+				newPoint = { xOffset, yOffset };
+			}
+		}
+		pendingLines.push_back(newPoint);
+	}
+
+	void VirtualTerminalGraphicsContextBatch::draw_rectangle(std::uint16_t width, std::uint16_t height)
+	{
+		flush_lines();
+		flush_cursor();
+		add_message(SubCommand::DrawRectangle, width, height);
+	}
+
+	void VirtualTerminalGraphicsContextBatch::draw_closed_ellipse(std::uint16_t width, std::uint16_t height)
+	{
+		flush_lines();
+		flush_cursor();
+		add_message(SubCommand::DrawClosedEllipse, width, height);
+	}
+
+	void VirtualTerminalGraphicsContextBatch::draw_polygon(std::uint8_t numberOfPoints, const std::int16_t *listOfXOffsetsRelativeToCursor, const std::int16_t *listOfYOffsetsRelativeToCursor)
+	{
+		if ((numberOfPoints > 0) &&
+		    (nullptr != listOfXOffsetsRelativeToCursor) &&
+		    (nullptr != listOfYOffsetsRelativeToCursor))
+		{
+			flush_lines();
+			flush_cursor();
+
+			std::vector<std::uint8_t> &message = start_message(SubCommand::DrawPolygon);
+			message.push_back(numberOfPoints);
+			for (std::uint8_t i = 0; i < numberOfPoints; i++)
+			{
+				message.push_back(static_cast<std::uint8_t>(listOfXOffsetsRelativeToCursor[i] & 0xFF));
+				message.push_back(static_cast<std::uint8_t>((listOfXOffsetsRelativeToCursor[i] >> 8) & 0xFF));
+				message.push_back(static_cast<std::uint8_t>(listOfYOffsetsRelativeToCursor[i] & 0xFF));
+				message.push_back(static_cast<std::uint8_t>((listOfYOffsetsRelativeToCursor[i] >> 8) & 0xFF));
+			}
+			finish_message();
+		}
+	}
+
+	void VirtualTerminalGraphicsContextBatch::draw_text(bool transparent, const std::string &value)
+	{
+		if ((!value.empty()) &&
+		    (value.size() <= std::numeric_limits<std::uint8_t>::max()))
+		{
+			flush_lines();
+			flush_cursor();
+
+			std::vector<std::uint8_t> &message = start_message(SubCommand::DrawText);
+			message.push_back(static_cast<std::uint8_t>(transparent));
+			message.push_back(static_cast<std::uint8_t>(value.size()));
+			message.insert(message.end(), value.begin(), value.end());
+			finish_message();
+		}
+	}
+
+	void VirtualTerminalGraphicsContextBatch::draw_vt_object(std::uint16_t vtObjectID)
+	{
+		flush_lines();
+		flush_cursor();
+
+		std::vector<std::uint8_t> &message = start_message(SubCommand::DrawVTObject);
+		message.push_back(static_cast<std::uint8_t>(vtObjectID & 0xFF));
+		message.push_back(static_cast<std::uint8_t>(vtObjectID >> 8));
+		finish_message();
+	}
+
+	void VirtualTerminalGraphicsContextBatch::forget_state()
+	{
+		for (auto &state : knownState)
+		{
+			state.value = 0;
+			state.known = false;
+		}
+	}
+
+	void VirtualTerminalGraphicsContextBatch::resend_state()
+	{
+		std::vector<std::vector<std::uint8_t>> recordedMessages;
+
+		recordedMessages.swap(messages);
+		for (std::uint8_t i = 0; i < sentState.size(); i++)
+		{
+			if (sentState[i].known)
+			{
+				const SubCommand command = static_cast<SubCommand>(static_cast<std::uint8_t>(SubCommand::SetForegroundColour) + i);
+				std::vector<std::uint8_t> &message = start_message(command);
+
+				message.push_back(static_cast<std::uint8_t>(sentState[i].value & 0xFF));
+				if ((SubCommand::SetForegroundColour != command) &&
+				    (SubCommand::SetBackgroundColour != command))
+				{
+					message.push_back(static_cast<std::uint8_t>(sentState[i].value >> 8));
+				}
+				finish_message();
+			}
+		}
+
+		for (auto &message : recordedMessages)
+		{
+			messages.push_back(std::move(message));
+		}
+	}
+
+	std::vector<std::vector<std::uint8_t>> VirtualTerminalGraphicsContextBatch::take_messages()
+	{
+		std::vector<std::vector<std::uint8_t>> retVal;
+
+		flush_lines();
+		flush_cursor();
+		retVal.swap(messages);
+		sentState = knownState;
+		return retVal;
+	}
+
+	void VirtualTerminalGraphicsContextBatch::set_state(SubCommand command, std::uint16_t value, std::uint8_t numberOfBytes)
+	{
+		KnownState &state = knownState[static_cast<std::uint8_t>(command) - static_cast<std::uint8_t>(SubCommand::SetForegroundColour)];
+
+		if ((!state.known) ||
+		    (value != state.value))
+		{
+			// Lines already recorded must be drawn with the old value. The cursor isn't affected, so a pending move can wait.
+			flush_lines();
+
+			std::vector<std::uint8_t> &message = start_message(command);
+			message.push_back(static_cast<std::uint8_t>(value & 0xFF));
+			if (2 == numberOfBytes)
+			{
+				message.push_back(static_cast<std::uint8_t>(value >> 8));
+			}
+			finish_message();
+
+			state.value = value;
+			state.known = true;
+		}
+	}
+
+	void VirtualTerminalGraphicsContextBatch::flush_cursor()
+	{
+		if (cursorPending)
+		{
+			cursorPending = false;
+
+			// A move that adds up to nothing doesn't need to be sent
+			if ((pendingCursorIsAbsolute) ||
+			    (0 != pendingCursorX) ||
+			    (0 != pendingCursorY))
+			{
+				add_message(pendingCursorIsAbsolute ? SubCommand::SetGraphicsCursor : SubCommand::MoveGraphicsCursor,
+				            static_cast<std::uint16_t>(pendingCursorX),
+				            static_cast<std::uint16_t>(pendingCursorY));
+			}
+		}
+	}
+
+	void VirtualTerminalGraphicsContextBatch::flush_lines()
+	{
+		if (!pendingLines.empty())
+		{
+			std::size_t numberOfPolygonPoints = pendingLines.size();
+			std::size_t firstSeparateLine = 0;
+
+			// A polygon that ends where it started is closed, and would be filled, so the last line is sent on its own
+			if ((0 == pendingLines.back().x) &&
+			    (0 == pendingLines.back().y))
+			{
+				numberOfPolygonPoints--;
+			}
+
+			if (numberOfPolygonPoints >= MINIMUM_POLYGON_LINES)
+			{
+				std::vector<std::uint8_t> &message = start_message(SubCommand::DrawPolygon);
+				message.push_back(static_cast<std::uint8_t>(numberOfPolygonPoints));
+				for (std::size_t i = 0; i < numberOfPolygonPoints; i++)
+				{
+					message.push_back(static_cast<std::uint8_t>(pendingLines[i].x & 0xFF));
+					message.push_back(static_cast<std::uint8_t>((pendingLines[i].x >> 8) & 0xFF));
+					message.push_back(static_cast<std::uint8_t>(pendingLines[i].y & 0xFF));
+					message.push_back(static_cast<std::uint8_t>((pendingLines[i].y >> 8) & 0xFF));
+				}
+				finish_message();
+				firstSeparateLine = numberOfPolygonPoints;
+			}
+
+			for (std::size_t i = firstSeparateLine; i < pendingLines.size(); i++)
+			{
+				const LinePoint previousPoint = (0 == i) ? LinePoint{ 0, 0 } : pendingLines[i - 1];
+
+				add_message(SubCommand::DrawLine,
+				            static_cast<std::uint16_t>(pendingLines[i].x - previousPoint.x),
+				            static_cast<std::uint16_t>(pendingLines[i].y - previousPoint.y));
+			}
+			pendingLines.clear();
+		}
+	}
+
+	void VirtualTerminalGraphicsContextBatch::add_message(SubCommand command, std::uint16_t firstValue, std::uint16_t secondValue)
+	{
+		std::vector<std::uint8_t> &message = start_message(command);
+
+		message.push_back(static_cast<std::uint8_t>(firstValue & 0xFF));
+		message.push_back(static_cast<std::uint8_t>(firstValue >> 8));
+		message.push_back(static_cast<std::uint8_t>(secondValue & 0xFF));
+		message.push_back(static_cast<std::uint8_t>(secondValue >> 8));
+	}
+
+	std::vector<std::uint8_t> &VirtualTerminalGraphicsContextBatch::start_message(SubCommand command)
+	{
+		messages.push_back({ GRAPHICS_CONTEXT_COMMAND,
+		                     static_cast<std::uint8_t>(objectID & 0xFF),
+		                     static_cast<std::uint8_t>(objectID >> 8),
+		                     static_cast<std::uint8_t>(command) });
+		return messages.back();
+	}
+
+	void VirtualTerminalGraphicsContextBatch::finish_message()
+	{
+		std::vector<std::uint8_t> &message = messages.back();
+
+		while (message.size() < CAN_DATA_LENGTH)
+		{
+			message.push_back(0xFF);
+		}
+	}
+
+} // namespace isobus
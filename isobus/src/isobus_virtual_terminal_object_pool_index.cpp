@@ -0,0 +1,839 @@
+//================================================================================================
+/// @file isobus_virtual_terminal_object_pool_index.cpp
+///
+/// @brief Implements an index of the objects inside an ISO11783-6 object pool
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_index.hpp"
+
+#include <algorithm>
+
+namespace isobus
+{
+	/// @brief Reads a little endian 16 bit value from the pool
+	static std::uint32_t read_uint16(const std::uint8_t *data)
+	{
+		return static_cast<std::uint32_t>(data[0]) | (static_cast<std::uint32_t>(data[1]) << 8);
+	}
+
+	/// @brief Reads a little endian 32 bit value from the pool
+	static std::uint64_t read_uint32(const std::uint8_t *data)
+	{
+		return static_cast<std::uint64_t>(read_uint16(data)) | (static_cast<std::uint64_t>(read_uint16(&data[2])) << 16);
+	}
+
+	constexpr std::uint16_t VirtualTerminalObjectPoolIndex::NULL_OBJECT_ID;
+
+	VirtualTerminalObjectPoolIndex::VirtualTerminalObjectPoolIndex() :
+	  parseErrorOffset(0)
+	{
+	}
+
+	bool VirtualTerminalObjectPoolIndex::parse(const std::uint8_t *pool, std::uint32_t size)
+	{
+		constexpr std::uint32_t OBJECT_HEADER_LENGTH = 3; // Object ID and type
+		bool retVal = (nullptr != pool);
+		std::uint32_t offset = 0;
+
+		clear();
+
+		while ((retVal) && (offset < size))
+		{
+			ObjectEntry entry;
+			entry.offset = offset;
+			entry.firstChildIndex = static_cast<std::uint32_t>(childObjectIDs.size());
+			entry.numberOfChildren = 0;
+
+			if ((size - offset) >= OBJECT_HEADER_LENGTH)
+			{
+				entry.objectID = static_cast<std::uint16_t>(read_uint16(&pool[offset]));
+				retVal = parse_object(&pool[offset], size - offset, entry);
+			}
+			else
+			{
+				retVal = false;
+			}
+
+			if (retVal)
+			{
+				objects.push_back(entry);
+				offset += entry.length;
+			}
+		}
+
+		if (retVal)
+		{
+			retVal = build_lookups();
+		}
+
+		if (!retVal)
+		{
+			clear();
+			parseErrorOffset = offset;
+		}
+		return retVal;
+	}
+
+	bool VirtualTerminalObjectPoolIndex::parse(const std::vector<std::uint8_t> &pool)
+	{
+		return parse(pool.data(), static_cast<std::uint32_t>(pool.size()));
+	}
+
+	void VirtualTerminalObjectPoolIndex::clear()
+	{
+		objects.clear();
+		objectIDLookup.clear();
+		childObjectIDs.clear();
+		firstParentIndex.clear();
+		parentObjectIDs.clear();
+		parseErrorOffset = 0;
+	}
+
+	std::uint32_t VirtualTerminalObjectPoolIndex::get_parse_error_offset() const
+	{
+		return parseErrorOffset;
+	}
+
+	std::uint32_t VirtualTerminalObjectPoolIndex::get_number_objects() const
+	{
+		return static_cast<std::uint32_t>(objects.size());
+	}
+
+	const VirtualTerminalObjectPoolIndex::ObjectEntry *VirtualTerminalObjectPoolIndex::get_object_by_index(std::uint32_t index) const
+	{
+		const ObjectEntry *retVal = nullptr;
+
+		if (index < objects.size())
+		{
+			retVal = &objects[index];
+		}
+		return retVal;
+	}
+
+	const VirtualTerminalObjectPoolIndex::ObjectEntry *VirtualTerminalObjectPoolIndex::get_object(std::uint16_t objectID) const
+	{
+		return get_object_by_index(get_object_index(objectID));
+	}
+
+	std::uint32_t VirtualTerminalObjectPoolIndex::get_object_index(std::uint16_t objectID) const
+	{
+		std::uint32_t retVal = static_cast<std::uint32_t>(objects.size());
+		auto lookup = std::lower_bound(objectIDLookup.begin(), objectIDLookup.end(), objectID, [](const ObjectIDLookup &entry, std::uint16_t value) { return entry.objectID < value; });
+
+		if ((objectIDLookup.end() != lookup) &&
+		    (objectID == lookup->objectID))
+		{
+			retVal = lookup->index;
+		}
+		return retVal;
+	}
+
+	std::uint16_t VirtualTerminalObjectPoolIndex::get_child_object_id(const ObjectEntry &object, std::uint16_t childIndex) const
+	{
+		std::uint16_t retVal = NULL_OBJECT_ID;
+
+		if (childIndex < object.numberOfChildren)
+		{
+			retVal = childObjectIDs[object.firstChildIndex + childIndex];
+		}
+		return retVal;
+	}
+
+	std::uint16_t VirtualTerminalObjectPoolIndex::get_number_parents(std::uint16_t objectID) const
+	{
+		const std::uint32_t index = get_object_index(objectID);
+		std::uint16_t retVal = 0;
+
+		if (index < objects.size())
+		{
+			retVal = static_cast<std::uint16_t>(firstParentIndex[index + 1] - firstParentIndex[index]);
+		}
+		return retVal;
+	}
+
+	std::uint16_t VirtualTerminalObjectPoolIndex::get_parent_object_id(std::uint16_t objectID, std::uint16_t parentIndex) const
+	{
+		const std::uint32_t index = get_object_index(objectID);
+		std::uint16_t retVal = NULL_OBJECT_ID;
+
+		if ((index < objects.size()) &&
+		    (parentIndex < (firstParentIndex[index + 1] - firstParentIndex[index])))
+		{
+			retVal = parentObjectIDs[firstParentIndex[index] + parentIndex];
+		}
+		return retVal;
+	}
+
+	bool VirtualTerminalObjectPoolIndex::get_numeric_value(const std::uint8_t *pool, const ObjectEntry &object, std::uint32_t &value)
+	{
+		const std::uint8_t *objectData = &pool[object.offset];
+		std::uint32_t valueOffset = 0;
+		std::uint8_t valueSize = 0;
+		bool retVal = false;
+
+		// The offsets of the variable reference and the value that follows it
+		switch (object.type)
+		{
+			case ObjectType::NumberVariable:
+			{
+				value = static_cast<std::uint32_t>(read_uint32(&objectData[3]));
+				retVal = true;
+			}
+			break;
+
+			case ObjectType::InputBoolean:
+			{
+				valueOffset = 10;
+				valueSize = 1;
+			}
+			break;
+
+			case ObjectType::InputNumber:
+			case ObjectType::OutputNumber:
+			{
+				valueOffset = 13;
+				valueSize = 4;
+			}
+			break;
+
+			case ObjectType::InputList:
+			case ObjectType::OutputList:
+			{
+				valueOffset = 9;
+				valueSize = 1;
+			}
+			break;
+
+			case ObjectType::OutputMeter:
+			{
+				valueOffset = 18;
+				valueSize = 2;
+			}
+			break;
+
+			case ObjectType::OutputLinearBarGraph:
+			{
+				valueOffset = 17;
+				valueSize = 2;
+			}
+			break;
+
+			case ObjectType::OutputArchedBarGraph:
+			{
+				valueOffset = 20;
+				valueSize = 2;
+			}
+			break;
+
+			default:
+			{
+				// This object has no numeric value
+			}
+			break;
+		}
+
+		if ((0 != valueSize) &&
+		    (NULL_OBJECT_ID == read_uint16(&objectData[valueOffset - 2])))
+		{
+			if (1 == valueSize)
+			{
+				value = objectData[valueOffset];
+			}
+			else if (2 == valueSize)
+			{
+				value = read_uint16(&objectData[valueOffset]);
+			}
+			else
+			{
+				value = static_cast<std::uint32_t>(read_uint32(&objectData[valueOffset]));
+			}
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	bool VirtualTerminalObjectPoolIndex::get_string_value(const std::uint8_t *pool, const ObjectEntry &object, std::string &value)
+	{
+		const std::uint8_t *objectData = &pool[object.offset];
+		bool retVal = false;
+
+		switch (object.type)
+		{
+			case ObjectType::StringVariable:
+			{
+				value.assign(&objectData[5], &objectData[5] + read_uint16(&objectData[3]));
+				retVal = true;
+			}
+			break;
+
+			case ObjectType::InputString:
+			{
+				// Unlike the other string objects, the length is a single byte
+				if (NULL_OBJECT_ID == read_uint16(&objectData[13]))
+				{
+					value.assign(&objectData[17], &objectData[17] + objectData[16]);
+					retVal = true;
+				}
+			}
+			break;
+
+			case ObjectType::OutputString:
+			{
+				if (NULL_OBJECT_ID == read_uint16(&objectData[11]))
+				{
+					value.assign(&objectData[16], &objectData[16] + read_uint16(&objectData[14]));
+					retVal = true;
+				}
+			}
+			break;
+
+			default:
+			{
+				// This object has no string value
+			}
+			break;
+		}
+		return retVal;
+	}
+
+	bool VirtualTerminalObjectPoolIndex::parse_object(const std::uint8_t *object, std::uint32_t bytesRemaining, ObjectEntry &entry)
+	{
+		constexpr std::uint32_t MACRO_REFERENCE_SIZE = 2; // Event ID and macro ID
+		constexpr std::uint32_t OBJECT_REFERENCE_SIZE = 2; // Object ID
+		constexpr std::uint32_t POSITIONED_OBJECT_REFERENCE_SIZE = 6; // Object ID, X, and Y
+		std::uint64_t length = 0; // Stays 0 if the object's counts don't fit in the pool
+		std::uint32_t childListOffset = 0;
+		std::uint32_t numberOfChildEntries = 0;
+		std::uint32_t childEntrySize = OBJECT_REFERENCE_SIZE;
+		std::uint32_t secondChildListOffset = 0;
+		std::uint32_t numberOfSecondChildEntries = 0;
+		bool retVal = false;
+
+		entry.type = static_cast<ObjectType>(object[2]);
+
+		switch (entry.type)
+		{
+			case ObjectType::WorkingSet:
+			{
+				if (bytesRemaining >= 10)
+				{
+					length = 10 + (POSITIONED_OBJECT_REFERENCE_SIZE * object[7]) + (MACRO_REFERENCE_SIZE * object[8]) + (2 * object[9]);
+					childListOffset = 10;
+					numberOfChildEntries = object[7];
+					childEntrySize = POSITIONED_OBJECT_REFERENCE_SIZE;
+				}
+			}
+			break;
+
+			case ObjectType::DataMask:
+			{
+				if (bytesRemaining >= 8)
+				{
+					length = 8 + (POSITIONED_OBJECT_REFERENCE_SIZE * object[6]) + (MACRO_REFERENCE_SIZE * object[7]);
+					childListOffset = 8;
+					numberOfChildEntries = object[6];
+					childEntrySize = POSITIONED_OBJECT_REFERENCE_SIZE;
+				}
+			}
+			break;
+
+			case ObjectType::AlarmMask:
+			case ObjectType::Container:
+			{
+				if (bytesRemaining >= 10)
+				{
+					length = 10 + (POSITIONED_OBJECT_REFERENCE_SIZE * object[8]) + (MACRO_REFERENCE_SIZE * object[9]);
+					childListOffset = 10;
+					numberOfChildEntries = object[8];
+					childEntrySize = POSITIONED_OBJECT_REFERENCE_SIZE;
+				}
+			}
+			break;
+
+			case ObjectType::SoftKeyMask:
+			{
+				if (bytesRemaining >= 6)
+				{
+					length = 6 + (OBJECT_REFERENCE_SIZE * object[4]) + (MACRO_REFERENCE_SIZE * object[5]);
+					childListOffset = 6;
+					numberOfChildEntries = object[4];
+				}
+			}
+			break;
+
+			case ObjectType::Key:
+			{
+				if (bytesRemaining >= 7)
+				{
+					length = 7 + (POSITIONED_OBJECT_REFERENCE_SIZE * object[5]) + (MACRO_REFERENCE_SIZE * object[6]);
+					childListOffset = 7;
+					numberOfChildEntries = object[5];
+					childEntrySize = POSITIONED_OBJECT_REFERENCE_SIZE;
+				}
+			}
+			break;
+
+			case ObjectType::Button:
+			{
+				if (bytesRemaining >= 13)
+				{
+					length = 13 + (POSITIONED_OBJECT_REFERENCE_SIZE * object[11]) + (MACRO_REFERENCE_SIZE * object[12]);
+					childListOffset = 13;
+					numberOfChildEntries = object[11];
+					childEntrySize = POSITIONED_OBJECT_REFERENCE_SIZE;
+				}
+			}
+			break;
+
+			case ObjectType::InputString:
+			{
+				// The value's length comes before the value, then the enabled flag and number of macros follow it
+				if ((bytesRemaining >= 17) &&
+				    (bytesRemaining >= (19 + static_cast<std::uint32_t>(object[16]))))
+				{
+					length = 19 + object[16] + (MACRO_REFERENCE_SIZE * object[18 + object[16]]);
+				}
+			}
+			break;
+
+			case ObjectType::InputList:
+			{
+				if (bytesRemaining >= 13)
+				{
+					length = 13 + (OBJECT_REFERENCE_SIZE * object[10]) + (MACRO_REFERENCE_SIZE * object[12]);
+					childListOffset = 13;
+					numberOfChildEntries = object[10];
+				}
+			}
+			break;
+
+			case ObjectType::OutputString:
+			{
+				if ((bytesRemaining >= 16) &&
+				    (bytesRemaining >= (17 + read_uint16(&object[14]))))
+				{
+					length = 17 + read_uint16(&object[14]) + (MACRO_REFERENCE_SIZE * object[16 + read_uint16(&object[14])]);
+				}
+			}
+			break;
+
+			case ObjectType::InputBoolean:
+			case ObjectType::InputNumber:
+			case ObjectType::OutputNumber:
+			case ObjectType::OutputLine:
+			case ObjectType::OutputRectangle:
+			case ObjectType::OutputEllipse:
+			case ObjectType::OutputMeter:
+			case ObjectType::OutputLinearBarGraph:
+			case ObjectType::OutputArchedBarGraph:
+			case ObjectType::FontAttributes:
+			case ObjectType::LineAttributes:
+			case ObjectType::FillAttributes:
+			case ObjectType::ScaledGraphic:
+			{
+				// These have a fixed size, with the number of macros as their last fixed byte
+				std::uint32_t fixedLength = 0;
+
+				switch (entry.type)
+				{
+					case ObjectType::InputBoolean:
+					case ObjectType::OutputRectangle:
+					{
+						fixedLength = 13;
+					}
+					break;
+
+					case ObjectType::InputNumber:
+					{
+						fixedLength = 38;
+					}
+					break;
+
+					case ObjectType::OutputNumber:
+					{
+						fixedLength = 29;
+					}
+					break;
+
+					case ObjectType::OutputLine:
+					{
+						fixedLength = 11;
+					}
+					break;
+
+					case ObjectType::OutputEllipse:
+					{
+						fixedLength = 15;
+					}
+					break;
+
+					case ObjectType::OutputMeter:
+					{
+						fixedLength = 21;
+					}
+					break;
+
+					case ObjectType::OutputLinearBarGraph:
+					{
+						fixedLength = 24;
+					}
+					break;
+
+					case ObjectType::OutputArchedBarGraph:
+					{
+						fixedLength = 27;
+					}
+					break;
+
+					case ObjectType::ScaledGraphic:
+					{
+						fixedLength = 12;
+					}
+					break;
+
+					default:
+					{
+						fixedLength = 8; // Font, line, and fill attributes
+					}
+					break;
+				}
+
+				if (bytesRemaining >= fixedLength)
+				{
+					length = fixedLength + (MACRO_REFERENCE_SIZE * object[fixedLength - 1]);
+				}
+			}
+			break;
+
+			case ObjectType::OutputPolygon:
+			{
+				constexpr std::uint32_t POINT_SIZE = 4;
+
+				if (bytesRemaining >= 14)
+				{
+					length = 14 + (POINT_SIZE * object[12]) + (MACRO_REFERENCE_SIZE * object[13]);
+				}
+			}
+			break;
+
+			case ObjectType::PictureGraphic:
+			{
+				if (bytesRemaining >= 17)
+				{
+					length = 17 + read_uint32(&object[12]) + (MACRO_REFERENCE_SIZE * object[16]);
+				}
+			}
+			break;
+
+			case ObjectType::NumberVariable:
+			{
+				length = 7;
+			}
+			break;
+
+			case ObjectType::StringVariable:
+			case ObjectType::Macro:
+			case ObjectType::ColourMap:
+			{
+				if (bytesRemaining >= 5)
+				{
+					length = 5 + read_uint16(&object[3]);
+				}
+			}
+			break;
+
+			case ObjectType::InputAttributes:
+			{
+				if ((bytesRemaining >= 5) &&
+				    (bytesRemaining >= (6 + static_cast<std::uint32_t>(object[4]))))
+				{
+					length = 6 + object[4] + (MACRO_REFERENCE_SIZE * object[5 + object[4]]);
+				}
+			}
+			break;
+
+			case ObjectType::ObjectPointer:
+			{
+				length = 5;
+				childListOffset = 3;
+				numberOfChildEntries = 1;
+			}
+			break;
+
+			case ObjectType::AuxiliaryFunctionType1:
+			case ObjectType::AuxiliaryFunctionType2:
+			case ObjectType::AuxiliaryInputType2:
+			{
+				if (bytesRemaining >= 6)
+				{
+					length = 6 + (POSITIONED_OBJECT_REFERENCE_SIZE * object[5]);
+					childListOffset = 6;
+					numberOfChildEntries = object[5];
+					childEntrySize = POSITIONED_OBJECT_REFERENCE_SIZE;
+				}
+			}
+			break;
+
+			case ObjectType::AuxiliaryInputType1:
+			{
+				if (bytesRemaining >= 7)
+				{
+					length = 7 + (POSITIONED_OBJECT_REFERENCE_SIZE * object[6]);
+					childListOffset = 7;
+					numberOfChildEntries = object[6];
+					childEntrySize = POSITIONED_OBJECT_REFERENCE_SIZE;
+				}
+			}
+			break;
+
+			case ObjectType::AuxiliaryControlDesignatorType2:
+			{
+				length = 6;
+			}
+			break;
+
+			case ObjectType::WindowMask:
+			{
+				// Window masks have a list of object references followed by a list of positioned objects
+				if (bytesRemaining >= 17)
+				{
+					length = 17 + (OBJECT_REFERENCE_SIZE * object[14]) + (POSITIONED_OBJECT_REFERENCE_SIZE * object[15]) + (MACRO_REFERENCE_SIZE * object[16]);
+					childListOffset = 17;
+					numberOfChildEntries = object[14];
+					secondChildListOffset = 17 + (OBJECT_REFERENCE_SIZE * object[14]);
+					numberOfSecondChildEntries = object[15];
+				}
+			}
+			break;
+
+			case ObjectType::KeyGroup:
+			{
+				if (bytesRemaining >= 10)
+				{
+					length = 10 + (OBJECT_REFERENCE_SIZE * object[8]) + (MACRO_REFERENCE_SIZE * object[9]);
+					childListOffset = 10;
+					numberOfChildEntries = object[8];
+				}
+			}
+			break;
+
+			case ObjectType::GraphicsContext:
+			{
+				length = 34;
+			}
+			break;
+
+			case ObjectType::OutputList:
+			{
+				if (bytesRemaining >= 12)
+				{
+					length = 12 + (OBJECT_REFERENCE_SIZE * object[10]) + (MACRO_REFERENCE_SIZE * object[11]);
+					childListOffset = 12;
+					numberOfChildEntries = object[10];
+				}
+			}
+			break;
+
+			case ObjectType::ExtendedInputAttributes:
+			{
+				// Each code plane lists its own number of character ranges, so walk them
+				constexpr std::uint32_t CHARACTER_RANGE_SIZE = 4;
+
+				if (bytesRemaining >= 5)
+				{
+					std::uint32_t codePlaneOffset = 5;
+					bool codePlanesFit = true;
+
+					for (std::uint32_t i = 0; (i < object[4]) && (codePlanesFit); i++)
+					{
+						codePlanesFit = (bytesRemaining >= (codePlaneOffset + 2));
+
+						if (codePlanesFit)
+						{
+							codePlaneOffset += 2 + (CHARACTER_RANGE_SIZE * object[codePlaneOffset + 1]);
+						}
+					}
+
+					if (codePlanesFit)
+					{
+						length = codePlaneOffset;
+					}
+				}
+			}
+			break;
+
+			case ObjectType::ObjectLabelReferenceList:
+			{
+				constexpr std::uint32_t OBJECT_LABEL_SIZE = 7; // Labelled object ID, string variable ID, font type, and graphic object ID
+
+				if (bytesRemaining >= 5)
+				{
+					length = 5 + (OBJECT_LABEL_SIZE * read_uint16(&object[3]));
+				}
+			}
+			break;
+
+			case ObjectType::ExternalObjectDefinition:
+			{
+				if (bytesRemaining >= 13)
+				{
+					length = 13 + (OBJECT_REFERENCE_SIZE * object[12]);
+					childListOffset = 13;
+					numberOfChildEntries = object[12];
+				}
+			}
+			break;
+
+			case ObjectType::ExternalReferenceNAME:
+			{
+				length = 12;
+			}
+			break;
+
+			case ObjectType::ExternalObjectPointer:
+			{
+				length = 9;
+			}
+			break;
+
+			case ObjectType::Animation:
+			{
+				if (bytesRemaining >= 17)
+				{
+					length = 17 + (POSITIONED_OBJECT_REFERENCE_SIZE * object[15]) + (MACRO_REFERENCE_SIZE * object[16]);
+					childListOffset = 17;
+					numberOfChildEntries = object[15];
+					childEntrySize = POSITIONED_OBJECT_REFERENCE_SIZE;
+				}
+			}
+			break;
+
+			case ObjectType::ColourPalette:
+			{
+				constexpr std::uint32_t COLOUR_SIZE = 4;
+
+				if (bytesRemaining >= 7)
+				{
+					length = 7 + (COLOUR_SIZE * read_uint16(&object[5]));
+				}
+			}
+			break;
+
+			case ObjectType::GraphicData:
+			{
+				if (bytesRemaining >= 8)
+				{
+					length = 8 + read_uint32(&object[4]);
+				}
+			}
+			break;
+
+			case ObjectType::WorkingSetSpecialControls:
+			{
+				constexpr std::uint32_t LANGUAGE_PAIR_SIZE = 4;
+
+				if (bytesRemaining >= 8)
+				{
+					length = 8 + (LANGUAGE_PAIR_SIZE * object[7]);
+				}
+			}
+			break;
+
+			default:
+			{
+				// Unknown object type, we can't know how long it is
+			}
+			break;
+		}
+
+		if ((0 != length) &&
+		    (length <= bytesRemaining))
+		{
+			entry.length = static_cast<std::uint32_t>(length);
+			add_children(&object[childListOffset], numberOfChildEntries, childEntrySize, entry);
+
+			if (0 != numberOfSecondChildEntries)
+			{
+				add_children(&object[secondChildListOffset], numberOfSecondChildEntries, POSITIONED_OBJECT_REFERENCE_SIZE, entry);
+			}
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	void VirtualTerminalObjectPoolIndex::add_children(const std::uint8_t *list, std::uint32_t numberOfEntries, std::uint32_t entrySize, ObjectEntry &entry)
+	{
+		for (std::uint32_t i = 0; i < numberOfEntries; i++)
+		{
+			const std::uint16_t childObjectID = static_cast<std::uint16_t>(read_uint16(&list[i * entrySize]));
+
+			// Lists are allowed to have empty entries
+			if (NULL_OBJECT_ID != childObjectID)
+			{
+				childObjectIDs.push_back(childObjectID);
+				entry.numberOfChildren++;
+			}
+		}
+	}
+
+	bool VirtualTerminalObjectPoolIndex::build_lookups()
+	{
+		bool retVal = true;
+
+		objectIDLookup.resize(objects.size());
+		for (std::uint32_t i = 0; i < objects.size(); i++)
+		{
+			objectIDLookup[i] = { objects[i].objectID, i };
+		}
+		std::sort(objectIDLookup.begin(), objectIDLookup.end(), [](const ObjectIDLookup &first, const ObjectIDLookup &second) { return first.objectID < second.objectID; });
+
+		for (std::uint32_t i = 1; (i < objectIDLookup.size()) && (retVal); i++)
+		{
+			if (objectIDLookup[i - 1].objectID == objectIDLookup[i].objectID)
+			{
+				retVal = false;
+			}
+		}
+
+		if (retVal)
+		{
+			// Count each object's parents, then fill in the parent ranges in a second walk over the children
+			std::vector<std::uint32_t> childObjectIndexes(childObjectIDs.size());
+			firstParentIndex.assign(objects.size() + 1, 0);
+
+			for (std::uint32_t i = 0; i < childObjectIDs.size(); i++)
+			{
+				childObjectIndexes[i] = get_object_index(childObjectIDs[i]);
+
+				if (childObjectIndexes[i] < objects.size())
+				{
+					firstParentIndex[childObjectIndexes[i] + 1]++;
+				}
+			}
+
+			for (std::uint32_t i = 0; i < objects.size(); i++)
+			{
+				firstParentIndex[i + 1] += firstParentIndex[i];
+			}
+
+			std::vector<std::uint32_t> nextParentIndex(firstParentIndex.begin(), firstParentIndex.end() - 1);
+			parentObjectIDs.resize(firstParentIndex.back());
+
+			for (const ObjectEntry &object : objects)
+			{
+				for (std::uint32_t i = object.firstChildIndex; i < (object.firstChildIndex + object.numberOfChildren); i++)
+				{
+					if (childObjectIndexes[i] < objects.size())
+					{
+						parentObjectIDs[nextParentIndex[childObjectIndexes[i]]++] = object.objectID;
+					}
+				}
+			}
+		}
+		return retVal;
+	}
+
+} // namespace isobus
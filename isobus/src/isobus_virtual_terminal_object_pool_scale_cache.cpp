@@ -0,0 +1,86 @@
+//================================================================================================
+/// @file isobus_virtual_terminal_object_pool_scale_cache.cpp
+///
+/// @brief Implements a cache of scaled object pools that is shared by all VT clients
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_scale_cache.hpp"
+
+#include <algorithm>
+
+namespace isobus
+{
+	std::vector<VirtualTerminalObjectPoolScaleCache::CacheEntry> VirtualTerminalObjectPoolScaleCache::cache;
+	std::mutex VirtualTerminalObjectPoolScaleCache::cacheMutex;
+
+	std::shared_ptr<const VirtualTerminalObjectPoolScaler> VirtualTerminalObjectPoolScaleCache::get_scaler(const std::uint8_t *pool, std::uint32_t size, const ScalingParameters &parameters)
+	{
+		// The lock is held while preparing, so clients connecting at the same time wait for one scaler instead of each making their own
+		const std::lock_guard<std::mutex> lock(cacheMutex);
+		std::shared_ptr<const VirtualTerminalObjectPoolScaler> retVal;
+
+		remove_unused_entries();
+
+		for (auto &entry : cache)
+		{
+			if ((pool == entry.pool) &&
+			    (size == entry.size) &&
+			    (get_is_same_parameters(parameters, entry.parameters)))
+			{
+				retVal = entry.scaler.lock();
+				break;
+			}
+		}
+
+		if (nullptr == retVal)
+		{
+			std::shared_ptr<VirtualTerminalObjectPoolScaler> newScaler = std::make_shared<VirtualTerminalObjectPoolScaler>();
+
+			newScaler->set_data_mask_scaling(parameters.originalDataMaskSize_px, parameters.dataMaskSize_px);
+			newScaler->set_soft_key_scaling(parameters.originalSoftKeyWidth_px, parameters.originalSoftKeyHeight_px, parameters.softKeyWidth_px, parameters.softKeyHeight_px);
+			newScaler->set_supported_font_sizes(parameters.smallFontSizes, parameters.largeFontSizes);
+
+			if (newScaler->prepare(pool, size))
+			{
+				CacheEntry newEntry;
+
+				newEntry.pool = pool;
+				newEntry.size = size;
+				newEntry.parameters = parameters;
+				newEntry.scaler = newScaler;
+				cache.push_back(newEntry);
+				retVal = newScaler;
+			}
+		}
+		return retVal;
+	}
+
+	std::uint32_t VirtualTerminalObjectPoolScaleCache::get_number_cached_scalers()
+	{
+		const std::lock_guard<std::mutex> lock(cacheMutex);
+
+		remove_unused_entries();
+		return static_cast<std::uint32_t>(cache.size());
+	}
+
+	bool VirtualTerminalObjectPoolScaleCache::get_is_same_parameters(const ScalingParameters &first, const ScalingParameters &second)
+	{
+		return ((first.originalDataMaskSize_px == second.originalDataMaskSize_px) &&
+		        (first.dataMaskSize_px == second.dataMaskSize_px) &&
+		        (first.originalSoftKeyWidth_px == second.originalSoftKeyWidth_px) &&
+		        (first.originalSoftKeyHeight_px == second.originalSoftKeyHeight_px) &&
+		        (first.softKeyWidth_px == second.softKeyWidth_px) &&
+		        (first.softKeyHeight_px == second.softKeyHeight_px) &&
+		        (first.smallFontSizes == second.smallFontSizes) &&
+		        (first.largeFontSizes == second.largeFontSizes));
+	}
+
+	void VirtualTerminalObjectPoolScaleCache::remove_unused_entries()
+	{
+		cache.erase(std::remove_if(cache.begin(), cache.end(), [](const CacheEntry &entry) { return entry.scaler.expired(); }), cache.end());
+	}
+
+} // namespace isobus
@@ -0,0 +1,413 @@
+//================================================================================================
+/// @file isobus_virtual_terminal_object_pool_scaler.cpp
+///
+/// @brief Implements a class that scales an object pool to a VT's resolution while it is uploaded
+/// @author Adrian Del Grosso
+///
+/// @copyright 2022 Adrian Del Grosso
+//================================================================================================
+
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_scaler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace isobus
+{
+	VirtualTerminalObjectPoolScaler::VirtualTerminalObjectPoolScaler() :
+	  dataMaskScaling{ { 1, 1 }, { 1, 1 } },
+	  softKeyScaling{ { 1, 1 }, { 1, 1 } },
+	  smallFontSizes(0),
+	  largeFontSizes(0)
+	{
+	}
+
+	void VirtualTerminalObjectPoolScaler::set_data_mask_scaling(std::uint16_t originalSize_px, std::uint16_t newSize_px)
+	{
+		if ((0 != originalSize_px) &&
+		    (0 != newSize_px))
+		{
+			dataMaskScaling = { { newSize_px, originalSize_px }, { newSize_px, originalSize_px } };
+		}
+		else
+		{
+			dataMaskScaling = { { 1, 1 }, { 1, 1 } };
+		}
+	}
+
+	void VirtualTerminalObjectPoolScaler::set_soft_key_scaling(std::uint16_t originalWidth_px, std::uint16_t originalHeight_px, std::uint16_t newWidth_px, std::uint16_t newHeight_px)
+	{
+		if ((0 != originalWidth_px) &&
+		    (0 != originalHeight_px) &&
+		    (0 != newWidth_px) &&
+		    (0 != newHeight_px))
+		{
+			softKeyScaling = { { newWidth_px, originalWidth_px }, { newHeight_px, originalHeight_px } };
+		}
+		else
+		{
+			softKeyScaling = { { 1, 1 }, { 1, 1 } };
+		}
+	}
+
+	void VirtualTerminalObjectPoolScaler::set_supported_font_sizes(std::uint8_t smallFontSizesBitfield, std::uint8_t largeFontSizesBitfield)
+	{
+		smallFontSizes = smallFontSizesBitfield;
+		largeFontSizes = largeFontSizesBitfield;
+	}
+
+	bool VirtualTerminalObjectPoolScaler::prepare(const std::uint8_t *pool, std::uint32_t size)
+	{
+		bool retVal = false;
+
+		clear();
+
+		if (poolIndex.parse(pool, size))
+		{
+			// Work out which objects are drawn in the soft key area by walking down from each soft key mask.
+			// The working set's designator is drawn in an area the size of a soft key, so it is walked too.
+			const std::uint32_t numberOfObjects = poolIndex.get_number_objects();
+			std::vector<bool> inSoftKeyArea(numberOfObjects, false);
+			std::vector<std::uint32_t> objectsToVisit;
+
+			for (std::uint32_t i = 0; i < numberOfObjects; i++)
+			{
+				const VirtualTerminalObjectPoolIndex::ObjectType type = poolIndex.get_object_by_index(i)->type;
+
+				if ((VirtualTerminalObjectPoolIndex::ObjectType::SoftKeyMask == type) ||
+				    (VirtualTerminalObjectPoolIndex::ObjectType::WorkingSet == type))
+				{
+					inSoftKeyArea[i] = true;
+					objectsToVisit.push_back(i);
+				}
+			}
+
+			while (!objectsToVisit.empty())
+			{
+				const VirtualTerminalObjectPoolIndex::ObjectEntry &object = *poolIndex.get_object_by_index(objectsToVisit.back());
+				objectsToVisit.pop_back();
+
+				for (std::uint16_t i = 0; i < object.numberOfChildren; i++)
+				{
+					const std::uint32_t childIndex = poolIndex.get_object_index(poolIndex.get_child_object_id(object, i));
+
+					if ((childIndex < numberOfObjects) &&
+					    (!inSoftKeyArea[childIndex]))
+					{
+						inSoftKeyArea[childIndex] = true;
+						objectsToVisit.push_back(childIndex);
+					}
+				}
+			}
+
+			for (std::uint32_t i = 0; i < numberOfObjects; i++)
+			{
+				scale_object(pool, *poolIndex.get_object_by_index(i), inSoftKeyArea[i] ? softKeyScaling : dataMaskScaling);
+			}
+			std::sort(patches.begin(), patches.end(), [](const Patch &first, const Patch &second) { return first.offset < second.offset; });
+
+			// Only the patches are needed from here on
+			poolIndex.clear();
+			retVal = true;
+		}
+		return retVal;
+	}
+
+	void VirtualTerminalObjectPoolScaler::apply(std::uint32_t poolOffset, std::uint8_t *buffer, std::uint32_t length) const
+	{
+		if (nullptr != buffer)
+		{
+			auto patch = std::lower_bound(patches.begin(), patches.end(), poolOffset, [](const Patch &entry, std::uint32_t offset) { return entry.offset < offset; });
+
+			while ((patches.end() != patch) &&
+			       (patch->offset < (poolOffset + length)))
+			{
+				buffer[patch->offset - poolOffset] = patch->value;
+				patch++;
+			}
+		}
+	}
+
+	std::uint32_t VirtualTerminalObjectPoolScaler::get_number_patched_bytes() const
+	{
+		return static_cast<std::uint32_t>(patches.size());
+	}
+
+	void VirtualTerminalObjectPoolScaler::clear()
+	{
+		poolIndex.clear();
+		patches.clear();
+	}
+
+	void VirtualTerminalObjectPoolScaler::scale_object(const std::uint8_t *pool, const VirtualTerminalObjectPoolIndex::ObjectEntry &object, const AreaScaling &scaling)
+	{
+		// Most objects store their width and height at the same place, right after the object type
+		constexpr std::uint32_t WIDTH_OFFSET = 3;
+		constexpr std::uint32_t HEIGHT_OFFSET = 5;
+		const std::uint8_t *objectData = &pool[object.offset];
+
+		switch (object.type)
+		{
+			case VirtualTerminalObjectPoolIndex::ObjectType::WorkingSet:
+			{
+				scale_object_positions(pool, object.offset + 10, objectData[7], scaling);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::DataMask:
+			{
+				scale_object_positions(pool, object.offset + 8, objectData[6], scaling);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::AlarmMask:
+			{
+				scale_object_positions(pool, object.offset + 10, objectData[8], scaling);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::Container:
+			{
+				scale_uint16(pool, object.offset + WIDTH_OFFSET, scaling.x);
+				scale_uint16(pool, object.offset + HEIGHT_OFFSET, scaling.y);
+				scale_object_positions(pool, object.offset + 10, objectData[8], scaling);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::Key:
+			{
+				scale_object_positions(pool, object.offset + 7, objectData[5], scaling);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::Button:
+			{
+				scale_uint16(pool, object.offset + WIDTH_OFFSET, scaling.x);
+				scale_uint16(pool, object.offset + HEIGHT_OFFSET, scaling.y);
+				scale_object_positions(pool, object.offset + 13, objectData[11], scaling);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::InputBoolean:
+			{
+				// Input booleans are square, with the width after the background colour
+				scale_uint16(pool, object.offset + 4, scaling.x);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::InputString:
+			case VirtualTerminalObjectPoolIndex::ObjectType::InputNumber:
+			case VirtualTerminalObjectPoolIndex::ObjectType::InputList:
+			case VirtualTerminalObjectPoolIndex::ObjectType::OutputString:
+			case VirtualTerminalObjectPoolIndex::ObjectType::OutputNumber:
+			case VirtualTerminalObjectPoolIndex::ObjectType::OutputLinearBarGraph:
+			case VirtualTerminalObjectPoolIndex::ObjectType::OutputList:
+			case VirtualTerminalObjectPoolIndex::ObjectType::ScaledGraphic:
+			{
+				scale_uint16(pool, object.offset + WIDTH_OFFSET, scaling.x);
+				scale_uint16(pool, object.offset + HEIGHT_OFFSET, scaling.y);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::OutputLine:
+			case VirtualTerminalObjectPoolIndex::ObjectType::OutputRectangle:
+			case VirtualTerminalObjectPoolIndex::ObjectType::OutputEllipse:
+			{
+				// These have a line attributes reference before their size
+				scale_uint16(pool, object.offset + 5, scaling.x);
+				scale_uint16(pool, object.offset + 7, scaling.y);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::OutputPolygon:
+			{
+				constexpr std::uint32_t POINT_SIZE = 4;
+
+				scale_uint16(pool, object.offset + WIDTH_OFFSET, scaling.x);
+				scale_uint16(pool, object.offset + HEIGHT_OFFSET, scaling.y);
+				for (std::uint32_t i = 0; i < objectData[12]; i++)
+				{
+					scale_uint16(pool, object.offset + 14 + (POINT_SIZE * i), scaling.x);
+					scale_uint16(pool, object.offset + 16 + (POINT_SIZE * i), scaling.y);
+				}
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::OutputMeter:
+			case VirtualTerminalObjectPoolIndex::ObjectType::PictureGraphic:
+			{
+				// Meters are round and pictures keep their aspect ratio, so they only have a width
+				scale_uint16(pool, object.offset + WIDTH_OFFSET, scaling.x);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::OutputArchedBarGraph:
+			{
+				scale_uint16(pool, object.offset + WIDTH_OFFSET, scaling.x);
+				scale_uint16(pool, object.offset + HEIGHT_OFFSET, scaling.y);
+				scale_uint16(pool, object.offset + 12, scaling.x);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::Animation:
+			{
+				scale_uint16(pool, object.offset + WIDTH_OFFSET, scaling.x);
+				scale_uint16(pool, object.offset + HEIGHT_OFFSET, scaling.y);
+				scale_object_positions(pool, object.offset + 17, objectData[15], scaling);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::WindowMask:
+			{
+				// The window's size is in cells, not pixels, so only its positioned objects get scaled
+				scale_object_positions(pool, object.offset + 17 + (2 * objectData[14]), objectData[15], scaling);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::LineAttributes:
+			{
+				scale_uint8(pool, object.offset + 4, scaling.x);
+			}
+			break;
+
+			case VirtualTerminalObjectPoolIndex::ObjectType::FontAttributes:
+			{
+				scale_font(pool, object, scaling);
+			}
+			break;
+
+			default:
+			{
+				// Nothing in this object depends on the screen size
+			}
+			break;
+		}
+	}
+
+	void VirtualTerminalObjectPoolScaler::scale_object_positions(const std::uint8_t *pool, std::uint32_t listOffset, std::uint32_t numberOfEntries, const AreaScaling &scaling)
+	{
+		constexpr std::uint32_t POSITIONED_OBJECT_REFERENCE_SIZE = 6; // Object ID, X, and Y
+
+		for (std::uint32_t i = 0; i < numberOfEntries; i++)
+		{
+			scale_int16(pool, listOffset + (POSITIONED_OBJECT_REFERENCE_SIZE * i) + 2, scaling.x);
+			scale_int16(pool, listOffset + (POSITIONED_OBJECT_REFERENCE_SIZE * i) + 4, scaling.y);
+		}
+	}
+
+	void VirtualTerminalObjectPoolScaler::scale_uint16(const std::uint8_t *pool, std::uint32_t offset, const ScaleFactor &factor)
+	{
+		const std::int32_t value = static_cast<std::int32_t>(pool[offset]) | (static_cast<std::int32_t>(pool[offset + 1]) << 8);
+		std::int32_t scaledValue = std::min<std::int32_t>(scale_value(value, factor), std::numeric_limits<std::uint16_t>::max());
+
+		// Don't let something visible shrink to nothing
+		if ((0 != value) &&
+		    (0 == scaledValue))
+		{
+			scaledValue = 1;
+		}
+		add_patch(pool, offset, static_cast<std::uint8_t>(scaledValue & 0xFF));
+		add_patch(pool, offset + 1, static_cast<std::uint8_t>((scaledValue >> 8) & 0xFF));
+	}
+
+	void VirtualTerminalObjectPoolScaler::scale_int16(const std::uint8_t *pool, std::uint32_t offset, const ScaleFactor &factor)
+	{
+		const std::int16_t value = static_cast<std::int16_t>(static_cast<std::uint16_t>(pool[offset]) | (static_cast<std::uint16_t>(pool[offset + 1]) << 8));
+		std::int32_t scaledValue = scale_value(value, factor);
+
+		scaledValue = std::max<std::int32_t>(std::min<std::int32_t>(scaledValue, std::numeric_limits<std::int16_t>::max()), std::numeric_limits<std::int16_t>::min());
+		add_patch(pool, offset, static_cast<std::uint8_t>(scaledValue & 0xFF));
+		add_patch(pool, offset + 1, static_cast<std::uint8_t>((scaledValue >> 8) & 0xFF));
+	}
+
+	void VirtualTerminalObjectPoolScaler::scale_uint8(const std::uint8_t *pool, std::uint32_t offset, const ScaleFactor &factor)
+	{
+		const std::int32_t value = pool[offset];
+		std::int32_t scaledValue = std::min<std::int32_t>(scale_value(value, factor), std::numeric_limits<std::uint8_t>::max());
+
+		if ((0 != value) &&
+		    (0 == scaledValue))
+		{
+			scaledValue = 1;
+		}
+		add_patch(pool, offset, static_cast<std::uint8_t>(scaledValue));
+	}
+
+	void VirtualTerminalObjectPoolScaler::scale_font(const std::uint8_t *pool, const VirtualTerminalObjectPoolIndex::ObjectEntry &object, const AreaScaling &scaling)
+	{
+		// The fixed font sizes, in the order of their font size codes
+		constexpr std::uint8_t NUMBER_FONT_SIZES = 15;
+		constexpr std::uint8_t FIRST_LARGE_FONT_SIZE = 8;
+		constexpr std::uint8_t FONT_WIDTHS_PX[NUMBER_FONT_SIZES] = { 6, 8, 8, 12, 16, 16, 24, 32, 32, 48, 64, 64, 96, 128, 128 };
+		constexpr std::uint8_t FONT_HEIGHTS_PX[NUMBER_FONT_SIZES] = { 8, 8, 12, 16, 16, 24, 32, 32, 48, 64, 64, 96, 128, 128, 192 };
+		constexpr std::uint8_t PROPORTIONAL_FONT_STYLE_BIT = 0x80;
+		const std::uint32_t fontSizeOffset = object.offset + 4;
+		const std::uint8_t fontSize = pool[fontSizeOffset];
+		const std::uint8_t fontStyle = pool[object.offset + 6];
+
+		if (0 != (PROPORTIONAL_FONT_STYLE_BIT & fontStyle))
+		{
+			// Proportional fonts store their height in pixels instead of a font size code
+			scale_uint8(pool, fontSizeOffset, scaling.y);
+		}
+		else if ((fontSize < NUMBER_FONT_SIZES) &&
+		         ((0 != smallFontSizes) || (0 != largeFontSizes)))
+		{
+			const std::int32_t scaledWidth = scale_value(FONT_WIDTHS_PX[fontSize], scaling.x);
+			const std::int32_t scaledHeight = scale_value(FONT_HEIGHTS_PX[fontSize], scaling.y);
+			std::uint8_t smallestSupportedSize = NUMBER_FONT_SIZES;
+			std::uint8_t bestSupportedSize = NUMBER_FONT_SIZES;
+
+			for (std::uint8_t i = 0; i < NUMBER_FONT_SIZES; i++)
+			{
+				bool supported;
+
+				if (i < FIRST_LARGE_FONT_SIZE)
+				{
+					supported = (0 != (smallFontSizes & (1 << i)));
+				}
+				else
+				{
+					supported = (0 != (largeFontSizes & (1 << (i - FIRST_LARGE_FONT_SIZE + 1))));
+				}
+
+				if (supported)
+				{
+					if (NUMBER_FONT_SIZES == smallestSupportedSize)
+					{
+						smallestSupportedSize = i;
+					}
+
+					// Font sizes get bigger with their code, so the last one that fits is the biggest
+					if ((FONT_WIDTHS_PX[i] <= scaledWidth) &&
+					    (FONT_HEIGHTS_PX[i] <= scaledHeight))
+					{
+						bestSupportedSize = i;
+					}
+				}
+			}
+
+			if (NUMBER_FONT_SIZES == bestSupportedSize)
+			{
+				bestSupportedSize = smallestSupportedSize;
+			}
+			add_patch(pool, fontSizeOffset, bestSupportedSize);
+		}
+	}
+
+	void VirtualTerminalObjectPoolScaler::add_patch(const std::uint8_t *pool, std::uint32_t offset, std::uint8_t value)
+	{
+		if (pool[offset] != value)
+		{
+			patches.push_back({ offset, value });
+		}
+	}
+
+	std::int32_t VirtualTerminalObjectPoolScaler::scale_value(std::int32_t value, const ScaleFactor &factor)
+	{
+		const std::int64_t scaledMagnitude = ((static_cast<std::int64_t>(std::abs(value)) * factor.numerator) + (factor.denominator / 2)) / factor.denominator;
+		return static_cast<std::int32_t>((value < 0) ? -scaledMagnitude : scaledMagnitude);
+	}
+
+} // namespace isobus
@@ -3,16 +3,27 @@
 #include "isobus/hardware_integration/can_hardware_interface.hpp"
 #include "isobus/hardware_integration/virtual_can_plugin.hpp"
 #include "isobus/isobus/can_NAME_filter.hpp"
+#include "isobus/isobus/can_address_claim_state_machine.hpp"
 #include "isobus/isobus/can_constants.hpp"
 #include "isobus/isobus/can_internal_control_function.hpp"
 #include "isobus/isobus/can_network_manager.hpp"
 #include "isobus/isobus/can_partnered_control_function.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <set>
 #include <thread>
 
 using namespace isobus;
 
+static void count_partner_bound_events(ControlFunction *, ControlFunctionEvent event, std::uint8_t, void *parentPointer)
+{
+	if (ControlFunctionEvent::PartnerBound == event)
+	{
+		static_cast<std::atomic<std::uint32_t> *>(parentPointer)->fetch_add(1);
+	}
+}
+
 TEST(ADDRESS_CLAIM_TESTS, PartneredClaim)
 {
 	std::shared_ptr<VirtualCANPlugin> firstDevice = std::make_shared<VirtualCANPlugin>();
@@ -33,6 +44,9 @@ TEST(ADDRESS_CLAIM_TESTS, PartneredClaim)
 	  },
 	  nullptr);
 
+	std::atomic<std::uint32_t> partnerBoundEvents(0);
+	CANNetworkManager::CANNetwork.add_control_function_event_callback(count_partner_bound_events, &partnerBoundEvents);
+
 	std::this_thread::sleep_for(std::chrono::milliseconds(250));
 
 	NAME firstName(0);
@@ -68,6 +82,74 @@ TEST(ADDRESS_CLAIM_TESTS, PartneredClaim)
 
 	EXPECT_TRUE(firstPartneredSecondECU.get_address_valid());
 	EXPECT_TRUE(secondPartneredFirstEcu.get_address_valid());
+	EXPECT_EQ(2, partnerBoundEvents.load());
 
 	CANHardwareInterface::stop();
+	CANNetworkManager::CANNetwork.remove_control_function_event_callback(count_partner_bound_events, &partnerBoundEvents);
+}
+
+static NAME make_claim_test_NAME(std::uint32_t identityNumber)
+{
+	NAME retVal(0);
+
+	retVal.set_arbitrary_address_capable(true);
+	retVal.set_industry_group(1);
+	retVal.set_function_code(static_cast<std::uint8_t>(NAME::Function::CabClimateControl));
+	retVal.set_identity_number(identityNumber);
+	retVal.set_manufacturer_code(69);
+	return retVal;
+}
+
+TEST(ADDRESS_CLAIM_TESTS, DerivesClaimDelayFromNAME)
+{
+	std::set<std::uint32_t> delays;
+
+	// NAMEs that only differ in their identity number, like identical firmware on many ECUs
+	for (std::uint32_t i = 0; i < 200; i++)
+	{
+		const std::uint32_t delay_us = AddressClaimStateMachine::get_random_claim_delay_us(make_claim_test_NAME(i));
+
+		EXPECT_EQ(0u, delay_us % 600);
+		EXPECT_LE(delay_us, 255u * 600u);
+		EXPECT_EQ(delay_us, AddressClaimStateMachine::get_random_claim_delay_us(make_claim_test_NAME(i)));
+		delays.insert(delay_us);
+	}
+
+	// 200 draws from 256 steps, so most of them should differ
+	EXPECT_GT(delays.size(), 100u);
+}
+
+TEST(ADDRESS_CLAIM_TESTS, WaitsForClaimDelayAgainAfterRestart)
+{
+	// Nothing is started on this channel, so the state machine can't get past sending its request
+	static constexpr std::uint8_t TEST_CAN_PORT = 2;
+	std::uint32_t identityNumber = 0;
+
+	while (AddressClaimStateMachine::get_random_claim_delay_us(make_claim_test_NAME(identityNumber)) < 30000)
+	{
+		identityNumber++;
+	}
+	const NAME testNAME = make_claim_test_NAME(identityNumber);
+	const std::chrono::microseconds delay(AddressClaimStateMachine::get_random_claim_delay_us(testNAME) + 5000);
+	AddressClaimStateMachine stateMachine(0x80, testNAME, TEST_CAN_PORT);
+
+	EXPECT_EQ(AddressClaimStateMachine::State::None, stateMachine.get_current_state());
+	stateMachine.update();
+	stateMachine.update();
+	EXPECT_EQ(AddressClaimStateMachine::State::WaitForClaim, stateMachine.get_current_state());
+	std::this_thread::sleep_for(delay);
+	stateMachine.update();
+	EXPECT_NE(AddressClaimStateMachine::State::WaitForClaim, stateMachine.get_current_state());
+
+	// Starting over waits for the whole delay again
+	stateMachine.set_is_enabled(false);
+	stateMachine.update();
+	EXPECT_EQ(AddressClaimStateMachine::State::None, stateMachine.get_current_state());
+	stateMachine.set_is_enabled(true);
+	stateMachine.update();
+	stateMachine.update();
+	EXPECT_EQ(AddressClaimStateMachine::State::WaitForClaim, stateMachine.get_current_state());
+	std::this_thread::sleep_for(delay);
+	stateMachine.update();
+	EXPECT_NE(AddressClaimStateMachine::State::WaitForClaim, stateMachine.get_current_state());
 }
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include "isobus/isobus/can_stack_async_logger.hpp"
+#include "isobus/isobus/can_stack_logger.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace isobus;
+
+class TestLogSink : public CANStackLogger
+{
+public:
+	void sink_CAN_stack_log(CANStackLogger::LoggingLevel, const std::string &text) override
+	{
+		// Once the backend stops, other threads log to the sink directly
+		const std::lock_guard<std::mutex> lock(logsMutex);
+		logs.push_back(text);
+	}
+
+	std::mutex logsMutex;
+	std::vector<std::string> logs;
+};
+
+TEST(ASYNC_LOGGER_TESTS, RecordsReachSinkAndDecoder)
+{
+	TestLogSink testSink;
+	std::stringstream binaryLog;
+
+	CANStackLogger::set_can_stack_logger_sink(&testSink);
+	CANStackAsyncLogger::set_binary_output(&binaryLog);
+	EXPECT_TRUE(CANStackAsyncLogger::start());
+	EXPECT_FALSE(CANStackAsyncLogger::start());
+
+	CAN_STACK_LOG_INFO("[Test]: Address %u label %s", static_cast<unsigned int>(0x81), "ABCDEFG");
+	std::thread otherThread([]() { CAN_STACK_LOG_WARNING("[Test]: PGN %u name %llu", static_cast<unsigned int>(0xFEDA), static_cast<unsigned long long>(0xA00086000C101234ULL)); });
+	otherThread.join();
+	CAN_STACK_LOG_DEBUG("[Test]: Below the log level %d", -1);
+
+	EXPECT_TRUE(CANStackAsyncLogger::stop());
+	EXPECT_FALSE(CANStackAsyncLogger::get_is_running());
+	CANStackAsyncLogger::set_binary_output(nullptr);
+	CANStackLogger::set_can_stack_logger_sink(nullptr);
+
+	ASSERT_EQ(2u, testSink.logs.size());
+	EXPECT_EQ("[Test]: Address 129 label ABCDEFG", testSink.logs[0]);
+	EXPECT_EQ("[Test]: PGN 65242 name 11529362380828971572", testSink.logs[1]);
+
+	std::ostringstream decoded;
+	std::string line;
+	EXPECT_TRUE(CANStackAsyncLogger::decode(binaryLog, decoded));
+	std::istringstream decodedLines(decoded.str());
+	ASSERT_TRUE(std::getline(decodedLines, line));
+	EXPECT_NE(std::string::npos, line.find("[Info] [Test]: Address 129 label ABCDEFG"));
+	ASSERT_TRUE(std::getline(decodedLines, line));
+	EXPECT_NE(std::string::npos, line.find("[Warning] [Test]: PGN 65242 name 11529362380828971572"));
+	EXPECT_FALSE(std::getline(decodedLines, line));
+}
+
+TEST(ASYNC_LOGGER_TESTS, StopKeepsRecordsOfThreadsStillLogging)
+{
+	constexpr std::uint32_t NUMBER_OF_THREADS = 4;
+	constexpr std::uint32_t LOGS_PER_THREAD = 200; // Fewer than a ring holds, so nothing is dropped
+	TestLogSink testSink;
+	std::atomic<std::uint32_t> threadsStarted(0);
+	std::atomic<bool> stopped(false);
+	std::vector<std::thread> threads;
+
+	CANStackLogger::set_can_stack_logger_sink(&testSink);
+	EXPECT_TRUE(CANStackAsyncLogger::start());
+
+	for (std::uint32_t i = 0; i < NUMBER_OF_THREADS; i++)
+	{
+		threads.emplace_back([&threadsStarted, &stopped, i]() {
+			threadsStarted++;
+			for (std::uint32_t j = 0; j < LOGS_PER_THREAD; j++)
+			{
+				CAN_STACK_LOG_INFO("[Test]: Thread %u record %u", static_cast<unsigned int>(i), static_cast<unsigned int>(j));
+			}
+
+			// A thread that exits frees its ring for the next one, so keep it until the rings are drained
+			while (!stopped)
+			{
+				std::this_thread::yield();
+			}
+		});
+	}
+	while (NUMBER_OF_THREADS != threadsStarted)
+	{
+		std::this_thread::yield();
+	}
+
+	// Every statement is logged once, either drained by stop or sent to the sink directly after it
+	EXPECT_TRUE(CANStackAsyncLogger::stop());
+	stopped = true;
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+	CANStackLogger::set_can_stack_logger_sink(nullptr);
+
+	EXPECT_EQ(NUMBER_OF_THREADS * LOGS_PER_THREAD, testSink.logs.size());
+	EXPECT_EQ(0u, CANStackAsyncLogger::get_number_dropped_records());
+}
@@ -1,9 +1,15 @@
 #include <gtest/gtest.h>
 
+#include "isobus/isobus/can_general_parameter_group_numbers.hpp"
 #include "isobus/isobus/can_internal_control_function.hpp"
+#include "isobus/isobus/can_network_manager.hpp"
 #include "isobus/isobus/can_partnered_control_function.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <memory>
+#include <thread>
 
 using namespace isobus;
 
@@ -36,3 +42,155 @@ TEST(CORE_TESTS, TestCreateAndDestroyICFs)
 	delete TestIcf2;
 	auto TestIcf3 = std::make_shared<isobus::InternalControlFunction>(TestDeviceNAME, 0x81, 0);
 }
+
+TEST(CORE_TESTS, TestPartnerNAMEFilterMatching)
+{
+	isobus::NAME TestDeviceNAME(0);
+	TestDeviceNAME.set_arbitrary_address_capable(true);
+	TestDeviceNAME.set_industry_group(2);
+	TestDeviceNAME.set_function_code(static_cast<std::uint8_t>(isobus::NAME::Function::VirtualTerminal));
+	TestDeviceNAME.set_manufacturer_code(64);
+
+	const isobus::NAMEFilter vtFilter(isobus::NAME::NAMEParameters::FunctionCode, static_cast<std::uint8_t>(isobus::NAME::Function::VirtualTerminal));
+	const isobus::NAMEFilter industryFilter(isobus::NAME::NAMEParameters::IndustryGroup, 2);
+	isobus::PartneredControlFunction TestPartner1(0, { vtFilter, industryFilter });
+	EXPECT_TRUE(TestPartner1.check_matches_name(TestDeviceNAME));
+
+	// Several filters on the same parameter match any of their values
+	const isobus::NAMEFilter firstManufacturerFilter(isobus::NAME::NAMEParameters::ManufacturerCode, 69);
+	const isobus::NAMEFilter secondManufacturerFilter(isobus::NAME::NAMEParameters::ManufacturerCode, 64);
+	isobus::PartneredControlFunction TestPartner2(0, { vtFilter, firstManufacturerFilter, secondManufacturerFilter });
+	EXPECT_TRUE(TestPartner2.check_matches_name(TestDeviceNAME));
+	TestDeviceNAME.set_manufacturer_code(70);
+	EXPECT_FALSE(TestPartner2.check_matches_name(TestDeviceNAME));
+
+	// A value that doesn't fit in the NAME parameter can never match
+	const isobus::NAMEFilter invalidIndustryFilter(isobus::NAME::NAMEParameters::IndustryGroup, 10);
+	isobus::PartneredControlFunction TestPartner3(0, { invalidIndustryFilter });
+	EXPECT_FALSE(TestPartner3.check_matches_name(TestDeviceNAME));
+
+	isobus::PartneredControlFunction TestPartner4(0, {});
+	EXPECT_FALSE(TestPartner4.check_matches_name(TestDeviceNAME));
+	// A parameter the NAME doesn't have can never match either, even on its own or next to a matching filter
+	const isobus::NAMEFilter unknownParameterFilter(static_cast<isobus::NAME::NAMEParameters>(42), 0);
+	isobus::PartneredControlFunction TestPartner5(0, { unknownParameterFilter });
+	EXPECT_FALSE(TestPartner5.check_matches_name(TestDeviceNAME));
+	EXPECT_FALSE(TestPartner5.check_matches_name(isobus::NAME(0)));
+	isobus::PartneredControlFunction TestPartner6(0, { vtFilter, unknownParameterFilter });
+	EXPECT_FALSE(TestPartner6.check_matches_name(TestDeviceNAME));
+}
+
+static void check_purged_source(CANMessage *message, void *parentPointer)
+{
+	ControlFunction *source = message->get_source_control_function();
+
+	// A purged partner must have been replaced in every queued message, never left dangling
+	if ((nullptr != source) &&
+	    (static_cast<std::uint64_t *>(parentPointer)[0] != source->get_NAME().get_full_name()))
+	{
+		static_cast<std::uint64_t *>(parentPointer)[1]++;
+	}
+	if ((nullptr != source) &&
+	    (ControlFunction::Type::Partnered == source->get_type()))
+	{
+		static_cast<std::uint64_t *>(parentPointer)[3]++;
+	}
+	static_cast<std::uint64_t *>(parentPointer)[2]++;
+}
+
+TEST(CORE_TESTS, PurgesPartnersWhileReceiving)
+{
+	constexpr std::uint8_t testPort = 2;
+	constexpr std::uint8_t testAddress = 0x52;
+	constexpr std::uint32_t testPGN = 0xFF10;
+	isobus::NAME testNAME(0);
+	testNAME.set_arbitrary_address_capable(true);
+	testNAME.set_function_code(static_cast<std::uint8_t>(isobus::NAME::Function::TirePressureControl));
+	testNAME.set_identity_number(52);
+	testNAME.set_manufacturer_code(64);
+
+	// Name to match, mismatches, messages seen, messages from the partner
+	std::uint64_t results[4] = { testNAME.get_full_name(), 0, 0, 0 };
+	CANNetworkManager::CANNetwork.add_any_control_function_parameter_group_number_callback(testPGN, check_purged_source, results);
+	CANNetworkManager::CANNetwork.update();
+
+	HardwareInterfaceCANFrame claimFrame;
+	claimFrame.timestamp_us = 0;
+	claimFrame.identifier = CANIdentifier(CANIdentifier::Type::Extended, static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim), CANIdentifier::CANPriority::PriorityDefault6, 0xFF, testAddress).get_identifier();
+	claimFrame.channel = testPort;
+	claimFrame.dataLength = 8;
+	claimFrame.isExtendedFrame = true;
+	for (std::uint8_t i = 0; i < 8; i++)
+	{
+		claimFrame.data[i] = static_cast<std::uint8_t>(testNAME.get_full_name() >> (8 * i));
+	}
+	CANNetworkManager::CANNetwork.can_lib_process_rx_message(claimFrame, nullptr);
+	CANNetworkManager::CANNetwork.update();
+
+	std::atomic<bool> receiving(true);
+	std::thread rxThread([&receiving]() {
+		HardwareInterfaceCANFrame frame;
+		frame.timestamp_us = 0;
+		frame.identifier = CANIdentifier(CANIdentifier::Type::Extended, testPGN, CANIdentifier::CANPriority::PriorityDefault6, 0xFF, testAddress).get_identifier();
+		frame.channel = testPort;
+		frame.dataLength = 8;
+		frame.isExtendedFrame = true;
+		std::fill(std::begin(frame.data), std::end(frame.data), 0xFF);
+
+		while (receiving)
+		{
+			CANNetworkManager::CANNetwork.can_lib_process_rx_message(frame, nullptr);
+			std::this_thread::yield();
+		}
+	});
+
+	const isobus::NAMEFilter filter(isobus::NAME::NAMEParameters::FunctionCode, static_cast<std::uint8_t>(isobus::NAME::Function::TirePressureControl));
+	for (std::uint32_t i = 0; i < 50; i++)
+	{
+		auto partner = new isobus::PartneredControlFunction(testPort, { filter });
+		const std::uint64_t partnerMessages = results[3];
+
+		// Delete the partner while the Rx thread is still attaching it to new messages
+		for (std::uint32_t j = 0; (j < 100000) && (partnerMessages == results[3]); j++)
+		{
+			CANNetworkManager::CANNetwork.update();
+			std::this_thread::yield();
+		}
+		delete partner;
+		CANNetworkManager::CANNetwork.update();
+	}
+	receiving = false;
+	rxThread.join();
+	CANNetworkManager::CANNetwork.update();
+	CANNetworkManager::CANNetwork.remove_any_control_function_parameter_group_number_callback(testPGN, check_purged_source, results);
+
+	EXPECT_EQ(0u, results[1]);
+	EXPECT_NE(0u, results[2]);
+	EXPECT_NE(0u, results[3]);
+}
+
+static void remove_self_on_first_event(ControlFunction *, ControlFunctionEvent event, std::uint8_t, void *parentPointer)
+{
+	if (ControlFunctionEvent::Deleted == event)
+	{
+		(*static_cast<std::uint32_t *>(parentPointer))++;
+	}
+	CANNetworkManager::CANNetwork.remove_control_function_event_callback(remove_self_on_first_event, parentPointer);
+}
+
+TEST(CORE_TESTS, EventCallbacksCanRemoveThemselves)
+{
+	const isobus::NAMEFilter vtFilter(isobus::NAME::NAMEParameters::FunctionCode, static_cast<std::uint8_t>(isobus::NAME::Function::VirtualTerminal));
+	std::uint32_t deletedEvents = 0;
+
+	CANNetworkManager::CANNetwork.add_control_function_event_callback(remove_self_on_first_event, &deletedEvents);
+
+	// Deleting a partner reports it synchronously, and the callback removing itself must not deadlock
+	isobus::PartneredControlFunction *firstPartner = new isobus::PartneredControlFunction(5, { vtFilter });
+	delete firstPartner;
+	EXPECT_EQ(1u, deletedEvents);
+
+	isobus::PartneredControlFunction *secondPartner = new isobus::PartneredControlFunction(5, { vtFilter });
+	delete secondPartner;
+	EXPECT_EQ(1u, deletedEvents);
+}
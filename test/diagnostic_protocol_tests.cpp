@@ -0,0 +1,332 @@
+#include <gtest/gtest.h>
+
+#include "isobus/hardware_integration/can_hardware_interface.hpp"
+#include "isobus/hardware_integration/virtual_can_plugin.hpp"
+#include "isobus/isobus/can_general_parameter_group_numbers.hpp"
+#include "isobus/isobus/can_identifier.hpp"
+#include "isobus/isobus/can_internal_control_function.hpp"
+#include "isobus/isobus/can_network_manager.hpp"
+#include "isobus/isobus/isobus_diagnostic_protocol.hpp"
+#include "isobus/utility/system_timing.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace isobus;
+
+static constexpr std::uint8_t TEST_CAN_PORT = 0;
+static constexpr std::uint8_t TEST_ECU_ADDRESS = 0x1D;
+static constexpr std::uint8_t TEST_REQUESTER_ADDRESS = 0x82;
+static constexpr std::uint32_t TP_COMMAND_PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::TransportProtocolCommand);
+static constexpr std::uint32_t TP_DATA_PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::TransportProtocolData);
+
+static std::mutex sentFramesMutex;
+static std::vector<HardwareInterfaceCANFrame> sentFrames;
+
+static void record_sent_frame(HardwareInterfaceCANFrame &frame, void *)
+{
+	const std::lock_guard<std::mutex> lock(sentFramesMutex);
+	sentFrames.push_back(frame);
+}
+
+static void clear_sent_frames()
+{
+	const std::lock_guard<std::mutex> lock(sentFramesMutex);
+	sentFrames.clear();
+}
+
+static void receive_frame(std::uint32_t pgn, std::uint8_t destinationAddress, const std::uint8_t *data)
+{
+	HardwareInterfaceCANFrame frame;
+
+	frame.timestamp_us = 0;
+	frame.identifier = CANIdentifier(CANIdentifier::Type::Extended, pgn, CANIdentifier::CANPriority::PriorityDefault6, destinationAddress, TEST_REQUESTER_ADDRESS).get_identifier();
+	frame.channel = TEST_CAN_PORT;
+	std::memcpy(frame.data, data, sizeof(frame.data));
+	frame.dataLength = 8;
+	frame.isExtendedFrame = true;
+	CANNetworkManager::CANNetwork.can_lib_process_rx_message(frame, nullptr);
+	CANNetworkManager::CANNetwork.update();
+}
+
+static void request_pgn(std::uint32_t pgn)
+{
+	const std::uint8_t request[8] = { static_cast<std::uint8_t>(pgn & 0xFF), static_cast<std::uint8_t>((pgn >> 8) & 0xFF), static_cast<std::uint8_t>(pgn >> 16), 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+	receive_frame(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ParameterGroupNumberRequest), TEST_ECU_ADDRESS, request);
+}
+
+// Reassembles the messages with a PGN that the test ECU sent, from single frames and BAM sessions
+static std::vector<std::vector<std::uint8_t>> get_sent_messages(std::uint32_t pgn)
+{
+	const std::lock_guard<std::mutex> lock(sentFramesMutex);
+	std::vector<std::vector<std::uint8_t>> retVal;
+	std::uint32_t broadcastSize = 0;
+	bool collecting = false;
+
+	for (const auto &frame : sentFrames)
+	{
+		const CANIdentifier identifier(frame.identifier);
+		const std::uint32_t framePGN = identifier.get_parameter_group_number();
+
+		if (TEST_ECU_ADDRESS != identifier.get_source_address())
+		{
+			// Not sent by the test ECU
+		}
+		else if (pgn == framePGN)
+		{
+			retVal.emplace_back(frame.data, frame.data + frame.dataLength);
+		}
+		else if ((TP_COMMAND_PGN == framePGN) &&
+		         (32 == frame.data[0]))
+		{
+			collecting = (pgn == (static_cast<std::uint32_t>(frame.data[5]) | (static_cast<std::uint32_t>(frame.data[6]) << 8) | (static_cast<std::uint32_t>(frame.data[7]) << 16)));
+			if (collecting)
+			{
+				broadcastSize = static_cast<std::uint32_t>(frame.data[1]) | (static_cast<std::uint32_t>(frame.data[2]) << 8);
+				retVal.emplace_back();
+			}
+		}
+		else if ((TP_DATA_PGN == framePGN) &&
+		         (collecting))
+		{
+			std::vector<std::uint8_t> &message = retVal.back();
+
+			message.insert(message.end(), frame.data + 1, frame.data + 8);
+			if (message.size() >= broadcastSize)
+			{
+				message.resize(broadcastSize);
+				collecting = false;
+			}
+		}
+	}
+
+	// A broadcast that is still running isn't a message yet
+	if (collecting)
+	{
+		retVal.pop_back();
+	}
+	return retVal;
+}
+
+// Runs the network until the test ECU has sent a message with a PGN, and returns the last one it sent
+static std::vector<std::uint8_t> wait_for_sent_message(std::uint32_t pgn)
+{
+	const std::uint32_t startTime_ms = SystemTiming::get_timestamp_ms();
+	std::vector<std::vector<std::uint8_t>> messages = get_sent_messages(pgn);
+
+	while ((messages.empty()) &&
+	       (!SystemTiming::time_expired_ms(startTime_ms, 3000)))
+	{
+		CANNetworkManager::CANNetwork.update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		messages = get_sent_messages(pgn);
+	}
+	return messages.empty() ? std::vector<std::uint8_t>() : messages.back();
+}
+
+// Sets up the bus, a claimed test ECU with the diagnostic protocol, and a requester that has claimed its address
+class DiagnosticTestNetwork
+{
+public:
+	DiagnosticTestNetwork() :
+	  diagnosticProtocol(nullptr)
+	{
+		clear_sent_frames();
+		// A channel keeps the frame handler an earlier test assigned to it, so start from no channels
+		CANHardwareInterface::set_number_of_can_channels(0);
+		CANHardwareInterface::set_number_of_can_channels(1);
+		EXPECT_TRUE(CANHardwareInterface::assign_can_channel_frame_handler(TEST_CAN_PORT, std::make_shared<VirtualCANPlugin>("", true)));
+		CANHardwareInterface::add_raw_can_message_rx_callback(record_sent_frame, nullptr);
+		CANHardwareInterface::start();
+
+		// The first update initializes the network manager, which clears the receive queue
+		CANNetworkManager::CANNetwork.update();
+
+		NAME ecuNAME(0);
+		ecuNAME.set_arbitrary_address_capable(true);
+		ecuNAME.set_industry_group(1);
+		ecuNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::DriveAxleControlBrakes));
+		ecuNAME.set_identity_number(420);
+		ecuNAME.set_manufacturer_code(69);
+		internalECU = std::make_shared<InternalControlFunction>(ecuNAME, TEST_ECU_ADDRESS, TEST_CAN_PORT);
+		EXPECT_TRUE(DiagnosticProtocol::assign_diagnostic_protocol_to_internal_control_function(internalECU));
+		diagnosticProtocol = DiagnosticProtocol::get_diagnostic_protocol_by_internal_control_function(internalECU);
+
+		NAME requesterNAME(0);
+		requesterNAME.set_arbitrary_address_capable(true);
+		requesterNAME.set_industry_group(1);
+		requesterNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::OnboardDiagnosticUnit));
+		requesterNAME.set_identity_number(421);
+		requesterNAME.set_manufacturer_code(69);
+		std::uint8_t addressClaim[8];
+		for (std::uint8_t i = 0; i < 8; i++)
+		{
+			addressClaim[i] = static_cast<std::uint8_t>(requesterNAME.get_full_name() >> (8 * i));
+		}
+		receive_frame(static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim), 0xFF, addressClaim);
+
+		const std::uint32_t startTime_ms = SystemTiming::get_timestamp_ms();
+		while ((!internalECU->get_address_valid()) &&
+		       (!SystemTiming::time_expired_ms(startTime_ms, 2000)))
+		{
+			CANNetworkManager::CANNetwork.update();
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		clear_sent_frames();
+	}
+
+	~DiagnosticTestNetwork()
+	{
+		DiagnosticProtocol::deassign_diagnostic_protocol_to_internal_control_function(internalECU);
+		CANHardwareInterface::stop();
+		CANHardwareInterface::remove_raw_can_message_rx_callback(record_sent_frame, nullptr);
+	}
+
+	std::shared_ptr<InternalControlFunction> internalECU;
+	DiagnosticProtocol *diagnosticProtocol;
+};
+
+TEST(DIAGNOSTIC_PROTOCOL_TESTS, TogglesDiagnosticTroubleCodes)
+{
+	NAME TestDeviceNAME(0);
+	TestDeviceNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::DriveAxleControlBrakes));
+	auto TestInternalECU = std::make_shared<InternalControlFunction>(TestDeviceNAME, 0x1C, 0);
+
+	ASSERT_TRUE(DiagnosticProtocol::assign_diagnostic_protocol_to_internal_control_function(TestInternalECU));
+	DiagnosticProtocol *diagnosticProtocol = DiagnosticProtocol::get_diagnostic_protocol_by_internal_control_function(TestInternalECU);
+	ASSERT_NE(nullptr, diagnosticProtocol);
+
+	const DiagnosticProtocol::DiagnosticTroubleCode firstDTC(1234, DiagnosticProtocol::FailureModeIdentifier::ConditionExists, DiagnosticProtocol::LampStatus::None);
+	const DiagnosticProtocol::DiagnosticTroubleCode secondDTC(1234, DiagnosticProtocol::FailureModeIdentifier::ConditionExists, DiagnosticProtocol::LampStatus::AmberWarningLampSolid);
+
+	EXPECT_FALSE(diagnosticProtocol->set_diagnostic_trouble_code_active(firstDTC, false));
+	EXPECT_TRUE(diagnosticProtocol->set_diagnostic_trouble_code_active(firstDTC, true));
+	EXPECT_FALSE(diagnosticProtocol->set_diagnostic_trouble_code_active(firstDTC, true));
+	EXPECT_TRUE(diagnosticProtocol->get_diagnostic_trouble_code_active(firstDTC));
+	EXPECT_FALSE(diagnosticProtocol->get_diagnostic_trouble_code_active(secondDTC));
+
+	EXPECT_TRUE(diagnosticProtocol->set_diagnostic_trouble_code_active(secondDTC, true));
+	EXPECT_TRUE(diagnosticProtocol->set_diagnostic_trouble_code_active(firstDTC, false));
+	EXPECT_FALSE(diagnosticProtocol->get_diagnostic_trouble_code_active(firstDTC));
+	EXPECT_TRUE(diagnosticProtocol->get_diagnostic_trouble_code_active(secondDTC));
+
+	diagnosticProtocol->clear_active_diagnostic_trouble_codes();
+	EXPECT_FALSE(diagnosticProtocol->get_diagnostic_trouble_code_active(secondDTC));
+	EXPECT_TRUE(diagnosticProtocol->set_diagnostic_trouble_code_active(secondDTC, true));
+	EXPECT_TRUE(diagnosticProtocol->get_diagnostic_trouble_code_active(secondDTC));
+
+	EXPECT_TRUE(DiagnosticProtocol::deassign_diagnostic_protocol_to_internal_control_function(TestInternalECU));
+}
+
+TEST(DIAGNOSTIC_PROTOCOL_TESTS, EncodesDTCListsAgainOnlyWhenTheyChange)
+{
+	DiagnosticTestNetwork network;
+	const std::uint32_t dm1PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage1);
+	const std::uint32_t dm2PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage2);
+	const DiagnosticProtocol::DiagnosticTroubleCode amberDTC(1234, DiagnosticProtocol::FailureModeIdentifier::ConditionExists, DiagnosticProtocol::LampStatus::AmberWarningLampSolid);
+	const DiagnosticProtocol::DiagnosticTroubleCode redDTC(0x7FFFE, DiagnosticProtocol::FailureModeIdentifier::VoltageAboveNormal, DiagnosticProtocol::LampStatus::RedStopLampSlowFlash);
+
+	ASSERT_TRUE(network.internalECU->get_address_valid());
+	ASSERT_NE(nullptr, network.diagnosticProtocol);
+	network.diagnosticProtocol->set_j1939_mode(true);
+
+	// No DTCs is sent as one all zero DTC, and lamps that are off are encoded as not flashing
+	request_pgn(dm2PGN);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0x00, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF }), wait_for_sent_message(dm2PGN));
+
+	// A DTC moving to the previously active list changes the cached DM2, lamp bytes included
+	EXPECT_TRUE(network.diagnosticProtocol->set_diagnostic_trouble_code_active(amberDTC, true));
+	EXPECT_TRUE(network.diagnosticProtocol->set_diagnostic_trouble_code_active(amberDTC, false));
+	clear_sent_frames();
+	request_pgn(dm2PGN);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0x04, 0xFF, 0xD2, 0x04, 0x1F, 0x01, 0xFF, 0xFF }), wait_for_sent_message(dm2PGN));
+
+	// Asking again sends the same bytes
+	clear_sent_frames();
+	request_pgn(dm2PGN);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0x04, 0xFF, 0xD2, 0x04, 0x1F, 0x01, 0xFF, 0xFF }), wait_for_sent_message(dm2PGN));
+
+	// Two DTCs don't fit in one frame. The slow flashing red lamp sets its flash bits to 00.
+	EXPECT_TRUE(network.diagnosticProtocol->set_diagnostic_trouble_code_active(redDTC, true));
+	EXPECT_TRUE(network.diagnosticProtocol->set_diagnostic_trouble_code_active(redDTC, false));
+	clear_sent_frames();
+	request_pgn(dm2PGN);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0x14, 0xCF, 0xD2, 0x04, 0x1F, 0x01, 0xFE, 0xFF, 0xE3, 0x01 }), wait_for_sent_message(dm2PGN));
+
+	// An ISO 11783 DM2 has no lamp bytes, so changing the mode encodes it again
+	network.diagnosticProtocol->set_j1939_mode(false);
+	clear_sent_frames();
+	request_pgn(dm2PGN);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0xFF, 0xFF, 0xD2, 0x04, 0x1F, 0x01, 0xFE, 0xFF, 0xE3, 0x01 }), wait_for_sent_message(dm2PGN));
+
+	// The DTC returning to the active list counts another occurrence, and changes both DM1 and DM2
+	network.diagnosticProtocol->set_j1939_mode(true);
+	EXPECT_TRUE(network.diagnosticProtocol->set_diagnostic_trouble_code_active(amberDTC, true));
+	clear_sent_frames();
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0x04, 0xFF, 0xD2, 0x04, 0x1F, 0x02, 0xFF, 0xFF }), wait_for_sent_message(dm1PGN));
+	request_pgn(dm2PGN);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0x10, 0xCF, 0xFE, 0xFF, 0xE3, 0x01, 0xFF, 0xFF }), wait_for_sent_message(dm2PGN));
+}
+
+TEST(DIAGNOSTIC_PROTOCOL_TESTS, SendsRequestedIdentificationMessages)
+{
+	DiagnosticTestNetwork network;
+	const std::uint32_t ecuIdentificationPGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUIdentificationInformation);
+	const std::uint32_t productIdentificationPGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::ProductIdentification);
+	const std::uint32_t softwareIdentificationPGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::SoftwareIdentification);
+	const std::uint32_t diagnosticProtocolIdentificationPGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticProtocolIdentification);
+
+	ASSERT_TRUE(network.internalECU->get_address_valid());
+	ASSERT_NE(nullptr, network.diagnosticProtocol);
+
+	// Every ECU ID field starts out empty, so only its delimiter is sent
+	request_pgn(ecuIdentificationPGN);
+	EXPECT_EQ((std::vector<std::uint8_t>{ '*', '*', '*', '*', '*', '*' }), wait_for_sent_message(ecuIdentificationPGN));
+
+	// NumberOfFields isn't a field, so setting it changes nothing
+	network.diagnosticProtocol->set_ecu_id_field(DiagnosticProtocol::ECUIdentificationFields::NumberOfFields, "Nope");
+	network.diagnosticProtocol->set_ecu_id_field(DiagnosticProtocol::ECUIdentificationFields::PartNumber, "PN-1234");
+	network.diagnosticProtocol->set_ecu_id_field(DiagnosticProtocol::ECUIdentificationFields::SerialNumber, "SN99");
+	const std::string ecuIdentification = "PN-1234*SN99*****";
+	clear_sent_frames();
+	request_pgn(ecuIdentificationPGN);
+	EXPECT_EQ(std::vector<std::uint8_t>(ecuIdentification.begin(), ecuIdentification.end()), wait_for_sent_message(ecuIdentificationPGN));
+
+	// The transfer reads from the payload it started with, so a change while it runs doesn't reach the bus
+	clear_sent_frames();
+	request_pgn(ecuIdentificationPGN);
+	network.diagnosticProtocol->set_ecu_id_field(DiagnosticProtocol::ECUIdentificationFields::Location, "Cab");
+	EXPECT_EQ(std::vector<std::uint8_t>(ecuIdentification.begin(), ecuIdentification.end()), wait_for_sent_message(ecuIdentificationPGN));
+
+	const std::string newECUIdentification = "PN-1234*SN99*Cab****";
+	clear_sent_frames();
+	request_pgn(ecuIdentificationPGN);
+	EXPECT_EQ(std::vector<std::uint8_t>(newECUIdentification.begin(), newECUIdentification.end()), wait_for_sent_message(ecuIdentificationPGN));
+
+	// Product ID fits in one frame until it is filled in
+	request_pgn(productIdentificationPGN);
+	EXPECT_EQ((std::vector<std::uint8_t>{ '*', '*', '*' }), wait_for_sent_message(productIdentificationPGN));
+
+	EXPECT_TRUE(network.diagnosticProtocol->set_product_identification_code("1234"));
+	EXPECT_TRUE(network.diagnosticProtocol->set_product_identification_brand("Open"));
+	EXPECT_TRUE(network.diagnosticProtocol->set_product_identification_model("Agi"));
+	const std::string productIdentification = "1234*Open*Agi*";
+	clear_sent_frames();
+	request_pgn(productIdentificationPGN);
+	EXPECT_EQ(std::vector<std::uint8_t>(productIdentification.begin(), productIdentification.end()), wait_for_sent_message(productIdentificationPGN));
+
+	network.diagnosticProtocol->set_software_id_field(0, "1.0");
+	network.diagnosticProtocol->set_software_id_field(1, "Build 42");
+	const std::string softwareIdentification = "1.0*Build 42*";
+	request_pgn(softwareIdentificationPGN);
+	EXPECT_EQ(std::vector<std::uint8_t>(softwareIdentification.begin(), softwareIdentification.end()), wait_for_sent_message(softwareIdentificationPGN));
+
+	// Only J1939-73 is supported
+	request_pgn(diagnosticProtocolIdentificationPGN);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }), wait_for_sent_message(diagnosticProtocolIdentificationPGN));
+}
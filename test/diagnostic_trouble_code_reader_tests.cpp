@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include "isobus/isobus/can_general_parameter_group_numbers.hpp"
+#include "isobus/isobus/can_identifier.hpp"
+#include "isobus/isobus/can_network_manager.hpp"
+#include "isobus/isobus/isobus_diagnostic_trouble_code_reader.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace isobus;
+
+static constexpr std::uint8_t TEST_CAN_PORT = 3;
+static constexpr std::uint8_t TEST_SOURCE_ADDRESS = 0x45;
+
+struct ReaderTestContext
+{
+	DiagnosticTroubleCodeReader *reader;
+	std::vector<DiagnosticTroubleCodeReader::DTCEvent> events;
+	std::uint32_t selfRemovingCalls;
+};
+
+static void record_dtc_event(const DiagnosticTroubleCodeReader::DTCEvent &event, void *parentPointer)
+{
+	static_cast<ReaderTestContext *>(parentPointer)->events.push_back(event);
+}
+
+static void remove_self_on_first_event(const DiagnosticTroubleCodeReader::DTCEvent &, void *parentPointer)
+{
+	ReaderTestContext *context = static_cast<ReaderTestContext *>(parentPointer);
+
+	context->selfRemovingCalls++;
+	context->reader->remove_dtc_event_callback(remove_self_on_first_event, parentPointer);
+}
+
+static void receive_frame(std::uint32_t pgn, std::uint8_t destinationAddress, const std::uint8_t *data, std::uint8_t dataLength)
+{
+	HardwareInterfaceCANFrame frame;
+
+	frame.timestamp_us = 0;
+	frame.identifier = CANIdentifier(CANIdentifier::Type::Extended, pgn, CANIdentifier::CANPriority::PriorityDefault6, destinationAddress, TEST_SOURCE_ADDRESS).get_identifier();
+	frame.channel = TEST_CAN_PORT;
+	std::memset(frame.data, 0xFF, sizeof(frame.data));
+	std::memcpy(frame.data, data, dataLength);
+	frame.dataLength = dataLength;
+	frame.isExtendedFrame = true;
+	CANNetworkManager::CANNetwork.can_lib_process_rx_message(frame, nullptr);
+	CANNetworkManager::CANNetwork.update();
+}
+
+static void receive_with_bam(std::uint32_t pgn, const std::vector<std::uint8_t> &payload)
+{
+	const std::uint8_t numberOfPackets = static_cast<std::uint8_t>((payload.size() + 6) / 7);
+	const std::uint8_t announce[8] = { 32, static_cast<std::uint8_t>(payload.size() & 0xFF), static_cast<std::uint8_t>(payload.size() >> 8), numberOfPackets, 0xFF, static_cast<std::uint8_t>(pgn & 0xFF), static_cast<std::uint8_t>((pgn >> 8) & 0xFF), static_cast<std::uint8_t>(pgn >> 16) };
+
+	receive_frame(static_cast<std::uint32_t>(CANLibParameterGroupNumber::TransportProtocolCommand), 0xFF, announce, 8);
+	for (std::uint8_t i = 0; i < numberOfPackets; i++)
+	{
+		std::uint8_t packet[8] = { static_cast<std::uint8_t>(i + 1), 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+		for (std::size_t j = 0; (j < 7) && ((i * 7u + j) < payload.size()); j++)
+		{
+			packet[1 + j] = payload[i * 7u + j];
+		}
+		receive_frame(static_cast<std::uint32_t>(CANLibParameterGroupNumber::TransportProtocolData), 0xFF, packet, 8);
+	}
+}
+
+static void append_dtc(std::vector<std::uint8_t> &payload, std::uint32_t spn, std::uint8_t fmi, std::uint8_t occurrenceCount)
+{
+	payload.push_back(static_cast<std::uint8_t>(spn & 0xFF));
+	payload.push_back(static_cast<std::uint8_t>((spn >> 8) & 0xFF));
+	payload.push_back(static_cast<std::uint8_t>(((spn >> 16) << 5) | (fmi & 0x1F)));
+	payload.push_back(occurrenceCount & 0x7F);
+}
+
+TEST(DIAGNOSTIC_TROUBLE_CODE_READER_TESTS, ReportsSingleFrameMultiFrameAndTimedOutDTCs)
+{
+	const std::uint32_t dm1PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage1);
+	const std::uint32_t dm2PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage2);
+	DiagnosticTroubleCodeReader reader;
+	ReaderTestContext context = { &reader, {}, 0 };
+	std::vector<DiagnosticTroubleCodeReader::ReceivedDTC> dtcs;
+	std::uint16_t lampStatus = 0;
+
+	reader.add_dtc_event_callback(record_dtc_event, &context);
+	reader.add_dtc_event_callback(remove_self_on_first_event, &context);
+
+	// The first update initializes the network manager, which clears the receive queue
+	CANNetworkManager::CANNetwork.update();
+
+	// BAM needs the source to have claimed its address
+	const std::uint8_t addressClaim[8] = { 0x01, 0x00, 0x00, 0x00, 0x00, 0x81, 0x00, 0xA0 };
+	receive_frame(static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim), 0xFF, addressClaim, 8);
+
+	std::vector<std::uint8_t> payload = { 0x04, 0xFF };
+	append_dtc(payload, 1234, 3, 1);
+	receive_frame(dm1PGN, 0xFF, payload.data(), static_cast<std::uint8_t>(payload.size()));
+
+	ASSERT_EQ(1u, context.events.size());
+	EXPECT_EQ(DiagnosticTroubleCodeReader::DTCEventType::Added, context.events[0].type);
+	EXPECT_EQ(DiagnosticTroubleCodeReader::DTCListType::Active, context.events[0].list);
+	EXPECT_EQ(TEST_CAN_PORT, context.events[0].canPort);
+	EXPECT_EQ(TEST_SOURCE_ADDRESS, context.events[0].sourceAddress);
+	EXPECT_EQ(1234u, context.events[0].dtc.suspectParameterNumber);
+	EXPECT_EQ(3, context.events[0].dtc.failureModeIdentifier);
+	EXPECT_EQ(1u, context.selfRemovingCalls);
+	EXPECT_TRUE(reader.get_lamp_status(TEST_CAN_PORT, TEST_SOURCE_ADDRESS, lampStatus));
+	EXPECT_EQ(0xFF04, lampStatus);
+
+	// Three DTCs don't fit in one frame, so they arrive with BAM
+	payload = { 0x04, 0xFF };
+	append_dtc(payload, 1234, 3, 2);
+	append_dtc(payload, 0x7FFFE, 31, 1);
+	append_dtc(payload, 520192, 12, 4);
+	context.events.clear();
+	receive_with_bam(dm1PGN, payload);
+
+	ASSERT_EQ(3u, context.events.size());
+	EXPECT_EQ(DiagnosticTroubleCodeReader::DTCEventType::OccurrenceCountChanged, context.events[0].type);
+	EXPECT_EQ(2, context.events[0].dtc.occurrenceCount);
+	EXPECT_EQ(DiagnosticTroubleCodeReader::DTCEventType::Added, context.events[1].type);
+	EXPECT_EQ(0x7FFFEu, context.events[1].dtc.suspectParameterNumber);
+	EXPECT_EQ(DiagnosticTroubleCodeReader::DTCEventType::Added, context.events[2].type);
+	EXPECT_EQ(520192u, context.events[2].dtc.suspectParameterNumber);
+	EXPECT_EQ(12, context.events[2].dtc.failureModeIdentifier);
+	EXPECT_EQ(1u, context.selfRemovingCalls);
+	EXPECT_TRUE(reader.get_dtcs(TEST_CAN_PORT, TEST_SOURCE_ADDRESS, DiagnosticTroubleCodeReader::DTCListType::Active, dtcs));
+	EXPECT_EQ(3u, dtcs.size());
+
+	payload = { 0x00, 0xFF };
+	append_dtc(payload, 100, 1, 1);
+	append_dtc(payload, 200, 2, 1);
+	context.events.clear();
+	receive_with_bam(dm2PGN, payload);
+
+	ASSERT_EQ(2u, context.events.size());
+	EXPECT_EQ(DiagnosticTroubleCodeReader::DTCListType::PreviouslyActive, context.events[0].list);
+	EXPECT_EQ(100u, context.events[0].dtc.suspectParameterNumber);
+	EXPECT_EQ(200u, context.events[1].dtc.suspectParameterNumber);
+	EXPECT_TRUE(reader.get_dtcs(TEST_CAN_PORT, TEST_SOURCE_ADDRESS, DiagnosticTroubleCodeReader::DTCListType::PreviouslyActive, dtcs));
+	EXPECT_EQ(2u, dtcs.size());
+
+	context.events.clear();
+	reader.update();
+	EXPECT_TRUE(context.events.empty());
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(DiagnosticTroubleCodeReader::DM1_TIMEOUT_MS + 100));
+	reader.update();
+
+	ASSERT_EQ(3u, context.events.size());
+	for (const auto &event : context.events)
+	{
+		EXPECT_EQ(DiagnosticTroubleCodeReader::DTCEventType::Removed, event.type);
+		EXPECT_EQ(DiagnosticTroubleCodeReader::DTCListType::Active, event.list);
+	}
+	EXPECT_TRUE(reader.get_dtcs(TEST_CAN_PORT, TEST_SOURCE_ADDRESS, DiagnosticTroubleCodeReader::DTCListType::Active, dtcs));
+	EXPECT_TRUE(dtcs.empty());
+	EXPECT_TRUE(reader.get_dtcs(TEST_CAN_PORT, TEST_SOURCE_ADDRESS, DiagnosticTroubleCodeReader::DTCListType::PreviouslyActive, dtcs));
+	EXPECT_EQ(2u, dtcs.size());
+
+	reader.remove_dtc_event_callback(record_dtc_event, &context);
+}
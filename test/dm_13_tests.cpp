@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
+#include "isobus/isobus/can_general_parameter_group_numbers.hpp"
 #include "isobus/isobus/can_managed_message.hpp"
+#include "isobus/isobus/can_network_manager.hpp"
 #include "isobus/isobus/isobus_diagnostic_protocol.hpp"
 
 using namespace isobus;
@@ -32,3 +34,25 @@ TEST(DM13_TESTS, TestInvalidDM13Rejection)
 	testDM13Message.set_data_size(4);
 	EXPECT_EQ(false, DiagnosticProtocol::parse_j1939_network_states(&testDM13Message, testNetworkStates));
 }
+
+TEST(DM13_TESTS, BroadcastGateHonoursExemptions)
+{
+	const std::uint32_t dm1PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::DiagnosticMessage1);
+	const std::uint32_t exemptPGN = 0xFF00;
+
+	EXPECT_TRUE(CANNetworkManager::CANNetwork.get_is_broadcast_allowed(0, dm1PGN));
+
+	CANNetworkManager::CANNetwork.suspend_broadcasts(0, 0);
+	CANNetworkManager::CANNetwork.add_broadcast_suspension_exemption(exemptPGN);
+	EXPECT_TRUE(CANNetworkManager::CANNetwork.get_are_broadcasts_suspended(0));
+	EXPECT_FALSE(CANNetworkManager::CANNetwork.get_is_broadcast_allowed(0, dm1PGN));
+	EXPECT_TRUE(CANNetworkManager::CANNetwork.get_is_broadcast_allowed(0, exemptPGN));
+	EXPECT_TRUE(CANNetworkManager::CANNetwork.get_is_broadcast_allowed(1, dm1PGN));
+
+	CANNetworkManager::CANNetwork.remove_broadcast_suspension_exemption(exemptPGN);
+	EXPECT_FALSE(CANNetworkManager::CANNetwork.get_is_broadcast_allowed(0, exemptPGN));
+
+	CANNetworkManager::CANNetwork.resume_broadcasts(0);
+	EXPECT_FALSE(CANNetworkManager::CANNetwork.get_are_broadcasts_suspended(0));
+	EXPECT_TRUE(CANNetworkManager::CANNetwork.get_is_broadcast_allowed(0, dm1PGN));
+}
@@ -0,0 +1,384 @@
+#include <gtest/gtest.h>
+
+#include "isobus/hardware_integration/can_hardware_interface.hpp"
+#include "isobus/hardware_integration/virtual_can_plugin.hpp"
+#include "isobus/isobus/can_NAME_filter.hpp"
+#include "isobus/isobus/can_general_parameter_group_numbers.hpp"
+#include "isobus/isobus/can_identifier.hpp"
+#include "isobus/isobus/can_internal_control_function.hpp"
+#include "isobus/isobus/can_network_manager.hpp"
+#include "isobus/isobus/can_parameter_group_number_request_protocol.hpp"
+#include "isobus/isobus/can_partnered_control_function.hpp"
+#include "isobus/utility/system_timing.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace isobus;
+
+static constexpr std::uint8_t TEST_CAN_PORT = 0;
+static constexpr std::uint8_t TEST_REQUESTER_ADDRESS = 0x81;
+static constexpr std::uint32_t TEST_PERIODIC_PGN = 0xFF20;
+static constexpr std::uint32_t TEST_BROADCAST_PGN = 0xFF21;
+
+struct PeriodicTestContext
+{
+	std::vector<ControlFunction *> destinations;
+};
+
+static bool record_periodic_transmission(std::uint32_t, ControlFunction *destinationControlFunction, void *parentPointer)
+{
+	static_cast<PeriodicTestContext *>(parentPointer)->destinations.push_back(destinationControlFunction);
+	return true;
+}
+
+struct RequestTestContext
+{
+	std::vector<std::uint32_t> pgns;
+	std::vector<ControlFunction *> requesters;
+	std::vector<std::uint32_t> timestamps_ms;
+};
+
+static bool record_pgn_request(std::uint32_t parameterGroupNumber, ControlFunction *requestingControlFunction, bool &acknowledge, AcknowledgementType &, void *parentPointer)
+{
+	RequestTestContext *context = static_cast<RequestTestContext *>(parentPointer);
+
+	context->pgns.push_back(parameterGroupNumber);
+	context->requesters.push_back(requestingControlFunction);
+	context->timestamps_ms.push_back(SystemTiming::get_timestamp_ms());
+	acknowledge = false;
+	return true;
+}
+
+static void receive_frame(std::uint32_t pgn, std::uint8_t destinationAddress, const std::uint8_t *data)
+{
+	HardwareInterfaceCANFrame frame;
+
+	frame.timestamp_us = 0;
+	frame.identifier = CANIdentifier(CANIdentifier::Type::Extended, pgn, CANIdentifier::CANPriority::PriorityDefault6, destinationAddress, TEST_REQUESTER_ADDRESS).get_identifier();
+	frame.channel = TEST_CAN_PORT;
+	std::memcpy(frame.data, data, sizeof(frame.data));
+	frame.dataLength = 8;
+	frame.isExtendedFrame = true;
+	CANNetworkManager::CANNetwork.can_lib_process_rx_message(frame, nullptr);
+	CANNetworkManager::CANNetwork.update();
+}
+
+// Updates the network until the internal control function has claimed its address
+static bool wait_for_address_claim(const InternalControlFunction &internalControlFunction)
+{
+	const std::uint32_t startTime_ms = SystemTiming::get_timestamp_ms();
+
+	while ((!internalControlFunction.get_address_valid()) &&
+	       (!SystemTiming::time_expired_ms(startTime_ms, 2000)))
+	{
+		CANNetworkManager::CANNetwork.update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	return internalControlFunction.get_address_valid();
+}
+
+static void request_repetition_rate(std::uint8_t destinationAddress, std::uint32_t pgn, std::uint16_t rate_ms)
+{
+	const std::uint8_t request[8] = { static_cast<std::uint8_t>(pgn & 0xFF), static_cast<std::uint8_t>((pgn >> 8) & 0xFF), static_cast<std::uint8_t>(pgn >> 16), static_cast<std::uint8_t>(rate_ms & 0xFF), static_cast<std::uint8_t>(rate_ms >> 8), 0xFF, 0xFF, 0xFF };
+
+	receive_frame(static_cast<std::uint32_t>(CANLibParameterGroupNumber::RequestForRepetitionRate), destinationAddress, request);
+}
+
+static void request_pgn(std::uint8_t destinationAddress, std::uint32_t pgn)
+{
+	const std::uint8_t request[8] = { static_cast<std::uint8_t>(pgn & 0xFF), static_cast<std::uint8_t>((pgn >> 8) & 0xFF), static_cast<std::uint8_t>(pgn >> 16), 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+	receive_frame(static_cast<std::uint32_t>(CANLibParameterGroupNumber::ParameterGroupNumberRequest), destinationAddress, request);
+}
+
+static void update_for(std::uint32_t duration_ms)
+{
+	const std::uint32_t startTime_ms = SystemTiming::get_timestamp_ms();
+
+	while (!SystemTiming::time_expired_ms(startTime_ms, duration_ms))
+	{
+		CANNetworkManager::CANNetwork.update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+TEST(PGN_REQUEST_PROTOCOL_TESTS, SchedulesRequestedRepetitionRates)
+{
+	// A channel keeps the frame handler an earlier test assigned to it, so start from no channels
+	CANHardwareInterface::set_number_of_can_channels(0);
+	CANHardwareInterface::set_number_of_can_channels(1);
+	EXPECT_TRUE(CANHardwareInterface::assign_can_channel_frame_handler(TEST_CAN_PORT, std::make_shared<VirtualCANPlugin>()));
+	CANHardwareInterface::start();
+
+	// The first update initializes the network manager, which clears the receive queue
+	CANNetworkManager::CANNetwork.update();
+
+	NAME internalNAME(0);
+	internalNAME.set_arbitrary_address_capable(true);
+	internalNAME.set_industry_group(1);
+	internalNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::HydraulicPumpControl));
+	internalNAME.set_identity_number(44);
+	internalNAME.set_manufacturer_code(69);
+	auto internalECU = std::make_shared<InternalControlFunction>(internalNAME, 0x1C, TEST_CAN_PORT);
+	ASSERT_TRUE(ParameterGroupNumberRequestProtocol::assign_pgn_request_protocol_to_internal_control_function(internalECU));
+	ParameterGroupNumberRequestProtocol *protocol = ParameterGroupNumberRequestProtocol::get_pgn_request_protocol_by_internal_control_function(internalECU);
+	ASSERT_NE(nullptr, protocol);
+	ASSERT_TRUE(wait_for_address_claim(*internalECU));
+
+	NAME requesterNAME(0);
+	requesterNAME.set_arbitrary_address_capable(true);
+	requesterNAME.set_industry_group(1);
+	requesterNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::ShiftControl));
+	requesterNAME.set_identity_number(45);
+	requesterNAME.set_manufacturer_code(69);
+	const std::uint64_t requesterRawNAME = requesterNAME.get_full_name();
+	std::uint8_t addressClaim[8];
+	for (std::uint8_t i = 0; i < 8; i++)
+	{
+		addressClaim[i] = static_cast<std::uint8_t>(requesterRawNAME >> (8 * i));
+	}
+
+	const NAMEFilter requesterFilter(NAME::NAMEParameters::FunctionCode, static_cast<std::uint8_t>(NAME::Function::ShiftControl));
+	PartneredControlFunction *requester = new PartneredControlFunction(TEST_CAN_PORT, { requesterFilter });
+	receive_frame(static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim), 0xFF, addressClaim);
+	ASSERT_TRUE(requester->get_address_valid());
+
+	// Without a default rate the PGN is only sent to requesters
+	PeriodicTestContext context;
+	ASSERT_TRUE(protocol->register_periodic_pgn(TEST_PERIODIC_PGN, 0, record_periodic_transmission, &context));
+	EXPECT_FALSE(protocol->register_periodic_pgn(TEST_PERIODIC_PGN, 0, record_periodic_transmission, &context));
+	EXPECT_EQ(0u, protocol->get_number_periodic_pgn_schedules());
+
+	request_repetition_rate(internalECU->get_address(), TEST_PERIODIC_PGN, 100);
+	EXPECT_EQ(1u, protocol->get_number_periodic_pgn_schedules());
+	update_for(550);
+
+	// Sent right away, then every 100 ms
+	ASSERT_GE(context.destinations.size(), 5u);
+	EXPECT_LE(context.destinations.size(), 7u);
+	for (const auto destination : context.destinations)
+	{
+		EXPECT_EQ(requester, destination);
+	}
+	ParameterGroupNumberRequestProtocol::PeriodicPGNStatistics statistics;
+	ASSERT_TRUE(protocol->get_periodic_pgn_statistics(TEST_PERIODIC_PGN, requester, statistics));
+	EXPECT_EQ(context.destinations.size(), statistics.numberOfTransmissions);
+	EXPECT_EQ(0u, statistics.numberOfFailedTransmissions);
+
+	// While broadcasts are suspended only the default rate broadcast stops, the requester still gets its rate
+	PeriodicTestContext broadcastContext;
+	ASSERT_TRUE(protocol->register_periodic_pgn(TEST_BROADCAST_PGN, 100, record_periodic_transmission, &broadcastContext));
+	CANNetworkManager::CANNetwork.suspend_broadcasts(TEST_CAN_PORT, 0);
+	context.destinations.clear();
+	update_for(350);
+	EXPECT_TRUE(broadcastContext.destinations.empty());
+	EXPECT_GE(context.destinations.size(), 3u);
+	CANNetworkManager::CANNetwork.resume_broadcasts(TEST_CAN_PORT);
+	update_for(150);
+	ASSERT_FALSE(broadcastContext.destinations.empty());
+	EXPECT_EQ(nullptr, broadcastContext.destinations[0]);
+	EXPECT_TRUE(protocol->remove_periodic_pgn(TEST_BROADCAST_PGN));
+
+	// A rate of 0xFFFF returns the requester to the default, which is no transmissions at all
+	request_repetition_rate(internalECU->get_address(), TEST_PERIODIC_PGN, ParameterGroupNumberRequestProtocol::DEFAULT_REPETITION_RATE);
+	EXPECT_EQ(0u, protocol->get_number_periodic_pgn_schedules());
+	context.destinations.clear();
+	update_for(250);
+	EXPECT_TRUE(context.destinations.empty());
+
+	// Deleting the requester drops its schedule before its memory is freed
+	request_repetition_rate(internalECU->get_address(), TEST_PERIODIC_PGN, 100);
+	EXPECT_EQ(1u, protocol->get_number_periodic_pgn_schedules());
+	delete requester;
+	EXPECT_EQ(0u, protocol->get_number_periodic_pgn_schedules());
+	context.destinations.clear();
+	update_for(250);
+	EXPECT_TRUE(context.destinations.empty());
+
+	EXPECT_TRUE(protocol->remove_periodic_pgn(TEST_PERIODIC_PGN));
+	EXPECT_TRUE(ParameterGroupNumberRequestProtocol::deassign_pgn_request_protocol_to_internal_control_function(internalECU));
+	CANHardwareInterface::stop();
+}
+
+TEST(PGN_REQUEST_PROTOCOL_TESTS, SpreadsResponsesToGlobalRequests)
+{
+	// A channel keeps the frame handler an earlier test assigned to it, so start from no channels
+	CANHardwareInterface::set_number_of_can_channels(0);
+	CANHardwareInterface::set_number_of_can_channels(1);
+	EXPECT_TRUE(CANHardwareInterface::assign_can_channel_frame_handler(TEST_CAN_PORT, std::make_shared<VirtualCANPlugin>()));
+	CANHardwareInterface::start();
+	CANNetworkManager::CANNetwork.update();
+
+	NAME internalNAME(0);
+	internalNAME.set_arbitrary_address_capable(true);
+	internalNAME.set_industry_group(1);
+	internalNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::HydraulicPumpControl));
+	internalNAME.set_identity_number(46);
+	internalNAME.set_manufacturer_code(69);
+	auto internalECU = std::make_shared<InternalControlFunction>(internalNAME, 0x1D, TEST_CAN_PORT);
+	ASSERT_TRUE(ParameterGroupNumberRequestProtocol::assign_pgn_request_protocol_to_internal_control_function(internalECU));
+	ParameterGroupNumberRequestProtocol *protocol = ParameterGroupNumberRequestProtocol::get_pgn_request_protocol_by_internal_control_function(internalECU);
+	ASSERT_NE(nullptr, protocol);
+	ASSERT_TRUE(wait_for_address_claim(*internalECU));
+
+	NAME requesterNAME(0);
+	requesterNAME.set_arbitrary_address_capable(true);
+	requesterNAME.set_industry_group(1);
+	requesterNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::ShiftControl));
+	requesterNAME.set_identity_number(47);
+	requesterNAME.set_manufacturer_code(69);
+	std::uint8_t addressClaim[8];
+	for (std::uint8_t i = 0; i < 8; i++)
+	{
+		addressClaim[i] = static_cast<std::uint8_t>(requesterNAME.get_full_name() >> (8 * i));
+	}
+
+	// The requester of the test above is still known to the network, so match this one by its identity number
+	const NAMEFilter requesterFilter(NAME::NAMEParameters::IdentityNumber, 47);
+	PartneredControlFunction *requester = new PartneredControlFunction(TEST_CAN_PORT, { requesterFilter });
+	receive_frame(static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim), 0xFF, addressClaim);
+	ASSERT_TRUE(requester->get_address_valid());
+
+	RequestTestContext context;
+	ASSERT_TRUE(protocol->register_pgn_request_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::Any), record_pgn_request, &context));
+
+	// A longer window is limited to the 200 ms J1939-21 allows for the response
+	protocol->set_global_response_spreading(1000, false);
+	std::uint32_t requestTimestamp_ms = SystemTiming::get_timestamp_ms();
+	request_pgn(0xFF, TEST_PERIODIC_PGN);
+	EXPECT_EQ(1u, protocol->get_number_pending_global_responses());
+	update_for(260);
+	ASSERT_EQ(1u, context.pgns.size());
+	EXPECT_EQ(TEST_PERIODIC_PGN, context.pgns[0]);
+	EXPECT_EQ(requester, context.requesters[0]);
+	EXPECT_LE(context.timestamps_ms[0] - requestTimestamp_ms, 210u);
+	EXPECT_EQ(0u, protocol->get_number_pending_global_responses());
+
+	// Identical global requests close together get one response
+	context.pgns.clear();
+	request_pgn(0xFF, TEST_BROADCAST_PGN);
+	request_pgn(0xFF, TEST_BROADCAST_PGN);
+	EXPECT_EQ(1u, protocol->get_number_pending_global_responses());
+	update_for(260);
+	EXPECT_EQ(1u, context.pgns.size());
+
+	// A request sent to us is answered right away, however recently it was asked for
+	context.pgns.clear();
+	request_pgn(internalECU->get_address(), TEST_BROADCAST_PGN);
+	request_pgn(internalECU->get_address(), TEST_BROADCAST_PGN);
+	EXPECT_EQ(2u, context.pgns.size());
+	EXPECT_EQ(0u, protocol->get_number_pending_global_responses());
+
+	// Deleting the requester drops its deferred responses before its memory is freed
+	context.pgns.clear();
+	request_pgn(0xFF, TEST_PERIODIC_PGN);
+	EXPECT_EQ(1u, protocol->get_number_pending_global_responses());
+	delete requester;
+	EXPECT_EQ(0u, protocol->get_number_pending_global_responses());
+	update_for(260);
+	EXPECT_TRUE(context.pgns.empty());
+
+	EXPECT_TRUE(protocol->remove_pgn_request_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::Any), record_pgn_request, &context));
+	EXPECT_TRUE(ParameterGroupNumberRequestProtocol::deassign_pgn_request_protocol_to_internal_control_function(internalECU));
+	CANHardwareInterface::stop();
+}
+
+TEST(PGN_REQUEST_PROTOCOL_TESTS, DispatchesRequestsToSpecificCallbacksFirst)
+{
+	// A channel keeps the frame handler an earlier test assigned to it, so start from no channels
+	CANHardwareInterface::set_number_of_can_channels(0);
+	CANHardwareInterface::set_number_of_can_channels(1);
+	EXPECT_TRUE(CANHardwareInterface::assign_can_channel_frame_handler(TEST_CAN_PORT, std::make_shared<VirtualCANPlugin>()));
+	CANHardwareInterface::start();
+	CANNetworkManager::CANNetwork.update();
+
+	NAME internalNAME(0);
+	internalNAME.set_arbitrary_address_capable(true);
+	internalNAME.set_industry_group(1);
+	internalNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::HydraulicPumpControl));
+	internalNAME.set_identity_number(48);
+	internalNAME.set_manufacturer_code(69);
+	auto internalECU = std::make_shared<InternalControlFunction>(internalNAME, 0x1E, TEST_CAN_PORT);
+	ASSERT_TRUE(ParameterGroupNumberRequestProtocol::assign_pgn_request_protocol_to_internal_control_function(internalECU));
+	ParameterGroupNumberRequestProtocol *protocol = ParameterGroupNumberRequestProtocol::get_pgn_request_protocol_by_internal_control_function(internalECU);
+	ASSERT_NE(nullptr, protocol);
+	ASSERT_TRUE(wait_for_address_claim(*internalECU));
+
+	NAME requesterNAME(0);
+	requesterNAME.set_arbitrary_address_capable(true);
+	requesterNAME.set_industry_group(1);
+	requesterNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::ShiftControl));
+	requesterNAME.set_identity_number(49);
+	requesterNAME.set_manufacturer_code(69);
+	std::uint8_t addressClaim[8];
+	for (std::uint8_t i = 0; i < 8; i++)
+	{
+		addressClaim[i] = static_cast<std::uint8_t>(requesterNAME.get_full_name() >> (8 * i));
+	}
+
+	// The requesters of the tests above are still known to the network, so match this one by its identity number
+	const NAMEFilter requesterFilter(NAME::NAMEParameters::IdentityNumber, 49);
+	PartneredControlFunction *requester = new PartneredControlFunction(TEST_CAN_PORT, { requesterFilter });
+	receive_frame(static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim), 0xFF, addressClaim);
+	ASSERT_TRUE(requester->get_address_valid());
+
+	// The wildcard is registered first, so the order below comes from the PGN and not from registration order
+	RequestTestContext wildcardContext;
+	RequestTestContext specificContext;
+	ASSERT_TRUE(protocol->register_pgn_request_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::Any), record_pgn_request, &wildcardContext));
+	ASSERT_TRUE(protocol->register_pgn_request_callback(TEST_BROADCAST_PGN, record_pgn_request, &specificContext));
+
+	// The same callback and parent can only be registered once per PGN
+	EXPECT_FALSE(protocol->register_pgn_request_callback(TEST_BROADCAST_PGN, record_pgn_request, &specificContext));
+	EXPECT_FALSE(protocol->register_pgn_request_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::Any), record_pgn_request, &wildcardContext));
+	EXPECT_EQ(2u, protocol->get_number_registered_pgn_request_callbacks());
+
+	// A callback for the requested PGN handles it, and the wildcard never sees it
+	request_pgn(internalECU->get_address(), TEST_BROADCAST_PGN);
+	ASSERT_EQ(1u, specificContext.pgns.size());
+	EXPECT_EQ(TEST_BROADCAST_PGN, specificContext.pgns[0]);
+	EXPECT_EQ(requester, specificContext.requesters[0]);
+	EXPECT_TRUE(wildcardContext.pgns.empty());
+
+	// Any other PGN goes to the wildcard
+	request_pgn(internalECU->get_address(), TEST_PERIODIC_PGN);
+	EXPECT_EQ(1u, specificContext.pgns.size());
+	ASSERT_EQ(1u, wildcardContext.pgns.size());
+	EXPECT_EQ(TEST_PERIODIC_PGN, wildcardContext.pgns[0]);
+
+	// Identical global requests within the deduplication window are answered once
+	wildcardContext.pgns.clear();
+	request_pgn(0xFF, TEST_PERIODIC_PGN);
+	request_pgn(0xFF, TEST_PERIODIC_PGN);
+	EXPECT_EQ(1u, wildcardContext.pgns.size());
+
+	// A request for another PGN isn't a duplicate, and a destination specific one never is
+	request_pgn(0xFF, TEST_BROADCAST_PGN);
+	request_pgn(internalECU->get_address(), TEST_PERIODIC_PGN);
+	request_pgn(internalECU->get_address(), TEST_PERIODIC_PGN);
+	EXPECT_EQ(2u, specificContext.pgns.size());
+	EXPECT_EQ(3u, wildcardContext.pgns.size());
+
+	// Once the window has passed the global request is answered again
+	update_for(ParameterGroupNumberRequestProtocol::REQUEST_DEDUPLICATION_WINDOW_MS + 20);
+	request_pgn(0xFF, TEST_PERIODIC_PGN);
+	EXPECT_EQ(4u, wildcardContext.pgns.size());
+
+	// Without its specific callback, the PGN falls through to the wildcard
+	EXPECT_TRUE(protocol->remove_pgn_request_callback(TEST_BROADCAST_PGN, record_pgn_request, &specificContext));
+	EXPECT_FALSE(protocol->remove_pgn_request_callback(TEST_BROADCAST_PGN, record_pgn_request, &specificContext));
+	EXPECT_EQ(1u, protocol->get_number_registered_pgn_request_callbacks());
+	request_pgn(internalECU->get_address(), TEST_BROADCAST_PGN);
+	EXPECT_EQ(2u, specificContext.pgns.size());
+	ASSERT_EQ(5u, wildcardContext.pgns.size());
+	EXPECT_EQ(TEST_BROADCAST_PGN, wildcardContext.pgns[4]);
+
+	EXPECT_TRUE(protocol->remove_pgn_request_callback(static_cast<std::uint32_t>(CANLibParameterGroupNumber::Any), record_pgn_request, &wildcardContext));
+	delete requester;
+	EXPECT_TRUE(ParameterGroupNumberRequestProtocol::deassign_pgn_request_protocol_to_internal_control_function(internalECU));
+	CANHardwareInterface::stop();
+}
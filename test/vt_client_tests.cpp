@@ -0,0 +1,699 @@
+#include <gtest/gtest.h>
+
+#include "isobus/hardware_integration/can_hardware_interface.hpp"
+#include "isobus/hardware_integration/virtual_can_plugin.hpp"
+#include "isobus/isobus/can_NAME_filter.hpp"
+#include "isobus/isobus/can_general_parameter_group_numbers.hpp"
+#include "isobus/isobus/can_identifier.hpp"
+#include "isobus/isobus/can_internal_control_function.hpp"
+#include "isobus/isobus/can_network_manager.hpp"
+#include "isobus/isobus/can_partnered_control_function.hpp"
+#include "isobus/isobus/isobus_virtual_terminal_client.hpp"
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_index.hpp"
+#include "isobus/utility/system_timing.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace isobus;
+
+static constexpr std::uint8_t TEST_CAN_PORT = 0;
+static constexpr std::uint8_t TEST_CLIENT_ADDRESS = 0x1C;
+static constexpr std::uint8_t TEST_VT_ADDRESS = 0x26;
+static constexpr std::uint32_t ECU_TO_VT_PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::ECUtoVirtualTerminal);
+static constexpr std::uint32_t VT_TO_ECU_PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::VirtualTerminalToECU);
+static constexpr std::uint32_t TP_COMMAND_PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::TransportProtocolCommand);
+static constexpr std::uint32_t TP_DATA_PGN = static_cast<std::uint32_t>(CANLibParameterGroupNumber::TransportProtocolData);
+
+// What the fake VT has seen of the messages the client sent to it
+struct FakeVTContext
+{
+	std::mutex sentFramesMutex;
+	std::vector<HardwareInterfaceCANFrame> sentFrames;
+	std::vector<std::vector<std::uint8_t>> receivedMessages;
+	std::vector<std::vector<std::uint8_t>> objectPoolTransfers;
+	std::string storedVersionLabel;
+	std::uint8_t version;
+	std::vector<std::uint8_t> transferData;
+	std::uint32_t transferSize;
+	std::uint32_t lastStatusTimestamp_ms;
+};
+
+static FakeVTContext fakeVT;
+
+static void record_sent_frame(HardwareInterfaceCANFrame &frame, void *)
+{
+	const std::lock_guard<std::mutex> lock(fakeVT.sentFramesMutex);
+	fakeVT.sentFrames.push_back(frame);
+}
+
+static std::vector<HardwareInterfaceCANFrame> take_sent_frames()
+{
+	const std::lock_guard<std::mutex> lock(fakeVT.sentFramesMutex);
+	std::vector<HardwareInterfaceCANFrame> retVal;
+
+	retVal.swap(fakeVT.sentFrames);
+	return retVal;
+}
+
+static void receive_from_vt(std::uint32_t pgn, std::uint8_t destinationAddress, const std::uint8_t *data)
+{
+	HardwareInterfaceCANFrame frame;
+
+	frame.timestamp_us = 0;
+	frame.identifier = CANIdentifier(CANIdentifier::Type::Extended, pgn, CANIdentifier::CANPriority::PriorityDefault6, destinationAddress, TEST_VT_ADDRESS).get_identifier();
+	frame.channel = TEST_CAN_PORT;
+	std::memcpy(frame.data, data, sizeof(frame.data));
+	frame.dataLength = 8;
+	frame.isExtendedFrame = true;
+	CANNetworkManager::CANNetwork.can_lib_process_rx_message(frame, nullptr);
+}
+
+static void respond_to_client(const std::uint8_t (&data)[8])
+{
+	receive_from_vt(VT_TO_ECU_PGN, TEST_CLIENT_ADDRESS, data);
+}
+
+// Sends a VT to ECU message that doesn't fit in one frame to all ECUs with BAM
+static void broadcast_to_clients(const std::vector<std::uint8_t> &payload)
+{
+	const std::uint8_t numberOfPackets = static_cast<std::uint8_t>((payload.size() + 6) / 7);
+	const std::uint8_t announce[8] = { 32, static_cast<std::uint8_t>(payload.size() & 0xFF), static_cast<std::uint8_t>(payload.size() >> 8), numberOfPackets, 0xFF, static_cast<std::uint8_t>(VT_TO_ECU_PGN & 0xFF), static_cast<std::uint8_t>((VT_TO_ECU_PGN >> 8) & 0xFF), static_cast<std::uint8_t>(VT_TO_ECU_PGN >> 16) };
+
+	receive_from_vt(TP_COMMAND_PGN, 0xFF, announce);
+	for (std::uint8_t i = 0; i < numberOfPackets; i++)
+	{
+		std::uint8_t packet[8] = { static_cast<std::uint8_t>(i + 1), 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+		for (std::size_t j = 0; (j < 7) && ((i * 7u + j) < payload.size()); j++)
+		{
+			packet[1 + j] = payload[i * 7u + j];
+		}
+		receive_from_vt(TP_DATA_PGN, 0xFF, packet);
+	}
+}
+
+// Answers the connection handshake, object pool upload and version labels like a VT of the configured version would
+static void answer_vt_message(const std::vector<std::uint8_t> &message)
+{
+	switch (message[0])
+	{
+		case 0x11:
+		{
+			fakeVT.objectPoolTransfers.push_back(message);
+		}
+		break;
+
+		case 0xC0:
+		{
+			respond_to_client({ 0xC0, fakeVT.version, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF });
+		}
+		break;
+
+		case 0xDF:
+		{
+			if (fakeVT.storedVersionLabel.empty())
+			{
+				respond_to_client({ 0xE0, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF });
+			}
+			else
+			{
+				std::vector<std::uint8_t> response = { 0xE0, 0x01 };
+
+				response.insert(response.end(), fakeVT.storedVersionLabel.begin(), fakeVT.storedVersionLabel.end());
+				response.resize(9, ' ');
+				broadcast_to_clients(response);
+			}
+		}
+		break;
+
+		case 0xD0:
+		case 0xD1:
+		case 0xD2:
+		{
+			respond_to_client({ message[0], 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xFF, 0xFF });
+		}
+		break;
+
+		case 0xC2:
+		{
+			respond_to_client({ 0xC2, 0xFF, 0xFF, 0xFF, 60, 60, 64, 6 });
+		}
+		break;
+
+		case 0xC3:
+		{
+			respond_to_client({ 0xC3, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00 });
+		}
+		break;
+
+		case 0xC7:
+		{
+			respond_to_client({ 0xC7, 0xFF, 0x02, 0x00, 0xE0, 0x01, 0xE0, 0x01 });
+		}
+		break;
+
+		case 0x12:
+		{
+			respond_to_client({ 0x12, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xFF });
+		}
+		break;
+
+		default:
+		{
+		}
+		break;
+	}
+}
+
+// Reassembles what the client sent to the VT, and acts as the VT's side of the transport protocol
+static void process_sent_frames()
+{
+	for (const auto &frame : take_sent_frames())
+	{
+		const CANIdentifier identifier(frame.identifier);
+		const std::uint32_t pgn = identifier.get_parameter_group_number();
+
+		if (TEST_VT_ADDRESS != identifier.get_destination_address())
+		{
+			// Not for the VT
+		}
+		else if (ECU_TO_VT_PGN == pgn)
+		{
+			fakeVT.receivedMessages.emplace_back(frame.data, frame.data + frame.dataLength);
+			answer_vt_message(fakeVT.receivedMessages.back());
+		}
+		else if ((TP_COMMAND_PGN == pgn) &&
+		         (16 == frame.data[0]))
+		{
+			const std::uint8_t clearToSend[8] = { 17, frame.data[3], 1, 0xFF, 0xFF, frame.data[5], frame.data[6], frame.data[7] };
+
+			fakeVT.transferSize = static_cast<std::uint32_t>(frame.data[1]) | (static_cast<std::uint32_t>(frame.data[2]) << 8);
+			fakeVT.transferData.clear();
+			receive_from_vt(TP_COMMAND_PGN, TEST_CLIENT_ADDRESS, clearToSend);
+		}
+		else if (TP_DATA_PGN == pgn)
+		{
+			fakeVT.transferData.insert(fakeVT.transferData.end(), frame.data + 1, frame.data + 8);
+
+			if (fakeVT.transferData.size() >= fakeVT.transferSize)
+			{
+				const std::uint8_t numberOfPackets = static_cast<std::uint8_t>((fakeVT.transferSize + 6) / 7);
+				const std::uint8_t endOfMessage[8] = { 19, static_cast<std::uint8_t>(fakeVT.transferSize & 0xFF), static_cast<std::uint8_t>(fakeVT.transferSize >> 8), numberOfPackets, 0xFF, static_cast<std::uint8_t>(ECU_TO_VT_PGN & 0xFF), static_cast<std::uint8_t>((ECU_TO_VT_PGN >> 8) & 0xFF), static_cast<std::uint8_t>(ECU_TO_VT_PGN >> 16) };
+
+				fakeVT.transferData.resize(fakeVT.transferSize);
+				fakeVT.receivedMessages.push_back(fakeVT.transferData);
+				receive_from_vt(TP_COMMAND_PGN, TEST_CLIENT_ADDRESS, endOfMessage);
+				answer_vt_message(fakeVT.receivedMessages.back());
+			}
+		}
+	}
+}
+
+// Runs the network manager and the fake VT once, sending the VT status message every 500 ms
+static void update_network()
+{
+	if (SystemTiming::time_expired_ms(fakeVT.lastStatusTimestamp_ms, 500))
+	{
+		const std::uint8_t status[8] = { 0xFE, TEST_CLIENT_ADDRESS, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0xFF };
+
+		receive_from_vt(VT_TO_ECU_PGN, 0xFF, status);
+		fakeVT.lastStatusTimestamp_ms = SystemTiming::get_timestamp_ms();
+	}
+	CANNetworkManager::CANNetwork.update();
+	std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	process_sent_frames();
+}
+
+// Runs the client, the network manager and the fake VT for a while
+static void update_for(VirtualTerminalClient &client, std::uint32_t duration_ms)
+{
+	const std::uint32_t startTime_ms = SystemTiming::get_timestamp_ms();
+
+	do
+	{
+		CANNetworkManager::CANNetwork.update();
+		client.update();
+		update_network();
+	} while (!SystemTiming::time_expired_ms(startTime_ms, duration_ms));
+}
+
+// Runs the network manager and the fake VT for a while, leaving the client to its worker thread
+static void update_network_for(std::uint32_t duration_ms)
+{
+	const std::uint32_t startTime_ms = SystemTiming::get_timestamp_ms();
+
+	do
+	{
+		update_network();
+	} while (!SystemTiming::time_expired_ms(startTime_ms, duration_ms));
+}
+
+static bool connect_client(VirtualTerminalClient &client)
+{
+	const std::uint32_t startTime_ms = SystemTiming::get_timestamp_ms();
+
+	while ((!client.get_is_connected()) &&
+	       (!SystemTiming::time_expired_ms(startTime_ms, 3000)))
+	{
+		update_for(client, 0);
+	}
+
+	// Let the messages sent while connecting, like the preferred assignment, reach the fake VT before forgetting them
+	update_for(client, 20);
+	fakeVT.receivedMessages.clear();
+	return client.get_is_connected();
+}
+
+// Returns the commands the client sent to the VT since the last call, leaving out working set maintenance
+static std::vector<std::vector<std::uint8_t>> take_vt_commands()
+{
+	std::vector<std::vector<std::uint8_t>> retVal;
+
+	for (const auto &message : fakeVT.receivedMessages)
+	{
+		if (0xFF != message[0])
+		{
+			retVal.push_back(message);
+		}
+	}
+	fakeVT.receivedMessages.clear();
+	return retVal;
+}
+
+// Runs the network and the fake VT until the client's worker thread sends a command, returns how long that took
+static std::uint32_t wait_for_vt_command(std::vector<std::vector<std::uint8_t>> &commands)
+{
+	const std::uint32_t startTime_ms = SystemTiming::get_timestamp_ms();
+
+	commands.clear();
+	while ((commands.empty()) &&
+	       (!SystemTiming::time_expired_ms(startTime_ms, 1000)))
+	{
+		update_network();
+		commands = take_vt_commands();
+	}
+	return SystemTiming::get_time_elapsed_ms(startTime_ms);
+}
+
+// A pool with a working set designator, a data mask holding an output string and an object pointer, and a font
+static std::vector<std::uint8_t> make_test_pool()
+{
+	return {
+		// Working set 0, active mask 1000, designator rectangle 6000, no macros, no languages
+		0x00, 0x00, 0x00, 0x01, 0x01, 0xE8, 0x03, 0x01, 0x00, 0x00,
+		0x70, 0x17, 0x00, 0x00, 0x00, 0x00,
+		// Data mask 1000, no soft key mask, two objects, one macro
+		0xE8, 0x03, 0x01, 0x00, 0xFF, 0xFF, 0x02, 0x01,
+		0xD0, 0x07, 0x0A, 0x00, 0x14, 0x00,
+		0xD1, 0x07, 0x0A, 0x00, 0x28, 0x00,
+		0x00, 0x05,
+		// Output string 2000, 3 character value, no macros
+		0xD0, 0x07, 0x0B, 0x64, 0x00, 0x14, 0x00, 0x01, 0xB8, 0x0B, 0x00, 0xFF, 0xFF, 0x00, 0x03, 0x00, 'a', 'b', 'c', 0x00,
+		// Object pointer 2001, pointing at the output string
+		0xD1, 0x07, 0x1B, 0xD0, 0x07,
+		// Font attributes 3000, no macros
+		0xB8, 0x0B, 0x17, 0x00, 0x00, 0x00, 0x00, 0x00,
+		// Output rectangle 6000, 60x60, no line or fill attributes, no macros
+		0x70, 0x17, 0x0E, 0xFF, 0xFF, 0x3C, 0x00, 0x3C, 0x00, 0x00, 0xFF, 0xFF, 0x00
+	};
+}
+
+// Sets up the bus, a claimed client control function and a partner bound to the fake VT
+class VTClientTestFixture
+{
+public:
+	VTClientTestFixture()
+	{
+		fakeVT.sentFrames.clear();
+		fakeVT.receivedMessages.clear();
+		fakeVT.objectPoolTransfers.clear();
+		fakeVT.storedVersionLabel.clear();
+		fakeVT.version = 3;
+		fakeVT.lastStatusTimestamp_ms = 0;
+		// A channel keeps the frame handler an earlier test assigned to it, so start from no channels
+		CANHardwareInterface::set_number_of_can_channels(0);
+		CANHardwareInterface::set_number_of_can_channels(1);
+		EXPECT_TRUE(CANHardwareInterface::assign_can_channel_frame_handler(TEST_CAN_PORT, std::make_shared<VirtualCANPlugin>("", true)));
+		CANHardwareInterface::add_raw_can_message_rx_callback(record_sent_frame, nullptr);
+		CANHardwareInterface::start();
+
+		// The first update initializes the network manager, which clears the receive queue
+		CANNetworkManager::CANNetwork.update();
+
+		NAME clientNAME(0);
+		clientNAME.set_arbitrary_address_capable(true);
+		clientNAME.set_industry_group(2);
+		clientNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::HydraulicPumpControl));
+		clientNAME.set_identity_number(31);
+		clientNAME.set_manufacturer_code(69);
+		internalECU = std::make_shared<InternalControlFunction>(clientNAME, TEST_CLIENT_ADDRESS, TEST_CAN_PORT);
+
+		const NAMEFilter vtFilter(NAME::NAMEParameters::FunctionCode, static_cast<std::uint8_t>(NAME::Function::VirtualTerminal));
+		partnerVT = std::make_shared<PartneredControlFunction>(TEST_CAN_PORT, std::vector<NAMEFilter>{ vtFilter });
+
+		NAME vtNAME(0);
+		vtNAME.set_arbitrary_address_capable(false);
+		vtNAME.set_industry_group(2);
+		vtNAME.set_function_code(static_cast<std::uint8_t>(NAME::Function::VirtualTerminal));
+		vtNAME.set_identity_number(32);
+		vtNAME.set_manufacturer_code(69);
+		std::uint8_t addressClaim[8];
+		for (std::uint8_t i = 0; i < 8; i++)
+		{
+			addressClaim[i] = static_cast<std::uint8_t>(vtNAME.get_full_name() >> (8 * i));
+		}
+		receive_from_vt(static_cast<std::uint32_t>(CANLibParameterGroupNumber::AddressClaim), 0xFF, addressClaim);
+
+		const std::uint32_t startTime_ms = SystemTiming::get_timestamp_ms();
+		while ((!internalECU->get_address_valid()) &&
+		       (!SystemTiming::time_expired_ms(startTime_ms, 2000)))
+		{
+			CANNetworkManager::CANNetwork.update();
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		take_sent_frames();
+	}
+
+	~VTClientTestFixture()
+	{
+		CANHardwareInterface::stop();
+		CANHardwareInterface::remove_raw_can_message_rx_callback(record_sent_frame, nullptr);
+	}
+
+	std::shared_ptr<InternalControlFunction> internalECU;
+	std::shared_ptr<PartneredControlFunction> partnerVT;
+};
+
+TEST(VT_CLIENT_TESTS, QueuesCommandsInOrderAndCoalescesThem)
+{
+	VTClientTestFixture fixture;
+	const std::vector<std::uint8_t> pool = make_test_pool();
+	VirtualTerminalClient client(fixture.partnerVT, fixture.internalECU);
+
+	ASSERT_TRUE(fixture.internalECU->get_address_valid());
+	ASSERT_TRUE(fixture.partnerVT->get_address_valid());
+	client.set_object_pool(0, VirtualTerminalClient::VTVersion::Version3, pool.data(), static_cast<std::uint32_t>(pool.size()));
+	client.initialize(false);
+
+	// Nothing can be queued before the VT is connected
+	EXPECT_FALSE(client.send_change_numeric_value(2000, 1));
+	EXPECT_FALSE(client.send_change_active_mask(0, 1000));
+	ASSERT_TRUE(connect_client(client));
+
+	// One command at a time is in flight, so the later changes to object 2000 collapse into one
+	EXPECT_TRUE(client.send_change_numeric_value(2000, 1));
+	update_for(client, 20);
+	EXPECT_TRUE(client.send_change_numeric_value(2000, 2));
+	EXPECT_TRUE(client.send_hide_show_object(2001, VirtualTerminalClient::HideShowObjectCommand::HideObject));
+	EXPECT_TRUE(client.send_change_active_mask(0, 1000));
+	EXPECT_TRUE(client.send_change_softkey_mask(VirtualTerminalClient::MaskType::DataMask, 1000, 4000));
+	EXPECT_TRUE(client.send_change_numeric_value(2000, 3));
+	update_for(client, 20);
+
+	std::vector<std::vector<std::uint8_t>> commands = take_vt_commands();
+	ASSERT_EQ(1u, commands.size());
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0xA8, 0xD0, 0x07, 0xFF, 0x01, 0x00, 0x00, 0x00 }), commands[0]);
+
+	// Each response lets the next queued command go, in the order they were first queued
+	respond_to_client({ 0xA8, 0xD0, 0x07, 0x00, 0x01, 0x00, 0x00, 0x00 });
+	update_for(client, 20);
+	respond_to_client({ 0xA8, 0xD0, 0x07, 0x00, 0x03, 0x00, 0x00, 0x00 });
+	update_for(client, 20);
+	respond_to_client({ 0xA0, 0xD1, 0x07, 0x00, 0x00, 0xFF, 0xFF, 0xFF });
+	update_for(client, 20);
+
+	// The change active mask response echoes the new mask instead of the working set
+	respond_to_client({ 0xAD, 0xE8, 0x03, 0x00, 0xFF, 0xFF, 0xFF, 0xFF });
+	update_for(client, 20);
+	respond_to_client({ 0xAE, 0xE8, 0x03, 0xA0, 0x0F, 0x00, 0xFF, 0xFF });
+	update_for(client, 20);
+
+	commands = take_vt_commands();
+	ASSERT_EQ(4u, commands.size());
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0xA8, 0xD0, 0x07, 0xFF, 0x03, 0x00, 0x00, 0x00 }), commands[0]);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0xA0, 0xD1, 0x07, 0x00, 0xFF, 0xFF, 0xFF, 0xFF }), commands[1]);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0xAD, 0x00, 0x00, 0xE8, 0x03, 0xFF, 0xFF, 0xFF }), commands[2]);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0xAE, 0x01, 0xE8, 0x03, 0xA0, 0x0F, 0xFF, 0xFF }), commands[3]);
+	EXPECT_EQ(2u, client.get_command_statistics(0xA8).numberOfResponses);
+	EXPECT_EQ(1u, client.get_command_statistics(0xA0).numberOfResponses);
+	EXPECT_EQ(1u, client.get_command_statistics(0xAD).numberOfResponses);
+	EXPECT_EQ(1u, client.get_command_statistics(0xAE).numberOfResponses);
+
+	client.terminate();
+}
+
+TEST(VT_CLIENT_TESTS, DropsQueuedCommandsWhenDisconnected)
+{
+	VTClientTestFixture fixture;
+	const std::vector<std::uint8_t> pool = make_test_pool();
+	VirtualTerminalClient client(fixture.partnerVT, fixture.internalECU);
+
+	client.set_object_pool(0, VirtualTerminalClient::VTVersion::Version3, pool.data(), static_cast<std::uint32_t>(pool.size()));
+	client.initialize(false);
+	ASSERT_TRUE(connect_client(client));
+
+	EXPECT_TRUE(client.send_change_numeric_value(2000, 1));
+	update_for(client, 20);
+	EXPECT_TRUE(client.send_change_numeric_value(2001, 2));
+	EXPECT_EQ(1u, take_vt_commands().size());
+
+	// A NACK of our VT messages ends the connection
+	const std::uint8_t negativeAcknowledge[8] = { 0x01, 0xFF, 0xFF, 0xFF, TEST_CLIENT_ADDRESS, static_cast<std::uint8_t>(ECU_TO_VT_PGN & 0xFF), static_cast<std::uint8_t>((ECU_TO_VT_PGN >> 8) & 0xFF), static_cast<std::uint8_t>(ECU_TO_VT_PGN >> 16) };
+	receive_from_vt(static_cast<std::uint32_t>(CANLibParameterGroupNumber::Acknowledge), TEST_CLIENT_ADDRESS, negativeAcknowledge);
+	CANNetworkManager::CANNetwork.update();
+	EXPECT_FALSE(client.get_is_connected());
+	EXPECT_FALSE(client.send_change_numeric_value(2000, 3));
+
+	// The commands of the old connection are not sent to the reconnected VT
+	ASSERT_TRUE(connect_client(client));
+	update_for(client, 50);
+	EXPECT_TRUE(take_vt_commands().empty());
+
+	EXPECT_TRUE(client.send_change_numeric_value(2000, 4));
+	update_for(client, 20);
+	const std::vector<std::vector<std::uint8_t>> commands = take_vt_commands();
+	ASSERT_EQ(1u, commands.size());
+	EXPECT_EQ(4, commands[0][4]);
+
+	client.terminate();
+}
+
+TEST(VT_CLIENT_TESTS, RetriesUnansweredCommandsAndTracksLatency)
+{
+	VTClientTestFixture fixture;
+	const std::vector<std::uint8_t> pool = make_test_pool();
+	VirtualTerminalClient client(fixture.partnerVT, fixture.internalECU);
+
+	client.set_object_pool(0, VirtualTerminalClient::VTVersion::Version3, pool.data(), static_cast<std::uint32_t>(pool.size()));
+	client.initialize(false);
+	ASSERT_TRUE(connect_client(client));
+
+	// A response is matched to the command in flight and its round trip is measured
+	EXPECT_TRUE(client.send_change_numeric_value(2000, 1));
+	update_for(client, 30);
+	ASSERT_EQ(1u, take_vt_commands().size());
+	respond_to_client({ 0xA8, 0xD0, 0x07, 0x00, 0x01, 0x00, 0x00, 0x00 });
+	update_for(client, 10);
+
+	VirtualTerminalClient::CommandStatistics statistics = client.get_command_statistics(0xA8);
+	EXPECT_EQ(1u, statistics.numberOfResponses);
+	EXPECT_GE(statistics.minimumLatency_ms, 25u);
+	EXPECT_EQ(statistics.minimumLatency_ms, statistics.maximumLatency_ms);
+	EXPECT_EQ(statistics.minimumLatency_ms, statistics.totalLatency_ms);
+
+	// A response for another object doesn't complete the command in flight
+	EXPECT_TRUE(client.send_change_numeric_value(2000, 2));
+	EXPECT_TRUE(client.send_change_numeric_value(2001, 3));
+	update_for(client, 20);
+	ASSERT_EQ(1u, take_vt_commands().size());
+	respond_to_client({ 0xA8, 0xD1, 0x07, 0x00, 0x03, 0x00, 0x00, 0x00 });
+	update_for(client, 20);
+	EXPECT_TRUE(take_vt_commands().empty());
+	EXPECT_EQ(1u, client.get_command_statistics(0xA8).numberOfResponses);
+
+	// Without a response the command is sent again, and dropped after its last retry so the queue moves on
+	update_for(client, 1550);
+	std::vector<std::vector<std::uint8_t>> commands = take_vt_commands();
+	ASSERT_EQ(1u, commands.size());
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0xA8, 0xD0, 0x07, 0xFF, 0x02, 0x00, 0x00, 0x00 }), commands[0]);
+	EXPECT_EQ(1u, client.get_command_statistics(0xA8).numberOfRetries);
+
+	update_for(client, 3200);
+	commands = take_vt_commands();
+	ASSERT_EQ(2u, commands.size());
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0xA8, 0xD0, 0x07, 0xFF, 0x02, 0x00, 0x00, 0x00 }), commands[0]);
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0xA8, 0xD1, 0x07, 0xFF, 0x03, 0x00, 0x00, 0x00 }), commands[1]);
+	statistics = client.get_command_statistics(0xA8);
+	EXPECT_EQ(2u, statistics.numberOfRetries);
+	EXPECT_EQ(1u, statistics.numberOfTimeouts);
+
+	client.terminate();
+}
+
+TEST(VT_CLIENT_TESTS, WorkerThreadWakesUpForCommandsAndResponses)
+{
+	VTClientTestFixture fixture;
+	const std::vector<std::uint8_t> pool = make_test_pool();
+	VirtualTerminalClient client(fixture.partnerVT, fixture.internalECU);
+	std::vector<std::vector<std::uint8_t>> commands;
+
+	client.set_object_pool(0, VirtualTerminalClient::VTVersion::Version3, pool.data(), static_cast<std::uint32_t>(pool.size()));
+	client.initialize(true);
+
+	const std::uint32_t startTime_ms = SystemTiming::get_timestamp_ms();
+	while ((!client.get_is_connected()) &&
+	       (!SystemTiming::time_expired_ms(startTime_ms, 3000)))
+	{
+		update_network();
+	}
+	ASSERT_TRUE(client.get_is_connected());
+	update_network_for(100);
+	fakeVT.receivedMessages.clear();
+
+	// Queuing a command wakes the thread, instead of the command waiting for the thread's longest sleep of 50 ms
+	EXPECT_TRUE(client.send_change_numeric_value(2000, 1));
+	EXPECT_TRUE(client.send_change_numeric_value(2001, 2));
+	EXPECT_LT(wait_for_vt_command(commands), 25u);
+	ASSERT_EQ(1u, commands.size());
+	EXPECT_EQ(0xD0, commands[0][1]);
+
+	// So does the response that lets the next command go
+	respond_to_client({ 0xA8, 0xD0, 0x07, 0x00, 0x01, 0x00, 0x00, 0x00 });
+	EXPECT_LT(wait_for_vt_command(commands), 25u);
+	ASSERT_EQ(1u, commands.size());
+	EXPECT_EQ(0xD1, commands[0][1]);
+
+	client.terminate();
+}
+
+TEST(VT_CLIENT_TESTS, MirrorsPoolValuesAndQueriesEachAttributeOnce)
+{
+	VTClientTestFixture fixture;
+	const std::vector<std::uint8_t> pool = make_test_pool();
+	VirtualTerminalClient client(fixture.partnerVT, fixture.internalECU);
+	std::uint32_t value = 0;
+	std::string stringValue;
+
+	client.set_object_pool(0, VirtualTerminalClient::VTVersion::Version3, pool.data(), static_cast<std::uint32_t>(pool.size()));
+	client.initialize(false);
+	ASSERT_TRUE(connect_client(client));
+
+	// The update after connecting seeded the mirror from the pool
+	EXPECT_TRUE(client.get_string_value(2000, stringValue));
+	EXPECT_EQ("abc", stringValue);
+
+	// Reading an attribute that isn't mirrored asks the VT once, however often it is read before the response
+	EXPECT_FALSE(client.get_attribute_value(2000, 1, value));
+	EXPECT_FALSE(client.get_attribute_value(2000, 1, value));
+	update_for(client, 20);
+	EXPECT_FALSE(client.get_attribute_value(2000, 1, value));
+	update_for(client, 20);
+	std::vector<std::vector<std::uint8_t>> commands = take_vt_commands();
+	ASSERT_EQ(1u, commands.size());
+	EXPECT_EQ((std::vector<std::uint8_t>{ 0xB9, 0xD0, 0x07, 0x01, 0xFF, 0xFF, 0xFF, 0xFF }), commands[0]);
+
+	respond_to_client({ 0xB9, 0xD0, 0x07, 0x01, 0x64, 0x00, 0x00, 0x00 });
+	update_for(client, 20);
+	EXPECT_TRUE(client.get_attribute_value(2000, 1, value));
+	EXPECT_EQ(100u, value);
+	EXPECT_TRUE(take_vt_commands().empty());
+
+	// An unanswered query is sent again once it times out
+	EXPECT_FALSE(client.get_attribute_value(2001, 2, value));
+	update_for(client, 20);
+	EXPECT_EQ(1u, take_vt_commands().size());
+	update_for(client, 1550);
+	EXPECT_FALSE(client.get_attribute_value(2001, 2, value));
+	update_for(client, 20);
+	EXPECT_EQ(1u, take_vt_commands().size());
+
+	client.terminate();
+}
+
+TEST(VT_CLIENT_TESTS, UploadsObjectsWhoseScaledOutputChangedOnTopOfDeltaBase)
+{
+	VTClientTestFixture fixture;
+	const std::vector<std::uint8_t> basePool = make_test_pool();
+	std::vector<std::uint8_t> pool = basePool;
+	VirtualTerminalClient client(fixture.partnerVT, fixture.internalECU);
+	VirtualTerminalObjectPoolIndex uploadedObjects;
+
+	// A soft key now shows the output string, which moves it into the soft key area and changes its scaling
+	pool.insert(pool.end(), {
+	                          // Soft key mask 4000, one key, no macros
+	                          0xA0, 0x0F, 0x04, 0x00, 0x01, 0x00, 0x88, 0x13,
+	                          // Key 5000, key code 1, the output string at 0,0, no macros
+	                          0x88, 0x13, 0x05, 0x00, 0x01, 0x01, 0x00, 0xD0, 0x07, 0x00, 0x00, 0x00, 0x00 });
+
+	fakeVT.version = 4;
+	fakeVT.storedVersionLabel = "BASE";
+	client.set_object_pool(0, VirtualTerminalClient::VTVersion::Version4, pool.data(), static_cast<std::uint32_t>(pool.size()), "NEW");
+	client.set_object_pool_delta_base(0, basePool.data(), static_cast<std::uint32_t>(basePool.size()), "BASE");
+	client.set_object_pool_scaling(200, 60, 60);
+	client.initialize(false);
+	ASSERT_TRUE(connect_client(client));
+
+	// The output string's bytes are the same as in the delta base, but it is scaled differently now
+	ASSERT_EQ(1u, fakeVT.objectPoolTransfers.size());
+	const std::vector<std::uint8_t> &transfer = fakeVT.objectPoolTransfers[0];
+	ASSERT_TRUE(uploadedObjects.parse(&transfer[1], static_cast<std::uint32_t>(transfer.size() - 1)));
+	EXPECT_NE(nullptr, uploadedObjects.get_object(2000));
+	EXPECT_NE(nullptr, uploadedObjects.get_object(4000));
+	EXPECT_NE(nullptr, uploadedObjects.get_object(5000));
+	EXPECT_EQ(nullptr, uploadedObjects.get_object(0));
+	EXPECT_EQ(nullptr, uploadedObjects.get_object(1000));
+
+	// The soft key area isn't scaled, so the string keeps its original size
+	const VirtualTerminalObjectPoolIndex::ObjectEntry *outputString = uploadedObjects.get_object(2000);
+	ASSERT_NE(nullptr, outputString);
+	EXPECT_EQ(100, transfer[1 + outputString->offset + 3]);
+
+	client.terminate();
+}
+
+TEST(VT_CLIENT_TESTS, SendsBackToBackMultiFrameCommandsIntact)
+{
+	VTClientTestFixture fixture;
+	const std::vector<std::uint8_t> pool = make_test_pool();
+	VirtualTerminalClient client(fixture.partnerVT, fixture.internalECU);
+	const std::string firstValue = "first value, longer than one frame";
+	const std::string secondValue = "the second value";
+	std::vector<std::uint8_t> firstCommand = { 0xB3, 0xD0, 0x07, static_cast<std::uint8_t>(firstValue.size()), 0x00 };
+	std::vector<std::uint8_t> secondCommand = { 0xB3, 0xD1, 0x07, static_cast<std::uint8_t>(secondValue.size()), 0x00 };
+
+	firstCommand.insert(firstCommand.end(), firstValue.begin(), firstValue.end());
+	secondCommand.insert(secondCommand.end(), secondValue.begin(), secondValue.end());
+
+	// With room for both in flight, the second transfer has to wait for the first to finish with the transfer buffer
+	client.set_maximum_commands_in_flight(2, VirtualTerminalClient::VTVersion::Version3);
+	client.set_object_pool(0, VirtualTerminalClient::VTVersion::Version3, pool.data(), static_cast<std::uint32_t>(pool.size()));
+	client.initialize(false);
+	ASSERT_TRUE(connect_client(client));
+
+	EXPECT_TRUE(client.send_change_string_value(2000, firstValue));
+	EXPECT_TRUE(client.send_change_string_value(2001, secondValue));
+	update_for(client, 100);
+	std::vector<std::vector<std::uint8_t>> commands = take_vt_commands();
+	ASSERT_EQ(2u, commands.size());
+	EXPECT_EQ(firstCommand, commands[0]);
+	EXPECT_EQ(secondCommand, commands[1]);
+
+	// The buffer is reused for the next command once the VT has answered, without leftovers of the longer one
+	respond_to_client({ 0xB3, 0xFF, 0xFF, 0xD0, 0x07, 0x00, 0xFF, 0xFF });
+	respond_to_client({ 0xB3, 0xFF, 0xFF, 0xD1, 0x07, 0x00, 0xFF, 0xFF });
+	update_for(client, 20);
+	EXPECT_TRUE(client.send_change_string_value(2000, secondValue));
+	update_for(client, 100);
+	commands = take_vt_commands();
+	ASSERT_EQ(1u, commands.size());
+	secondCommand[1] = 0xD0;
+	EXPECT_EQ(secondCommand, commands[0]);
+	EXPECT_EQ(2u, client.get_command_statistics(0xB3).numberOfResponses);
+
+	client.terminate();
+}
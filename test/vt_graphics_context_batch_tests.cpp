@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include "isobus/isobus/isobus_virtual_terminal_graphics_context_batch.hpp"
+
+using namespace isobus;
+
+TEST(VT_GRAPHICS_CONTEXT_BATCH_TESTS, ElidesRedundantCommands)
+{
+	VirtualTerminalGraphicsContextBatch batch(1234);
+
+	batch.set_foreground_colour(12);
+	batch.set_foreground_colour(12);
+	batch.move_graphics_cursor(5, 5);
+	batch.move_graphics_cursor(-2, 10);
+	batch.draw_point(0, 0);
+	batch.set_foreground_colour(12);
+	batch.move_graphics_cursor(3, -3);
+	batch.move_graphics_cursor(-3, 3);
+	batch.draw_point(0, 0);
+
+	const auto messages = batch.take_messages();
+	ASSERT_EQ(4, messages.size());
+
+	const std::vector<std::uint8_t> setColour = { 0xB8, 0xD2, 0x04, 0x02, 12, 0xFF, 0xFF, 0xFF };
+	const std::vector<std::uint8_t> moveCursor = { 0xB8, 0xD2, 0x04, 0x01, 3, 0x00, 15, 0x00 };
+	const std::vector<std::uint8_t> drawPoint = { 0xB8, 0xD2, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 };
+	EXPECT_EQ(setColour, messages[0]);
+	EXPECT_EQ(moveCursor, messages[1]);
+	EXPECT_EQ(drawPoint, messages[2]);
+	EXPECT_EQ(drawPoint, messages[3]);
+	EXPECT_TRUE(batch.take_messages().empty());
+}
+
+TEST(VT_GRAPHICS_CONTEXT_BATCH_TESTS, SendsLineRunsAsOpenPolygons)
+{
+	VirtualTerminalGraphicsContextBatch batch(1);
+
+	for (std::uint8_t i = 0; i < 10; i++)
+	{
+		batch.draw_line(2, 1);
+	}
+	auto messages = batch.take_messages();
+	ASSERT_EQ(1, messages.size());
+	ASSERT_EQ(5 + 4 * 10, messages[0].size());
+	EXPECT_EQ(0x0C, messages[0][3]);
+	EXPECT_EQ(10, messages[0][4]);
+	EXPECT_EQ(20, messages[0][41]);
+	EXPECT_EQ(10, messages[0][43]);
+
+	// A run that ends where it started is sent without its last line, so the polygon isn't closed
+	batch.draw_line(10, 0);
+	batch.draw_line(0, 10);
+	batch.draw_line(-10, 0);
+	batch.draw_line(0, -5);
+	batch.draw_line(0, -5);
+	messages = batch.take_messages();
+	ASSERT_EQ(2, messages.size());
+	EXPECT_EQ(0x0C, messages[0][3]);
+	EXPECT_EQ(4, messages[0][4]);
+	const std::vector<std::uint8_t> lastLine = { 0xB8, 0x01, 0x00, 0x09, 0x00, 0x00, 0xFB, 0xFF };
+	EXPECT_EQ(lastLine, messages[1]);
+
+	// Short runs are cheaper as separate lines
+	batch.draw_line(1, 1);
+	batch.draw_line(1, 1);
+	EXPECT_EQ(2, batch.take_messages().size());
+}
+
+TEST(VT_GRAPHICS_CONTEXT_BATCH_TESTS, ResendsStateTheRecordedCommandsRelyOn)
+{
+	VirtualTerminalGraphicsContextBatch batch(1234);
+
+	batch.set_foreground_colour(5);
+	batch.set_line_attributes_object_id(0x0102);
+	batch.draw_point(0, 0);
+	EXPECT_EQ(3, batch.take_messages().size());
+
+	// The colour is left out, so a VT that lost it must be told again before the point is drawn
+	batch.set_foreground_colour(5);
+	batch.draw_point(0, 0);
+	batch.resend_state();
+
+	const auto messages = batch.take_messages();
+	ASSERT_EQ(3, messages.size());
+
+	const std::vector<std::uint8_t> setColour = { 0xB8, 0xD2, 0x04, 0x02, 5, 0xFF, 0xFF, 0xFF };
+	const std::vector<std::uint8_t> setLineAttributes = { 0xB8, 0xD2, 0x04, 0x04, 0x02, 0x01, 0xFF, 0xFF };
+	const std::vector<std::uint8_t> drawPoint = { 0xB8, 0xD2, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 };
+	EXPECT_EQ(setColour, messages[0]);
+	EXPECT_EQ(setLineAttributes, messages[1]);
+	EXPECT_EQ(drawPoint, messages[2]);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_index.hpp"
+
+using namespace isobus;
+
+// A pool with a working set, a data mask holding an output string and an object pointer, and a font
+static std::vector<std::uint8_t> make_test_pool()
+{
+	return {
+		// Working set 0, active mask 1000, one object, no macros, no languages
+		0x00, 0x00, 0x00, 0x01, 0x01, 0xE8, 0x03, 0x01, 0x00, 0x00,
+		0xE8, 0x03, 0x00, 0x00, 0x00, 0x00,
+		// Data mask 1000, no soft key mask, two objects, one macro
+		0xE8, 0x03, 0x01, 0x00, 0xFF, 0xFF, 0x02, 0x01,
+		0xD0, 0x07, 0x0A, 0x00, 0x14, 0x00,
+		0xD1, 0x07, 0x0A, 0x00, 0x28, 0x00,
+		0x00, 0x05,
+		// Output string 2000, 3 character value, no macros
+		0xD0, 0x07, 0x0B, 0x64, 0x00, 0x14, 0x00, 0x01, 0xB8, 0x0B, 0x00, 0xFF, 0xFF, 0x00, 0x03, 0x00, 'a', 'b', 'c', 0x00,
+		// Object pointer 2001, pointing at the output string
+		0xD1, 0x07, 0x1B, 0xD0, 0x07,
+		// Font attributes 3000, no macros
+		0xB8, 0x0B, 0x17, 0x00, 0x00, 0x00, 0x00, 0x00
+	};
+}
+
+TEST(VT_OBJECT_POOL_INDEX_TESTS, ParsesObjectsAndRelationships)
+{
+	const std::vector<std::uint8_t> pool = make_test_pool();
+	VirtualTerminalObjectPoolIndex index;
+
+	ASSERT_TRUE(index.parse(pool));
+	EXPECT_EQ(5, index.get_number_objects());
+
+	const VirtualTerminalObjectPoolIndex::ObjectEntry *dataMask = index.get_object(1000);
+	ASSERT_NE(nullptr, dataMask);
+	EXPECT_EQ(VirtualTerminalObjectPoolIndex::ObjectType::DataMask, dataMask->type);
+	EXPECT_EQ(16, dataMask->offset);
+	EXPECT_EQ(22, dataMask->length);
+	EXPECT_EQ(2, dataMask->numberOfChildren);
+	EXPECT_EQ(2000, index.get_child_object_id(*dataMask, 0));
+	EXPECT_EQ(2001, index.get_child_object_id(*dataMask, 1));
+	EXPECT_EQ(VirtualTerminalObjectPoolIndex::NULL_OBJECT_ID, index.get_child_object_id(*dataMask, 2));
+
+	const VirtualTerminalObjectPoolIndex::ObjectEntry *outputString = index.get_object(2000);
+	ASSERT_NE(nullptr, outputString);
+	EXPECT_EQ(20, outputString->length);
+	EXPECT_EQ(2, index.get_number_parents(2000));
+	EXPECT_EQ(1000, index.get_parent_object_id(2000, 0));
+	EXPECT_EQ(2001, index.get_parent_object_id(2000, 1));
+	EXPECT_EQ(0, index.get_number_parents(0));
+	EXPECT_EQ(nullptr, index.get_object(1234));
+
+	// A truncated pool fails at the object that doesn't fit
+	const std::vector<std::uint8_t> truncatedPool(pool.begin(), pool.end() - 1);
+	EXPECT_FALSE(index.parse(truncatedPool));
+	EXPECT_EQ(0, index.get_number_objects());
+	EXPECT_EQ(63, index.get_parse_error_offset());
+
+	// Object IDs must be unique
+	std::vector<std::uint8_t> duplicatePool = pool;
+	duplicatePool[63] = 0xD0;
+	duplicatePool[64] = 0x07;
+	EXPECT_FALSE(index.parse(duplicatePool));
+}
+
+TEST(VT_OBJECT_POOL_INDEX_TESTS, ReadsInitialValues)
+{
+	const std::vector<std::uint8_t> pool = {
+		// Input string 5000, no variable, 4 character value, enabled, no macros
+		0x88, 0x13, 0x08, 0x64, 0x00, 0x14, 0x00, 0x01, 0xB8, 0x0B, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x00, 0x04, 't', 'e', 's', 't', 0x01, 0x00,
+		// Input string 5001, value in string variable 5002
+		0x89, 0x13, 0x08, 0x64, 0x00, 0x14, 0x00, 0x01, 0xB8, 0x0B, 0xFF, 0xFF, 0x00, 0x8A, 0x13, 0x00, 0x00, 0x01, 0x00,
+		// String variable 5002
+		0x8A, 0x13, 0x16, 0x03, 0x00, 'x', 'y', 'z',
+		// Number variable 5003
+		0x8B, 0x13, 0x15, 0x2A, 0x00, 0x00, 0x00,
+		// Font attributes 3000, no macros
+		0xB8, 0x0B, 0x17, 0x00, 0x00, 0x00, 0x00, 0x00
+	};
+	VirtualTerminalObjectPoolIndex index;
+	std::string stringValue;
+	std::uint32_t numericValue = 0;
+
+	ASSERT_TRUE(index.parse(pool));
+	ASSERT_EQ(5, index.get_number_objects());
+
+	EXPECT_TRUE(VirtualTerminalObjectPoolIndex::get_string_value(pool.data(), *index.get_object(5000), stringValue));
+	EXPECT_EQ("test", stringValue);
+	EXPECT_FALSE(VirtualTerminalObjectPoolIndex::get_string_value(pool.data(), *index.get_object(5001), stringValue));
+	EXPECT_TRUE(VirtualTerminalObjectPoolIndex::get_string_value(pool.data(), *index.get_object(5002), stringValue));
+	EXPECT_EQ("xyz", stringValue);
+	EXPECT_FALSE(VirtualTerminalObjectPoolIndex::get_numeric_value(pool.data(), *index.get_object(5000), numericValue));
+	EXPECT_TRUE(VirtualTerminalObjectPoolIndex::get_numeric_value(pool.data(), *index.get_object(5003), numericValue));
+	EXPECT_EQ(42, numericValue);
+}
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_scale_cache.hpp"
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_scaler.hpp"
+
+#include <memory>
+#include <vector>
+
+using namespace isobus;
+
+TEST(VT_OBJECT_POOL_SCALE_CACHE_TESTS, SharesScaledPoolsPerResolution)
+{
+	const std::vector<std::uint8_t> pool = {
+		// Output string 2000, 3 character value, no macros
+		0xD0, 0x07, 0x0B, 0x64, 0x00, 0x14, 0x00, 0x01, 0xB8, 0x0B, 0x00, 0xFF, 0xFF, 0x00, 0x03, 0x00, 'a', 'b', 'c', 0x00,
+		// Font attributes 3000, no macros
+		0xB8, 0x0B, 0x17, 0x00, 0x00, 0x00, 0x00, 0x00
+	};
+	VirtualTerminalObjectPoolScaleCache::ScalingParameters parameters = { 200, 480, 60, 60, 80, 80, 0xFF, 0x00 };
+
+	std::shared_ptr<const VirtualTerminalObjectPoolScaler> firstVT = VirtualTerminalObjectPoolScaleCache::get_scaler(pool.data(), static_cast<std::uint32_t>(pool.size()), parameters);
+	std::shared_ptr<const VirtualTerminalObjectPoolScaler> secondVT = VirtualTerminalObjectPoolScaleCache::get_scaler(pool.data(), static_cast<std::uint32_t>(pool.size()), parameters);
+	ASSERT_NE(nullptr, firstVT);
+	EXPECT_EQ(firstVT, secondVT);
+	EXPECT_EQ(1, VirtualTerminalObjectPoolScaleCache::get_number_cached_scalers());
+
+	parameters.dataMaskSize_px = 240;
+	std::shared_ptr<const VirtualTerminalObjectPoolScaler> thirdVT = VirtualTerminalObjectPoolScaleCache::get_scaler(pool.data(), static_cast<std::uint32_t>(pool.size()), parameters);
+	ASSERT_NE(nullptr, thirdVT);
+	EXPECT_NE(firstVT, thirdVT);
+	EXPECT_EQ(2, VirtualTerminalObjectPoolScaleCache::get_number_cached_scalers());
+
+	// Scalers are dropped once no client uses them
+	firstVT.reset();
+	secondVT.reset();
+	thirdVT.reset();
+	EXPECT_EQ(0, VirtualTerminalObjectPoolScaleCache::get_number_cached_scalers());
+}
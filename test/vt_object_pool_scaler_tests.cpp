@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "isobus/isobus/isobus_virtual_terminal_object_pool_scaler.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace isobus;
+
+// A pool with a working set designator, a data mask holding an output string and an object pointer, and a font
+static std::vector<std::uint8_t> make_test_pool()
+{
+	return {
+		// Working set 0, active mask 1000, designator rectangle 4000 at 5,6, no macros, no languages
+		0x00, 0x00, 0x00, 0x01, 0x01, 0xE8, 0x03, 0x01, 0x00, 0x00,
+		0xA0, 0x0F, 0x05, 0x00, 0x06, 0x00,
+		// Data mask 1000, no soft key mask, two objects, one macro
+		0xE8, 0x03, 0x01, 0x00, 0xFF, 0xFF, 0x02, 0x01,
+		0xD0, 0x07, 0x0A, 0x00, 0x14, 0x00,
+		0xD1, 0x07, 0x0A, 0x00, 0x28, 0x00,
+		0x00, 0x05,
+		// Output string 2000, 3 character value, no macros
+		0xD0, 0x07, 0x0B, 0x64, 0x00, 0x14, 0x00, 0x01, 0xB8, 0x0B, 0x00, 0xFF, 0xFF, 0x00, 0x03, 0x00, 'a', 'b', 'c', 0x00,
+		// Object pointer 2001, pointing at the output string
+		0xD1, 0x07, 0x1B, 0xD0, 0x07,
+		// Font attributes 3000, no macros
+		0xB8, 0x0B, 0x17, 0x00, 0x00, 0x00, 0x00, 0x00,
+		// Output rectangle 4000, 60x60, no line or fill attributes, no macros
+		0xA0, 0x0F, 0x0E, 0xFF, 0xFF, 0x3C, 0x00, 0x3C, 0x00, 0x00, 0xFF, 0xFF, 0x00
+	};
+}
+
+TEST(VT_OBJECT_POOL_SCALER_TESTS, ScalesPoolWhileCopying)
+{
+	const std::vector<std::uint8_t> pool = make_test_pool();
+	VirtualTerminalObjectPoolScaler scaler;
+
+	scaler.set_data_mask_scaling(200, 400);
+	scaler.set_soft_key_scaling(60, 60, 90, 90);
+	scaler.set_supported_font_sizes(0xFF, 0x00);
+	ASSERT_TRUE(scaler.prepare(pool.data(), static_cast<std::uint32_t>(pool.size())));
+	EXPECT_EQ(11, scaler.get_number_patched_bytes());
+
+	// Patch the pool in odd sized chunks, like the transport protocol would
+	std::vector<std::uint8_t> scaledPool = pool;
+	for (std::uint32_t i = 0; i < scaledPool.size(); i += 7)
+	{
+		scaler.apply(i, &scaledPool[i], std::min<std::uint32_t>(7, static_cast<std::uint32_t>(scaledPool.size()) - i));
+	}
+
+	// The designator is drawn in an area the size of a soft key, so it follows the soft key scaling
+	EXPECT_EQ(8, scaledPool[12]);
+	EXPECT_EQ(9, scaledPool[14]);
+	EXPECT_EQ(90, scaledPool[76]);
+	EXPECT_EQ(90, scaledPool[78]);
+
+	// Object positions in the data mask
+	EXPECT_EQ(20, scaledPool[26]);
+	EXPECT_EQ(40, scaledPool[28]);
+	EXPECT_EQ(20, scaledPool[32]);
+	EXPECT_EQ(80, scaledPool[34]);
+
+	// Output string size
+	EXPECT_EQ(200, scaledPool[41]);
+	EXPECT_EQ(0, scaledPool[42]);
+	EXPECT_EQ(40, scaledPool[43]);
+
+	// 6x8 font doubled to 12x16
+	EXPECT_EQ(3, scaledPool[67]);
+
+	// Without the bigger fonts the closest fit is 8x12
+	scaler.set_supported_font_sizes(0x07, 0x00);
+	ASSERT_TRUE(scaler.prepare(pool.data(), static_cast<std::uint32_t>(pool.size())));
+	scaledPool = pool;
+	scaler.apply(0, scaledPool.data(), static_cast<std::uint32_t>(scaledPool.size()));
+	EXPECT_EQ(2, scaledPool[67]);
+}